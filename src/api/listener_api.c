@@ -0,0 +1,138 @@
+/**
+ * @file listener_api.c
+ * @brief Protocol listener API endpoints
+ */
+
+#include "../include/api.h"
+#include "../include/common.h"
+#include "../include/protocol.h"
+#include "../common/uuid.h"
+#include "../protocols/admission.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <jansson.h>
+
+// Forward declarations
+static json_t* listener_to_json(protocol_listener_t* listener);
+
+/**
+ * @brief Register listener API handlers
+ */
+status_t register_listener_api_handlers(void) {
+    status_t status = http_server_register_handler("/api/listeners", "GET", api_listeners_get);
+    if (status != STATUS_SUCCESS) {
+        return status;
+    }
+    
+    return http_server_register_handler("/api/admission", "GET", api_admission_get);
+}
+
+/**
+ * @brief Get all listeners and their counters API handler
+ */
+status_t api_listeners_get(struct MHD_Connection* connection,
+                         const char* url, const char* method,
+                         const char* upload_data, size_t upload_data_size) {
+    protocol_listener_t** listeners = NULL;
+    size_t count = 0;
+    
+    status_t status = protocol_manager_get_listeners(&listeners, &count);
+    if (status != STATUS_SUCCESS) {
+        return http_server_send_response(connection, 500, "text/plain", "Failed to get listeners");
+    }
+    
+    // Create JSON response
+    json_t* json = json_array();
+    if (json == NULL) {
+        free(listeners);
+        return http_server_send_response(connection, 500, "text/plain", "Failed to create response");
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        json_t* listener_json = listener_to_json(listeners[i]);
+        if (listener_json != NULL) {
+            json_array_append_new(json, listener_json);
+        }
+    }
+    
+    free(listeners);
+    
+    // Send response
+    status = http_server_send_json_response(connection, 200, json);
+    
+    // Free JSON
+    json_decref(json);
+    
+    return status;
+}
+
+/**
+ * @brief Get admission limits and rejection counters API handler
+ */
+status_t api_admission_get(struct MHD_Connection* connection,
+                         const char* url, const char* method,
+                         const char* upload_data, size_t upload_data_size) {
+    admission_config_t config;
+    admission_stats_t stats;
+    
+    admission_get_config(&config);
+    admission_get_stats(&stats);
+    
+    // Create JSON response
+    json_t* json = json_object();
+    if (json == NULL) {
+        return http_server_send_response(connection, 500, "text/plain", "Failed to create response");
+    }
+    
+    json_object_set_new(json, "rate", json_integer(config.rate));
+    json_object_set_new(json, "burst", json_integer(config.burst));
+    json_object_set_new(json, "subnet_rate", json_integer(config.subnet_rate));
+    json_object_set_new(json, "subnet_burst", json_integer(config.subnet_burst));
+    json_object_set_new(json, "admitted", json_integer((json_int_t)stats.admitted));
+    json_object_set_new(json, "rejected_global", json_integer((json_int_t)stats.rejected_global));
+    json_object_set_new(json, "rejected_subnet", json_integer((json_int_t)stats.rejected_subnet));
+    json_object_set_new(json, "tracked_subnets", json_integer((json_int_t)stats.tracked_subnets));
+    
+    // Send response
+    status_t status = http_server_send_json_response(connection, 200, json);
+    
+    // Free JSON
+    json_decref(json);
+    
+    return status;
+}
+
+/**
+ * @brief Convert listener to JSON
+ */
+static json_t* listener_to_json(protocol_listener_t* listener) {
+    // Create JSON object
+    json_t* json = json_object();
+    if (json == NULL) {
+        return NULL;
+    }
+    
+    // Add listener ID
+    char id_str[37];
+    uuid_to_string(listener->id, id_str, sizeof(id_str));
+    json_object_set_new(json, "id", json_string(id_str));
+    
+    // Add protocol type
+    json_object_set_new(json, "type", json_string(protocol_type_name(listener->protocol_type)));
+    
+    // Add counters
+    json_t* stats_json = json_object();
+    protocol_stat_t stats[PROTOCOL_MAX_STATS];
+    size_t stat_count = PROTOCOL_MAX_STATS;
+    
+    if (stats_json != NULL && protocol_manager_get_stats(listener, stats, &stat_count) == STATUS_SUCCESS) {
+        for (size_t i = 0; i < stat_count; i++) {
+            json_object_set_new(stats_json, stats[i].name, json_integer((json_int_t)stats[i].value));
+        }
+    }
+    
+    json_object_set_new(json, "stats", stats_json != NULL ? stats_json : json_object());
+    
+    return json;
+}
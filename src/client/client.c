@@ -3,12 +3,15 @@
  * @brief Client management implementation for C2 server
  */
 
-#define _GNU_SOURCE /* For strdup */
+#define _GNU_SOURCE /* For strdup and clock_gettime */
 
 #include "../include/client.h"
 #include "../include/protocol.h"
 #include "../protocols/protocol_switch.h"
 #include "../common/uuid.h"
+#include "../common/epoch.h"
+#include "../common/logger.h"
+#include "../common/timing_wheel.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -19,61 +22,169 @@
 // Heartbeat magic number
 #define HEARTBEAT_MAGIC 0x48454152  // "HEAR"
 
-// Client list
-static client_t** clients = NULL;
-static size_t clients_count = 0;
-static pthread_mutex_t clients_mutex = PTHREAD_MUTEX_INITIALIZER;
+// Heartbeat wheel resolution, deadlines are whole seconds
+#define CLIENT_HEARTBEAT_TICK_MS 250
+
+// Registry stripes, a power of two
+#define CLIENT_REGISTRY_STRIPES 16
+
+// Initial bucket count of a stripe's table, a power of two
+#define CLIENT_TABLE_INITIAL_BUCKETS 64
+
+// Buckets moved to the new table by each registry operation while it grows
+#define CLIENT_TABLE_REHASH_STEP 4
+
+// Spare room in a new snapshot for clients registered while it is built
+#define CLIENT_SNAPSHOT_SLACK 64
+
+// Initial slot count of a stripe's hot table
+#define CLIENT_HOT_INITIAL_SLOTS 64
+
+// Registry hash table, buckets chained through client->registry_next
+typedef struct {
+    client_t** buckets;
+    size_t mask;                        // Bucket count - 1
+    size_t count;                       // Clients linked into this table
+} client_table_t;
+
+/**
+ * Hot fields of a stripe's clients, one dense slot per client.
+ *
+ * Stored column by column, so sweeps over state or last-seen times read
+ * contiguous memory instead of a cache line of client_t per client plus the
+ * heap strings hanging off it. client_t keeps its own copies for readers of
+ * a single client; every update writes both under the stripe lock. Removal
+ * moves the last slot into the hole, so the columns never have gaps.
+ */
+typedef struct {
+    time_t* last_seen;                  // Columns share one allocation
+    time_t* last_heartbeat;
+    client_t** owners;                  // Client in each slot
+    client_state_t* states;
+    size_t count;
+    size_t capacity;
+} client_hot_table_t;
+
+/**
+ * Registry stripe, keyed on the client UUID.
+ *
+ * Clients hash to one of CLIENT_REGISTRY_STRIPES stripes, each with its own
+ * lock guarding both its table and the mutable fields of its clients, so
+ * updates to clients in different stripes never contend.
+ *
+ * A stripe's table doubles once it averages one client per bucket. Clients
+ * move to the new table a few buckets per operation rather than all at once,
+ * so no single registration pays for rehashing the whole stripe. Growth
+ * finishes well before the new table fills, there are never more than two.
+ */
+typedef struct {
+    _Alignas(64) pthread_mutex_t mutex; // Own cache line, stripes are locked from every listener
+    client_table_t tables[2];           // [1] is the table being grown into
+    size_t rehash_index;                // Next bucket of tables[0] to move while growing
+    client_hot_table_t hot;             // Hot fields of the stripe's clients
+} client_stripe_t;
+
+static client_stripe_t client_stripes[CLIENT_REGISTRY_STRIPES] = {
+    [0 ... CLIENT_REGISTRY_STRIPES - 1] = { .mutex = PTHREAD_MUTEX_INITIALIZER }
+};
+static size_t clients_count = 0;        // Registered clients, updated atomically
+static uint64_t clients_version = 0;    // Bumped by every registration and removal
+
+// Latest enumeration snapshot, read under epoch protection and rebuilt once stale
+static client_snapshot_t* client_snapshot = NULL;
+static pthread_mutex_t client_snapshot_mutex = PTHREAD_MUTEX_INITIALIZER;  // Serializes rebuilds
 
 // Forward declarations
-static void* client_heartbeat_thread(void* arg);
+static void client_heartbeat_arm(client_t* client);
+static void client_heartbeat_expired(timing_wheel_timer_t* timer, void* arg);
+static uint64_t client_hash(const uuid_t id);
+static client_stripe_t* client_stripe(const uuid_t id);
+static status_t client_registry_insert(client_stripe_t* stripe, client_t* client);
+static client_t** client_registry_link(client_stripe_t* stripe, const uuid_t id, const client_t* client, client_table_t** table);
+static void client_registry_rehash_step(client_stripe_t* stripe, size_t steps);
+static void client_registry_foreach(client_table_t* tables, void (*visit)(client_t* client, void* arg), void* arg);
+static status_t client_hot_grow(client_hot_table_t* hot);
+static void client_hot_sync(client_stripe_t* stripe, client_t* client);
+static void client_hot_remove(client_hot_table_t* hot, client_t* client);
+static client_snapshot_t* client_snapshot_rebuild(void);
+static void client_free(void* ptr);
 
-// Heartbeat thread
-static pthread_t heartbeat_thread;
-static bool heartbeat_thread_running = false;
-static pthread_mutex_t heartbeat_mutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t heartbeat_cond = PTHREAD_COND_INITIALIZER;
+// Heartbeat deadlines of active clients, one timer each
+static timing_wheel_t* heartbeat_wheel = NULL;
 
 /**
  * @brief Initialize client manager
  */
 status_t client_manager_init(void) {
-    // Initialize client list
-    clients = NULL;
-    clients_count = 0;
+    // Initialize client registry
+    for (size_t i = 0; i < CLIENT_REGISTRY_STRIPES; i++) {
+        memset(client_stripes[i].tables, 0, sizeof(client_stripes[i].tables));
+        client_stripes[i].rehash_index = 0;
+    }
     
-    // Start heartbeat thread
-    heartbeat_thread_running = true;
-    if (pthread_create(&heartbeat_thread, NULL, &client_heartbeat_thread, NULL) != 0) {
-        return STATUS_ERROR;
+    __atomic_store_n(&clients_count, 0, __ATOMIC_RELAXED);
+    
+    // Start heartbeat wheel
+    timing_wheel_t* wheel = NULL;
+    status_t status = timing_wheel_create(CLIENT_HEARTBEAT_TICK_MS, true, &wheel);
+    if (status != STATUS_SUCCESS) {
+        return status;
     }
     
+    __atomic_store_n(&heartbeat_wheel, wheel, __ATOMIC_RELEASE);
+    
     return STATUS_SUCCESS;
 }
 
+/**
+ * @brief Destroy a client detached from the registry
+ */
+static void client_destroy_visit(client_t* client, void* arg) {
+    (void)arg;
+    client_destroy(client);
+}
+
 /**
  * @brief Shutdown client manager
  */
 status_t client_manager_shutdown(void) {
-    // Stop heartbeat thread
-    pthread_mutex_lock(&heartbeat_mutex);
-    heartbeat_thread_running = false;
-    pthread_cond_signal(&heartbeat_cond);
-    pthread_mutex_unlock(&heartbeat_mutex);
-    
-    pthread_join(heartbeat_thread, NULL);
+    // Stop heartbeat wheel, pending deadlines are dropped
+    timing_wheel_destroy(__atomic_exchange_n(&heartbeat_wheel, NULL, __ATOMIC_ACQ_REL));
+    
+    // Detach each stripe, client_destroy takes the stripe lock to unlink
+    for (size_t i = 0; i < CLIENT_REGISTRY_STRIPES; i++) {
+        client_stripe_t* stripe = &client_stripes[i];
+        client_table_t tables[2];
+        client_hot_table_t hot;
+        
+        pthread_mutex_lock(&stripe->mutex);
+        
+        memcpy(tables, stripe->tables, sizeof(tables));
+        memset(stripe->tables, 0, sizeof(stripe->tables));
+        stripe->rehash_index = 0;
+        hot = stripe->hot;
+        memset(&stripe->hot, 0, sizeof(client_hot_table_t));
+        
+        pthread_mutex_unlock(&stripe->mutex);
+        
+        // Destroy the stripe's clients
+        client_registry_foreach(tables, client_destroy_visit, NULL);
+        
+        free(tables[0].buckets);
+        free(tables[1].buckets);
+        free(hot.last_seen);
+    }
     
-    // Destroy all clients
-    pthread_mutex_lock(&clients_mutex);
+    __atomic_store_n(&clients_count, 0, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&clients_version, 1, __ATOMIC_RELEASE);
     
-    for (size_t i = 0; i < clients_count; i++) {
-        client_destroy(clients[i]);
+    // Readers may still hold the last snapshot
+    client_snapshot_t* snapshot = __atomic_exchange_n(&client_snapshot, NULL, __ATOMIC_ACQ_REL);
+    if (snapshot != NULL) {
+        epoch_retire(snapshot, free);
     }
     
-    free(clients);
-    clients = NULL;
-    clients_count = 0;
-    
-    pthread_mutex_unlock(&clients_mutex);
+    epoch_barrier();
     
     return STATUS_SUCCESS;
 }
@@ -100,6 +211,10 @@ status_t client_register(protocol_listener_t* listener, void* protocol_context,
     
     // Set initial state
     new_client->state = CLIENT_STATE_CONNECTED;
+    timing_wheel_timer_init(&new_client->heartbeat_timer, client_heartbeat_expired, new_client);
+    
+    // The caller's reference, dropped by client_destroy
+    new_client->refcount = 1;
     
     // Set protocol listener
     new_client->listener = listener;
@@ -114,21 +229,18 @@ status_t client_register(protocol_listener_t* listener, void* protocol_context,
     new_client->heartbeat_interval = 60;  // 1 minute
     new_client->heartbeat_jitter = 10;    // 10 seconds
     
-    // Add client to list
-    pthread_mutex_lock(&clients_mutex);
+    // Add client to registry
+    client_stripe_t* stripe = client_stripe(new_client->id);
+    
+    pthread_mutex_lock(&stripe->mutex);
     
-    client_t** new_clients = (client_t**)realloc(clients, (clients_count + 1) * sizeof(client_t*));
-    if (new_clients == NULL) {
-        pthread_mutex_unlock(&clients_mutex);
+    if (client_registry_insert(stripe, new_client) != STATUS_SUCCESS) {
+        pthread_mutex_unlock(&stripe->mutex);
         free(new_client);
         return STATUS_ERROR_MEMORY;
     }
     
-    clients = new_clients;
-    clients[clients_count] = new_client;
-    clients_count++;
-    
-    pthread_mutex_unlock(&clients_mutex);
+    pthread_mutex_unlock(&stripe->mutex);
     
     *client = new_client;
     
@@ -143,10 +255,20 @@ status_t client_update_state(client_t* client, client_state_t state) {
         return STATUS_ERROR_INVALID_PARAM;
     }
     
-    pthread_mutex_lock(&clients_mutex);
+    client_stripe_t* stripe = client_stripe(client->id);
+    
+    pthread_mutex_lock(&stripe->mutex);
+    bool activated = state == CLIENT_STATE_ACTIVE && client->state != CLIENT_STATE_ACTIVE;
     client->state = state;
     time(&client->last_seen_time);
-    pthread_mutex_unlock(&clients_mutex);
+    client_hot_sync(stripe, client);
+    
+    // Only active clients have a heartbeat deadline
+    if (activated) {
+        client_heartbeat_arm(client);
+    }
+    
+    pthread_mutex_unlock(&stripe->mutex);
     
     return STATUS_SUCCESS;
 }
@@ -159,17 +281,19 @@ status_t client_update_info(client_t* client, const char* hostname, const char*
         return STATUS_ERROR_INVALID_PARAM;
     }
     
-    pthread_mutex_lock(&clients_mutex);
+    client_stripe_t* stripe = client_stripe(client->id);
     
-    // Update hostname
+    pthread_mutex_lock(&stripe->mutex);
+    
+    // Update hostname, old strings wait out snapshot readers that may be printing them
     if (hostname != NULL) {
         if (client->hostname != NULL) {
-            free(client->hostname);
+            epoch_retire(client->hostname, free);
         }
         
         client->hostname = strdup(hostname);
         if (client->hostname == NULL) {
-            pthread_mutex_unlock(&clients_mutex);
+            pthread_mutex_unlock(&stripe->mutex);
             return STATUS_ERROR_MEMORY;
         }
     }
@@ -177,12 +301,12 @@ status_t client_update_info(client_t* client, const char* hostname, const char*
     // Update IP address
     if (ip_address != NULL) {
         if (client->ip_address != NULL) {
-            free(client->ip_address);
+            epoch_retire(client->ip_address, free);
         }
         
         client->ip_address = strdup(ip_address);
         if (client->ip_address == NULL) {
-            pthread_mutex_unlock(&clients_mutex);
+            pthread_mutex_unlock(&stripe->mutex);
             return STATUS_ERROR_MEMORY;
         }
     }
@@ -190,19 +314,20 @@ status_t client_update_info(client_t* client, const char* hostname, const char*
     // Update OS information
     if (os_info != NULL) {
         if (client->os_info != NULL) {
-            free(client->os_info);
+            epoch_retire(client->os_info, free);
         }
         
         client->os_info = strdup(os_info);
         if (client->os_info == NULL) {
-            pthread_mutex_unlock(&clients_mutex);
+            pthread_mutex_unlock(&stripe->mutex);
             return STATUS_ERROR_MEMORY;
         }
     }
     
     time(&client->last_seen_time);
+    client_hot_sync(stripe, client);
     
-    pthread_mutex_unlock(&clients_mutex);
+    pthread_mutex_unlock(&stripe->mutex);
     
     return STATUS_SUCCESS;
 }
@@ -224,10 +349,18 @@ status_t client_set_heartbeat(client_t* client, uint32_t interval, uint32_t jitt
         return STATUS_ERROR_INVALID_PARAM;
     }
     
-    pthread_mutex_lock(&clients_mutex);
+    client_stripe_t* stripe = client_stripe(client->id);
+    
+    pthread_mutex_lock(&stripe->mutex);
     client->heartbeat_interval = interval;
     client->heartbeat_jitter = jitter;
-    pthread_mutex_unlock(&clients_mutex);
+    
+    // A shorter interval brings the client's deadline forward
+    if (client->state == CLIENT_STATE_ACTIVE) {
+        client_heartbeat_arm(client);
+    }
+    
+    pthread_mutex_unlock(&stripe->mutex);
     
     return STATUS_SUCCESS;
 }
@@ -240,16 +373,40 @@ status_t client_heartbeat(client_t* client) {
         return STATUS_ERROR_INVALID_PARAM;
     }
     
-    pthread_mutex_lock(&clients_mutex);
+    client_stripe_t* stripe = client_stripe(client->id);
+    
+    pthread_mutex_lock(&stripe->mutex);
     time(&client->last_heartbeat);
     time(&client->last_seen_time);
     
-    // Update state if needed
+    // Update state if needed. An armed deadline is left alone, it only moved
+    // later and the expiry rechecks it.
     if (client->state == CLIENT_STATE_INACTIVE) {
         client->state = CLIENT_STATE_ACTIVE;
+        client_heartbeat_arm(client);
     }
     
-    pthread_mutex_unlock(&clients_mutex);
+    client_hot_sync(stripe, client);
+    
+    pthread_mutex_unlock(&stripe->mutex);
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Record that a client was just seen
+ */
+status_t client_touch(client_t* client) {
+    if (client == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    client_stripe_t* stripe = client_stripe(client->id);
+    
+    pthread_mutex_lock(&stripe->mutex);
+    time(&client->last_seen_time);
+    client_hot_sync(stripe, client);
+    pthread_mutex_unlock(&stripe->mutex);
     
     return STATUS_SUCCESS;
 }
@@ -367,18 +524,28 @@ client_t* client_find(const uuid_t* id) {
         return NULL;
     }
     
-    pthread_mutex_lock(&clients_mutex);
+    client_stripe_t* stripe = client_stripe(*id);
     
-    for (size_t i = 0; i < clients_count; i++) {
-        if (uuid_compare_wrapper(clients[i]->id, *id) == 0) {
-            pthread_mutex_unlock(&clients_mutex);
-            return clients[i];
-        }
-    }
+    pthread_mutex_lock(&stripe->mutex);
     
-    pthread_mutex_unlock(&clients_mutex);
+    client_registry_rehash_step(stripe, CLIENT_TABLE_REHASH_STEP);
     
-    return NULL;
+    client_t** link = client_registry_link(stripe, *id, NULL, NULL);
+    client_t* client = link != NULL ? client_acquire(*link) : NULL;
+    
+    pthread_mutex_unlock(&stripe->mutex);
+    
+    return client;
+}
+
+/**
+ * @brief Append a client to a client_get_all snapshot
+ */
+static void client_collect(client_t* client, void* arg) {
+    client_t*** cursor = (client_t***)arg;
+    
+    **cursor = client;
+    (*cursor)++;
 }
 
 /**
@@ -389,29 +556,191 @@ status_t client_get_all(client_t*** clients_out, size_t* count) {
         return STATUS_ERROR_INVALID_PARAM;
     }
     
-    pthread_mutex_lock(&clients_mutex);
+    const client_snapshot_t* snapshot = client_snapshot_acquire();
+    if (snapshot == NULL) {
+        return STATUS_ERROR_MEMORY;
+    }
     
-    // Create copy of clients array
+    // Copy the snapshot, taking a reference to each client still alive
     client_t** clients_copy = NULL;
+    size_t copied = 0;
     
-    if (clients_count > 0) {
-        clients_copy = (client_t**)malloc(clients_count * sizeof(client_t*));
+    if (snapshot->count > 0) {
+        clients_copy = (client_t**)malloc(snapshot->count * sizeof(client_t*));
         if (clients_copy == NULL) {
-            pthread_mutex_unlock(&clients_mutex);
+            client_snapshot_release(snapshot);
             return STATUS_ERROR_MEMORY;
         }
         
-        memcpy(clients_copy, clients, clients_count * sizeof(client_t*));
+        for (size_t i = 0; i < snapshot->count; i++) {
+            if (client_acquire(snapshot->clients[i]) != NULL) {
+                clients_copy[copied++] = snapshot->clients[i];
+            }
+        }
     }
     
     *clients_out = clients_copy;
-    *count = clients_count;
+    *count = copied;
     
-    pthread_mutex_unlock(&clients_mutex);
+    client_snapshot_release(snapshot);
     
     return STATUS_SUCCESS;
 }
 
+/**
+ * @brief Count registered clients in each state
+ */
+void client_count_states(size_t counts[CLIENT_STATE_COUNT]) {
+    if (counts == NULL) {
+        return;
+    }
+    
+    memset(counts, 0, CLIENT_STATE_COUNT * sizeof(size_t));
+    
+    for (size_t i = 0; i < CLIENT_REGISTRY_STRIPES; i++) {
+        client_stripe_t* stripe = &client_stripes[i];
+        
+        pthread_mutex_lock(&stripe->mutex);
+        
+        for (size_t slot = 0; slot < stripe->hot.count; slot++) {
+            client_state_t state = stripe->hot.states[slot];
+            
+            if ((size_t)state < CLIENT_STATE_COUNT) {
+                counts[state]++;
+            }
+        }
+        
+        pthread_mutex_unlock(&stripe->mutex);
+    }
+}
+
+/**
+ * @brief Get registered clients not seen since a given time
+ */
+status_t client_get_idle(time_t since, client_t*** clients_out, size_t* count) {
+    if (clients_out == NULL || count == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    client_t** idle = NULL;
+    size_t found = 0;
+    size_t capacity = 0;
+    
+    for (size_t i = 0; i < CLIENT_REGISTRY_STRIPES; i++) {
+        client_stripe_t* stripe = &client_stripes[i];
+        bool failed = false;
+        
+        pthread_mutex_lock(&stripe->mutex);
+        
+        // Only the last-seen column is read, owners just for the matches
+        for (size_t slot = 0; slot < stripe->hot.count; slot++) {
+            if (stripe->hot.last_seen[slot] >= since) {
+                continue;
+            }
+            
+            if (found == capacity) {
+                size_t grown_capacity = capacity > 0 ? capacity * 2 : CLIENT_HOT_INITIAL_SLOTS;
+                client_t** grown = (client_t**)realloc(idle, grown_capacity * sizeof(client_t*));
+                if (grown == NULL) {
+                    failed = true;
+                    break;
+                }
+                
+                idle = grown;
+                capacity = grown_capacity;
+            }
+            
+            // Registered clients still hold their first reference
+            if (client_acquire(stripe->hot.owners[slot]) != NULL) {
+                idle[found++] = stripe->hot.owners[slot];
+            }
+        }
+        
+        pthread_mutex_unlock(&stripe->mutex);
+        
+        if (failed) {
+            for (size_t j = 0; j < found; j++) {
+                client_release(idle[j]);
+            }
+            
+            free(idle);
+            return STATUS_ERROR_MEMORY;
+        }
+    }
+    
+    *clients_out = idle;
+    *count = found;
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Get a read-only snapshot of all clients
+ */
+const client_snapshot_t* client_snapshot_acquire(void) {
+    if (epoch_enter() != STATUS_SUCCESS) {
+        return NULL;
+    }
+    
+    client_snapshot_t* snapshot = __atomic_load_n(&client_snapshot, __ATOMIC_ACQUIRE);
+    
+    // Any registration or removal since it was built makes it stale, the first reader to notice rebuilds it
+    if (snapshot == NULL || snapshot->version != __atomic_load_n(&clients_version, __ATOMIC_ACQUIRE)) {
+        snapshot = client_snapshot_rebuild();
+        if (snapshot == NULL) {
+            epoch_exit();
+            return NULL;
+        }
+    }
+    
+    return snapshot;
+}
+
+/**
+ * @brief Release a snapshot from client_snapshot_acquire
+ */
+void client_snapshot_release(const client_snapshot_t* snapshot) {
+    if (snapshot != NULL) {
+        epoch_exit();
+    }
+}
+
+
+/**
+ * @brief Take a reference to a client
+ */
+client_t* client_acquire(client_t* client) {
+    if (client == NULL) {
+        return NULL;
+    }
+    
+    uint32_t refs = __atomic_load_n(&client->refcount, __ATOMIC_RELAXED);
+    
+    // Never revive a client whose last reference is gone, it is only waiting out readers
+    do {
+        if (refs == 0) {
+            return NULL;
+        }
+    } while (!__atomic_compare_exchange_n(&client->refcount, &refs, refs + 1, true,
+                                          __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+    
+    return client;
+}
+
+/**
+ * @brief Drop a reference to a client
+ */
+void client_release(client_t* client) {
+    if (client == NULL) {
+        return;
+    }
+    
+    // Snapshot readers hold no reference, so the last one out defers the free past them
+    if (__atomic_sub_fetch(&client->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+        epoch_retire(client, client_free);
+    }
+}
+
 /**
  * @brief Destroy a client
  */
@@ -420,6 +749,41 @@ status_t client_destroy(client_t* client) {
         return STATUS_ERROR_INVALID_PARAM;
     }
     
+    // Unlink from the registry, unless shutdown already detached it
+    client_stripe_t* stripe = client_stripe(client->id);
+    
+    pthread_mutex_lock(&stripe->mutex);
+    
+    client_table_t* table = NULL;
+    client_t** link = client_registry_link(stripe, client->id, client, &table);
+    
+    if (link != NULL) {
+        *link = client->registry_next;
+        table->count--;
+        client_hot_remove(&stripe->hot, client);
+        __atomic_sub_fetch(&clients_count, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&clients_version, 1, __ATOMIC_RELEASE);
+    }
+    
+    // Nothing arms the heartbeat timer once unregistered, so after the cancel it stays idle
+    client->registered = false;
+    
+    pthread_mutex_unlock(&stripe->mutex);
+    
+    timing_wheel_cancel(__atomic_load_n(&heartbeat_wheel, __ATOMIC_ACQUIRE), &client->heartbeat_timer);
+    
+    // Other holders keep it alive until they release it
+    client_release(client);
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Free a client once its last reference is gone and no reader can see it
+ */
+static void client_free(void* ptr) {
+    client_t* client = (client_t*)ptr;
+    
     // Free hostname
     if (client->hostname != NULL) {
         free(client->hostname);
@@ -442,8 +806,6 @@ status_t client_destroy(client_t* client) {
     
     // Free client
     free(client);
-    
-    return STATUS_SUCCESS;
 }
 
 /**
@@ -472,56 +834,394 @@ status_t client_send_heartbeat_request(client_t* client) {
 }
 
 /**
- * @brief Heartbeat timeout thread function
+ * @brief Schedule a client's heartbeat timer for its deadline (stripe lock held)
  */
-static void* client_heartbeat_thread(void* arg) {
-    struct timespec ts;
+static void client_heartbeat_arm(client_t* client) {
+    timing_wheel_t* wheel = __atomic_load_n(&heartbeat_wheel, __ATOMIC_ACQUIRE);
+    
+    if (wheel == NULL || !client->registered) {
+        return;
+    }
+    
+    // The deadline is on the wall clock like last_heartbeat, the wheel takes a delay
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    
+    int64_t now_ms = (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+    int64_t deadline_ms = ((int64_t)client->last_heartbeat + client->heartbeat_interval +
+                           client->heartbeat_jitter + 1) * 1000;
     
-    while (true) {
-        // Wait for condition or timeout
-        pthread_mutex_lock(&heartbeat_mutex);
+    timing_wheel_schedule(wheel, &client->heartbeat_timer, deadline_ms > now_ms ? (uint64_t)(deadline_ms - now_ms) : 0);
+}
+
+/**
+ * @brief Heartbeat timer expiry, on the wheel thread
+ * 
+ * Heartbeats do not touch the timer, so the deadline may have moved on
+ * since it was armed: rearm for the new one, otherwise mark the client
+ * inactive and ask it for a heartbeat outside the stripe lock.
+ */
+static void client_heartbeat_expired(timing_wheel_timer_t* timer, void* arg) {
+    (void)timer;
+    client_stripe_t* stripe = client_stripe(((client_t*)arg)->id);
+    bool timed_out = false;
+    
+    // client_destroy waits for other threads' callbacks, not one destroying from here
+    client_t* client = client_acquire((client_t*)arg);
+    if (client == NULL) {
+        return;
+    }
+    
+    pthread_mutex_lock(&stripe->mutex);
+    
+    if (client->registered && client->state == CLIENT_STATE_ACTIVE) {
+        if (client_is_heartbeat_timeout(client)) {
+            client->state = CLIENT_STATE_INACTIVE;
+            client_hot_sync(stripe, client);
+            timed_out = true;
+        } else {
+            client_heartbeat_arm(client);
+        }
+    }
+    
+    pthread_mutex_unlock(&stripe->mutex);
+    
+    if (timed_out) {
+        char id_str[37];
+        uuid_to_string(client->id, id_str, sizeof(id_str));
+        LOG_WARN("Client %s missed its heartbeat, marked inactive", id_str);
         
-        if (!heartbeat_thread_running) {
-            pthread_mutex_unlock(&heartbeat_mutex);
-            break;
+        // Try to send a heartbeat request to the client
+        client_send_heartbeat_request(client);
+    }
+    
+    client_release(client);
+}
+
+/**
+ * @brief Hash a client UUID (splitmix64 finaliser over both halves)
+ *
+ * The low bits pick the bucket and the high bits the stripe.
+ */
+static uint64_t client_hash(const uuid_t id) {
+    uint64_t high;
+    uint64_t low;
+    
+    memcpy(&high, id, sizeof(high));
+    memcpy(&low, id + sizeof(high), sizeof(low));
+    
+    uint64_t x = high ^ (low * 0x9e3779b97f4a7c15ULL);
+    
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    
+    return x;
+}
+
+/**
+ * @brief Stripe a client ID belongs to
+ */
+static client_stripe_t* client_stripe(const uuid_t id) {
+    return &client_stripes[(client_hash(id) >> 32) & (CLIENT_REGISTRY_STRIPES - 1)];
+}
+
+/**
+ * @brief Allocate an empty table
+ */
+static status_t client_table_init(client_table_t* table, size_t buckets) {
+    table->buckets = (client_t**)calloc(buckets, sizeof(client_t*));
+    if (table->buckets == NULL) {
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    table->mask = buckets - 1;
+    table->count = 0;
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Push a client onto its bucket in a table
+ */
+static void client_table_link(client_table_t* table, client_t* client) {
+    client_t** bucket = &table->buckets[client_hash(client->id) & table->mask];
+    
+    client->registry_next = *bucket;
+    *bucket = client;
+    table->count++;
+}
+
+/**
+ * @brief Add a client to its stripe (stripe lock held)
+ */
+static status_t client_registry_insert(client_stripe_t* stripe, client_t* client) {
+    if (stripe->tables[0].buckets == NULL &&
+        client_table_init(&stripe->tables[0], CLIENT_TABLE_INITIAL_BUCKETS) != STATUS_SUCCESS) {
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    if (stripe->hot.count == stripe->hot.capacity && client_hot_grow(&stripe->hot) != STATUS_SUCCESS) {
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    client_registry_rehash_step(stripe, CLIENT_TABLE_REHASH_STEP);
+    
+    // Start growing at one client per bucket. If the larger table cannot be
+    // allocated the chains just get longer and growth is retried next time.
+    if (stripe->tables[1].buckets == NULL && stripe->tables[0].count > stripe->tables[0].mask) {
+        if (client_table_init(&stripe->tables[1], (stripe->tables[0].mask + 1) * 2) == STATUS_SUCCESS) {
+            stripe->rehash_index = 0;
+        }
+    }
+    
+    // New clients go straight to the table being grown into
+    client_table_link(stripe->tables[1].buckets != NULL ? &stripe->tables[1] : &stripe->tables[0], client);
+    client->registered = true;
+    
+    client->hot_slot = stripe->hot.count++;
+    stripe->hot.owners[client->hot_slot] = client;
+    client_hot_sync(stripe, client);
+    
+    __atomic_add_fetch(&clients_count, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&clients_version, 1, __ATOMIC_RELEASE);
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Find the link pointing at a registered client (stripe lock held)
+ *
+ * IDs are only unique once the UUID generator is initialized, so removal
+ * looks for the client itself rather than the first one with its ID.
+ *
+ * @param stripe Stripe the ID hashes to
+ * @param id Client ID
+ * @param client Client to find, NULL for any client with the ID
+ * @param table Output table holding the client, may be NULL
+ * @return client_t** Link to the client, NULL if not registered
+ */
+static client_t** client_registry_link(client_stripe_t* stripe, const uuid_t id, const client_t* client, client_table_t** table) {
+    uint64_t hash = client_hash(id);
+    
+    // Buckets already moved out of the old table are empty, so checking both is cheap
+    for (size_t i = 0; i < 2; i++) {
+        if (stripe->tables[i].buckets == NULL) {
+            continue;
         }
         
-        // Wait for 10 seconds
-        clock_gettime(CLOCK_REALTIME, &ts);
-        ts.tv_sec += 10;
+        client_t** link = &stripe->tables[i].buckets[hash & stripe->tables[i].mask];
         
-        pthread_cond_timedwait(&heartbeat_cond, &heartbeat_mutex, &ts);
+        for (; *link != NULL; link = &(*link)->registry_next) {
+            if (client != NULL ? *link == client : uuid_compare_wrapper((*link)->id, id) == 0) {
+                if (table != NULL) {
+                    *table = &stripe->tables[i];
+                }
+                return link;
+            }
+        }
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief Move a few buckets to the new table while a stripe grows (stripe lock held)
+ *
+ * @param stripe Stripe
+ * @param steps Buckets of the old table to move
+ */
+static void client_registry_rehash_step(client_stripe_t* stripe, size_t steps) {
+    client_table_t* old_table = &stripe->tables[0];
+    client_table_t* new_table = &stripe->tables[1];
+    
+    if (new_table->buckets == NULL) {
+        return;
+    }
+    
+    for (; steps > 0 && stripe->rehash_index <= old_table->mask; steps--, stripe->rehash_index++) {
+        client_t* client = old_table->buckets[stripe->rehash_index];
+        old_table->buckets[stripe->rehash_index] = NULL;
         
-        if (!heartbeat_thread_running) {
-            pthread_mutex_unlock(&heartbeat_mutex);
-            break;
+        while (client != NULL) {
+            client_t* next = client->registry_next;
+            client_table_link(new_table, client);
+            old_table->count--;
+            client = next;
         }
+    }
+    
+    // Old table drained, the new one takes its place
+    if (stripe->rehash_index > old_table->mask) {
+        free(old_table->buckets);
+        *old_table = *new_table;
+        memset(new_table, 0, sizeof(client_table_t));
+        stripe->rehash_index = 0;
+    }
+}
+
+/**
+ * @brief Visit every client in a stripe's tables
+ *
+ * The visitor may free the client but must not otherwise change the registry.
+ *
+ * @param tables Stripe tables with the stripe lock held, or a detached copy
+ * @param visit Visitor
+ * @param arg Visitor argument
+ */
+static void client_registry_foreach(client_table_t* tables, void (*visit)(client_t* client, void* arg), void* arg) {
+    for (size_t i = 0; i < 2; i++) {
+        if (tables[i].buckets == NULL) {
+            continue;
+        }
+        
+        for (size_t bucket = 0; bucket <= tables[i].mask; bucket++) {
+            client_t* client = tables[i].buckets[bucket];
+            
+            while (client != NULL) {
+                client_t* next = client->registry_next;
+                visit(client, arg);
+                client = next;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Double a hot table's capacity (stripe lock held)
+ */
+static status_t client_hot_grow(client_hot_table_t* hot) {
+    size_t capacity = hot->capacity > 0 ? hot->capacity * 2 : CLIENT_HOT_INITIAL_SLOTS;
+    
+    // Widest columns first, so each one starts aligned
+    uint8_t* block = (uint8_t*)malloc(capacity * (2 * sizeof(time_t) + sizeof(client_t*) + sizeof(client_state_t)));
+    if (block == NULL) {
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    client_hot_table_t grown = {
+        .last_seen = (time_t*)block,
+        .last_heartbeat = (time_t*)(block + capacity * sizeof(time_t)),
+        .owners = (client_t**)(block + capacity * 2 * sizeof(time_t)),
+        .states = (client_state_t*)(block + capacity * (2 * sizeof(time_t) + sizeof(client_t*))),
+        .count = hot->count,
+        .capacity = capacity
+    };
+    
+    if (hot->count > 0) {
+        memcpy(grown.last_seen, hot->last_seen, hot->count * sizeof(time_t));
+        memcpy(grown.last_heartbeat, hot->last_heartbeat, hot->count * sizeof(time_t));
+        memcpy(grown.owners, hot->owners, hot->count * sizeof(client_t*));
+        memcpy(grown.states, hot->states, hot->count * sizeof(client_state_t));
+    }
+    
+    free(hot->last_seen);
+    *hot = grown;
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Copy a client's hot fields into its slot (stripe lock held)
+ */
+static void client_hot_sync(client_stripe_t* stripe, client_t* client) {
+    client_hot_table_t* hot = &stripe->hot;
+    size_t slot = client->hot_slot;
+    
+    // Shutdown detaches the table before destroying its clients
+    if (slot >= hot->count || hot->owners[slot] != client) {
+        return;
+    }
+    
+    hot->last_seen[slot] = client->last_seen_time;
+    hot->last_heartbeat[slot] = client->last_heartbeat;
+    hot->states[slot] = client->state;
+}
+
+/**
+ * @brief Free a client's slot by moving the last slot into it (stripe lock held)
+ */
+static void client_hot_remove(client_hot_table_t* hot, client_t* client) {
+    size_t slot = client->hot_slot;
+    size_t last = --hot->count;
+    
+    if (slot != last) {
+        hot->last_seen[slot] = hot->last_seen[last];
+        hot->last_heartbeat[slot] = hot->last_heartbeat[last];
+        hot->states[slot] = hot->states[last];
+        hot->owners[slot] = hot->owners[last];
+        hot->owners[slot]->hot_slot = slot;
+    }
+}
+
+/**
+ * @brief Build and publish a fresh snapshot (inside an epoch read section)
+ *
+ * Stripes are copied one at a time, so registrations stall for at most one
+ * stripe's worth of copying. Changes made meanwhile leave the new snapshot
+ * stale and the next reader rebuilds it.
+ *
+ * @return client_snapshot_t* Published snapshot, NULL if out of memory
+ */
+static client_snapshot_t* client_snapshot_rebuild(void) {
+    pthread_mutex_lock(&client_snapshot_mutex);
+    
+    // Another reader may have rebuilt it while this one waited
+    uint64_t version = __atomic_load_n(&clients_version, __ATOMIC_ACQUIRE);
+    client_snapshot_t* current = __atomic_load_n(&client_snapshot, __ATOMIC_ACQUIRE);
+    
+    if (current != NULL && current->version == version) {
+        pthread_mutex_unlock(&client_snapshot_mutex);
+        return current;
+    }
+    
+    size_t capacity = __atomic_load_n(&clients_count, __ATOMIC_RELAXED) + CLIENT_SNAPSHOT_SLACK;
+    client_snapshot_t* snapshot = (client_snapshot_t*)malloc(sizeof(client_snapshot_t) + capacity * sizeof(client_t*));
+    if (snapshot == NULL) {
+        pthread_mutex_unlock(&client_snapshot_mutex);
+        return NULL;
+    }
+    
+    memset(snapshot, 0, sizeof(client_snapshot_t));
+    snapshot->version = version;
+    
+    for (size_t i = 0; i < CLIENT_REGISTRY_STRIPES; i++) {
+        client_stripe_t* stripe = &client_stripes[i];
         
-        pthread_mutex_unlock(&heartbeat_mutex);
+        pthread_mutex_lock(&stripe->mutex);
         
-        // Check all clients for heartbeat timeout
-        pthread_mutex_lock(&clients_mutex);
+        size_t needed = snapshot->count + stripe->tables[0].count + stripe->tables[1].count;
         
-        for (size_t i = 0; i < clients_count; i++) {
-            if (clients[i]->state == CLIENT_STATE_ACTIVE && client_is_heartbeat_timeout(clients[i])) {
-                // Update client state
-                clients[i]->state = CLIENT_STATE_INACTIVE;
-                
-                // Log the event
-                // We need to implement uuid_to_string in uuid.c
-                fprintf(stderr, "Client heartbeat timeout\n");
-                
-                // Notify protocol listener if available
-                // Use protocol_manager_register_callbacks to register callbacks
-                // This is a placeholder for now
-                
-                // Try to send a heartbeat request to the client
-                client_send_heartbeat_request(clients[i]);
+        if (needed > capacity) {
+            capacity = needed * 2;
+            client_snapshot_t* grown = (client_snapshot_t*)realloc(snapshot, sizeof(client_snapshot_t) + capacity * sizeof(client_t*));
+            if (grown == NULL) {
+                pthread_mutex_unlock(&stripe->mutex);
+                pthread_mutex_unlock(&client_snapshot_mutex);
+                free(snapshot);
+                return NULL;
             }
+            
+            snapshot = grown;
         }
         
-        pthread_mutex_unlock(&clients_mutex);
+        client_t** cursor = snapshot->clients + snapshot->count;
+        client_registry_foreach(stripe->tables, client_collect, &cursor);
+        snapshot->count = (size_t)(cursor - snapshot->clients);
+        
+        pthread_mutex_unlock(&stripe->mutex);
     }
     
-    return NULL;
+    __atomic_store_n(&client_snapshot, snapshot, __ATOMIC_RELEASE);
+    
+    pthread_mutex_unlock(&client_snapshot_mutex);
+    
+    // Readers of the old one keep it until they release it
+    if (current != NULL) {
+        epoch_retire(current, free);
+    }
+    
+    return snapshot;
 }
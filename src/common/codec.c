@@ -0,0 +1,426 @@
+/**
+ * @file codec.c
+ * @brief Hex and base32 codecs for text-only transports
+ *
+ * The hex kernels handle 16 (SSE2) or 32 (AVX2) input bytes per step and
+ * finish the tail with the scalar loop. AVX2 is compiled per function and
+ * picked at run time, so the build needs no extra flags.
+ */
+
+#include "codec.h"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CODEC_X86 1
+#include <immintrin.h>
+#endif
+
+// Hex digits
+static const char hex_digits[] = "0123456789abcdef";
+
+// Base32 alphabet (RFC 4648, lowercase)
+static const char base32_alphabet[] = "abcdefghijklmnopqrstuvwxyz234567";
+
+// Forward declarations
+static int hex_value(char c);
+static int base32_value(char c);
+
+#ifdef CODEC_X86
+static size_t hex_encode_sse2(const uint8_t* data, size_t data_len, char* output);
+static size_t hex_decode_sse2(const char* input, size_t input_len, uint8_t* output, bool* valid);
+static size_t hex_encode_avx2(const uint8_t* data, size_t data_len, char* output);
+static size_t hex_decode_avx2(const char* input, size_t input_len, uint8_t* output, bool* valid);
+
+/**
+ * @brief Check for AVX2 at run time
+ */
+static bool codec_has_avx2(void) {
+    return __builtin_cpu_supports("avx2");
+}
+#endif
+
+/**
+ * @brief Encode binary data as lowercase hex
+ */
+size_t codec_hex_encode(const uint8_t* data, size_t data_len, char* output) {
+    size_t done = 0;
+
+#ifdef CODEC_X86
+    if (data_len >= 32 && codec_has_avx2()) {
+        done = hex_encode_avx2(data, data_len, output);
+    } else if (data_len >= 16) {
+        done = hex_encode_sse2(data, data_len, output);
+    }
+#endif
+    
+    codec_hex_encode_scalar(data + done, data_len - done, output + done * 2);
+    
+    return data_len * 2;
+}
+
+/**
+ * @brief Decode hex in either case
+ */
+status_t codec_hex_decode(const char* input, size_t input_len, uint8_t* output, size_t* output_len) {
+    if (input_len % 2 != 0) {
+        return STATUS_ERROR_INVALID_FORMAT;
+    }
+    
+    size_t done = 0;
+
+#ifdef CODEC_X86
+    bool valid = true;
+    
+    if (input_len >= 64 && codec_has_avx2()) {
+        done = hex_decode_avx2(input, input_len, output, &valid);
+    } else if (input_len >= 32) {
+        done = hex_decode_sse2(input, input_len, output, &valid);
+    }
+    
+    if (!valid) {
+        return STATUS_ERROR_INVALID_FORMAT;
+    }
+#endif
+    
+    size_t tail_len = 0;
+    status_t status = codec_hex_decode_scalar(input + done * 2, input_len - done * 2, output + done, &tail_len);
+    if (status != STATUS_SUCCESS) {
+        return status;
+    }
+    
+    *output_len = done + tail_len;
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Scalar hex encoder
+ */
+size_t codec_hex_encode_scalar(const uint8_t* data, size_t data_len, char* output) {
+    for (size_t i = 0; i < data_len; i++) {
+        output[i * 2] = hex_digits[data[i] >> 4];
+        output[i * 2 + 1] = hex_digits[data[i] & 0x0F];
+    }
+    
+    return data_len * 2;
+}
+
+/**
+ * @brief Scalar hex decoder
+ */
+status_t codec_hex_decode_scalar(const char* input, size_t input_len, uint8_t* output, size_t* output_len) {
+    if (input_len % 2 != 0) {
+        return STATUS_ERROR_INVALID_FORMAT;
+    }
+    
+    for (size_t i = 0; i < input_len; i += 2) {
+        int high = hex_value(input[i]);
+        int low = hex_value(input[i + 1]);
+        
+        if (high < 0 || low < 0) {
+            return STATUS_ERROR_INVALID_FORMAT;
+        }
+        
+        output[i / 2] = (uint8_t)((high << 4) | low);
+    }
+    
+    *output_len = input_len / 2;
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Encode binary data as unpadded lowercase base32
+ */
+size_t codec_base32_encode(const uint8_t* data, size_t data_len, char* output) {
+    size_t out = 0;
+    size_t i = 0;
+    
+    // Whole 5 byte groups, 8 characters each
+    for (; i + 5 <= data_len; i += 5) {
+        uint64_t bits = ((uint64_t)data[i] << 32) | ((uint64_t)data[i + 1] << 24) |
+                        ((uint64_t)data[i + 2] << 16) | ((uint64_t)data[i + 3] << 8) | data[i + 4];
+        
+        for (int shift = 35; shift >= 0; shift -= 5) {
+            output[out++] = base32_alphabet[(bits >> shift) & 0x1F];
+        }
+    }
+    
+    // Remaining bytes, the last character padded with zero bits
+    uint32_t buffer = 0;
+    int bits = 0;
+    
+    for (; i < data_len; i++) {
+        buffer = (buffer << 8) | data[i];
+        bits += 8;
+        
+        while (bits >= 5) {
+            bits -= 5;
+            output[out++] = base32_alphabet[(buffer >> bits) & 0x1F];
+        }
+    }
+    
+    if (bits > 0) {
+        output[out++] = base32_alphabet[(buffer << (5 - bits)) & 0x1F];
+    }
+    
+    return out;
+}
+
+/**
+ * @brief Decode unpadded base32 in either case
+ */
+status_t codec_base32_decode(const char* input, size_t input_len, uint8_t* output, size_t* output_len) {
+    // A trailing group of 1, 3 or 6 characters cannot come from whole bytes
+    size_t tail = input_len % 8;
+    if (tail == 1 || tail == 3 || tail == 6) {
+        return STATUS_ERROR_INVALID_FORMAT;
+    }
+    
+    size_t out = 0;
+    size_t i = 0;
+    
+    // Whole 8 character groups, 5 bytes each
+    for (; i + 8 <= input_len; i += 8) {
+        uint64_t bits = 0;
+        
+        for (size_t j = 0; j < 8; j++) {
+            int value = base32_value(input[i + j]);
+            if (value < 0) {
+                return STATUS_ERROR_INVALID_FORMAT;
+            }
+            bits = (bits << 5) | (uint64_t)value;
+        }
+        
+        output[out++] = (uint8_t)(bits >> 32);
+        output[out++] = (uint8_t)(bits >> 24);
+        output[out++] = (uint8_t)(bits >> 16);
+        output[out++] = (uint8_t)(bits >> 8);
+        output[out++] = (uint8_t)bits;
+    }
+    
+    // Remaining characters
+    uint32_t buffer = 0;
+    int bits = 0;
+    
+    for (; i < input_len; i++) {
+        int value = base32_value(input[i]);
+        if (value < 0) {
+            return STATUS_ERROR_INVALID_FORMAT;
+        }
+        
+        buffer = (buffer << 5) | (uint32_t)value;
+        bits += 5;
+        
+        if (bits >= 8) {
+            bits -= 8;
+            output[out++] = (uint8_t)(buffer >> bits);
+        }
+    }
+    
+    // Padding bits must be zero so every byte string has one encoding
+    if (bits > 0 && (buffer & ((1u << bits) - 1)) != 0) {
+        return STATUS_ERROR_INVALID_FORMAT;
+    }
+    
+    *output_len = out;
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Name of the hex kernel in use
+ */
+const char* codec_simd_level(void) {
+#ifdef CODEC_X86
+    return codec_has_avx2() ? "avx2" : "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+/**
+ * @brief Value of a hex digit, or -1
+ */
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/**
+ * @brief Value of a base32 digit, or -1
+ */
+static int base32_value(char c) {
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a';
+    }
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A';
+    }
+    if (c >= '2' && c <= '7') {
+        return c - '2' + 26;
+    }
+    return -1;
+}
+
+#ifdef CODEC_X86
+
+/**
+ * @brief Map 16 nibbles to hex digits: n + '0', plus 39 more for 10..15
+ */
+static inline __m128i hex_digits_sse2(__m128i nibbles) {
+    __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8('a' - '0' - 10));
+    return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+}
+
+/**
+ * @brief Map 16 hex digits to nibbles, accumulating invalid lanes
+ */
+static inline __m128i hex_nibbles_sse2(__m128i chars, __m128i* invalid) {
+    __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+    
+    __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)),
+                                     _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), chars));
+    __m128i is_letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                      _mm_cmpgt_epi8(_mm_set1_epi8('f' + 1), lower));
+    
+    *invalid = _mm_or_si128(*invalid, _mm_andnot_si128(_mm_or_si128(is_digit, is_letter), _mm_set1_epi8(-1)));
+    
+    return _mm_or_si128(_mm_and_si128(is_digit, _mm_sub_epi8(chars, _mm_set1_epi8('0'))),
+                        _mm_and_si128(is_letter, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+}
+
+/**
+ * @brief SSE2 hex encoder, 16 bytes per step
+ *
+ * @return size_t Number of input bytes encoded
+ */
+static size_t hex_encode_sse2(const uint8_t* data, size_t data_len, char* output) {
+    size_t i = 0;
+    
+    for (; i + 16 <= data_len; i += 16) {
+        __m128i in = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i high = hex_digits_sse2(_mm_and_si128(_mm_srli_epi16(in, 4), _mm_set1_epi8(0x0F)));
+        __m128i low = hex_digits_sse2(_mm_and_si128(in, _mm_set1_epi8(0x0F)));
+        
+        // Interleave so each byte becomes its high digit then its low digit
+        _mm_storeu_si128((__m128i*)(output + i * 2), _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128((__m128i*)(output + i * 2 + 16), _mm_unpackhi_epi8(high, low));
+    }
+    
+    return i;
+}
+
+/**
+ * @brief SSE2 hex decoder, 32 characters per step
+ *
+ * @return size_t Number of bytes decoded
+ */
+static size_t hex_decode_sse2(const char* input, size_t input_len, uint8_t* output, bool* valid) {
+    __m128i invalid = _mm_setzero_si128();
+    size_t i = 0;
+    
+    for (; i + 32 <= input_len; i += 32) {
+        __m128i a = hex_nibbles_sse2(_mm_loadu_si128((const __m128i*)(input + i)), &invalid);
+        __m128i b = hex_nibbles_sse2(_mm_loadu_si128((const __m128i*)(input + i + 16)), &invalid);
+        
+        // Each 16-bit lane holds (low digit << 8) | high digit, fold to one byte
+        a = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(a, 4), _mm_set1_epi16(0x00F0)), _mm_srli_epi16(a, 8));
+        b = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(b, 4), _mm_set1_epi16(0x00F0)), _mm_srli_epi16(b, 8));
+        
+        _mm_storeu_si128((__m128i*)(output + i / 2), _mm_packus_epi16(a, b));
+    }
+    
+    *valid = _mm_movemask_epi8(invalid) == 0;
+    
+    return i / 2;
+}
+
+/**
+ * @brief Map 32 nibbles to hex digits
+ */
+__attribute__((target("avx2")))
+static inline __m256i hex_digits_avx2(__m256i nibbles) {
+    __m256i letters = _mm256_and_si256(_mm256_cmpgt_epi8(nibbles, _mm256_set1_epi8(9)), _mm256_set1_epi8('a' - '0' - 10));
+    return _mm256_add_epi8(_mm256_add_epi8(nibbles, _mm256_set1_epi8('0')), letters);
+}
+
+/**
+ * @brief Map 32 hex digits to nibbles, accumulating invalid lanes
+ */
+__attribute__((target("avx2")))
+static inline __m256i hex_nibbles_avx2(__m256i chars, __m256i* invalid) {
+    __m256i lower = _mm256_or_si256(chars, _mm256_set1_epi8(0x20));
+    
+    __m256i is_digit = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('0' - 1)),
+                                        _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chars));
+    __m256i is_letter = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                                         _mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), lower));
+    
+    *invalid = _mm256_or_si256(*invalid, _mm256_andnot_si256(_mm256_or_si256(is_digit, is_letter), _mm256_set1_epi8(-1)));
+    
+    return _mm256_or_si256(_mm256_and_si256(is_digit, _mm256_sub_epi8(chars, _mm256_set1_epi8('0'))),
+                           _mm256_and_si256(is_letter, _mm256_sub_epi8(lower, _mm256_set1_epi8('a' - 10))));
+}
+
+/**
+ * @brief AVX2 hex encoder, 32 bytes per step
+ *
+ * @return size_t Number of input bytes encoded
+ */
+__attribute__((target("avx2")))
+static size_t hex_encode_avx2(const uint8_t* data, size_t data_len, char* output) {
+    size_t i = 0;
+    
+    for (; i + 32 <= data_len; i += 32) {
+        __m256i in = _mm256_loadu_si256((const __m256i*)(data + i));
+        __m256i high = hex_digits_avx2(_mm256_and_si256(_mm256_srli_epi16(in, 4), _mm256_set1_epi8(0x0F)));
+        __m256i low = hex_digits_avx2(_mm256_and_si256(in, _mm256_set1_epi8(0x0F)));
+        
+        // Unpacking works per 128-bit lane, put the halves back in order
+        __m256i first = _mm256_unpacklo_epi8(high, low);
+        __m256i second = _mm256_unpackhi_epi8(high, low);
+        
+        _mm256_storeu_si256((__m256i*)(output + i * 2), _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256((__m256i*)(output + i * 2 + 32), _mm256_permute2x128_si256(first, second, 0x31));
+    }
+    
+    return i;
+}
+
+/**
+ * @brief AVX2 hex decoder, 64 characters per step
+ *
+ * @return size_t Number of bytes decoded
+ */
+__attribute__((target("avx2")))
+static size_t hex_decode_avx2(const char* input, size_t input_len, uint8_t* output, bool* valid) {
+    __m256i invalid = _mm256_setzero_si256();
+    size_t i = 0;
+    
+    for (; i + 64 <= input_len; i += 64) {
+        __m256i a = hex_nibbles_avx2(_mm256_loadu_si256((const __m256i*)(input + i)), &invalid);
+        __m256i b = hex_nibbles_avx2(_mm256_loadu_si256((const __m256i*)(input + i + 32)), &invalid);
+        
+        a = _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi16(a, 4), _mm256_set1_epi16(0x00F0)), _mm256_srli_epi16(a, 8));
+        b = _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi16(b, 4), _mm256_set1_epi16(0x00F0)), _mm256_srli_epi16(b, 8));
+        
+        // Packing works per 128-bit lane, restore the 64-bit quarter order
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+        _mm256_storeu_si256((__m256i*)(output + i / 2), packed);
+    }
+    
+    *valid = _mm256_movemask_epi8(invalid) == 0;
+    
+    return i / 2;
+}
+
+#endif /* CODEC_X86 */
@@ -0,0 +1,80 @@
+/**
+ * @file codec.h
+ * @brief Hex and base32 codecs for text-only transports (DNS labels and TXT records)
+ */
+
+#ifndef DINOC_CODEC_H
+#define DINOC_CODEC_H
+
+#include "../include/common.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Length of the base32 encoding of data_len bytes (unpadded)
+ */
+#define CODEC_BASE32_ENCODED_LEN(data_len) (((data_len) * 8 + 4) / 5)
+
+/**
+ * @brief Encode binary data as lowercase hex
+ *
+ * Uses AVX2 or SSE2 kernels when the CPU has them.
+ *
+ * @param data Input binary data
+ * @param data_len Length of input data
+ * @param output Output buffer of at least 2 * data_len bytes (not NUL terminated)
+ * @return size_t Number of characters written
+ */
+size_t codec_hex_encode(const uint8_t* data, size_t data_len, char* output);
+
+/**
+ * @brief Decode hex in either case
+ *
+ * @param input Input hex characters
+ * @param input_len Number of characters (must be even)
+ * @param output Output buffer of at least input_len / 2 bytes
+ * @param output_len Number of bytes written
+ * @return status_t STATUS_SUCCESS or STATUS_ERROR_INVALID_FORMAT
+ */
+status_t codec_hex_decode(const char* input, size_t input_len, uint8_t* output, size_t* output_len);
+
+/**
+ * @brief Encode binary data as unpadded lowercase base32 (RFC 4648 alphabet)
+ *
+ * Only letters and digits, so the output is valid in DNS labels and
+ * survives resolvers that randomise the case of query names.
+ *
+ * @param data Input binary data
+ * @param data_len Length of input data
+ * @param output Output buffer of at least CODEC_BASE32_ENCODED_LEN(data_len) bytes
+ * @return size_t Number of characters written
+ */
+size_t codec_base32_encode(const uint8_t* data, size_t data_len, char* output);
+
+/**
+ * @brief Decode unpadded base32 in either case
+ *
+ * @param input Input base32 characters
+ * @param input_len Number of characters
+ * @param output Output buffer of at least input_len * 5 / 8 bytes
+ * @param output_len Number of bytes written
+ * @return status_t STATUS_SUCCESS or STATUS_ERROR_INVALID_FORMAT
+ */
+status_t codec_base32_decode(const char* input, size_t input_len, uint8_t* output, size_t* output_len);
+
+/**
+ * @brief Scalar hex encoder (reference for tests and benchmarks)
+ */
+size_t codec_hex_encode_scalar(const uint8_t* data, size_t data_len, char* output);
+
+/**
+ * @brief Scalar hex decoder (reference for tests and benchmarks)
+ */
+status_t codec_hex_decode_scalar(const char* input, size_t input_len, uint8_t* output, size_t* output_len);
+
+/**
+ * @brief Name of the hex kernel in use ("avx2", "sse2" or "scalar")
+ */
+const char* codec_simd_level(void);
+
+#endif /* DINOC_CODEC_H */
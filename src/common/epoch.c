@@ -0,0 +1,271 @@
+/**
+ * @file epoch.c
+ * @brief Epoch-based reclamation: lock-free read sections, deferred frees for shared objects
+ *
+ * Each thread announces the global epoch it saw when it entered its
+ * outermost read section. The global epoch only advances once every thread
+ * inside a section has announced the current one, so an object retired in
+ * epoch e can no longer be reached by any reader after two advances.
+ */
+
+#define _DEFAULT_SOURCE /* For sched_yield */
+
+#include "epoch.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+// Announced epoch of a thread outside any read section
+#define EPOCH_IDLE UINT64_MAX
+
+// Per-thread reader record, reused once its thread exits but never freed
+typedef struct epoch_record {
+    struct epoch_record* next;
+    uint64_t epoch;                  // Epoch announced on entry, EPOCH_IDLE outside
+    unsigned int depth;              // Nested sections, touched only by the owner
+    bool in_use;                     // Claimed by a live thread
+} epoch_record_t;
+
+// Object waiting for readers to move on
+typedef struct epoch_retired {
+    struct epoch_retired* next;
+    void* ptr;
+    epoch_release_t release;
+    uint64_t epoch;                  // Global epoch when retired
+} epoch_retired_t;
+
+// Reclamation state
+static struct {
+    uint64_t epoch;                  // Global epoch
+    epoch_record_t* records;         // Pushed with compare-and-swap, never unlinked
+    pthread_mutex_t mutex;           // Guards retired and advancing the epoch
+    epoch_retired_t* retired;
+    pthread_key_t key;               // Releases a thread's record on exit
+    pthread_once_t key_once;
+} epoch_state = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .key_once = PTHREAD_ONCE_INIT
+};
+
+static _Thread_local epoch_record_t* epoch_self = NULL;
+
+// Forward declarations
+static epoch_record_t* epoch_register(void);
+static void epoch_thread_exit(void* arg);
+static void epoch_key_create(void);
+static epoch_retired_t* epoch_collect(void);
+static void epoch_release_all(epoch_retired_t* list);
+
+/**
+ * @brief Enter a read section
+ */
+status_t epoch_enter(void) {
+    epoch_record_t* self = epoch_self;
+    
+    if (self == NULL) {
+        self = epoch_register();
+        if (self == NULL) {
+            return STATUS_ERROR_MEMORY;
+        }
+    }
+    
+    if (self->depth++ == 0) {
+        // A stale epoch is safe, it only holds the next advance back
+        __atomic_store_n(&self->epoch, __atomic_load_n(&epoch_state.epoch, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+        
+        // Announce before loading any protected pointer
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Leave a read section
+ */
+void epoch_exit(void) {
+    epoch_record_t* self = epoch_self;
+    
+    if (self == NULL || self->depth == 0) {
+        return;
+    }
+    
+    if (--self->depth == 0) {
+        __atomic_store_n(&self->epoch, EPOCH_IDLE, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * @brief Free an object once every read section that could see it has ended
+ */
+void epoch_retire(void* ptr, epoch_release_t release) {
+    if (ptr == NULL || release == NULL) {
+        return;
+    }
+    
+    epoch_retired_t* retired = (epoch_retired_t*)malloc(sizeof(epoch_retired_t));
+    if (retired == NULL) {
+        // Nowhere to park it, wait the readers out instead. Inside a read
+        // section that would wait on ourselves, so leak it rather than hang.
+        if (epoch_self == NULL || epoch_self->depth == 0) {
+            epoch_barrier();
+            release(ptr);
+        }
+        return;
+    }
+    
+    memset(retired, 0, sizeof(epoch_retired_t));
+    retired->ptr = ptr;
+    retired->release = release;
+    
+    pthread_mutex_lock(&epoch_state.mutex);
+    
+    retired->epoch = __atomic_load_n(&epoch_state.epoch, __ATOMIC_RELAXED);
+    retired->next = epoch_state.retired;
+    epoch_state.retired = retired;
+    
+    epoch_retired_t* ready = epoch_collect();
+    
+    pthread_mutex_unlock(&epoch_state.mutex);
+    
+    epoch_release_all(ready);
+}
+
+/**
+ * @brief Wait until every object retired so far has been released
+ */
+void epoch_barrier(void) {
+    while (true) {
+        pthread_mutex_lock(&epoch_state.mutex);
+        
+        epoch_retired_t* ready = epoch_collect();
+        bool empty = epoch_state.retired == NULL;
+        
+        pthread_mutex_unlock(&epoch_state.mutex);
+        
+        epoch_release_all(ready);
+        
+        if (empty) {
+            break;
+        }
+        
+        sched_yield();
+    }
+}
+
+/**
+ * @brief Advance the epoch if every reader has caught up, and take what is safe to release (mutex held)
+ *
+ * @return epoch_retired_t* Objects to release once the mutex is dropped
+ */
+static epoch_retired_t* epoch_collect(void) {
+    // Order the writer's unlinks before reading announcements
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    
+    uint64_t epoch = __atomic_load_n(&epoch_state.epoch, __ATOMIC_RELAXED);
+    bool advance = true;
+    
+    for (epoch_record_t* record = __atomic_load_n(&epoch_state.records, __ATOMIC_ACQUIRE);
+         record != NULL; record = record->next) {
+        uint64_t announced = __atomic_load_n(&record->epoch, __ATOMIC_ACQUIRE);
+        
+        if (announced != EPOCH_IDLE && announced != epoch) {
+            advance = false;
+            break;
+        }
+    }
+    
+    if (advance) {
+        epoch++;
+        __atomic_store_n(&epoch_state.epoch, epoch, __ATOMIC_RELEASE);
+    }
+    
+    // Two advances since retirement, no reader can still hold it
+    epoch_retired_t* ready = NULL;
+    epoch_retired_t** link = &epoch_state.retired;
+    
+    while (*link != NULL) {
+        epoch_retired_t* retired = *link;
+        
+        if (retired->epoch + 2 <= epoch) {
+            *link = retired->next;
+            retired->next = ready;
+            ready = retired;
+        } else {
+            link = &retired->next;
+        }
+    }
+    
+    return ready;
+}
+
+/**
+ * @brief Release a list of retired objects
+ */
+static void epoch_release_all(epoch_retired_t* list) {
+    while (list != NULL) {
+        epoch_retired_t* next = list->next;
+        list->release(list->ptr);
+        free(list);
+        list = next;
+    }
+}
+
+/**
+ * @brief Claim a record for the calling thread, reusing one left by an exited thread
+ */
+static epoch_record_t* epoch_register(void) {
+    pthread_once(&epoch_state.key_once, epoch_key_create);
+    
+    epoch_record_t* record = __atomic_load_n(&epoch_state.records, __ATOMIC_ACQUIRE);
+    
+    for (; record != NULL; record = record->next) {
+        bool expected = false;
+        
+        if (__atomic_compare_exchange_n(&record->in_use, &expected, true, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+    
+    if (record == NULL) {
+        record = (epoch_record_t*)malloc(sizeof(epoch_record_t));
+        if (record == NULL) {
+            return NULL;
+        }
+        
+        memset(record, 0, sizeof(epoch_record_t));
+        record->epoch = EPOCH_IDLE;
+        record->in_use = true;
+        
+        record->next = __atomic_load_n(&epoch_state.records, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&epoch_state.records, &record->next, record, true,
+                                            __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        }
+    }
+    
+    record->depth = 0;
+    epoch_self = record;
+    pthread_setspecific(epoch_state.key, record);
+    
+    return record;
+}
+
+/**
+ * @brief Hand an exiting thread's record back for reuse
+ */
+static void epoch_thread_exit(void* arg) {
+    epoch_record_t* record = (epoch_record_t*)arg;
+    
+    record->depth = 0;
+    __atomic_store_n(&record->epoch, EPOCH_IDLE, __ATOMIC_RELEASE);
+    __atomic_store_n(&record->in_use, false, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Create the thread exit key
+ */
+static void epoch_key_create(void) {
+    pthread_key_create(&epoch_state.key, epoch_thread_exit);
+}
@@ -0,0 +1,56 @@
+/**
+ * @file epoch.h
+ * @brief Epoch-based reclamation: lock-free read sections, deferred frees for shared objects
+ */
+
+#ifndef DINOC_EPOCH_H
+#define DINOC_EPOCH_H
+
+#include "../include/common.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Release function for a retired object
+ *
+ * @param ptr Object passed to epoch_retire
+ */
+typedef void (*epoch_release_t)(void* ptr);
+
+/**
+ * @brief Enter a read section
+ *
+ * Objects reachable from shared pointers loaded inside the section stay
+ * valid until the matching epoch_exit, even if a writer retires them
+ * meanwhile. Sections nest and cost no lock; a thread's first section
+ * registers it.
+ *
+ * @return status_t Status code, an error only if the thread cannot be registered
+ */
+status_t epoch_enter(void);
+
+/**
+ * @brief Leave a read section
+ */
+void epoch_exit(void);
+
+/**
+ * @brief Free an object once every read section that could see it has ended
+ *
+ * The caller must already have unlinked the object from every shared
+ * pointer. May release this and earlier retired objects before returning,
+ * so it must not be called with locks the release functions take.
+ *
+ * @param ptr Object
+ * @param release Release function
+ */
+void epoch_retire(void* ptr, epoch_release_t release);
+
+/**
+ * @brief Wait until every object retired so far has been released
+ *
+ * Must not be called inside a read section.
+ */
+void epoch_barrier(void);
+
+#endif /* DINOC_EPOCH_H */
@@ -0,0 +1,375 @@
+/**
+ * @file reactor.c
+ * @brief Shared epoll reactor: a fixed set of loop threads serving every listener's descriptors
+ */
+
+#define _GNU_SOURCE /* For pthread_setaffinity_np */
+
+#include "reactor.h"
+#include "logger.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <errno.h>
+#include <sys/eventfd.h>
+
+// Loop thread
+typedef struct reactor_loop {
+    reactor_t* reactor;
+    size_t index;
+    int epoll_fd;
+    int wakeup_fd;                   // Registered with a NULL source
+    pthread_t thread;
+    bool thread_started;
+    bool exited;                     // Loop thread has returned
+    pthread_mutex_t mutex;           // Guards iterations, exited and retired
+    pthread_cond_t round_done;       // Signalled after every dispatch round
+    uint64_t iterations;             // Completed dispatch rounds
+    reactor_source_t* retired;       // Removed from inside the loop, freed after the round
+} reactor_loop_t;
+
+// Registered descriptor
+struct reactor_source {
+    reactor_loop_t* loop;
+    int fd;
+    reactor_handler_t handler;
+    void* arg;
+    bool removed;                    // Stale events fetched in the same round are skipped
+    reactor_source_t* next_retired;
+};
+
+// Reactor
+struct reactor {
+    reactor_loop_t* loops;
+    size_t loop_count;
+    size_t next_loop;
+    bool running;
+};
+
+// Loop served by the calling thread, NULL outside loop threads
+static _Thread_local reactor_loop_t* reactor_current_loop = NULL;
+
+// Forward declarations
+static void* reactor_loop_thread(void* arg);
+static void reactor_wake(reactor_loop_t* loop);
+static void reactor_stop_loops(reactor_t* reactor, size_t started);
+
+/**
+ * @brief Create a reactor and start its loop threads
+ */
+status_t reactor_create(size_t loop_count, reactor_t** reactor) {
+    if (reactor == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    
+    if (loop_count == 0) {
+        loop_count = cores > 0 ? (size_t)cores : 1;
+    }
+    
+    reactor_t* new_reactor = (reactor_t*)malloc(sizeof(reactor_t));
+    if (new_reactor == NULL) {
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    memset(new_reactor, 0, sizeof(reactor_t));
+    
+    new_reactor->loops = (reactor_loop_t*)calloc(loop_count, sizeof(reactor_loop_t));
+    if (new_reactor->loops == NULL) {
+        free(new_reactor);
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    new_reactor->loop_count = loop_count;
+    new_reactor->running = true;
+    
+    for (size_t i = 0; i < loop_count; i++) {
+        reactor_loop_t* loop = &new_reactor->loops[i];
+        loop->reactor = new_reactor;
+        loop->index = i;
+        loop->wakeup_fd = -1;
+        
+        pthread_mutex_init(&loop->mutex, NULL);
+        pthread_cond_init(&loop->round_done, NULL);
+        
+        loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        loop->wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.ptr = NULL;
+        
+        if (loop->epoll_fd < 0 || loop->wakeup_fd < 0 ||
+            epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, loop->wakeup_fd, &event) < 0 ||
+            pthread_create(&loop->thread, NULL, reactor_loop_thread, loop) != 0) {
+            LOG_ERROR("Failed to start reactor loop %zu: %s", i, strerror(errno));
+            reactor_stop_loops(new_reactor, i + 1);
+            free(new_reactor->loops);
+            free(new_reactor);
+            return STATUS_ERROR_THREAD;
+        }
+        
+        loop->thread_started = true;
+        
+        // One loop per core, so each core polls its own share of the descriptors
+        if (loop_count > 1 && cores > 0) {
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            CPU_SET((int)(i % (size_t)cores), &cpuset);
+            
+            if (pthread_setaffinity_np(loop->thread, sizeof(cpuset), &cpuset) != 0) {
+                LOG_WARN("Failed to pin reactor loop %zu", i);
+            }
+        }
+    }
+    
+    *reactor = new_reactor;
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Stop the loop threads and free the reactor
+ */
+void reactor_destroy(reactor_t* reactor) {
+    if (reactor == NULL) {
+        return;
+    }
+    
+    reactor_stop_loops(reactor, reactor->loop_count);
+    
+    free(reactor->loops);
+    free(reactor);
+}
+
+/**
+ * @brief Number of loop threads
+ */
+size_t reactor_loop_count(const reactor_t* reactor) {
+    return reactor != NULL ? reactor->loop_count : 0;
+}
+
+/**
+ * @brief Pick a loop round robin
+ */
+size_t reactor_next_loop(reactor_t* reactor) {
+    if (reactor == NULL) {
+        return 0;
+    }
+    
+    return __atomic_fetch_add(&reactor->next_loop, 1, __ATOMIC_RELAXED) % reactor->loop_count;
+}
+
+/**
+ * @brief Register a descriptor
+ */
+status_t reactor_add(reactor_t* reactor, size_t loop, int fd, uint32_t events,
+                     reactor_handler_t handler, void* arg, reactor_source_t** source) {
+    if (reactor == NULL || fd < 0 || handler == NULL || source == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    reactor_source_t* new_source = (reactor_source_t*)malloc(sizeof(reactor_source_t));
+    if (new_source == NULL) {
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    memset(new_source, 0, sizeof(reactor_source_t));
+    new_source->loop = &reactor->loops[loop % reactor->loop_count];
+    new_source->fd = fd;
+    new_source->handler = handler;
+    new_source->arg = arg;
+    
+    // Published before epoll_ctl, the loop may dispatch it straight away
+    *source = new_source;
+    
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.ptr = new_source;
+    
+    if (epoll_ctl(new_source->loop->epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        LOG_ERROR("Failed to add descriptor %d to reactor: %s", fd, strerror(errno));
+        *source = NULL;
+        free(new_source);
+        return STATUS_ERROR_SOCKET;
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Change the events a source waits for
+ */
+status_t reactor_modify(reactor_source_t* source, uint32_t events) {
+    if (source == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.ptr = source;
+    
+    if (epoll_ctl(source->loop->epoll_fd, EPOLL_CTL_MOD, source->fd, &event) < 0) {
+        return STATUS_ERROR_SOCKET;
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Unregister a descriptor
+ */
+void reactor_remove(reactor_source_t* source) {
+    if (source == NULL) {
+        return;
+    }
+    
+    reactor_loop_t* loop = source->loop;
+    
+    // The descriptor may already be closed, which removed it from epoll
+    epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, source->fd, NULL);
+    __atomic_store_n(&source->removed, true, __ATOMIC_RELEASE);
+    
+    pthread_mutex_lock(&loop->mutex);
+    
+    // Inside the loop: the current round may still hold events for it
+    if (reactor_current_loop == loop) {
+        source->next_retired = loop->retired;
+        loop->retired = source;
+        pthread_mutex_unlock(&loop->mutex);
+        return;
+    }
+    
+    // Elsewhere: a round that fetched its events before the removal ends at most one round from now
+    uint64_t target = loop->iterations + 1;
+    
+    if (!loop->exited) {
+        reactor_wake(loop);
+    }
+    
+    while (!loop->exited && loop->iterations < target) {
+        pthread_cond_wait(&loop->round_done, &loop->mutex);
+    }
+    
+    pthread_mutex_unlock(&loop->mutex);
+    
+    free(source);
+}
+
+/**
+ * @brief Whether the calling thread is the loop thread serving a source
+ */
+bool reactor_in_loop(const reactor_source_t* source) {
+    return source != NULL && reactor_current_loop == source->loop;
+}
+
+/**
+ * @brief Loop thread: wait, dispatch, then free sources retired during the round
+ */
+static void* reactor_loop_thread(void* arg) {
+    reactor_loop_t* loop = (reactor_loop_t*)arg;
+    reactor_t* reactor = loop->reactor;
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+    
+    reactor_current_loop = loop;
+    
+    while (__atomic_load_n(&reactor->running, __ATOMIC_ACQUIRE)) {
+        int count = epoll_wait(loop->epoll_fd, events, REACTOR_MAX_EVENTS, -1);
+        
+        if (count < 0 && errno != EINTR) {
+            LOG_ERROR("Reactor loop %zu wait failed: %s", loop->index, strerror(errno));
+            break;
+        }
+        
+        for (int i = 0; i < count; i++) {
+            reactor_source_t* source = (reactor_source_t*)events[i].data.ptr;
+            
+            // Wakeup request, the running flag is re-checked by the loop
+            if (source == NULL) {
+                uint64_t value;
+                if (read(loop->wakeup_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+                    LOG_ERROR("Failed to drain reactor wakeup: %s", strerror(errno));
+                }
+                continue;
+            }
+            
+            if (__atomic_load_n(&source->removed, __ATOMIC_ACQUIRE)) {
+                continue;
+            }
+            
+            source->handler(source->fd, events[i].events, source->arg);
+        }
+        
+        // Round complete, release removers waiting on it
+        pthread_mutex_lock(&loop->mutex);
+        loop->iterations++;
+        reactor_source_t* retired = loop->retired;
+        loop->retired = NULL;
+        pthread_cond_broadcast(&loop->round_done);
+        pthread_mutex_unlock(&loop->mutex);
+        
+        while (retired != NULL) {
+            reactor_source_t* next = retired->next_retired;
+            free(retired);
+            retired = next;
+        }
+    }
+    
+    pthread_mutex_lock(&loop->mutex);
+    loop->exited = true;
+    pthread_cond_broadcast(&loop->round_done);
+    pthread_mutex_unlock(&loop->mutex);
+    
+    return NULL;
+}
+
+/**
+ * @brief Interrupt a loop's epoll_wait
+ */
+static void reactor_wake(reactor_loop_t* loop) {
+    uint64_t value = 1;
+    
+    if (write(loop->wakeup_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+        LOG_ERROR("Failed to wake reactor loop %zu: %s", loop->index, strerror(errno));
+    }
+}
+
+/**
+ * @brief Wake, join and release the first started loops
+ */
+static void reactor_stop_loops(reactor_t* reactor, size_t started) {
+    __atomic_store_n(&reactor->running, false, __ATOMIC_RELEASE);
+    
+    for (size_t i = 0; i < started; i++) {
+        reactor_loop_t* loop = &reactor->loops[i];
+        
+        if (loop->thread_started) {
+            reactor_wake(loop);
+            pthread_join(loop->thread, NULL);
+            loop->thread_started = false;
+        }
+        
+        // Sources retired in the last round
+        while (loop->retired != NULL) {
+            reactor_source_t* next = loop->retired->next_retired;
+            free(loop->retired);
+            loop->retired = next;
+        }
+        
+        if (loop->wakeup_fd >= 0) {
+            close(loop->wakeup_fd);
+        }
+        if (loop->epoll_fd >= 0) {
+            close(loop->epoll_fd);
+        }
+        
+        pthread_cond_destroy(&loop->round_done);
+        pthread_mutex_destroy(&loop->mutex);
+    }
+}
@@ -0,0 +1,106 @@
+/**
+ * @file reactor.h
+ * @brief Shared epoll reactor: a fixed set of loop threads serving every listener's descriptors
+ */
+
+#ifndef DINOC_REACTOR_H
+#define DINOC_REACTOR_H
+
+#include "../include/common.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/epoll.h>
+
+// Most events one loop handles per epoll_wait call
+#define REACTOR_MAX_EVENTS 256
+
+typedef struct reactor reactor_t;
+typedef struct reactor_source reactor_source_t;
+
+/**
+ * @brief Readiness handler
+ *
+ * Runs on the loop thread the source was added to, never concurrently with
+ * another handler of the same loop.
+ *
+ * @param fd Registered descriptor
+ * @param events EPOLL* events that fired
+ * @param arg Argument given to reactor_add
+ */
+typedef void (*reactor_handler_t)(int fd, uint32_t events, void* arg);
+
+/**
+ * @brief Create a reactor and start its loop threads
+ *
+ * @param loop_count Loop threads (0 = one per core); loops are pinned to cores when there is more than one
+ * @param reactor Output reactor
+ * @return status_t Status code
+ */
+status_t reactor_create(size_t loop_count, reactor_t** reactor);
+
+/**
+ * @brief Stop the loop threads and free the reactor
+ *
+ * Every source must have been removed.
+ *
+ * @param reactor Reactor
+ */
+void reactor_destroy(reactor_t* reactor);
+
+/**
+ * @brief Number of loop threads
+ */
+size_t reactor_loop_count(const reactor_t* reactor);
+
+/**
+ * @brief Pick a loop round robin, for spreading independent sources
+ */
+size_t reactor_next_loop(reactor_t* reactor);
+
+/**
+ * @brief Register a descriptor
+ *
+ * Sources whose handlers share unlocked state must be added to the same
+ * loop. Events are level-triggered unless EPOLLET is given.
+ *
+ * @param reactor Reactor
+ * @param loop Loop index (taken modulo the loop count)
+ * @param fd Descriptor
+ * @param events EPOLL* events to wait for
+ * @param handler Readiness handler
+ * @param arg Handler argument
+ * @param source Output registration, passed to reactor_modify and reactor_remove
+ * @return status_t Status code
+ */
+status_t reactor_add(reactor_t* reactor, size_t loop, int fd, uint32_t events,
+                     reactor_handler_t handler, void* arg, reactor_source_t** source);
+
+/**
+ * @brief Change the events a source waits for
+ *
+ * @param source Registration
+ * @param events EPOLL* events to wait for
+ * @return status_t Status code
+ */
+status_t reactor_modify(reactor_source_t* source, uint32_t events);
+
+/**
+ * @brief Unregister a descriptor
+ *
+ * Once this returns the handler is not running and will not run again, so
+ * its argument can be freed. From another thread this waits for the
+ * source's loop to finish its current round; from the loop itself
+ * (including the source's own handler) it returns at once. The descriptor
+ * is not closed.
+ *
+ * @param source Registration
+ */
+void reactor_remove(reactor_source_t* source);
+
+/**
+ * @brief Whether the calling thread is the loop thread serving a source
+ */
+bool reactor_in_loop(const reactor_source_t* source);
+
+#endif /* DINOC_REACTOR_H */
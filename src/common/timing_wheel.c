@@ -0,0 +1,431 @@
+/**
+ * @file timing_wheel.c
+ * @brief Hierarchical timing wheel: O(1) timer arm and cancel, expiry cost proportional to the timers that expire
+ */
+
+#define _DEFAULT_SOURCE /* For clock_gettime and pthread_condattr_setclock */
+
+#include "timing_wheel.h"
+#include "logger.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#define TIMING_WHEEL_SLOT_MASK (TIMING_WHEEL_SLOTS - 1)
+
+// Timing wheel
+struct timing_wheel {
+    pthread_mutex_t mutex;           // Guards everything below
+    pthread_cond_t wakeup;           // Wheel thread: first timer armed, or stop
+    pthread_cond_t callback_done;    // Signalled after every callback
+    timing_wheel_link_t slots[TIMING_WHEEL_LEVELS][TIMING_WHEEL_SLOTS];
+    timing_wheel_link_t expired;     // Fired, callbacks still to run
+    uint64_t current;                // Next tick to process, every earlier tick has fired
+    size_t count;                    // Pending timers
+    uint32_t tick_ms;
+    uint64_t start_ms;               // Clock time of tick 0
+    timing_wheel_timer_t* running;   // Timer whose callback is in progress
+    pthread_t running_thread;        // Thread running it
+    pthread_t thread;
+    bool thread_started;
+    bool stopping;
+};
+
+// Forward declarations
+static void* timing_wheel_thread(void* arg);
+static void timing_wheel_process_tick(timing_wheel_t* wheel);
+static void timing_wheel_place(timing_wheel_t* wheel, timing_wheel_timer_t* timer);
+static void timing_wheel_cascade(timing_wheel_t* wheel, size_t level, size_t index);
+static uint64_t timing_wheel_clock_tick(const timing_wheel_t* wheel);
+
+/**
+ * @brief Empty a list
+ */
+static inline void timing_wheel_list_init(timing_wheel_link_t* head) {
+    head->next = head;
+    head->prev = head;
+}
+
+/**
+ * @brief Append to a list
+ */
+static inline void timing_wheel_list_add(timing_wheel_link_t* head, timing_wheel_link_t* link) {
+    link->prev = head->prev;
+    link->next = head;
+    head->prev->next = link;
+    head->prev = link;
+}
+
+/**
+ * @brief Unlink from whichever list holds the link
+ */
+static inline void timing_wheel_list_del(timing_wheel_link_t* link) {
+    link->prev->next = link->next;
+    link->next->prev = link->prev;
+    link->next = link;
+    link->prev = link;
+}
+
+/**
+ * @brief Create a wheel
+ */
+status_t timing_wheel_create(uint32_t tick_ms, bool run_thread, timing_wheel_t** wheel) {
+    if (tick_ms == 0 || wheel == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    timing_wheel_t* new_wheel = (timing_wheel_t*)malloc(sizeof(timing_wheel_t));
+    if (new_wheel == NULL) {
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    memset(new_wheel, 0, sizeof(timing_wheel_t));
+    new_wheel->tick_ms = tick_ms;
+    new_wheel->start_ms = timing_wheel_now_ms();
+    new_wheel->current = 1;
+    
+    for (size_t level = 0; level < TIMING_WHEEL_LEVELS; level++) {
+        for (size_t i = 0; i < TIMING_WHEEL_SLOTS; i++) {
+            timing_wheel_list_init(&new_wheel->slots[level][i]);
+        }
+    }
+    
+    timing_wheel_list_init(&new_wheel->expired);
+    
+    // Deadlines are on the monotonic clock, so wall clock steps do not stall the wheel
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    
+    pthread_mutex_init(&new_wheel->mutex, NULL);
+    pthread_cond_init(&new_wheel->wakeup, &attr);
+    pthread_cond_init(&new_wheel->callback_done, NULL);
+    
+    pthread_condattr_destroy(&attr);
+    
+    if (run_thread) {
+        if (pthread_create(&new_wheel->thread, NULL, timing_wheel_thread, new_wheel) != 0) {
+            LOG_ERROR("Failed to start timing wheel thread");
+            pthread_cond_destroy(&new_wheel->callback_done);
+            pthread_cond_destroy(&new_wheel->wakeup);
+            pthread_mutex_destroy(&new_wheel->mutex);
+            free(new_wheel);
+            return STATUS_ERROR_THREAD;
+        }
+        
+        new_wheel->thread_started = true;
+    }
+    
+    *wheel = new_wheel;
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Stop the wheel thread and free the wheel
+ */
+void timing_wheel_destroy(timing_wheel_t* wheel) {
+    if (wheel == NULL) {
+        return;
+    }
+    
+    if (wheel->thread_started) {
+        pthread_mutex_lock(&wheel->mutex);
+        wheel->stopping = true;
+        pthread_cond_signal(&wheel->wakeup);
+        pthread_mutex_unlock(&wheel->mutex);
+        
+        pthread_join(wheel->thread, NULL);
+    }
+    
+    // Leave dropped timers unlinked, their owners may still cancel them
+    for (size_t level = 0; level < TIMING_WHEEL_LEVELS; level++) {
+        for (size_t i = 0; i < TIMING_WHEEL_SLOTS; i++) {
+            timing_wheel_link_t* head = &wheel->slots[level][i];
+            
+            while (head->next != head) {
+                timing_wheel_timer_t* timer = (timing_wheel_timer_t*)head->next;
+                timing_wheel_list_del(&timer->link);
+                timer->pending = false;
+            }
+        }
+    }
+    
+    while (wheel->expired.next != &wheel->expired) {
+        timing_wheel_timer_t* timer = (timing_wheel_timer_t*)wheel->expired.next;
+        timing_wheel_list_del(&timer->link);
+        timer->pending = false;
+    }
+    
+    pthread_cond_destroy(&wheel->callback_done);
+    pthread_cond_destroy(&wheel->wakeup);
+    pthread_mutex_destroy(&wheel->mutex);
+    free(wheel);
+}
+
+/**
+ * @brief Tick length in milliseconds
+ */
+uint32_t timing_wheel_tick_ms(const timing_wheel_t* wheel) {
+    return wheel != NULL ? wheel->tick_ms : 0;
+}
+
+/**
+ * @brief Prepare a timer before its first use
+ */
+void timing_wheel_timer_init(timing_wheel_timer_t* timer, timing_wheel_callback_t callback, void* arg) {
+    if (timer == NULL) {
+        return;
+    }
+    
+    memset(timer, 0, sizeof(timing_wheel_timer_t));
+    timing_wheel_list_init(&timer->link);
+    timer->callback = callback;
+    timer->arg = arg;
+}
+
+/**
+ * @brief Arm a timer, moving it if it is already pending
+ */
+status_t timing_wheel_schedule(timing_wheel_t* wheel, timing_wheel_timer_t* timer, uint64_t delay_ms) {
+    if (wheel == NULL || timer == NULL || timer->callback == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    uint64_t ticks = (delay_ms + wheel->tick_ms - 1) / wheel->tick_ms;
+    
+    pthread_mutex_lock(&wheel->mutex);
+    
+    if (timer->pending) {
+        timing_wheel_list_del(&timer->link);
+        wheel->count--;
+    }
+    
+    if (wheel->thread_started) {
+        // Round up, part of the tick in progress has already passed
+        uint64_t next_tick = timing_wheel_clock_tick(wheel) + 1;
+        
+        // An empty wheel has nothing to cascade, skip the ticks it slept through
+        if (wheel->count == 0 && wheel->current < next_tick) {
+            wheel->current = next_tick;
+        }
+        
+        timer->expires = next_tick + ticks;
+    } else {
+        timer->expires = wheel->current - 1 + ticks;
+    }
+    
+    // Anything beyond the top level waits in its last slot
+    if (timer->expires > wheel->current + TIMING_WHEEL_MAX_TICKS) {
+        timer->expires = wheel->current + TIMING_WHEEL_MAX_TICKS;
+    }
+    
+    timing_wheel_place(wheel, timer);
+    timer->pending = true;
+    
+    // The wheel thread sleeps without a deadline while nothing is armed
+    if (wheel->count++ == 0 && wheel->thread_started) {
+        pthread_cond_signal(&wheel->wakeup);
+    }
+    
+    pthread_mutex_unlock(&wheel->mutex);
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Disarm a timer
+ */
+void timing_wheel_cancel(timing_wheel_t* wheel, timing_wheel_timer_t* timer) {
+    if (wheel == NULL || timer == NULL) {
+        return;
+    }
+    
+    pthread_mutex_lock(&wheel->mutex);
+    
+    // A callback in progress may rearm its timer, wait for it before unlinking
+    while (wheel->running == timer && !pthread_equal(wheel->running_thread, pthread_self())) {
+        pthread_cond_wait(&wheel->callback_done, &wheel->mutex);
+    }
+    
+    if (timer->pending) {
+        timing_wheel_list_del(&timer->link);
+        timer->pending = false;
+        wheel->count--;
+    }
+    
+    pthread_mutex_unlock(&wheel->mutex);
+}
+
+/**
+ * @brief Run a wheel without a thread forward by some ticks
+ */
+void timing_wheel_advance(timing_wheel_t* wheel, uint64_t ticks) {
+    if (wheel == NULL || wheel->thread_started) {
+        return;
+    }
+    
+    pthread_mutex_lock(&wheel->mutex);
+    
+    for (uint64_t i = 0; i < ticks; i++) {
+        timing_wheel_process_tick(wheel);
+    }
+    
+    pthread_mutex_unlock(&wheel->mutex);
+}
+
+/**
+ * @brief Monotonic time in milliseconds
+ */
+uint64_t timing_wheel_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Wheel thread: fires due ticks, sleeping until the next one or indefinitely when nothing is armed
+ */
+static void* timing_wheel_thread(void* arg) {
+    timing_wheel_t* wheel = (timing_wheel_t*)arg;
+    
+    pthread_mutex_lock(&wheel->mutex);
+    
+    while (!wheel->stopping) {
+        if (wheel->count == 0) {
+            pthread_cond_wait(&wheel->wakeup, &wheel->mutex);
+            continue;
+        }
+        
+        uint64_t now_tick = timing_wheel_clock_tick(wheel);
+        
+        while (wheel->current <= now_tick && !wheel->stopping) {
+            timing_wheel_process_tick(wheel);
+        }
+        
+        if (wheel->stopping || wheel->count == 0) {
+            continue;
+        }
+        
+        // Sleep until the next tick is due
+        uint64_t deadline_ms = wheel->start_ms + wheel->current * wheel->tick_ms;
+        struct timespec deadline;
+        deadline.tv_sec = (time_t)(deadline_ms / 1000);
+        deadline.tv_nsec = (long)(deadline_ms % 1000) * 1000000;
+        
+        pthread_cond_timedwait(&wheel->wakeup, &wheel->mutex, &deadline);
+    }
+    
+    pthread_mutex_unlock(&wheel->mutex);
+    
+    return NULL;
+}
+
+/**
+ * @brief Fire one tick (called with the mutex held, released around callbacks)
+ *
+ * When the level 0 index wraps, the next slot of each higher level whose
+ * index wrapped too is redistributed downwards. Only the timers due on this
+ * tick are touched otherwise.
+ */
+static void timing_wheel_process_tick(timing_wheel_t* wheel) {
+    size_t index = wheel->current & TIMING_WHEEL_SLOT_MASK;
+    
+    if (index == 0) {
+        for (size_t level = 1; level < TIMING_WHEEL_LEVELS; level++) {
+            size_t level_index = (wheel->current >> (level * TIMING_WHEEL_SLOT_BITS)) & TIMING_WHEEL_SLOT_MASK;
+            
+            timing_wheel_cascade(wheel, level, level_index);
+            
+            if (level_index != 0) {
+                break;
+            }
+        }
+    }
+    
+    // Detach the due slot, callbacks may arm timers into it again
+    timing_wheel_link_t* slot = &wheel->slots[0][index];
+    
+    while (slot->next != slot) {
+        timing_wheel_link_t* link = slot->next;
+        timing_wheel_list_del(link);
+        timing_wheel_list_add(&wheel->expired, link);
+    }
+    
+    wheel->current++;
+    
+    while (wheel->expired.next != &wheel->expired) {
+        timing_wheel_timer_t* timer = (timing_wheel_timer_t*)wheel->expired.next;
+        timing_wheel_callback_t callback = timer->callback;
+        void* callback_arg = timer->arg;
+        
+        timing_wheel_list_del(&timer->link);
+        timer->pending = false;
+        wheel->count--;
+        
+        wheel->running = timer;
+        wheel->running_thread = pthread_self();
+        
+        pthread_mutex_unlock(&wheel->mutex);
+        callback(timer, callback_arg);
+        pthread_mutex_lock(&wheel->mutex);
+        
+        wheel->running = NULL;
+        pthread_cond_broadcast(&wheel->callback_done);
+    }
+}
+
+/**
+ * @brief Link a timer into the slot for its expiry, relative to the current tick
+ */
+static void timing_wheel_place(timing_wheel_t* wheel, timing_wheel_timer_t* timer) {
+    // Already due, fire on the next tick processed
+    if (timer->expires <= wheel->current) {
+        timing_wheel_list_add(&wheel->slots[0][wheel->current & TIMING_WHEEL_SLOT_MASK], &timer->link);
+        return;
+    }
+    
+    uint64_t delta = timer->expires - wheel->current;
+    size_t level = 0;
+    
+    while (level < TIMING_WHEEL_LEVELS - 1 && delta >= (1ULL << ((level + 1) * TIMING_WHEEL_SLOT_BITS))) {
+        level++;
+    }
+    
+    size_t index = (timer->expires >> (level * TIMING_WHEEL_SLOT_BITS)) & TIMING_WHEEL_SLOT_MASK;
+    timing_wheel_list_add(&wheel->slots[level][index], &timer->link);
+}
+
+/**
+ * @brief Move one higher-level slot's timers to the slots their remaining delay now falls in
+ */
+static void timing_wheel_cascade(timing_wheel_t* wheel, size_t level, size_t index) {
+    timing_wheel_link_t* slot = &wheel->slots[level][index];
+    timing_wheel_link_t moving;
+    
+    if (slot->next == slot) {
+        return;
+    }
+    
+    // Take the whole list first, so no timer is visited twice
+    moving.next = slot->next;
+    moving.prev = slot->prev;
+    moving.next->prev = &moving;
+    moving.prev->next = &moving;
+    timing_wheel_list_init(slot);
+    
+    while (moving.next != &moving) {
+        timing_wheel_timer_t* timer = (timing_wheel_timer_t*)moving.next;
+        timing_wheel_list_del(&timer->link);
+        timing_wheel_place(wheel, timer);
+    }
+}
+
+/**
+ * @brief Last tick whose time has come, by the clock
+ */
+static uint64_t timing_wheel_clock_tick(const timing_wheel_t* wheel) {
+    return (timing_wheel_now_ms() - wheel->start_ms) / wheel->tick_ms;
+}
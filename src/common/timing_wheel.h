@@ -0,0 +1,131 @@
+/**
+ * @file timing_wheel.h
+ * @brief Hierarchical timing wheel: O(1) timer arm and cancel, expiry cost proportional to the timers that expire
+ */
+
+#ifndef DINOC_TIMING_WHEEL_H
+#define DINOC_TIMING_WHEEL_H
+
+#include "../include/common.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Wheel geometry
+ *
+ * Four levels of 64 slots. Level 0 holds timers due within 64 ticks, each
+ * higher level covers 64 times the span of the one below and is cascaded
+ * down one slot at a time as the lower level wraps. Longer delays are
+ * clamped to the last slot of the top level.
+ */
+#define TIMING_WHEEL_LEVELS 4
+#define TIMING_WHEEL_SLOT_BITS 6
+#define TIMING_WHEEL_SLOTS (1 << TIMING_WHEEL_SLOT_BITS)
+#define TIMING_WHEEL_MAX_TICKS ((1ULL << (TIMING_WHEEL_LEVELS * TIMING_WHEEL_SLOT_BITS)) - 1)
+
+typedef struct timing_wheel timing_wheel_t;
+typedef struct timing_wheel_timer timing_wheel_timer_t;
+
+/**
+ * @brief Expiry callback
+ *
+ * Runs on the thread driving the wheel with the wheel unlocked, so it may
+ * schedule or cancel timers, including its own.
+ *
+ * @param timer Timer that expired
+ * @param arg Argument given to timing_wheel_timer_init
+ */
+typedef void (*timing_wheel_callback_t)(timing_wheel_timer_t* timer, void* arg);
+
+// Slot list link
+typedef struct timing_wheel_link {
+    struct timing_wheel_link* next;
+    struct timing_wheel_link* prev;
+} timing_wheel_link_t;
+
+/**
+ * @brief Timer, embedded in its owner so arming never allocates
+ *
+ * Fields are private to the wheel.
+ */
+struct timing_wheel_timer {
+    timing_wheel_link_t link;        // Must stay first
+    uint64_t expires;                // Tick the timer fires on
+    timing_wheel_callback_t callback;
+    void* arg;
+    bool pending;                    // Linked into a slot or the expired list
+};
+
+/**
+ * @brief Create a wheel
+ *
+ * @param tick_ms Tick length in milliseconds, the timer resolution
+ * @param run_thread Start a thread that advances the wheel in real time; without one the owner calls timing_wheel_advance
+ * @param wheel Output wheel
+ * @return status_t Status code
+ */
+status_t timing_wheel_create(uint32_t tick_ms, bool run_thread, timing_wheel_t** wheel);
+
+/**
+ * @brief Stop the wheel thread and free the wheel
+ *
+ * Timers still pending are dropped without running.
+ *
+ * @param wheel Wheel
+ */
+void timing_wheel_destroy(timing_wheel_t* wheel);
+
+/**
+ * @brief Tick length in milliseconds
+ */
+uint32_t timing_wheel_tick_ms(const timing_wheel_t* wheel);
+
+/**
+ * @brief Prepare a timer before its first use
+ *
+ * @param timer Timer
+ * @param callback Expiry callback
+ * @param arg Callback argument
+ */
+void timing_wheel_timer_init(timing_wheel_timer_t* timer, timing_wheel_callback_t callback, void* arg);
+
+/**
+ * @brief Arm a timer, moving it if it is already pending
+ *
+ * The timer fires once, no earlier than delay_ms from now and at most one
+ * tick later.
+ *
+ * @param wheel Wheel
+ * @param timer Timer
+ * @param delay_ms Delay in milliseconds
+ * @return status_t Status code
+ */
+status_t timing_wheel_schedule(timing_wheel_t* wheel, timing_wheel_timer_t* timer, uint64_t delay_ms);
+
+/**
+ * @brief Disarm a timer
+ *
+ * Once this returns the callback is not running and will not run again
+ * unless the timer is rescheduled, so its owner can be freed. Called from
+ * another thread it waits for a callback in progress; from the callback's
+ * own thread it returns at once.
+ *
+ * @param wheel Wheel
+ * @param timer Timer
+ */
+void timing_wheel_cancel(timing_wheel_t* wheel, timing_wheel_timer_t* timer);
+
+/**
+ * @brief Run a wheel without a thread forward by some ticks, firing what expires
+ *
+ * @param wheel Wheel created without a thread
+ * @param ticks Ticks to advance
+ */
+void timing_wheel_advance(timing_wheel_t* wheel, uint64_t ticks);
+
+/**
+ * @brief Monotonic time in milliseconds, the clock the wheel runs on
+ */
+uint64_t timing_wheel_now_ms(void);
+
+#endif /* DINOC_TIMING_WHEEL_H */
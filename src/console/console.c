@@ -10,6 +10,7 @@
 #include "../include/task.h"
 #include "../include/protocol.h"
 #include "../common/uuid.h"
+#include "../common/epoch.h"
 #include "../common/logger.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -433,20 +434,24 @@ static status_t console_cmd_clients(int argc, char** argv) {
     }
     
     if (argc == 1) {
-        // List all clients
-        client_t** clients = NULL;
-        size_t count = 0;
-        
-        status_t status = client_get_all(&clients, &count);
-        if (status != STATUS_SUCCESS) {
-            fprintf(stderr, "Error: Failed to get clients: %d\n", status);
-            return status;
+        // List all clients from a snapshot, without holding up registrations
+        const client_snapshot_t* snapshot = client_snapshot_acquire();
+        if (snapshot == NULL) {
+            fprintf(stderr, "Error: Failed to get clients: %d\n", STATUS_ERROR_MEMORY);
+            return STATUS_ERROR_MEMORY;
         }
         
+        client_t* const* clients = snapshot->clients;
+        size_t count = snapshot->count;
+        
         if (count == 0) {
             printf("No clients connected\n");
         } else {
-            printf("Connected clients (%zu):\n", count);
+            size_t states[CLIENT_STATE_COUNT];
+            client_count_states(states);
+            
+            printf("Connected clients (%zu, %zu active, %zu inactive):\n", count,
+                   states[CLIENT_STATE_ACTIVE], states[CLIENT_STATE_INACTIVE]);
             printf("%-36s %-15s %-20s %-10s %-20s\n", "ID", "IP Address", "Hostname", "State", "Last Seen");
             printf("--------------------------------------------------------------------------------\n");
             
@@ -490,8 +495,8 @@ static status_t console_cmd_clients(int argc, char** argv) {
             }
         }
         
-        // Free client array
-        free(clients);
+        // Release snapshot
+        client_snapshot_release(snapshot);
     } else {
         // Show client details
         uuid_t id;
@@ -507,6 +512,9 @@ static status_t console_cmd_clients(int argc, char** argv) {
             return STATUS_ERROR_NOT_FOUND;
         }
         
+        // The reference keeps the client, the read section its strings
+        epoch_enter();
+        
         printf("Client Details:\n");
         char id_str[37];
         uuid_to_string(client->id, id_str, sizeof(id_str));
@@ -580,6 +588,9 @@ static status_t console_cmd_clients(int argc, char** argv) {
         
         printf("Loaded Modules: %zu\n", client->modules_count);
         // In a real implementation, you would list the loaded modules here
+        
+        epoch_exit();
+        client_release(client);
     }
     
     fprintf(stderr, "Console thread created\n");
@@ -617,8 +628,48 @@ static status_t console_cmd_listeners(int argc, char** argv) {
         return STATUS_ERROR_INVALID_PARAM;
     }
     
-    // In a real implementation, you would get the listeners from the protocol manager
-    printf("Listener listing not implemented yet\n");
+    protocol_listener_t** listeners = NULL;
+    size_t count = 0;
+    
+    status_t status = protocol_manager_get_listeners(&listeners, &count);
+    if (status != STATUS_SUCCESS) {
+        fprintf(stderr, "Error: Failed to get listeners: %d\n", status);
+        return status;
+    }
+    
+    size_t shown = 0;
+    
+    for (size_t i = 0; i < count; i++) {
+        const char* type_str = protocol_type_name(listeners[i]->protocol_type);
+        
+        // Filter by protocol type
+        if (argc == 2 && strcmp(argv[1], type_str) != 0) {
+            continue;
+        }
+        
+        char id_str[37];
+        uuid_to_string(listeners[i]->id, id_str, sizeof(id_str));
+        printf("%-36s %-6s\n", id_str, type_str);
+        
+        // Listener counters
+        protocol_stat_t stats[PROTOCOL_MAX_STATS];
+        size_t stat_count = PROTOCOL_MAX_STATS;
+        
+        if (protocol_manager_get_stats(listeners[i], stats, &stat_count) == STATUS_SUCCESS) {
+            for (size_t j = 0; j < stat_count; j++) {
+                printf("    %-20s %llu\n", stats[j].name, (unsigned long long)stats[j].value);
+            }
+        }
+        
+        shown++;
+    }
+    
+    if (shown == 0) {
+        printf("No listeners\n");
+    }
+    
+    // Free listener array
+    free(listeners);
     
     return STATUS_SUCCESS;
 }
@@ -639,13 +690,15 @@ static status_t console_cmd_shell(int argc, char** argv) {
         return STATUS_ERROR_INVALID_PARAM;
     }
     
-    // Find client
+    // Find client, only its existence is checked
     client_t* client = client_find(&client_id);
     if (client == NULL) {
         fprintf(stderr, "Error: Client not found\n");
         return STATUS_ERROR_NOT_FOUND;
     }
     
+    client_release(client);
+    
     // Build command string
     char* command = argv[2];
     for (int i = 3; i < argc; i++) {
@@ -695,13 +748,15 @@ static status_t console_cmd_download(int argc, char** argv) {
         return STATUS_ERROR_INVALID_PARAM;
     }
     
-    // Find client
+    // Find client, only its existence is checked
     client_t* client = client_find(&client_id);
     if (client == NULL) {
         fprintf(stderr, "Error: Client not found\n");
         return STATUS_ERROR_NOT_FOUND;
     }
     
+    client_release(client);
+    
     // Get remote path
     const char* remote_path = argv[2];
     
@@ -744,13 +799,15 @@ static status_t console_cmd_upload(int argc, char** argv) {
         return STATUS_ERROR_INVALID_PARAM;
     }
     
-    // Find client
+    // Find client, only its existence is checked
     client_t* client = client_find(&client_id);
     if (client == NULL) {
         fprintf(stderr, "Error: Client not found\n");
         return STATUS_ERROR_NOT_FOUND;
     }
     
+    client_release(client);
+    
     // Get local path
     const char* local_path = argv[2];
     
@@ -780,13 +837,15 @@ static status_t console_cmd_module(int argc, char** argv) {
         return STATUS_ERROR_INVALID_PARAM;
     }
     
-    // Find client
+    // Find client, only its existence is checked
     client_t* client = client_find(&client_id);
     if (client == NULL) {
         fprintf(stderr, "Error: Client not found\n");
         return STATUS_ERROR_NOT_FOUND;
     }
     
+    client_release(client);
+    
     // Get operation
     const char* operation = argv[2];
     
@@ -841,13 +900,15 @@ static status_t console_cmd_config(int argc, char** argv) {
         return STATUS_ERROR_INVALID_PARAM;
     }
     
-    // Find client
+    // Find client, only its existence is checked
     client_t* client = client_find(&client_id);
     if (client == NULL) {
         fprintf(stderr, "Error: Client not found\n");
         return STATUS_ERROR_NOT_FOUND;
     }
     
+    client_release(client);
+    
     // Get key and value
     const char* key = argv[2];
     const char* value = argv[3];
@@ -899,11 +960,13 @@ static status_t console_cmd_switch(int argc, char** argv) {
     } else {
         fprintf(stderr, "Error: Invalid protocol type '%s'\n", protocol_type_str);
         fprintf(stderr, "Valid protocol types: tcp, udp, ws, icmp, dns\n");
+        client_release(client);
         return STATUS_ERROR_INVALID_PARAM;
     }
     
     // Switch protocol
     status_t status = client_switch_protocol(client, protocol_type);
+    client_release(client);
     
     if (status != STATUS_SUCCESS) {
         fprintf(stderr, "Error: Failed to switch protocol: %d\n", status);
@@ -58,4 +58,14 @@ status_t api_client_tasks_get(struct MHD_Connection* connection,
                             const char* url, const char* method,
                             const char* upload_data, size_t upload_data_size);
 
+// Listener API handlers
+status_t register_listener_api_handlers(void);
+
+status_t api_listeners_get(struct MHD_Connection* connection,
+                         const char* url, const char* method,
+                         const char* upload_data, size_t upload_data_size);
+status_t api_admission_get(struct MHD_Connection* connection,
+                         const char* url, const char* method,
+                         const char* upload_data, size_t upload_data_size);
+
 #endif /* DINOC_API_H */
@@ -8,6 +8,7 @@
 
 #include "common.h"
 #include "protocol.h"
+#include "../common/timing_wheel.h"
 #include <stdint.h>
 #include <stdbool.h>
 #include <time.h>
@@ -28,8 +29,20 @@ typedef enum {
     CLIENT_STATE_DISCONNECTED = 5  // Client is disconnected
 } client_state_t;
 
+// Number of client states, for arrays indexed by client_state_t
+#define CLIENT_STATE_COUNT (CLIENT_STATE_DISCONNECTED + 1)
+
 /**
  * @brief Client structure
+ * 
+ * Reference counted. client_register hands the caller the first reference,
+ * which client_destroy drops; anyone else holding the client across calls
+ * takes their own with client_acquire. The struct is freed after the last
+ * release, once no snapshot reader can still see it.
+ * 
+ * Listeners keep the registration reference for the life of the connection
+ * or session. Functions taking a client_t* borrow the caller's reference for
+ * the call; the task manager and the API refer to clients by ID only.
  */
 struct client {
     uuid_t id;                     // Client ID
@@ -47,8 +60,22 @@ struct client {
     uint32_t heartbeat_jitter;     // Heartbeat jitter in seconds
     void* modules;                 // Loaded modules
     size_t modules_count;          // Number of loaded modules
+    struct client* registry_next;  // Next client in the registry hash bucket
+    uint32_t refcount;             // References held, updated atomically
+    bool registered;               // Linked into the registry
+    size_t hot_slot;               // Slot in the registry's hot-field columns
+    timing_wheel_timer_t heartbeat_timer; // Armed for the heartbeat deadline while active
 };
 
+/**
+ * @brief Read-only list of the registered clients at some recent point
+ */
+typedef struct {
+    uint64_t version;              // Registry version it was built from
+    size_t count;                  // Number of clients
+    client_t* clients[];           // Clients, in no particular order
+} client_snapshot_t;
+
 /**
  * @brief Initialize client manager
  * 
@@ -111,6 +138,14 @@ status_t client_set_heartbeat(client_t* client, uint32_t interval, uint32_t jitt
  */
 status_t client_heartbeat(client_t* client);
 
+/**
+ * @brief Record that a client was just seen
+ * 
+ * @param client Client to update
+ * @return status_t Status code
+ */
+status_t client_touch(client_t* client);
+
 /**
  * @brief Send heartbeat request to client
  * 
@@ -160,22 +195,84 @@ status_t client_unload_module(client_t* client, const char* module_name);
  * @brief Find a client by ID
  * 
  * @param id Client ID
- * @return client_t* Found client or NULL if not found
+ * @return client_t* Found client with a reference the caller releases, or NULL if not found
  */
 client_t* client_find(const uuid_t* id);
 
 /**
  * @brief Get all clients
  * 
+ * The caller releases each client and frees the array.
+ * 
  * @param clients Pointer to store clients array
  * @param count Pointer to store number of clients
  * @return status_t Status code
  */
 status_t client_get_all(client_t*** clients, size_t* count);
 
+/**
+ * @brief Count registered clients in each state
+ * 
+ * Reads only the registry's dense state columns, not the clients themselves.
+ * 
+ * @param counts Output counts indexed by client_state_t
+ */
+void client_count_states(size_t counts[CLIENT_STATE_COUNT]);
+
+/**
+ * @brief Get registered clients not seen since a given time
+ * 
+ * Scans the registry's dense last-seen columns and touches only the clients
+ * that match. The caller releases each client and frees the array.
+ * 
+ * @param since Clients last seen before this time are returned
+ * @param clients Pointer to store clients array
+ * @param count Pointer to store number of clients
+ * @return status_t Status code
+ */
+status_t client_get_idle(time_t since, client_t*** clients, size_t* count);
+
+/**
+ * @brief Get a read-only snapshot of all clients
+ * 
+ * Takes no registry lock unless the snapshot is stale and has to be
+ * rebuilt. The snapshot and the clients in it, string fields included, stay
+ * valid until released even if clients are destroyed meanwhile; release it
+ * promptly, it holds back reclamation of everything retired meanwhile.
+ * 
+ * @return const client_snapshot_t* Snapshot, or NULL if out of memory
+ */
+const client_snapshot_t* client_snapshot_acquire(void);
+
+/**
+ * @brief Release a snapshot from client_snapshot_acquire
+ * 
+ * @param snapshot Snapshot, must be released on the thread that acquired it
+ */
+void client_snapshot_release(const client_snapshot_t* snapshot);
+
+/**
+ * @brief Take a reference to a client
+ * 
+ * @param client Client the caller holds a reference to or can see from a snapshot
+ * @return client_t* The client, or NULL if its last reference is already gone
+ */
+client_t* client_acquire(client_t* client);
+
+/**
+ * @brief Drop a reference to a client
+ * 
+ * @param client Client
+ */
+void client_release(client_t* client);
+
 /**
  * @brief Destroy a client
  * 
+ * Removes the client from the registry and drops the reference from
+ * client_register. Holders of other references can keep using it until
+ * they release them.
+ * 
  * @param client Client to destroy
  * @return status_t Status code
  */
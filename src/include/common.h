@@ -37,7 +37,8 @@ typedef enum {
     STATUS_ERROR_BIND = -21,
     STATUS_ERROR_LISTEN = -22,
     STATUS_ERROR_THREAD = -23,
-    STATUS_ERROR_SEND = -24
+    STATUS_ERROR_SEND = -24,
+    STATUS_ERROR_WOULD_BLOCK = -25
 } status_t;
 
 // Forward declarations
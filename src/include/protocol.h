@@ -13,6 +13,8 @@
 // Forward declarations
 typedef struct protocol_listener protocol_listener_t;
 typedef struct client client_t;
+typedef struct reactor reactor_t;
+typedef struct timing_wheel timing_wheel_t;
 
 // Protocol types
 typedef enum {
@@ -23,6 +25,19 @@ typedef enum {
     PROTOCOL_TYPE_DNS = 4
 } protocol_type_t;
 
+// Connection I/O models (stream listeners)
+typedef enum {
+    PROTOCOL_IO_MODEL_THREAD = 0,  // One thread per connection
+    PROTOCOL_IO_MODEL_EPOLL = 1,   // Edge-triggered epoll loops shared by many connections
+    PROTOCOL_IO_MODEL_URING = 2    // Single io_uring instance (falls back to epoll)
+} protocol_io_model_t;
+
+// Packet capture backends (ICMP listener)
+typedef enum {
+    PROTOCOL_CAPTURE_PCAP = 0,     // libpcap with a read timeout, one copy per packet
+    PROTOCOL_CAPTURE_RING = 1      // mmap'd AF_PACKET TPACKET_V3 ring read in place
+} protocol_capture_backend_t;
+
 // Protocol message structure
 typedef struct {
     uint8_t* data;
@@ -33,12 +48,32 @@ typedef struct {
 typedef struct {
     char* bind_address;
     uint16_t port;
-    uint32_t timeout_ms;
+    uint32_t timeout_ms;  // Idle session timeout (0 = listener default, TCP/WebSocket never reap)
     char* domain;         // For DNS protocol
     char* pcap_device;    // For ICMP protocol
+    protocol_capture_backend_t capture_backend; // For ICMP protocol
     char* ws_path;        // For WebSocket protocol
+    bool ws_deflate;                  // WebSocket: offer permessage-deflate
+    uint32_t ws_deflate_window_bits;  // WebSocket: server compression window bits, 9-15 (0 = 15)
+    uint32_t ws_deflate_mem_level;    // WebSocket: zlib memory level, 1-9 (0 = 8)
+    protocol_io_model_t io_model; // For TCP protocol
+    uint32_t loop_threads;        // TCP epoll event loops or WebSocket service threads (0 = one per core)
+    uint32_t acceptor_shards;     // SO_REUSEPORT accept sockets pinned to cores (0/1 = single acceptor)
+    uint32_t max_message_size;    // Largest inbound TCP frame (0 = 16 MiB)
+    uint32_t send_high_water;     // Queued outbound TCP/WebSocket bytes before sends are refused (0 = 4 MiB)
+    uint32_t workers;             // UDP receive workers, each with its own SO_REUSEPORT socket (0/1 = single)
+    bool socket_filter;           // UDP/ICMP: drop non-protocol traffic in the kernel with a BPF filter
 } protocol_listener_config_t;
 
+// Listener counter (name is a static string)
+typedef struct {
+    const char* name;
+    uint64_t value;
+} protocol_stat_t;
+
+// Most counters a listener reports
+#define PROTOCOL_MAX_STATS 16
+
 // Protocol listener interface
 struct protocol_listener {
     uuid_t id;
@@ -54,11 +89,28 @@ struct protocol_listener {
                                  void (*on_message_received)(protocol_listener_t*, client_t*, protocol_message_t*),
                                  void (*on_client_connected)(protocol_listener_t*, client_t*),
                                  void (*on_client_disconnected)(protocol_listener_t*, client_t*));
+    
+    // Optional, NULL for listeners without an outbound queue
+    status_t (*get_send_backlog)(protocol_listener_t* listener, client_t* client, size_t* queued_bytes, bool* backed_up);
+    
+    // Optional, NULL for listeners without counters; *count is the capacity in, the number filled out
+    status_t (*get_stats)(protocol_listener_t* listener, protocol_stat_t* stats, size_t* count);
+    
+    // Optional, NULL for listeners that always run their own threads; called before start so the
+    // listener registers its descriptors with the shared reactor instead
+    status_t (*attach_reactor)(protocol_listener_t* listener, reactor_t* reactor);
+    
+    // Optional, NULL for listeners without connections to reap; called before start so the
+    // listener closes connections idle for its timeout_ms on the shared timing wheel
+    status_t (*attach_timing_wheel)(protocol_listener_t* listener, timing_wheel_t* wheel);
 };
 
 // Protocol manager functions
 status_t protocol_manager_init(void);
 status_t protocol_manager_shutdown(void);
+status_t protocol_manager_start_reactor(size_t loop_threads);
+reactor_t* protocol_manager_get_reactor(void);
+timing_wheel_t* protocol_manager_get_timing_wheel(void);
 
 status_t protocol_manager_create_listener(protocol_type_t type, const protocol_listener_config_t* config, protocol_listener_t** listener);
 status_t protocol_manager_destroy_listener(protocol_listener_t* listener);
@@ -67,6 +119,10 @@ status_t protocol_manager_start_listener(protocol_listener_t* listener);
 status_t protocol_manager_stop_listener(protocol_listener_t* listener);
 
 status_t protocol_manager_send_message(protocol_listener_t* listener, client_t* client, protocol_message_t* message);
+status_t protocol_manager_get_send_backlog(protocol_listener_t* listener, client_t* client, size_t* queued_bytes, bool* backed_up);
+status_t protocol_manager_get_stats(protocol_listener_t* listener, protocol_stat_t* stats, size_t* count);
+status_t protocol_manager_get_listeners(protocol_listener_t*** listeners, size_t* count);
+const char* protocol_type_name(protocol_type_t type);
 
 status_t protocol_manager_register_callbacks(protocol_listener_t* listener,
                                            void (*on_message_received)(protocol_listener_t*, client_t*, protocol_message_t*),
@@ -7,6 +7,7 @@
 #define DINOC_SERVER_H
 
 #include "common.h"
+#include "protocol.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -16,12 +17,31 @@
 typedef struct {
     char* config_file;            // Configuration file path
     char* bind_address;           // Bind address for listeners
+    uint32_t reactor_threads;     // Shared reactor loop threads for UDP, DNS, ICMP and epoll TCP (0 = disabled)
+    uint32_t admission_rate;      // New sessions per second across all listeners (0 = unlimited)
+    uint32_t admission_burst;     // Sessions admitted back to back (0 = admission_rate)
+    uint32_t admission_subnet_rate;  // New sessions per second per source /24 (0 = unlimited)
+    uint32_t admission_subnet_burst; // Per-subnet burst (0 = admission_subnet_rate)
+    uint32_t idle_timeout_ms;     // Close TCP/WebSocket connections silent this long (0 = never)
     uint16_t tcp_port;            // TCP port
+    protocol_io_model_t tcp_io_model; // TCP connection I/O model
+    uint32_t tcp_loop_threads;    // TCP event loop threads (0 = one per core)
+    uint32_t tcp_acceptor_shards; // TCP SO_REUSEPORT accept shards (0/1 = single acceptor)
+    uint32_t tcp_max_message_size; // Largest inbound TCP message (0 = 16 MiB)
+    uint32_t tcp_send_high_water;  // Queued outbound bytes per TCP client before sends are refused (0 = 4 MiB)
     uint16_t udp_port;            // UDP port
+    uint32_t udp_workers;         // UDP SO_REUSEPORT receive workers (0/1 = single worker)
+    bool udp_socket_filter;       // Drop non-protocol UDP datagrams in the kernel
     uint16_t ws_port;             // WebSocket port
+    uint32_t ws_service_threads;  // WebSocket service threads (0 = one per core)
+    bool ws_deflate;              // Negotiate permessage-deflate on WebSocket connections
+    uint32_t ws_deflate_window_bits; // permessage-deflate window bits (9-15)
+    uint32_t ws_deflate_mem_level;   // permessage-deflate zlib memory level (1-9)
     uint16_t dns_port;            // DNS port
     char* dns_domain;             // DNS domain
     char* pcap_device;            // PCAP device for ICMP
+    protocol_capture_backend_t icmp_capture; // ICMP packet capture backend
+    bool icmp_socket_filter;      // Drop echo requests without protocol traffic in the kernel
     uint16_t http_api_port;       // HTTP API port
     char* log_file;               // Log file path
     uint8_t log_level;            // Log level
@@ -61,9 +61,9 @@ int main(int argc, char** argv) {
     // Wait for signal
     printf("Server started, press Ctrl+C to stop\n");
     
-    // Main loop
+    // Main loop: sleep until a signal arrives, the handler exits the process
     while (1) {
-        sleep(1);
+        pause();
     }
     
     // This point should never be reached
@@ -363,6 +363,12 @@ status_t module_execute_on_client(client_t* client, module_t* module, const char
         return STATUS_ERROR_INVALID_PARAM;
     }
     
+    // Don't queue more work behind a client that is not reading
+    bool backed_up = false;
+    if (protocol_manager_get_send_backlog(client->listener, client, NULL, &backed_up) == STATUS_SUCCESS && backed_up) {
+        return STATUS_ERROR_WOULD_BLOCK;
+    }
+    
     // Create task to execute module command
     task_t* task = NULL;
     
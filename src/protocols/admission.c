@@ -0,0 +1,283 @@
+/**
+ * @file admission.c
+ * @brief Token-bucket admission control for new sessions, shared by all listeners
+ */
+
+#define _GNU_SOURCE /* For getrandom */
+
+#include "admission.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/random.h>
+#include <arpa/inet.h>
+
+// Buckets count thousandths of a token, so slow rates still refill every millisecond
+#define ADMISSION_TOKEN 1000
+
+// Token bucket
+typedef struct {
+    uint64_t tokens;            // Thousandths of a token
+    uint64_t last_ms;           // Monotonic time of the last refill
+} admission_bucket_t;
+
+// Per-subnet bucket slot
+typedef struct {
+    uint32_t prefix;            // Source /24, host byte order
+    bool used;
+    admission_bucket_t bucket;
+} admission_subnet_t;
+
+// Admission controller
+typedef struct {
+    pthread_mutex_t mutex;      // Guards everything below
+    bool enabled;               // Any limit set, read without the mutex on the fast path
+    admission_config_t config;
+    admission_bucket_t global;
+    admission_subnet_t subnets[ADMISSION_SUBNET_SLOTS];
+    uint64_t seed;              // Hash seed, so sources cannot be picked to collide
+    admission_stats_t stats;
+} admission_t;
+
+static admission_t admission = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER
+};
+
+// Forward declarations
+static void admission_refill(admission_bucket_t* bucket, uint32_t rate, uint32_t burst, uint64_t now_ms);
+static admission_subnet_t* admission_subnet_get(uint32_t prefix, uint64_t now_ms);
+static size_t admission_subnet_hash(uint32_t prefix);
+static bool admission_take(const struct sockaddr_in* addr, uint64_t now_ms);
+static uint64_t admission_now_ms(void);
+
+/**
+ * @brief Set the limits, refilling every bucket
+ */
+status_t admission_configure(const admission_config_t* config) {
+    if (config == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    pthread_mutex_lock(&admission.mutex);
+    
+    admission.config = *config;
+    if (admission.config.burst == 0) {
+        admission.config.burst = admission.config.rate;
+    }
+    if (admission.config.subnet_burst == 0) {
+        admission.config.subnet_burst = admission.config.subnet_rate;
+    }
+    
+    // Start full, a restart should not refuse the first clients back
+    uint64_t now_ms = admission_now_ms();
+    admission.global.tokens = (uint64_t)admission.config.burst * ADMISSION_TOKEN;
+    admission.global.last_ms = now_ms;
+    
+    memset(admission.subnets, 0, sizeof(admission.subnets));
+    memset(&admission.stats, 0, sizeof(admission.stats));
+    
+    if (getrandom(&admission.seed, sizeof(admission.seed), GRND_NONBLOCK) != sizeof(admission.seed)) {
+        admission.seed = (uint64_t)time(NULL) ^ (uint64_t)(uintptr_t)&admission;
+    }
+    
+    __atomic_store_n(&admission.enabled, config->rate > 0 || config->subnet_rate > 0, __ATOMIC_RELEASE);
+    
+    pthread_mutex_unlock(&admission.mutex);
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Get the limits in force
+ */
+void admission_get_config(admission_config_t* config) {
+    if (config == NULL) {
+        return;
+    }
+    
+    pthread_mutex_lock(&admission.mutex);
+    *config = admission.config;
+    pthread_mutex_unlock(&admission.mutex);
+}
+
+/**
+ * @brief Take a token for a new session from a source address
+ */
+bool admission_allow(const struct sockaddr_in* addr) {
+    if (!__atomic_load_n(&admission.enabled, __ATOMIC_ACQUIRE)) {
+        return true;
+    }
+    
+    return admission_take(addr, admission_now_ms());
+}
+
+/**
+ * @brief admission_allow with the monotonic time supplied by the caller
+ */
+bool admission_allow_at(const struct sockaddr_in* addr, uint64_t now_ms) {
+    if (!__atomic_load_n(&admission.enabled, __ATOMIC_ACQUIRE)) {
+        return true;
+    }
+    
+    return admission_take(addr, now_ms);
+}
+
+/**
+ * @brief admission_allow for an accepted socket, using its peer address
+ */
+bool admission_allow_socket(int fd) {
+    if (!__atomic_load_n(&admission.enabled, __ATOMIC_ACQUIRE)) {
+        return true;
+    }
+    
+    struct sockaddr_storage peer;
+    socklen_t peer_len = sizeof(peer);
+    
+    if (getpeername(fd, (struct sockaddr*)&peer, &peer_len) == 0 && peer.ss_family == AF_INET) {
+        return admission_take((const struct sockaddr_in*)&peer, admission_now_ms());
+    }
+    
+    return admission_take(NULL, admission_now_ms());
+}
+
+/**
+ * @brief Get the admission counters
+ */
+void admission_get_stats(admission_stats_t* stats) {
+    if (stats == NULL) {
+        return;
+    }
+    
+    pthread_mutex_lock(&admission.mutex);
+    
+    *stats = admission.stats;
+    stats->tracked_subnets = 0;
+    
+    for (size_t i = 0; i < ADMISSION_SUBNET_SLOTS; i++) {
+        if (admission.subnets[i].used) {
+            stats->tracked_subnets++;
+        }
+    }
+    
+    pthread_mutex_unlock(&admission.mutex);
+}
+
+/**
+ * @brief Charge the global and source /24 buckets for one session
+ *
+ * @param addr Source address, NULL to charge only the global bucket
+ * @param now_ms Monotonic time in milliseconds
+ * @return bool Whether both buckets had a token
+ */
+static bool admission_take(const struct sockaddr_in* addr, uint64_t now_ms) {
+    const admission_config_t* config = &admission.config;
+    
+    pthread_mutex_lock(&admission.mutex);
+    
+    // Check both buckets before charging either
+    admission_subnet_t* subnet = NULL;
+    
+    if (config->subnet_rate > 0 && addr != NULL) {
+        subnet = admission_subnet_get(ntohl(addr->sin_addr.s_addr) & 0xFFFFFF00u, now_ms);
+        admission_refill(&subnet->bucket, config->subnet_rate, config->subnet_burst, now_ms);
+        
+        if (subnet->bucket.tokens < ADMISSION_TOKEN) {
+            admission.stats.rejected_subnet++;
+            pthread_mutex_unlock(&admission.mutex);
+            return false;
+        }
+    }
+    
+    if (config->rate > 0) {
+        admission_refill(&admission.global, config->rate, config->burst, now_ms);
+        
+        if (admission.global.tokens < ADMISSION_TOKEN) {
+            admission.stats.rejected_global++;
+            pthread_mutex_unlock(&admission.mutex);
+            return false;
+        }
+        
+        admission.global.tokens -= ADMISSION_TOKEN;
+    }
+    
+    if (subnet != NULL) {
+        subnet->bucket.tokens -= ADMISSION_TOKEN;
+    }
+    
+    admission.stats.admitted++;
+    
+    pthread_mutex_unlock(&admission.mutex);
+    
+    return true;
+}
+
+/**
+ * @brief Add the tokens earned since the last refill, up to the bucket depth
+ */
+static void admission_refill(admission_bucket_t* bucket, uint32_t rate, uint32_t burst, uint64_t now_ms) {
+    uint64_t limit = (uint64_t)burst * ADMISSION_TOKEN;
+    
+    // Callers may pass slightly stale times, never refill backwards
+    if (now_ms > bucket->last_ms) {
+        uint64_t earned = (now_ms - bucket->last_ms) * rate;
+        bucket->tokens = bucket->tokens + earned < limit ? bucket->tokens + earned : limit;
+        bucket->last_ms = now_ms;
+    }
+}
+
+/**
+ * @brief Find the bucket for a /24, claiming a free or least recently used slot for new ones
+ */
+static admission_subnet_t* admission_subnet_get(uint32_t prefix, uint64_t now_ms) {
+    size_t index = admission_subnet_hash(prefix);
+    admission_subnet_t* victim = NULL;
+    
+    for (size_t i = 0; i < ADMISSION_SUBNET_PROBES; i++) {
+        admission_subnet_t* slot = &admission.subnets[(index + i) & (ADMISSION_SUBNET_SLOTS - 1)];
+        
+        if (slot->used && slot->prefix == prefix) {
+            return slot;
+        }
+        
+        // Prefer a free slot, otherwise the one idle the longest
+        if (victim == NULL || (!slot->used && victim->used) ||
+            (slot->used && victim->used && slot->bucket.last_ms < victim->bucket.last_ms)) {
+            victim = slot;
+        }
+    }
+    
+    // New subnets start with a full bucket
+    victim->prefix = prefix;
+    victim->used = true;
+    victim->bucket.tokens = (uint64_t)admission.config.subnet_burst * ADMISSION_TOKEN;
+    victim->bucket.last_ms = now_ms;
+    
+    return victim;
+}
+
+/**
+ * @brief Hash a /24 prefix (splitmix64 finaliser over the seeded key)
+ */
+static size_t admission_subnet_hash(uint32_t prefix) {
+    uint64_t x = (uint64_t)prefix ^ admission.seed;
+    
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    
+    return (size_t)(x & (ADMISSION_SUBNET_SLOTS - 1));
+}
+
+/**
+ * @brief Monotonic time in milliseconds
+ */
+static uint64_t admission_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file admission.h
+ * @brief Token-bucket admission control for new sessions, shared by all listeners
+ */
+
+#ifndef DINOC_ADMISSION_H
+#define DINOC_ADMISSION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <netinet/in.h>
+#include "../include/common.h"
+
+/**
+ * @brief Per-subnet bucket table size and probe length
+ *
+ * When every slot in a probe window is busy the least recently used one is
+ * recycled, so memory stays fixed however many subnets connect.
+ */
+#define ADMISSION_SUBNET_SLOTS 4096
+#define ADMISSION_SUBNET_PROBES 8
+
+/**
+ * @brief Admission limits (a zero rate disables that bucket)
+ */
+typedef struct {
+    uint32_t rate;              // New sessions per second across all listeners
+    uint32_t burst;             // Global bucket depth (0 = rate)
+    uint32_t subnet_rate;       // New sessions per second per source /24
+    uint32_t subnet_burst;      // Per-subnet bucket depth (0 = subnet_rate)
+} admission_config_t;
+
+/**
+ * @brief Admission counters
+ */
+typedef struct {
+    uint64_t admitted;          // Sessions let through while a limit was set
+    uint64_t rejected_global;   // Refused by the global bucket
+    uint64_t rejected_subnet;   // Refused by the source /24 bucket
+    uint64_t tracked_subnets;   // Subnet buckets currently held
+} admission_stats_t;
+
+/**
+ * @brief Set the limits, refilling every bucket
+ *
+ * @param config Limits
+ * @return status_t Status code
+ */
+status_t admission_configure(const admission_config_t* config);
+
+/**
+ * @brief Get the limits in force
+ *
+ * @param config Output limits
+ */
+void admission_get_config(admission_config_t* config);
+
+/**
+ * @brief Take a token for a new session from a source address
+ *
+ * Called by listeners before client_register. Both the global and the
+ * source /24 bucket must have a token, and neither is charged when the
+ * other refuses.
+ *
+ * @param addr Source address
+ * @return bool Whether the session may be created
+ */
+bool admission_allow(const struct sockaddr_in* addr);
+
+/**
+ * @brief admission_allow with the monotonic time supplied by the caller
+ *
+ * @param addr Source address
+ * @param now_ms Monotonic time in milliseconds
+ * @return bool Whether the session may be created
+ */
+bool admission_allow_at(const struct sockaddr_in* addr, uint64_t now_ms);
+
+/**
+ * @brief admission_allow for an accepted socket, using its peer address
+ *
+ * Peers that are not IPv4 are only charged to the global bucket.
+ *
+ * @param fd Connected socket
+ * @return bool Whether the session may be created
+ */
+bool admission_allow_socket(int fd);
+
+/**
+ * @brief Get the admission counters
+ *
+ * @param stats Output counters
+ */
+void admission_get_stats(admission_stats_t* stats);
+
+#endif /* DINOC_ADMISSION_H */
@@ -1,61 +1,187 @@
 /**
  * @file dns_listener.c
  * @brief Implementation of DNS protocol listener
+ *
+ * Authoritative UDP DNS server for the configured domain. Clients carry data
+ * upstream in the query name and poll for downstream data with TXT queries:
+ *
+ *   <nonce>.<hex data>...<hex data>.<domain>
+ *
+ * The first label below the domain is a cache-busting nonce and is ignored,
+ * the remaining labels are hex and are concatenated into one message. A TXT
+ * answer carries the next queued downstream message (hex, in 255 byte
+ * strings); A and AAAA answers acknowledge the query and report how many
+ * downstream messages are queued.
+ *
+ * Resolvers retransmit and fan out identical queries, so answers are cached
+ * briefly per (question, client): a repeat gets the same answer, including
+ * the same downstream message, without being dispatched again.
  */
 
-#define _GNU_SOURCE /* For strdup */
+#define _GNU_SOURCE /* For strdup and recvmmsg */
 
 #include "../include/protocol.h"
 #include "../common/uuid.h"
 #include "../include/common.h"
 #include "../include/client.h"
+#include "../common/logger.h"
+#include "../common/codec.h"
+#include "../common/reactor.h"
 #include "protocol_fragmentation.h"
+#include "udp_sessions.h"
+#include "admission.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <pthread.h>
-#include <ares.h>
+#include <sys/socket.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <time.h>
 #include <errno.h>
+#include <sys/timerfd.h>
 
 // Heartbeat magic number
 #define HEARTBEAT_MAGIC 0x48454152  // "HEAR"
 
 // DNS protocol constants
 #define DNS_MAX_DOMAIN_LENGTH 253
+#define DNS_MAX_NAME_LENGTH 255          // Wire format, including the root label
 #define DNS_MAX_LABEL_LENGTH 63
+#define DNS_MAX_LABELS 128
 #define DNS_MAX_TXT_LENGTH 255
+#define DNS_TXT_STRING_DATA (DNS_MAX_TXT_LENGTH / 2) // Data bytes per hex character string
 #define DNS_DEFAULT_PORT 53
 #define DNS_DEFAULT_TIMEOUT 5000
+#define DNS_HEADER_SIZE 12
+#define DNS_MAX_UDP_SIZE 512             // Largest response without EDNS
+
+// Largest downstream message that fits a single TXT answer in 512 bytes:
+// header (12) + question (259) + answer RR (12) + length byte + hex data
+#define DNS_MAX_MESSAGE_SIZE ((DNS_MAX_UDP_SIZE - DNS_HEADER_SIZE - (DNS_MAX_NAME_LENGTH + 4) - 12 - 1) / 2)
+
+// Downstream messages queued per client before sends are refused
+#define DNS_MAX_PENDING 1024
+
+// Batched I/O
+#define DNS_BATCH_SIZE 32                // Queries per recvmmsg/sendmmsg call
+#define DNS_MAX_QUERY_SIZE 1024          // Receive slot size (queries are small)
+
+// Idle clients are swept at most this often
+#define DNS_SWEEP_MS 1000
+
+// Header flags
+#define DNS_FLAG_QR 0x8000
+#define DNS_FLAG_AA 0x0400
+#define DNS_FLAG_RD 0x0100
+#define DNS_OPCODE_MASK 0x7800
+
+// Record types and classes
+#define DNS_TYPE_A 1
+#define DNS_TYPE_TXT 16
+#define DNS_TYPE_AAAA 28
+#define DNS_CLASS_IN 1
+
+// Response codes
+#define DNS_RCODE_NOERROR 0
+#define DNS_RCODE_FORMERR 1
+#define DNS_RCODE_NXDOMAIN 3
+#define DNS_RCODE_NOTIMP 4
+#define DNS_RCODE_REFUSED 5
+
+// TTL of every answer, zero so resolvers do not cache
+#define DNS_ANSWER_TTL 0
+
+// Response cache
+#define DNS_CACHE_SLOTS 1024             // Direct-mapped, power of two
+#define DNS_CACHE_TTL_MS 2000            // How long repeats of a query get the cached answer
+
+// Cached response, keyed by the question section and the client address
+typedef struct {
+    uint64_t hash;
+    uint64_t expires_ms;             // 0 = empty slot
+    uint32_t client_addr;
+    uint16_t question_len;
+    uint16_t response_len;
+    uint8_t question[DNS_MAX_NAME_LENGTH + 4];
+    uint8_t response[DNS_MAX_UDP_SIZE];
+} dns_cache_entry_t;
+
+// Queued downstream message
+typedef struct dns_pending {
+    struct dns_pending* next;
+    size_t len;
+    uint8_t data[];
+} dns_pending_t;
+
+// Peer state (client protocol context)
+typedef struct {
+    char address[INET_ADDRSTRLEN];   // Source IP address
+    dns_pending_t* pending_head;     // Downstream messages waiting for a TXT query
+    dns_pending_t* pending_tail;
+    size_t pending_count;
+} dns_peer_t;
+
+// Parsed query, pointing into the received datagram
+typedef struct {
+    uint16_t id;
+    uint16_t flags;
+    uint16_t qtype;
+    uint16_t qclass;
+    size_t question_len;             // Question section length (0 if not parsed)
+    int rcode;                       // Response code decided while parsing
+    uint8_t label_offsets[DNS_MAX_LABELS]; // Data label offsets within the name
+    size_t label_count;              // Data labels (below the domain, after the nonce)
+} dns_query_t;
 
 // DNS listener context
 typedef struct {
-    ares_channel channel;            // c-ares channel
+    protocol_listener_t base;        // Listener interface (must be first)
+    int socket;                      // Server socket
     pthread_t listener_thread;       // Listener thread
     bool running;                    // Running flag
+    
+    // Reactor mode: socket and sweep timer on one loop instead of the listener thread
+    reactor_t* reactor;
+    reactor_source_t* source;
+    reactor_source_t* sweep_source;
+    int sweep_fd;
     char* bind_address;              // Bind address
     uint16_t port;                   // Port
     char* domain;                    // Domain
     uint32_t timeout_ms;             // Timeout in milliseconds
     
+    // Domain in lowercase wire format, matched against query name suffixes
+    uint8_t domain_wire[DNS_MAX_NAME_LENGTH];
+    size_t domain_wire_len;
+    size_t domain_labels;
+    
     // Callbacks
     void (*on_message_received)(protocol_listener_t*, client_t*, protocol_message_t*);
     void (*on_client_connected)(protocol_listener_t*, client_t*);
     void (*on_client_disconnected)(protocol_listener_t*, client_t*);
     
-    // Client tracking
-    client_t** clients;              // Array of clients
-    size_t client_count;             // Number of clients
-    size_t client_capacity;          // Capacity of clients array
-    pthread_mutex_t clients_mutex;   // Mutex for clients array
-    
-    // File descriptors for select
-    fd_set read_fds;                 // Read file descriptors
-    fd_set write_fds;                // Write file descriptors
-    int max_fd;                      // Maximum file descriptor
+    // Client tracking (sessions keyed by source IP, owned by the listener thread)
+    udp_session_table_t sessions;
+    uint64_t last_sweep_ms;
+    pthread_mutex_t pending_mutex;   // Guards the peers' downstream queues
+    
+    // Response cache (owned by the listener thread)
+    dns_cache_entry_t* cache;
+    
+    // Counters, written by the listener thread only
+    uint64_t queries;
+    uint64_t cache_hits;
+    uint64_t cache_misses;
+    
+    // Batched I/O, one receive slot and one response slot per query
+    struct mmsghdr rx_msgs[DNS_BATCH_SIZE];
+    struct iovec rx_iov[DNS_BATCH_SIZE];
+    struct sockaddr_in rx_addrs[DNS_BATCH_SIZE];
+    struct iovec tx_iov[DNS_BATCH_SIZE];
+    uint8_t* rx_slab;
+    uint8_t* tx_slab;
 } dns_listener_ctx_t;
 
 // Forward declarations
@@ -64,256 +190,760 @@ static status_t dns_listener_start(protocol_listener_t* listener);
 static status_t dns_listener_stop(protocol_listener_t* listener);
 static status_t dns_listener_destroy(protocol_listener_t* listener);
 static status_t dns_listener_send_message(protocol_listener_t* listener, client_t* client, protocol_message_t* message);
+static status_t dns_listener_get_stats(protocol_listener_t* listener, protocol_stat_t* stats, size_t* count);
+static status_t dns_listener_attach_reactor(protocol_listener_t* listener, reactor_t* reactor);
 static status_t dns_listener_register_callbacks(protocol_listener_t* listener,
                                               void (*on_message_received)(protocol_listener_t*, client_t*, protocol_message_t*),
                                               void (*on_client_connected)(protocol_listener_t*, client_t*),
                                               void (*on_client_disconnected)(protocol_listener_t*, client_t*));
-static void dns_query_callback(void* arg, int status, int timeouts, unsigned char* abuf, int alen);
-static client_t* dns_find_client_by_address(dns_listener_ctx_t* ctx, const char* address);
-static status_t dns_add_client(dns_listener_ctx_t* ctx, const char* address, client_t** client);
-static status_t dns_encode_data_to_txt(const uint8_t* data, size_t data_len, char*** txt_records, size_t* txt_record_count);
-static status_t dns_decode_txt_to_data(const char* const* txt_records, size_t txt_record_count, uint8_t** data, size_t* data_len);
-
-/**
- * @brief DNS query callback
- */
-static void dns_query_callback(void* arg, int status, int timeouts, unsigned char* abuf, int alen) {
-    // This is called when a DNS query is received
-    // We need to parse the query and respond with our data
-    
-    // Implementation will be added in subsequent steps
-}
+static status_t dns_encode_domain(dns_listener_ctx_t* ctx, const char* domain);
+static status_t dns_parse_query(const dns_listener_ctx_t* ctx, const uint8_t* packet, size_t len, dns_query_t* query);
+static size_t dns_decode_labels(const uint8_t* packet, const dns_query_t* query, uint8_t* data, bool* valid);
+static size_t dns_build_response(dns_listener_ctx_t* ctx, const uint8_t* packet, const dns_query_t* query,
+                                 client_t* client, uint8_t* out);
+static uint8_t* dns_put16(uint8_t* out, uint16_t value);
+static uint8_t* dns_put_answer(uint8_t* out, uint16_t type, uint16_t rdlength);
+static dns_cache_entry_t* dns_cache_slot(dns_listener_ctx_t* ctx, const uint8_t* packet, const dns_query_t* query,
+                                         uint32_t client_addr, uint64_t* hash);
+static void dns_count(uint64_t* counter);
+static int dns_receive_batch(dns_listener_ctx_t* ctx, int flags);
+static void dns_process_query(dns_listener_ctx_t* ctx, size_t index, uint64_t now_ms);
+static void dns_flush_responses(dns_listener_ctx_t* ctx, size_t count);
+static client_t* dns_find_or_create_client(dns_listener_ctx_t* ctx, const struct sockaddr_in* addr, uint64_t now_ms);
+static void dns_session_closed(client_t* client, void* arg);
+static status_t dns_reactor_attach(dns_listener_ctx_t* ctx);
+static void dns_reactor_detach(dns_listener_ctx_t* ctx);
+static void dns_reactor_readable(int fd, uint32_t events, void* arg);
+static void dns_reactor_sweep(int fd, uint32_t events, void* arg);
 
 /**
  * @brief DNS listener thread
+ *
+ * Pulls up to DNS_BATCH_SIZE queries per recvmmsg call, answers each into
+ * its response slot and sends all answers with a single sendmmsg call.
  */
 static void* dns_listener_thread(void* arg) {
     protocol_listener_t* listener = (protocol_listener_t*)arg;
     dns_listener_ctx_t* ctx = (dns_listener_ctx_t*)listener;
     
-    // Set up file descriptors for select
-    struct timeval tv;
+    // Receive timeout in force: only while there are sessions to sweep
+    bool timed = false;
     
     // Run server loop
     while (ctx->running) {
-        // Initialize file descriptor sets
-        FD_ZERO(&ctx->read_fds);
-        FD_ZERO(&ctx->write_fds);
+        // Drop clients that have been silent for the listener timeout
+        uint64_t sweep_ms = udp_session_now_ms();
+        if (sweep_ms - ctx->last_sweep_ms >= DNS_SWEEP_MS) {
+            udp_session_table_expire(&ctx->sessions, sweep_ms, ctx->timeout_ms, dns_session_closed, ctx);
+            ctx->last_sweep_ms = sweep_ms;
+        }
         
-        // Note: c-ares processing is commented out due to missing library
-        /*
-        // Get file descriptors from c-ares
-        int nfds = ctx->max_fd + 1;
-        ares_fds(ctx->channel, &ctx->read_fds, &ctx->write_fds);
+        // Block without a timeout while idle, stop wakes the receive through shutdown()
+        bool want_timed = ctx->sessions.count > 0;
+        if (want_timed != timed) {
+            struct timeval tv;
+            tv.tv_sec = want_timed ? 1 : 0;
+            tv.tv_usec = 0;
+            
+            if (setsockopt(ctx->socket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) < 0) {
+                perror("setsockopt");
+            }
+            timed = want_timed;
+        }
         
-        // Set timeout
-        tv.tv_sec = 0;
-        tv.tv_usec = 100000; // 100ms
+        // Block for the first query, then take whatever else is queued
+        int count = dns_receive_batch(ctx, MSG_WAITFORONE);
         
-        // Wait for activity
-        int count = select(nfds, &ctx->read_fds, &ctx->write_fds, NULL, &tv);
+        // Woken by stop
+        if (!ctx->running) {
+            break;
+        }
         
         if (count < 0) {
-            if (errno != EINTR) {
-                // Fatal error
-                break;
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                // Timeout, continue
+                continue;
             }
-            continue;
+            
+            LOG_ERROR("DNS listener: recvmmsg failed: %s", strerror(errno));
+            break;
         }
-        
-        // Process c-ares events
-        ares_process(ctx->channel, &ctx->read_fds, &ctx->write_fds);
-        */
-        
-        // Simple sleep to avoid busy loop
-        usleep(100000); // 100ms
     }
     
     return NULL;
 }
 
 /**
- * @brief Find client by address
+ * @brief Receive up to DNS_BATCH_SIZE queries, answer them and send the answers
+ *
+ * @param ctx Listener context
+ * @param flags recvmmsg flags (MSG_WAITFORONE in the listener thread, MSG_DONTWAIT from the reactor)
+ * @return int Queries received, -1 with errno set on failure
  */
-static client_t* dns_find_client_by_address(dns_listener_ctx_t* ctx, const char* address) {
-    if (ctx == NULL || address == NULL) {
-        return NULL;
+static int dns_receive_batch(dns_listener_ctx_t* ctx, int flags) {
+    // Reset the slots the previous call filled in
+    for (int i = 0; i < DNS_BATCH_SIZE; i++) {
+        ctx->rx_msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+        ctx->rx_msgs[i].msg_len = 0;
     }
     
-    client_t* client = NULL;
+    int count = recvmmsg(ctx->socket, ctx->rx_msgs, DNS_BATCH_SIZE, flags, NULL);
     
-    pthread_mutex_lock(&ctx->clients_mutex);
+    if (count <= 0 || !ctx->running) {
+        return count;
+    }
     
-    for (size_t i = 0; i < ctx->client_count; i++) {
-        if (ctx->clients[i]->protocol_context != NULL) {
-            char* client_ip = (char*)ctx->clients[i]->protocol_context;
-            if (strcmp(client_ip, address) == 0) {
-                client = ctx->clients[i];
-                break;
-            }
-        }
+    uint64_t now_ms = udp_session_now_ms();
+    
+    for (int i = 0; i < count; i++) {
+        dns_process_query(ctx, (size_t)i, now_ms);
     }
     
-    pthread_mutex_unlock(&ctx->clients_mutex);
+    dns_flush_responses(ctx, (size_t)count);
     
-    return client;
+    return count;
 }
 
 /**
- * @brief Add client
+ * @brief Register the socket and a session sweep timer with the reactor
  */
-static status_t dns_add_client(dns_listener_ctx_t* ctx, const char* address, client_t** client) {
-    if (ctx == NULL || address == NULL || client == NULL) {
-        return STATUS_ERROR_INVALID_PARAM;
+static status_t dns_reactor_attach(dns_listener_ctx_t* ctx) {
+    size_t loop = reactor_next_loop(ctx->reactor);
+    
+    ctx->sweep_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (ctx->sweep_fd < 0) {
+        LOG_ERROR("DNS listener: Failed to create sweep timer: %s", strerror(errno));
+        return STATUS_ERROR_SOCKET;
     }
     
-    // Create protocol context (IP address)
-    void* protocol_context = strdup(address);
-    if (protocol_context == NULL) {
-        return STATUS_ERROR_MEMORY;
+    struct itimerspec interval;
+    memset(&interval, 0, sizeof(interval));
+    interval.it_value.tv_sec = DNS_SWEEP_MS / 1000;
+    interval.it_value.tv_nsec = (DNS_SWEEP_MS % 1000) * 1000000L;
+    interval.it_interval = interval.it_value;
+    
+    if (timerfd_settime(ctx->sweep_fd, 0, &interval, NULL) < 0 ||
+        reactor_add(ctx->reactor, loop, ctx->socket, EPOLLIN, dns_reactor_readable, ctx, &ctx->source) != STATUS_SUCCESS ||
+        reactor_add(ctx->reactor, loop, ctx->sweep_fd, EPOLLIN, dns_reactor_sweep, ctx, &ctx->sweep_source) != STATUS_SUCCESS) {
+        LOG_ERROR("DNS listener: Failed to register with the reactor");
+        return STATUS_ERROR_SOCKET;
     }
     
-    // Register client
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Remove the socket and sweep timer from the reactor
+ */
+static void dns_reactor_detach(dns_listener_ctx_t* ctx) {
+    reactor_remove(ctx->source);
+    ctx->source = NULL;
+    reactor_remove(ctx->sweep_source);
+    ctx->sweep_source = NULL;
+    
+    if (ctx->sweep_fd >= 0) {
+        close(ctx->sweep_fd);
+        ctx->sweep_fd = -1;
+    }
+}
+
+/**
+ * @brief Reactor handler: queries are waiting
+ *
+ * One batch per call, the level-triggered registration calls back while
+ * queries remain.
+ */
+static void dns_reactor_readable(int fd, uint32_t events, void* arg) {
+    (void)fd;
+    (void)events;
+    
+    if (dns_receive_batch((dns_listener_ctx_t*)arg, MSG_DONTWAIT) < 0 &&
+        errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        LOG_ERROR("DNS listener: recvmmsg failed: %s", strerror(errno));
+    }
+}
+
+/**
+ * @brief Reactor handler: drop clients that have been silent for the listener timeout
+ */
+static void dns_reactor_sweep(int fd, uint32_t events, void* arg) {
+    (void)events;
+    dns_listener_ctx_t* ctx = (dns_listener_ctx_t*)arg;
+    
+    uint64_t expirations;
+    if (read(fd, &expirations, sizeof(expirations)) < 0) {
+        return;
+    }
+    
+    uint64_t now_ms = udp_session_now_ms();
+    udp_session_table_expire(&ctx->sessions, now_ms, ctx->timeout_ms, dns_session_closed, ctx);
+    ctx->last_sweep_ms = now_ms;
+}
+
+/**
+ * @brief Answer one received query into its response slot
+ *
+ * Upstream data is handed to the message callback before the answer is
+ * built, so a reply queued by the callback goes out with this response.
+ * Queries that must not be answered leave the slot empty.
+ */
+static void dns_process_query(dns_listener_ctx_t* ctx, size_t index, uint64_t now_ms) {
     protocol_listener_t* listener = (protocol_listener_t*)ctx;
-    status_t status = client_register(listener, protocol_context, client);
+    const uint8_t* packet = (const uint8_t*)ctx->rx_iov[index].iov_base;
+    size_t len = ctx->rx_msgs[index].msg_len;
+    uint8_t* out = (uint8_t*)ctx->tx_iov[index].iov_base;
     
-    if (status != STATUS_SUCCESS) {
-        free(protocol_context);
-        return status;
+    ctx->tx_iov[index].iov_len = 0;
+    
+    dns_query_t query;
+    if (dns_parse_query(ctx, packet, len, &query) != STATUS_SUCCESS) {
+        return;
     }
     
-    // Update client state
-    client_update_state(*client, CLIENT_STATE_CONNECTED);
+    dns_count(&ctx->queries);
     
-    // Update client information
-    client_update_info(*client, NULL, address, NULL);
+    client_t* client = NULL;
+    dns_cache_entry_t* cached = NULL;
+    uint64_t hash = 0;
+    uint32_t client_addr = ctx->rx_addrs[index].sin_addr.s_addr;
+    
+    if (query.rcode == DNS_RCODE_NOERROR) {
+        // Repeats of a recent query get the same answer, with their own ID
+        cached = dns_cache_slot(ctx, packet, &query, client_addr, &hash);
+        
+        if (cached->expires_ms > now_ms && cached->hash == hash && cached->client_addr == client_addr &&
+            cached->question_len == query.question_len &&
+            memcmp(cached->question, packet + DNS_HEADER_SIZE, query.question_len) == 0) {
+            dns_count(&ctx->cache_hits);
+            memcpy(out, cached->response, cached->response_len);
+            out[0] = packet[0];
+            out[1] = packet[1];
+            ctx->tx_iov[index].iov_len = cached->response_len;
+            return;
+        }
+        
+        dns_count(&ctx->cache_misses);
+        
+        // Find or create the client for the sender's address
+        client = dns_find_or_create_client(ctx, &ctx->rx_addrs[index], now_ms);
+        if (client == NULL) {
+            // Refused by admission control, or the client could not be created
+            return;
+        }
+        
+        // Decode the data labels (a name holds less than 128 data bytes)
+        uint8_t data[DNS_MAX_NAME_LENGTH / 2];
+        bool valid = true;
+        size_t data_len = dns_decode_labels(packet, &query, data, &valid);
+        
+        if (!valid) {
+            query.rcode = DNS_RCODE_NXDOMAIN;
+        } else if (data_len == sizeof(uint32_t) && *((uint32_t*)data) == HEARTBEAT_MAGIC) {
+            // Process heartbeat
+            client_heartbeat(client);
+            
+            // Update client state if needed
+            if (client->state == CLIENT_STATE_CONNECTED ||
+                client->state == CLIENT_STATE_REGISTERED) {
+                client_update_state(client, CLIENT_STATE_ACTIVE);
+            }
+        } else if (data_len > 0 && ctx->on_message_received != NULL) {
+            // Call message received callback
+            protocol_message_t message;
+            message.data = data;
+            message.data_len = data_len;
+            ctx->on_message_received(listener, client, &message);
+        }
+    }
+    
+    size_t response_len = dns_build_response(ctx, packet, &query, client, out);
+    ctx->tx_iov[index].iov_len = response_len;
+    
+    // Remember the answer for retransmissions
+    if (cached != NULL) {
+        cached->hash = hash;
+        cached->expires_ms = now_ms + DNS_CACHE_TTL_MS;
+        cached->client_addr = client_addr;
+        cached->question_len = (uint16_t)query.question_len;
+        cached->response_len = (uint16_t)response_len;
+        memcpy(cached->question, packet + DNS_HEADER_SIZE, query.question_len);
+        memcpy(cached->response, out, response_len);
+    }
+}
+
+/**
+ * @brief Find the cache slot for a question and client (FNV-1a)
+ */
+static dns_cache_entry_t* dns_cache_slot(dns_listener_ctx_t* ctx, const uint8_t* packet, const dns_query_t* query,
+                                         uint32_t client_addr, uint64_t* hash) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    
+    for (size_t i = 0; i < sizeof(client_addr); i++) {
+        h = (h ^ ((client_addr >> (i * 8)) & 0xFF)) * 0x100000001b3ULL;
+    }
+    
+    const uint8_t* question = packet + DNS_HEADER_SIZE;
+    for (size_t i = 0; i < query->question_len; i++) {
+        h = (h ^ question[i]) * 0x100000001b3ULL;
+    }
+    
+    *hash = h;
+    
+    return &ctx->cache[(h ^ (h >> 32)) & (DNS_CACHE_SLOTS - 1)];
+}
+
+/**
+ * @brief Bump a counter read by other threads
+ */
+static void dns_count(uint64_t* counter) {
+    __atomic_store_n(counter, *counter + 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Send the responses built for a batch, skipping empty slots
+ */
+static void dns_flush_responses(dns_listener_ctx_t* ctx, size_t count) {
+    struct mmsghdr msgs[DNS_BATCH_SIZE];
+    size_t ready = 0;
     
-    // Add client to list
-    pthread_mutex_lock(&ctx->clients_mutex);
+    for (size_t i = 0; i < count; i++) {
+        if (ctx->tx_iov[i].iov_len == 0) {
+            continue;
+        }
+        
+        // Answer from the address the query came from
+        memset(&msgs[ready], 0, sizeof(struct mmsghdr));
+        msgs[ready].msg_hdr.msg_iov = &ctx->tx_iov[i];
+        msgs[ready].msg_hdr.msg_iovlen = 1;
+        msgs[ready].msg_hdr.msg_name = &ctx->rx_addrs[i];
+        msgs[ready].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+        ready++;
+    }
+    
+    size_t sent_count = 0;
     
-    // Resize clients array if needed
-    if (ctx->client_count >= ctx->client_capacity) {
-        size_t new_capacity = ctx->client_capacity * 2;
-        client_t** new_clients = (client_t**)realloc(ctx->clients, new_capacity * sizeof(client_t*));
+    while (sent_count < ready) {
+        int sent = sendmmsg(ctx->socket, msgs + sent_count, (unsigned int)(ready - sent_count), 0);
         
-        if (new_clients == NULL) {
-            pthread_mutex_unlock(&ctx->clients_mutex);
-            return STATUS_ERROR_MEMORY;
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            
+            // Datagram delivery is best effort, skip the one that failed
+            LOG_ERROR("Failed to send DNS response: %s", strerror(errno));
+            sent_count++;
+            continue;
         }
         
-        ctx->clients = new_clients;
-        ctx->client_capacity = new_capacity;
+        sent_count += (size_t)sent;
     }
+}
+
+/**
+ * @brief Convert the configured domain to lowercase wire format
+ */
+static status_t dns_encode_domain(dns_listener_ctx_t* ctx, const char* domain) {
+    size_t domain_len = strlen(domain);
     
-    ctx->clients[ctx->client_count++] = *client;
-    pthread_mutex_unlock(&ctx->clients_mutex);
+    // Ignore a trailing dot
+    if (domain_len > 0 && domain[domain_len - 1] == '.') {
+        domain_len--;
+    }
     
-    // Call client connected callback
-    if (ctx->on_client_connected != NULL) {
-        ctx->on_client_connected(listener, *client);
+    if (domain_len == 0 || domain_len > DNS_MAX_DOMAIN_LENGTH) {
+        return STATUS_ERROR_INVALID_PARAM;
     }
     
+    size_t out = 0;
+    size_t label_start = 0;
+    
+    ctx->domain_labels = 0;
+    
+    for (size_t i = 0; i <= domain_len; i++) {
+        if (i < domain_len && domain[i] != '.') {
+            continue;
+        }
+        
+        size_t label_len = i - label_start;
+        if (label_len == 0 || label_len > DNS_MAX_LABEL_LENGTH) {
+            return STATUS_ERROR_INVALID_PARAM;
+        }
+        
+        ctx->domain_wire[out++] = (uint8_t)label_len;
+        for (size_t j = label_start; j < i; j++) {
+            char c = domain[j];
+            ctx->domain_wire[out++] = (uint8_t)(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+        }
+        
+        ctx->domain_labels++;
+        label_start = i + 1;
+    }
+    
+    ctx->domain_wire[out++] = 0;
+    ctx->domain_wire_len = out;
+    
     return STATUS_SUCCESS;
 }
 
 /**
- * @brief Encode data to TXT records
+ * @brief Parse a query without copying or allocating
+ *
+ * @return status_t STATUS_SUCCESS if the query gets a response (possibly an
+ *         error response, see query->rcode), or an error if it is dropped
  */
-static status_t dns_encode_data_to_txt(const uint8_t* data, size_t data_len, char*** txt_records, size_t* txt_record_count) {
-    if (data == NULL || txt_records == NULL || txt_record_count == NULL) {
-        return STATUS_ERROR_INVALID_PARAM;
+static status_t dns_parse_query(const dns_listener_ctx_t* ctx, const uint8_t* packet, size_t len, dns_query_t* query) {
+    if (len < DNS_HEADER_SIZE) {
+        return STATUS_ERROR_INVALID_FORMAT;
     }
     
-    // Calculate number of TXT records needed
-    size_t record_count = (data_len + DNS_MAX_TXT_LENGTH - 1) / DNS_MAX_TXT_LENGTH;
+    memset(query, 0, sizeof(dns_query_t));
+    query->id = (uint16_t)((packet[0] << 8) | packet[1]);
+    query->flags = (uint16_t)((packet[2] << 8) | packet[3]);
     
-    // Allocate TXT records array
-    char** records = (char**)malloc(record_count * sizeof(char*));
-    if (records == NULL) {
-        return STATUS_ERROR_MEMORY;
+    // Never answer responses
+    if (query->flags & DNS_FLAG_QR) {
+        return STATUS_ERROR_INVALID_FORMAT;
+    }
+    
+    // Standard queries only
+    if (query->flags & DNS_OPCODE_MASK) {
+        query->rcode = DNS_RCODE_NOTIMP;
+        return STATUS_SUCCESS;
     }
     
-    // Initialize records
-    for (size_t i = 0; i < record_count; i++) {
-        records[i] = NULL;
+    uint16_t qdcount = (uint16_t)((packet[4] << 8) | packet[5]);
+    if (qdcount != 1) {
+        query->rcode = DNS_RCODE_FORMERR;
+        return STATUS_SUCCESS;
     }
     
-    // Encode data into TXT records
-    for (size_t i = 0; i < record_count; i++) {
-        size_t offset = i * DNS_MAX_TXT_LENGTH;
-        size_t chunk_size = data_len - offset;
+    // Walk the query name, remembering where each label starts
+    uint8_t offsets[DNS_MAX_LABELS];
+    size_t label_count = 0;
+    size_t offset = DNS_HEADER_SIZE;
+    
+    while (true) {
+        if (offset >= len || offset - DNS_HEADER_SIZE >= DNS_MAX_NAME_LENGTH) {
+            query->rcode = DNS_RCODE_FORMERR;
+            return STATUS_SUCCESS;
+        }
         
-        if (chunk_size > DNS_MAX_TXT_LENGTH) {
-            chunk_size = DNS_MAX_TXT_LENGTH;
+        uint8_t label_len = packet[offset];
+        
+        if (label_len == 0) {
+            offset++;
+            break;
         }
         
-        // Allocate record
-        records[i] = (char*)malloc(chunk_size * 2 + 1);
-        if (records[i] == NULL) {
-            // Free allocated records
-            for (size_t j = 0; j < i; j++) {
-                free(records[j]);
-            }
-            free(records);
-            return STATUS_ERROR_MEMORY;
+        // Compression pointers have no place in a question
+        if (label_len > DNS_MAX_LABEL_LENGTH || label_count == DNS_MAX_LABELS) {
+            query->rcode = DNS_RCODE_FORMERR;
+            return STATUS_SUCCESS;
         }
         
-        // Encode chunk as hex string
-        for (size_t j = 0; j < chunk_size; j++) {
-            sprintf(&records[i][j * 2], "%02x", data[offset + j]);
+        offsets[label_count++] = (uint8_t)(offset - DNS_HEADER_SIZE);
+        offset += 1 + (size_t)label_len;
+    }
+    
+    if (offset + 4 > len) {
+        query->rcode = DNS_RCODE_FORMERR;
+        return STATUS_SUCCESS;
+    }
+    
+    query->qtype = (uint16_t)((packet[offset] << 8) | packet[offset + 1]);
+    query->qclass = (uint16_t)((packet[offset + 2] << 8) | packet[offset + 3]);
+    query->question_len = offset + 4 - DNS_HEADER_SIZE;
+    
+    // The name must end with the domain, on a label boundary
+    if (label_count < ctx->domain_labels) {
+        query->rcode = DNS_RCODE_REFUSED;
+        return STATUS_SUCCESS;
+    }
+    
+    size_t suffix = DNS_HEADER_SIZE + offsets[label_count - ctx->domain_labels];
+    if (offset - suffix != ctx->domain_wire_len) {
+        query->rcode = DNS_RCODE_REFUSED;
+        return STATUS_SUCCESS;
+    }
+    
+    for (size_t i = 0; i < ctx->domain_wire_len; i++) {
+        uint8_t c = packet[suffix + i];
+        if (c >= 'A' && c <= 'Z') {
+            c = (uint8_t)(c - 'A' + 'a');
         }
         
-        records[i][chunk_size * 2] = '\0';
+        if (c != ctx->domain_wire[i]) {
+            query->rcode = DNS_RCODE_REFUSED;
+            return STATUS_SUCCESS;
+        }
     }
     
-    *txt_records = records;
-    *txt_record_count = record_count;
+    // Skip the nonce label, the rest below the domain carries data
+    size_t below = label_count - ctx->domain_labels;
+    for (size_t i = 1; i < below; i++) {
+        query->label_offsets[query->label_count++] = offsets[i];
+    }
     
     return STATUS_SUCCESS;
 }
 
 /**
- * @brief Decode TXT records to data
+ * @brief Decode the hex data labels of a query
+ *
+ * @return size_t Number of bytes written to data
  */
-static status_t dns_decode_txt_to_data(const char* const* txt_records, size_t txt_record_count, uint8_t** data, size_t* data_len) {
-    if (txt_records == NULL || data == NULL || data_len == NULL) {
-        return STATUS_ERROR_INVALID_PARAM;
+static size_t dns_decode_labels(const uint8_t* packet, const dns_query_t* query, uint8_t* data, bool* valid) {
+    // Gather the labels so digit pairs may straddle label boundaries
+    char hex[DNS_MAX_NAME_LENGTH];
+    size_t hex_len = 0;
+    
+    for (size_t i = 0; i < query->label_count; i++) {
+        const uint8_t* label = packet + DNS_HEADER_SIZE + query->label_offsets[i];
+        memcpy(hex + hex_len, label + 1, label[0]);
+        hex_len += label[0];
     }
     
-    // Calculate total data length
-    size_t total_len = 0;
+    size_t data_len = 0;
+    *valid = codec_hex_decode(hex, hex_len, data, &data_len) == STATUS_SUCCESS;
     
-    for (size_t i = 0; i < txt_record_count; i++) {
-        if (txt_records[i] == NULL) {
-            return STATUS_ERROR_INVALID_PARAM;
+    return *valid ? data_len : 0;
+}
+
+/**
+ * @brief Write a big-endian 16-bit value
+ */
+static uint8_t* dns_put16(uint8_t* out, uint16_t value) {
+    out[0] = (uint8_t)(value >> 8);
+    out[1] = (uint8_t)value;
+    return out + 2;
+}
+
+/**
+ * @brief Write the fixed part of an answer RR for the question name
+ */
+static uint8_t* dns_put_answer(uint8_t* out, uint16_t type, uint16_t rdlength) {
+    out = dns_put16(out, 0xC000 | DNS_HEADER_SIZE);   // Pointer to the question name
+    out = dns_put16(out, type);
+    out = dns_put16(out, DNS_CLASS_IN);
+    out = dns_put16(out, (uint16_t)(DNS_ANSWER_TTL >> 16));
+    out = dns_put16(out, (uint16_t)DNS_ANSWER_TTL);
+    return dns_put16(out, rdlength);
+}
+
+/**
+ * @brief Build the response for a parsed query
+ *
+ * The response never exceeds DNS_MAX_UDP_SIZE bytes.
+ *
+ * @return size_t Response length
+ */
+static size_t dns_build_response(dns_listener_ctx_t* ctx, const uint8_t* packet, const dns_query_t* query,
+                                 client_t* client, uint8_t* out) {
+    uint8_t* p = out;
+    int rcode = query->rcode;
+    
+    // Echo the question only when it could be parsed
+    bool has_question = query->question_len > 0 && rcode != DNS_RCODE_FORMERR;
+    
+    // Pick the answer
+    uint16_t answers = 0;
+    dns_pending_t* pending = NULL;
+    size_t pending_count = 0;
+    
+    if (rcode == DNS_RCODE_NOERROR && query->qclass == DNS_CLASS_IN && client != NULL) {
+        pthread_mutex_lock(&ctx->pending_mutex);
+        
+        dns_peer_t* peer = (dns_peer_t*)client->protocol_context;
+        if (peer != NULL) {
+            pending_count = peer->pending_count;
+            
+            // TXT queries take the next downstream message
+            if (query->qtype == DNS_TYPE_TXT && peer->pending_head != NULL) {
+                pending = peer->pending_head;
+                peer->pending_head = pending->next;
+                if (peer->pending_head == NULL) {
+                    peer->pending_tail = NULL;
+                }
+                peer->pending_count--;
+            }
         }
         
-        total_len += strlen(txt_records[i]) / 2;
+        pthread_mutex_unlock(&ctx->pending_mutex);
+        
+        if (pending != NULL || query->qtype == DNS_TYPE_A || query->qtype == DNS_TYPE_AAAA) {
+            answers = 1;
+        }
     }
     
-    // Allocate data buffer
-    uint8_t* buffer = (uint8_t*)malloc(total_len);
-    if (buffer == NULL) {
-        return STATUS_ERROR_MEMORY;
+    // Header
+    p = dns_put16(p, query->id);
+    p = dns_put16(p, (uint16_t)(DNS_FLAG_QR | DNS_FLAG_AA | (query->flags & DNS_FLAG_RD) | (uint16_t)rcode));
+    p = dns_put16(p, has_question ? 1 : 0);
+    p = dns_put16(p, answers);
+    p = dns_put16(p, 0);
+    p = dns_put16(p, 0);
+    
+    if (!has_question) {
+        return (size_t)(p - out);
     }
     
-    // Decode TXT records
-    size_t offset = 0;
+    // Question, copied verbatim
+    memcpy(p, packet + DNS_HEADER_SIZE, query->question_len);
+    p += query->question_len;
     
-    for (size_t i = 0; i < txt_record_count; i++) {
-        size_t record_len = strlen(txt_records[i]);
-        
-        // Decode hex string
-        for (size_t j = 0; j < record_len; j += 2) {
-            char hex[3] = { txt_records[i][j], txt_records[i][j + 1], '\0' };
-            buffer[offset++] = (uint8_t)strtol(hex, NULL, 16);
+    if (answers == 0) {
+        return (size_t)(p - out);
+    }
+    
+    // Queued message count, reported in A/AAAA acknowledgements
+    uint16_t queued = pending_count > 0xFFFF ? 0xFFFF : (uint16_t)pending_count;
+    
+    switch (query->qtype) {
+        case DNS_TYPE_TXT: {
+            // Hex data split into character strings of at most 255 bytes
+            size_t strings = (pending->len + DNS_TXT_STRING_DATA - 1) / DNS_TXT_STRING_DATA;
+            p = dns_put_answer(p, DNS_TYPE_TXT, (uint16_t)(pending->len * 2 + strings));
+            
+            for (size_t offset = 0; offset < pending->len; offset += DNS_TXT_STRING_DATA) {
+                size_t chunk = pending->len - offset < DNS_TXT_STRING_DATA ? pending->len - offset : DNS_TXT_STRING_DATA;
+                
+                *p++ = (uint8_t)(chunk * 2);
+                p += codec_hex_encode(pending->data + offset, chunk, (char*)p);
+            }
+            
+            free(pending);
+            break;
         }
+        
+        case DNS_TYPE_A:
+            // 10.0.x.y, x.y = queued downstream messages
+            p = dns_put_answer(p, DNS_TYPE_A, 4);
+            *p++ = 10;
+            *p++ = 0;
+            p = dns_put16(p, queued);
+            break;
+        
+        case DNS_TYPE_AAAA:
+            // fd00::x:y, x:y = queued downstream messages
+            p = dns_put_answer(p, DNS_TYPE_AAAA, 16);
+            memset(p, 0, 14);
+            p[0] = 0xfd;
+            p = dns_put16(p + 14, queued);
+            break;
     }
     
-    *data = buffer;
-    *data_len = total_len;
+    return (size_t)(p - out);
+}
+
+/**
+ * @brief Find or create the client for a source address
+ *
+ * Resolvers pick a fresh source port per query, so clients are keyed by IP only.
+ */
+static client_t* dns_find_or_create_client(dns_listener_ctx_t* ctx, const struct sockaddr_in* addr, uint64_t now_ms) {
+    struct sockaddr_in key;
+    memset(&key, 0, sizeof(key));
+    key.sin_family = AF_INET;
+    key.sin_addr = addr->sin_addr;
+    
+    // Find existing session
+    client_t* existing = udp_session_table_lookup(&ctx->sessions, &key, now_ms);
+    if (existing != NULL) {
+        return existing;
+    }
     
-    return STATUS_SUCCESS;
+    // Over-limit sources are dropped before anything is allocated
+    if (!admission_allow_at(&key, now_ms)) {
+        return NULL;
+    }
+    
+    // Create protocol context
+    dns_peer_t* peer = (dns_peer_t*)malloc(sizeof(dns_peer_t));
+    if (peer == NULL) {
+        LOG_ERROR("Failed to create DNS client");
+        return NULL;
+    }
+    
+    memset(peer, 0, sizeof(dns_peer_t));
+    inet_ntop(AF_INET, &addr->sin_addr, peer->address, sizeof(peer->address));
+    
+    // Register client
+    protocol_listener_t* listener = (protocol_listener_t*)ctx;
+    client_t* client = NULL;
+    status_t status = client_register(listener, peer, &client);
+    
+    if (status != STATUS_SUCCESS) {
+        LOG_ERROR("Failed to create DNS client");
+        free(peer);
+        return NULL;
+    }
+    
+    // Update client state
+    client_update_state(client, CLIENT_STATE_CONNECTED);
+    
+    // Update client information
+    client_update_info(client, NULL, peer->address, NULL);
+    
+    // Add session
+    status = udp_session_table_insert(&ctx->sessions, &key, client, now_ms);
+    
+    if (status != STATUS_SUCCESS) {
+        LOG_ERROR("Failed to add DNS session: %d", status);
+        client_update_state(client, CLIENT_STATE_DISCONNECTED);
+        
+        pthread_mutex_lock(&ctx->pending_mutex);
+        client->protocol_context = NULL;
+        pthread_mutex_unlock(&ctx->pending_mutex);
+        
+        free(peer);
+        client_destroy(client);
+        return NULL;
+    }
+    
+    // Call client connected callback
+    if (ctx->on_client_connected != NULL) {
+        ctx->on_client_connected(listener, client);
+    }
+    
+    return client;
+}
+
+/**
+ * @brief Tear down a client whose session was removed
+ */
+static void dns_session_closed(client_t* client, void* arg) {
+    dns_listener_ctx_t* ctx = (dns_listener_ctx_t*)arg;
+    protocol_listener_t* listener = (protocol_listener_t*)ctx;
+    
+    // Update client state
+    client_update_state(client, CLIENT_STATE_DISCONNECTED);
+    
+    // Call client disconnected callback
+    if (ctx->on_client_disconnected != NULL) {
+        ctx->on_client_disconnected(listener, client);
+    }
+    
+    // Free protocol context and any undelivered messages
+    pthread_mutex_lock(&ctx->pending_mutex);
+    
+    dns_peer_t* peer = (dns_peer_t*)client->protocol_context;
+    client->protocol_context = NULL;
+    
+    pthread_mutex_unlock(&ctx->pending_mutex);
+    
+    if (peer != NULL) {
+        while (peer->pending_head != NULL) {
+            dns_pending_t* next = peer->pending_head->next;
+            free(peer->pending_head);
+            peer->pending_head = next;
+        }
+        
+        free(peer);
+    }
+    
+    // A returning peer registers as a new client
+    client_destroy(client);
 }
 
 /**
@@ -337,11 +967,18 @@ status_t dns_listener_create(const protocol_listener_config_t* config, protocol_
     
     // Initialize context
     memset(ctx, 0, sizeof(dns_listener_ctx_t));
+    ctx->socket = -1;
+    ctx->sweep_fd = -1;
     
     // Copy config
     ctx->port = config->port > 0 ? config->port : DNS_DEFAULT_PORT;
     ctx->timeout_ms = config->timeout_ms > 0 ? config->timeout_ms : DNS_DEFAULT_TIMEOUT;
     
+    if (dns_encode_domain(ctx, config->domain) != STATUS_SUCCESS) {
+        free(ctx);
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
     if (config->bind_address != NULL) {
         ctx->bind_address = strdup(config->bind_address);
         if (ctx->bind_address == NULL) {
@@ -359,15 +996,12 @@ status_t dns_listener_create(const protocol_listener_config_t* config, protocol_
         return STATUS_ERROR_MEMORY;
     }
     
-    // Initialize clients array
-    ctx->client_capacity = 16;
-    ctx->client_count = 0;
-    ctx->clients = (client_t**)malloc(ctx->client_capacity * sizeof(client_t*));
+    // Initialize session table and response cache
+    ctx->cache = (dns_cache_entry_t*)calloc(DNS_CACHE_SLOTS, sizeof(dns_cache_entry_t));
     
-    if (ctx->clients == NULL) {
-        if (ctx->domain != NULL) {
-            free(ctx->domain);
-        }
+    if (ctx->cache == NULL || udp_session_table_init(&ctx->sessions, UDP_SESSION_DEFAULT_CAPACITY) != STATUS_SUCCESS) {
+        free(ctx->cache);
+        free(ctx->domain);
         if (ctx->bind_address != NULL) {
             free(ctx->bind_address);
         }
@@ -376,7 +1010,7 @@ status_t dns_listener_create(const protocol_listener_config_t* config, protocol_
     }
     
     // Initialize mutex
-    pthread_mutex_init(&ctx->clients_mutex, NULL);
+    pthread_mutex_init(&ctx->pending_mutex, NULL);
     
     // Set function pointers
     protocol_listener_t* base = (protocol_listener_t*)ctx;
@@ -385,6 +1019,8 @@ status_t dns_listener_create(const protocol_listener_config_t* config, protocol_
     base->destroy = dns_listener_destroy;
     base->send_message = dns_listener_send_message;
     base->register_callbacks = dns_listener_register_callbacks;
+    base->get_stats = dns_listener_get_stats;
+    base->attach_reactor = dns_listener_attach_reactor;
     
     // Set protocol type
     base->protocol_type = PROTOCOL_TYPE_DNS;
@@ -411,42 +1047,80 @@ static status_t dns_listener_start(protocol_listener_t* listener) {
         return STATUS_ERROR_ALREADY_RUNNING;
     }
     
-    // Initialize DNS listener
-    // Note: c-ares initialization is commented out due to missing library
-    /*
-    int status = ares_library_init(ARES_LIB_INIT_ALL);
-    if (status != ARES_SUCCESS) {
-        return STATUS_ERROR_GENERIC;
+    // Create server socket
+    ctx->socket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (ctx->socket < 0) {
+        return STATUS_ERROR_SOCKET;
     }
     
-    // Create c-ares channel
-    struct ares_options options;
-    int optmask = 0;
+    int opt = 1;
+    if (setsockopt(ctx->socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+        close(ctx->socket);
+        ctx->socket = -1;
+        return STATUS_ERROR_SOCKET;
+    }
     
-    memset(&options, 0, sizeof(options));
+    // Bind socket
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = ctx->bind_address != NULL ? inet_addr(ctx->bind_address) : htonl(INADDR_ANY);
+    server_addr.sin_port = htons(ctx->port);
+    
+    if (bind(ctx->socket, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+        LOG_ERROR("DNS listener: Failed to bind port %d: %s", ctx->port, strerror(errno));
+        close(ctx->socket);
+        ctx->socket = -1;
+        return STATUS_ERROR_BIND;
+    }
     
-    // Set options
-    options.udp_port = ctx->port;
-    optmask |= ARES_OPT_UDP_PORT;
+    // Preallocate batch buffers
+    ctx->rx_slab = (uint8_t*)malloc((size_t)DNS_BATCH_SIZE * DNS_MAX_QUERY_SIZE);
+    ctx->tx_slab = (uint8_t*)malloc((size_t)DNS_BATCH_SIZE * DNS_MAX_UDP_SIZE);
+    
+    if (ctx->rx_slab == NULL || ctx->tx_slab == NULL) {
+        free(ctx->rx_slab);
+        free(ctx->tx_slab);
+        ctx->rx_slab = NULL;
+        ctx->tx_slab = NULL;
+        close(ctx->socket);
+        ctx->socket = -1;
+        return STATUS_ERROR_MEMORY;
+    }
     
-    status = ares_init_options(&ctx->channel, &options, optmask);
-    if (status != ARES_SUCCESS) {
-        ares_library_cleanup();
-        return STATUS_ERROR_GENERIC;
+    for (int i = 0; i < DNS_BATCH_SIZE; i++) {
+        ctx->rx_iov[i].iov_base = ctx->rx_slab + (size_t)i * DNS_MAX_QUERY_SIZE;
+        ctx->rx_iov[i].iov_len = DNS_MAX_QUERY_SIZE;
+        ctx->rx_msgs[i].msg_hdr.msg_iov = &ctx->rx_iov[i];
+        ctx->rx_msgs[i].msg_hdr.msg_iovlen = 1;
+        ctx->rx_msgs[i].msg_hdr.msg_name = &ctx->rx_addrs[i];
+        ctx->rx_msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+        
+        ctx->tx_iov[i].iov_base = ctx->tx_slab + (size_t)i * DNS_MAX_UDP_SIZE;
+        ctx->tx_iov[i].iov_len = 0;
     }
-    */
     
     // Set running flag
     ctx->running = true;
     
+    // Shared reactor: no thread of our own
+    if (ctx->reactor != NULL) {
+        status_t status = dns_reactor_attach(ctx);
+        if (status != STATUS_SUCCESS) {
+            dns_listener_stop(listener);
+        }
+        return status;
+    }
+    
     // Create listener thread
     if (pthread_create(&ctx->listener_thread, NULL, dns_listener_thread, listener) != 0) {
-        // Note: c-ares cleanup is commented out due to missing library
-        /*
-        ares_destroy(ctx->channel);
-        ares_library_cleanup();
-        */
         ctx->running = false;
+        free(ctx->rx_slab);
+        free(ctx->tx_slab);
+        ctx->rx_slab = NULL;
+        ctx->tx_slab = NULL;
+        close(ctx->socket);
+        ctx->socket = -1;
         return STATUS_ERROR_GENERIC;
     }
     
@@ -471,38 +1145,32 @@ static status_t dns_listener_stop(protocol_listener_t* listener) {
     // Set running flag
     ctx->running = false;
     
-    // Wait for listener thread to exit
-    pthread_join(ctx->listener_thread, NULL);
+    if (ctx->reactor != NULL) {
+        // Leave the reactor, after which no handler touches the context
+        dns_reactor_detach(ctx);
+    } else {
+        // Wake the listener thread (shutdown ends a blocked recvmmsg)
+        shutdown(ctx->socket, SHUT_RDWR);
+        
+        // Wait for listener thread to exit
+        pthread_join(ctx->listener_thread, NULL);
+    }
     
-    // Destroy DNS listener
-    // Note: c-ares cleanup is commented out due to missing library
-    /*
-    ares_destroy(ctx->channel);
-    ares_library_cleanup();
-    */
+    // Close server socket
+    close(ctx->socket);
+    ctx->socket = -1;
     
-    // Update client states and free protocol contexts
-    pthread_mutex_lock(&ctx->clients_mutex);
+    // Free batch buffers
+    free(ctx->rx_slab);
+    free(ctx->tx_slab);
+    ctx->rx_slab = NULL;
+    ctx->tx_slab = NULL;
     
-    for (size_t i = 0; i < ctx->client_count; i++) {
-        client_t* client = ctx->clients[i];
-        
-        // Update client state
-        client_update_state(client, CLIENT_STATE_DISCONNECTED);
-        
-        // Call client disconnected callback
-        if (ctx->on_client_disconnected != NULL) {
-            ctx->on_client_disconnected(listener, client);
-        }
-        
-        // Free protocol context
-        if (client->protocol_context != NULL) {
-            free(client->protocol_context);
-            client->protocol_context = NULL;
-        }
-    }
+    // Disconnect clients and free protocol contexts
+    udp_session_table_expire(&ctx->sessions, udp_session_now_ms(), 0, dns_session_closed, ctx);
     
-    pthread_mutex_unlock(&ctx->clients_mutex);
+    // Cached answers belong to the clients just dropped
+    memset(ctx->cache, 0, DNS_CACHE_SLOTS * sizeof(dns_cache_entry_t));
     
     return STATUS_SUCCESS;
 }
@@ -522,11 +1190,12 @@ static status_t dns_listener_destroy(protocol_listener_t* listener) {
         dns_listener_stop(listener);
     }
     
-    // Free clients array (but not clients themselves, as they are managed by the client system)
-    pthread_mutex_lock(&ctx->clients_mutex);
-    free(ctx->clients);
-    pthread_mutex_unlock(&ctx->clients_mutex);
-    pthread_mutex_destroy(&ctx->clients_mutex);
+    // Free session table (but not clients themselves, as they are managed by the client system)
+    udp_session_table_free(&ctx->sessions);
+    pthread_mutex_destroy(&ctx->pending_mutex);
+    
+    // Free response cache
+    free(ctx->cache);
     
     // Free domain
     if (ctx->domain != NULL) {
@@ -546,6 +1215,8 @@ static status_t dns_listener_destroy(protocol_listener_t* listener) {
 
 /**
  * @brief Send message to DNS client
+ *
+ * The message is queued and answers the client's next TXT query.
  */
 static status_t dns_listener_send_message(protocol_listener_t* listener, client_t* client, protocol_message_t* message) {
     if (listener == NULL || client == NULL || message == NULL || message->data == NULL || message->data_len == 0) {
@@ -559,31 +1230,95 @@ static status_t dns_listener_send_message(protocol_listener_t* listener, client_
         return STATUS_ERROR_NOT_RUNNING;
     }
     
-    // Check if message is too large
-    if (message->data_len > DNS_MAX_TXT_LENGTH) {
+    // Check if message is too large for one TXT answer
+    if (message->data_len > DNS_MAX_MESSAGE_SIZE) {
         // Use fragmentation
-        return fragmentation_send_message(listener, client, message->data, message->data_len, DNS_MAX_TXT_LENGTH);
+        return fragmentation_send_message(listener, client, message->data, message->data_len,
+                                          DNS_MAX_MESSAGE_SIZE - sizeof(fragment_header_t));
     }
     
-    // Encode message data to TXT records
-    char** txt_records = NULL;
-    size_t txt_record_count = 0;
+    dns_pending_t* pending = (dns_pending_t*)malloc(sizeof(dns_pending_t) + message->data_len);
+    if (pending == NULL) {
+        return STATUS_ERROR_MEMORY;
+    }
     
-    status_t status = dns_encode_data_to_txt(message->data, message->data_len, &txt_records, &txt_record_count);
-    if (status != STATUS_SUCCESS) {
-        return status;
+    pending->next = NULL;
+    pending->len = message->data_len;
+    memcpy(pending->data, message->data, message->data_len);
+    
+    pthread_mutex_lock(&ctx->pending_mutex);
+    
+    dns_peer_t* peer = (dns_peer_t*)client->protocol_context;
+    
+    if (peer == NULL) {
+        pthread_mutex_unlock(&ctx->pending_mutex);
+        free(pending);
+        return STATUS_ERROR_NOT_CONNECTED;
+    }
+    
+    // Refuse new messages while the client is not polling them away
+    if (peer->pending_count >= DNS_MAX_PENDING) {
+        pthread_mutex_unlock(&ctx->pending_mutex);
+        free(pending);
+        return STATUS_ERROR_WOULD_BLOCK;
+    }
+    
+    if (peer->pending_tail != NULL) {
+        peer->pending_tail->next = pending;
+    } else {
+        peer->pending_head = pending;
     }
+    peer->pending_tail = pending;
+    peer->pending_count++;
     
-    // Send TXT records
-    // In a real implementation, this would involve setting up DNS responses
-    // For simplicity, we'll just free the TXT records and return success
+    pthread_mutex_unlock(&ctx->pending_mutex);
     
-    // Free TXT records
-    for (size_t i = 0; i < txt_record_count; i++) {
-        free(txt_records[i]);
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Get DNS listener counters
+ */
+static status_t dns_listener_get_stats(protocol_listener_t* listener, protocol_stat_t* stats, size_t* count) {
+    if (listener == NULL || stats == NULL || count == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    dns_listener_ctx_t* ctx = (dns_listener_ctx_t*)listener;
+    
+    protocol_stat_t values[] = {
+        { "queries", __atomic_load_n(&ctx->queries, __ATOMIC_RELAXED) },
+        { "cache_hits", __atomic_load_n(&ctx->cache_hits, __ATOMIC_RELAXED) },
+        { "cache_misses", __atomic_load_n(&ctx->cache_misses, __ATOMIC_RELAXED) },
+        { "cache_slots", DNS_CACHE_SLOTS },
+    };
+    
+    size_t n = sizeof(values) / sizeof(values[0]);
+    if (n > *count) {
+        n = *count;
+    }
+    
+    memcpy(stats, values, n * sizeof(protocol_stat_t));
+    *count = n;
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Serve the listener from a shared reactor instead of its own thread
+ */
+static status_t dns_listener_attach_reactor(protocol_listener_t* listener, reactor_t* reactor) {
+    if (listener == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    dns_listener_ctx_t* ctx = (dns_listener_ctx_t*)listener;
+    
+    if (ctx->running) {
+        return STATUS_ERROR_ALREADY_RUNNING;
     }
     
-    free(txt_records);
+    ctx->reactor = reactor;
     
     return STATUS_SUCCESS;
 }
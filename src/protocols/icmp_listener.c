@@ -22,7 +22,13 @@ typedef unsigned short u_short;
 #include "../include/common.h"
 #include "../include/client.h"
 #include "../common/uuid.h"
+#include "../common/logger.h"
+#include "../common/reactor.h"
 #include "protocol_fragmentation.h"
+#include "icmp_ring.h"
+#include "icmp_packet.h"
+#include "admission.h"
+#include "../include/protocol_header.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -36,6 +42,8 @@ typedef unsigned short u_short;
 #include <pcap.h>
 #include <errno.h>
 #include <time.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 
 // Heartbeat magic number
 #define HEARTBEAT_MAGIC 0x48454152  // "HEAR"
@@ -49,12 +57,52 @@ typedef unsigned short u_short;
 // Maximum ICMP data size (to avoid fragmentation at IP level)
 #define MAX_ICMP_DATA_SIZE 1400
 
+// Replies per sendmmsg call, and the largest reply packet
+#define ICMP_BATCH_SIZE 64
+#define ICMP_PACKET_SIZE (ICMP_PACKET_HEADER_SIZE + MAX_ICMP_DATA_SIZE)
+
+// Replies waiting for one sendmmsg call
+typedef struct {
+    struct mmsghdr msgs[ICMP_BATCH_SIZE];
+    struct iovec iov[ICMP_BATCH_SIZE];
+    struct sockaddr_in addrs[ICMP_BATCH_SIZE];
+    uint8_t packets[ICMP_BATCH_SIZE][ICMP_PACKET_SIZE];
+    size_t count;
+} icmp_batch_t;
+
+// ICMP peer (client protocol context)
+typedef struct {
+    char address[INET_ADDRSTRLEN];  // Dotted source address
+    struct sockaddr_in addr;        // Reply destination
+    icmp_reply_template_t reply;    // Prebuilt reply headers
+    uint16_t sequence;              // Next reply sequence number (clients_mutex)
+} icmp_peer_t;
+
 // ICMP listener context
 typedef struct {
+    protocol_listener_t base;       // Listener interface (must be first)
     int raw_socket;                 // Raw socket for sending ICMP
     pcap_t* pcap_handle;            // PCAP handle for packet capture
+    protocol_capture_backend_t capture_backend; // Capture backend
+    bool socket_filter;             // Drop echo requests without protocol traffic in the kernel
+    icmp_ring_t ring;               // TPACKET_V3 ring (ring backend)
+    pthread_mutex_t stats_mutex;    // Serializes ring counter updates
+    
+    // Outbound replies: senders fill one batch while the sender thread sends the other
+    icmp_batch_t batches[2];
+    icmp_batch_t* tx_pending;       // Batch being filled
+    pthread_t sender_thread;        // Sender thread
+    bool sender_running;            // Sender thread keeps waiting for replies
+    pthread_mutex_t tx_mutex;       // Protects tx_pending
+    pthread_cond_t tx_ready;        // Signalled when the first reply is queued
+    pthread_cond_t tx_space;        // Signalled when the pending batch is swapped out
+    uint64_t replies_sent;          // Replies handed to the kernel
+    uint64_t reply_batches;         // sendmmsg calls
     pthread_t listener_thread;      // Listener thread
+    int wakeup_fd;                  // Eventfd waking the listener thread on stop
     bool running;                   // Running flag
+    reactor_t* reactor;             // Shared event loops, NULL for the listener thread
+    reactor_source_t* source;       // Capture descriptor registration (reactor mode)
     char* bind_address;             // Bind address
     char* pcap_device;              // PCAP device name
     uint32_t timeout_ms;            // Timeout in milliseconds
@@ -68,7 +116,7 @@ typedef struct {
     client_t** clients;              // Array of clients
     size_t client_count;             // Number of clients
     size_t client_capacity;          // Capacity of clients array
-    pthread_mutex_t clients_mutex;   // Mutex for clients array
+    pthread_mutex_t clients_mutex;   // Mutex for clients array and their peers
 } icmp_listener_ctx_t;
 
 // Forward declarations
@@ -81,25 +129,51 @@ static status_t icmp_listener_register_callbacks(protocol_listener_t* listener,
                                                void (*on_message_received)(protocol_listener_t*, client_t*, protocol_message_t*),
                                                void (*on_client_connected)(protocol_listener_t*, client_t*),
                                                void (*on_client_disconnected)(protocol_listener_t*, client_t*));
+static status_t icmp_listener_get_stats(protocol_listener_t* listener, protocol_stat_t* stats, size_t* count);
+static status_t icmp_listener_attach_reactor(protocol_listener_t* listener, reactor_t* reactor);
+static status_t icmp_capture_fd(icmp_listener_ctx_t* ctx, int* fd);
+static status_t icmp_reactor_attach(icmp_listener_ctx_t* ctx);
+static void icmp_reactor_capture(int fd, uint32_t events, void* arg);
 static void icmp_packet_handler(u_char* user, const struct pcap_pkthdr* pkthdr, const u_char* packet);
+static void icmp_ring_packet_handler(const uint8_t* packet, size_t packet_len, void* arg);
+static void icmp_process_packet(icmp_listener_ctx_t* ctx, const uint8_t* packet, size_t packet_len);
 static client_t* icmp_find_or_create_client(icmp_listener_ctx_t* ctx, const char* ip_address);
-static uint16_t icmp_checksum(uint16_t* addr, int len);
+static status_t icmp_pcap_open(icmp_listener_ctx_t* ctx);
+static void* icmp_sender_thread(void* arg);
+static void icmp_batch_flush(icmp_listener_ctx_t* ctx, icmp_batch_t* batch);
 
 /**
- * @brief ICMP packet handler
+ * @brief ICMP packet handler (pcap backend)
  */
 static void icmp_packet_handler(u_char* user, const struct pcap_pkthdr* pkthdr, const u_char* packet) {
-    protocol_listener_t* listener = (protocol_listener_t*)user;
-    icmp_listener_ctx_t* ctx = (icmp_listener_ctx_t*)listener;
+    icmp_process_packet((icmp_listener_ctx_t*)user, packet, pkthdr->caplen);
+}
+
+/**
+ * @brief ICMP packet handler (ring backend, packet points into the ring)
+ */
+static void icmp_ring_packet_handler(const uint8_t* packet, size_t packet_len, void* arg) {
+    icmp_process_packet((icmp_listener_ctx_t*)arg, packet, packet_len);
+}
+
+/**
+ * @brief Handle a captured IP packet
+ */
+static void icmp_process_packet(icmp_listener_ctx_t* ctx, const uint8_t* packet, size_t packet_len) {
+    protocol_listener_t* listener = (protocol_listener_t*)ctx;
     
     // Check if packet is large enough to contain IP and ICMP headers
-    if (pkthdr->len < IP_HEADER_SIZE + ICMP_HEADER_SIZE) {
+    if (packet_len < IP_HEADER_SIZE + ICMP_HEADER_SIZE) {
         return;
     }
     
     // Get IP header
     const struct ip* ip_header = (struct ip*)(packet);
-    int ip_header_len = ip_header->ip_hl * 4;
+    size_t ip_header_len = (size_t)ip_header->ip_hl * 4;
+    
+    if (ip_header_len < IP_HEADER_SIZE || packet_len < ip_header_len + ICMP_HEADER_SIZE) {
+        return;
+    }
     
     // Get ICMP header
     const struct icmp* icmp_header = (struct icmp*)(packet + ip_header_len);
@@ -120,11 +194,11 @@ static void icmp_packet_handler(u_char* user, const struct pcap_pkthdr* pkthdr,
     }
     
     // Update client last seen time
-    client->last_seen_time = time(NULL);
+    client_touch(client);
     
     // Get ICMP data
     uint8_t* packet_data = (uint8_t*)(packet + ip_header_len + ICMP_HEADER_SIZE);
-    size_t data_len = pkthdr->len - ip_header_len - ICMP_HEADER_SIZE;
+    size_t data_len = packet_len - ip_header_len - ICMP_HEADER_SIZE;
     
     // Create message
     protocol_message_t message;
@@ -165,8 +239,8 @@ static client_t* icmp_find_or_create_client(icmp_listener_ctx_t* ctx, const char
     // Find client by IP address
     for (size_t i = 0; i < ctx->client_count; i++) {
         if (ctx->clients[i]->protocol_context != NULL) {
-            char* client_ip = (char*)ctx->clients[i]->protocol_context;
-            if (strcmp(client_ip, ip_address) == 0) {
+            icmp_peer_t* peer = (icmp_peer_t*)ctx->clients[i]->protocol_context;
+            if (strcmp(peer->address, ip_address) == 0) {
                 client = ctx->clients[i];
                 break;
             }
@@ -177,18 +251,35 @@ static client_t* icmp_find_or_create_client(icmp_listener_ctx_t* ctx, const char
     
     // Create new client if not found
     if (client == NULL) {
-        // Create protocol context (IP address)
-        void* protocol_context = strdup(ip_address);
-        if (protocol_context == NULL) {
+        // Create protocol context (address and reply template)
+        icmp_peer_t* peer = (icmp_peer_t*)malloc(sizeof(icmp_peer_t));
+        if (peer == NULL) {
+            return NULL;
+        }
+        
+        memset(peer, 0, sizeof(icmp_peer_t));
+        strncpy(peer->address, ip_address, sizeof(peer->address) - 1);
+        peer->addr.sin_family = AF_INET;
+        
+        if (inet_pton(AF_INET, ip_address, &peer->addr.sin_addr) <= 0) {
+            free(peer);
             return NULL;
         }
         
+        // Over-limit sources are dropped before the client is registered
+        if (!admission_allow(&peer->addr)) {
+            free(peer);
+            return NULL;
+        }
+        
+        icmp_reply_template_init(&peer->reply, peer->addr.sin_addr, htons(rand() & 0xFFFF));
+        
         // Register client
         protocol_listener_t* listener = (protocol_listener_t*)ctx;
-        status_t status = client_register(listener, protocol_context, &client);
+        status_t status = client_register(listener, peer, &client);
         
         if (status != STATUS_SUCCESS) {
-            free(protocol_context);
+            free(peer);
             return NULL;
         }
         
@@ -228,47 +319,107 @@ static client_t* icmp_find_or_create_client(icmp_listener_ctx_t* ctx, const char
 }
 
 /**
- * @brief Calculate ICMP checksum
+ * @brief ICMP listener thread
+ * 
+ * Sleeps in poll until packets arrive or stop writes the wakeup eventfd,
+ * so an idle listener uses no CPU and stops at once.
  */
-static uint16_t icmp_checksum(uint16_t* addr, int len) {
-    int nleft = len;
-    int sum = 0;
-    uint16_t* w = addr;
-    uint16_t answer = 0;
+static void* icmp_listener_thread(void* arg) {
+    protocol_listener_t* listener = (protocol_listener_t*)arg;
+    icmp_listener_ctx_t* ctx = (icmp_listener_ctx_t*)listener;
     
-    // Adding 16-bit words
-    while (nleft > 1) {
-        sum += *w++;
-        nleft -= 2;
+    int fd;
+    if (icmp_capture_fd(ctx, &fd) != STATUS_SUCCESS) {
+        return NULL;
     }
     
-    // Add left-over byte, if any
-    if (nleft == 1) {
-        *(uint8_t*)(&answer) = *(uint8_t*)w;
-        sum += answer;
-    }
+    struct pollfd fds[2];
+    fds[0].fd = fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = ctx->wakeup_fd;
+    fds[1].events = POLLIN;
     
-    // Fold 32-bit sum to 16 bits
-    sum = (sum >> 16) + (sum & 0xFFFF);
-    sum += (sum >> 16);
-    answer = ~sum;
+    // Run packet capture loop
+    while (ctx->running) {
+        int ready = poll(fds, 2, -1);
+        
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("ICMP listener: poll failed: %s", strerror(errno));
+            break;
+        }
+        
+        // Stop request, the running flag is re-checked by the loop
+        if (fds[1].revents != 0) {
+            continue;
+        }
+        
+        if (fds[0].revents != 0) {
+            icmp_reactor_capture(fd, (uint32_t)fds[0].revents, ctx);
+        }
+    }
     
-    return answer;
+    return NULL;
 }
 
 /**
- * @brief ICMP listener thread
+ * @brief Capture descriptor to wait on, made non-blocking for libpcap
  */
-static void* icmp_listener_thread(void* arg) {
-    protocol_listener_t* listener = (protocol_listener_t*)arg;
-    icmp_listener_ctx_t* ctx = (icmp_listener_ctx_t*)listener;
+static status_t icmp_capture_fd(icmp_listener_ctx_t* ctx, int* fd) {
+    *fd = ctx->ring.socket;
     
-    // Run packet capture loop
-    while (ctx->running) {
-        pcap_dispatch(ctx->pcap_handle, -1, icmp_packet_handler, (u_char*)listener);
+    // libpcap reads from its own descriptor, which must not block the caller
+    if (ctx->capture_backend != PROTOCOL_CAPTURE_RING) {
+        char errbuf[PCAP_ERRBUF_SIZE];
+        
+        if (pcap_setnonblock(ctx->pcap_handle, 1, errbuf) == -1) {
+            LOG_ERROR("ICMP listener: pcap_setnonblock failed: %s", errbuf);
+            return STATUS_ERROR_GENERIC;
+        }
+        
+        *fd = pcap_get_selectable_fd(ctx->pcap_handle);
+        if (*fd < 0) {
+            LOG_ERROR("ICMP listener: capture device has no selectable descriptor");
+            return STATUS_ERROR_GENERIC;
+        }
     }
     
-    return NULL;
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Register the capture descriptor with the reactor
+ */
+static status_t icmp_reactor_attach(icmp_listener_ctx_t* ctx) {
+    int fd;
+    status_t status = icmp_capture_fd(ctx, &fd);
+    if (status != STATUS_SUCCESS) {
+        return status;
+    }
+    
+    return reactor_add(ctx->reactor, reactor_next_loop(ctx->reactor), fd, EPOLLIN,
+                       icmp_reactor_capture, ctx, &ctx->source);
+}
+
+/**
+ * @brief Reactor handler: captured packets are waiting
+ * 
+ * Also called by the listener thread when poll reports the descriptor.
+ */
+static void icmp_reactor_capture(int fd, uint32_t events, void* arg) {
+    (void)fd;
+    (void)events;
+    icmp_listener_ctx_t* ctx = (icmp_listener_ctx_t*)arg;
+    
+    if (ctx->capture_backend == PROTOCOL_CAPTURE_RING) {
+        // Every retired block, without waiting for the next one
+        while (icmp_ring_poll(&ctx->ring, 0, icmp_ring_packet_handler, ctx) > 0) {
+        }
+    } else {
+        pcap_dispatch(ctx->pcap_handle, -1, icmp_packet_handler, (u_char*)ctx);
+    }
 }
 
 /**
@@ -290,6 +441,10 @@ status_t icmp_listener_create(const protocol_listener_config_t* config, protocol
     
     // Copy config
     ctx->timeout_ms = config->timeout_ms;
+    ctx->capture_backend = config->capture_backend;
+    ctx->socket_filter = config->socket_filter;
+    ctx->ring.socket = -1;
+    ctx->wakeup_fd = -1;
     
     if (config->bind_address != NULL) {
         ctx->bind_address = strdup(config->bind_address);
@@ -299,6 +454,15 @@ status_t icmp_listener_create(const protocol_listener_config_t* config, protocol
         }
     }
     
+    if (config->pcap_device != NULL) {
+        ctx->pcap_device = strdup(config->pcap_device);
+        if (ctx->pcap_device == NULL) {
+            free(ctx->bind_address);
+            free(ctx);
+            return STATUS_ERROR_MEMORY;
+        }
+    }
+    
     // Initialize clients array
     ctx->client_capacity = 16;
     ctx->client_count = 0;
@@ -308,12 +472,32 @@ status_t icmp_listener_create(const protocol_listener_config_t* config, protocol
         if (ctx->bind_address != NULL) {
             free(ctx->bind_address);
         }
+        free(ctx->pcap_device);
         free(ctx);
         return STATUS_ERROR_MEMORY;
     }
     
-    // Initialize mutex
+    // Initialize mutexes
     pthread_mutex_init(&ctx->clients_mutex, NULL);
+    pthread_mutex_init(&ctx->stats_mutex, NULL);
+    pthread_mutex_init(&ctx->tx_mutex, NULL);
+    pthread_cond_init(&ctx->tx_ready, NULL);
+    pthread_cond_init(&ctx->tx_space, NULL);
+    
+    // Point each reply slot at its packet buffer and address
+    for (int b = 0; b < 2; b++) {
+        icmp_batch_t* batch = &ctx->batches[b];
+        
+        for (int i = 0; i < ICMP_BATCH_SIZE; i++) {
+            batch->iov[i].iov_base = batch->packets[i];
+            batch->msgs[i].msg_hdr.msg_iov = &batch->iov[i];
+            batch->msgs[i].msg_hdr.msg_iovlen = 1;
+            batch->msgs[i].msg_hdr.msg_name = &batch->addrs[i];
+            batch->msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+        }
+    }
+    
+    ctx->tx_pending = &ctx->batches[0];
     
     // Set function pointers
     protocol_listener_t* base = (protocol_listener_t*)ctx;
@@ -322,6 +506,8 @@ status_t icmp_listener_create(const protocol_listener_config_t* config, protocol
     base->destroy = icmp_listener_destroy;
     base->send_message = icmp_listener_send_message;
     base->register_callbacks = icmp_listener_register_callbacks;
+    base->get_stats = icmp_listener_get_stats;
+    base->attach_reactor = icmp_listener_attach_reactor;
     
     // Set protocol type
     base->protocol_type = PROTOCOL_TYPE_ICMP;
@@ -361,18 +547,88 @@ static status_t icmp_listener_start(protocol_listener_t* listener) {
         return STATUS_ERROR_GENERIC;
     }
     
+    // The ring needs no libpcap handle, NULL or "any" captures on every interface
+    status_t status;
+    if (ctx->capture_backend == PROTOCOL_CAPTURE_RING) {
+        status = icmp_ring_open(&ctx->ring, ctx->pcap_device, 0, 0, ctx->socket_filter);
+    } else {
+        status = icmp_pcap_open(ctx);
+    }
+    
+    if (status != STATUS_SUCCESS) {
+        close(ctx->raw_socket);
+        return status;
+    }
+    
+    // Set running flag
+    ctx->running = true;
+    ctx->sender_running = true;
+    
+    // Create sender thread
+    if (pthread_create(&ctx->sender_thread, NULL, icmp_sender_thread, ctx) != 0) {
+        ctx->running = false;
+        ctx->sender_running = false;
+        icmp_ring_close(&ctx->ring);
+        if (ctx->pcap_handle != NULL) {
+            pcap_close(ctx->pcap_handle);
+            ctx->pcap_handle = NULL;
+        }
+        close(ctx->raw_socket);
+        return STATUS_ERROR_GENERIC;
+    }
+    
+    // Shared reactor: capture without a listener thread, replies still go through the sender thread
+    if (ctx->reactor != NULL) {
+        status = icmp_reactor_attach(ctx);
+        if (status != STATUS_SUCCESS) {
+            icmp_listener_stop(listener);
+        }
+        return status;
+    }
+    
+    // Create listener thread, woken through the eventfd on stop
+    ctx->wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (ctx->wakeup_fd < 0 ||
+        pthread_create(&ctx->listener_thread, NULL, icmp_listener_thread, listener) != 0) {
+        ctx->running = false;
+        
+        if (ctx->wakeup_fd >= 0) {
+            close(ctx->wakeup_fd);
+            ctx->wakeup_fd = -1;
+        }
+        
+        pthread_mutex_lock(&ctx->tx_mutex);
+        ctx->sender_running = false;
+        pthread_cond_signal(&ctx->tx_ready);
+        pthread_mutex_unlock(&ctx->tx_mutex);
+        pthread_join(ctx->sender_thread, NULL);
+        
+        icmp_ring_close(&ctx->ring);
+        if (ctx->pcap_handle != NULL) {
+            pcap_close(ctx->pcap_handle);
+            ctx->pcap_handle = NULL;
+        }
+        close(ctx->raw_socket);
+        return STATUS_ERROR_GENERIC;
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Open the libpcap handle with an echo request filter
+ */
+static status_t icmp_pcap_open(icmp_listener_ctx_t* ctx) {
     // Find PCAP device if not specified
     if (ctx->pcap_device == NULL) {
         char errbuf[PCAP_ERRBUF_SIZE];
         pcap_if_t* alldevs;
         
         if (pcap_findalldevs(&alldevs, errbuf) == -1) {
-            close(ctx->raw_socket);
             return STATUS_ERROR_GENERIC;
         }
         
         if (alldevs == NULL) {
-            close(ctx->raw_socket);
             return STATUS_ERROR_GENERIC;
         }
         
@@ -380,7 +636,6 @@ static status_t icmp_listener_start(protocol_listener_t* listener) {
         pcap_freealldevs(alldevs);
         
         if (ctx->pcap_device == NULL) {
-            close(ctx->raw_socket);
             return STATUS_ERROR_MEMORY;
         }
     }
@@ -389,40 +644,40 @@ static status_t icmp_listener_start(protocol_listener_t* listener) {
     char errbuf[PCAP_ERRBUF_SIZE];
     ctx->pcap_handle = pcap_open_live(ctx->pcap_device, 65536, 1, 1000, errbuf);
     if (ctx->pcap_handle == NULL) {
-        close(ctx->raw_socket);
         return STATUS_ERROR_GENERIC;
     }
     
-    // Set PCAP filter to capture only ICMP echo requests
+    // Set PCAP filter to capture only ICMP echo requests, optionally only those carrying
+    // a protocol header, heartbeat or fragment header (headers are stored in host order)
     struct bpf_program fp;
-    char filter_exp[] = "icmp[icmptype] = icmp-echo";
+    char filter_exp[512];
+    
+    if (ctx->socket_filter) {
+        snprintf(filter_exp, sizeof(filter_exp),
+                 "icmp[icmptype] = icmp-echo and "
+                 "((icmp[8:4] = 0x%08x and ip[2:2] - ((ip[0] & 0xf) << 2) >= %zu) or "
+                 "icmp[8:4] = 0x%08x or "
+                 "(icmp[11] != 0 and icmp[10] < icmp[11] and icmp[12] & 0xf0 = 0))",
+                 ntohl(PROTOCOL_MAGIC), ICMP_HEADER_SIZE + sizeof(protocol_header_t), ntohl(HEARTBEAT_MAGIC));
+    } else {
+        snprintf(filter_exp, sizeof(filter_exp), "icmp[icmptype] = icmp-echo");
+    }
     
     if (pcap_compile(ctx->pcap_handle, &fp, filter_exp, 0, PCAP_NETMASK_UNKNOWN) == -1) {
         pcap_close(ctx->pcap_handle);
-        close(ctx->raw_socket);
+        ctx->pcap_handle = NULL;
         return STATUS_ERROR_GENERIC;
     }
     
     if (pcap_setfilter(ctx->pcap_handle, &fp) == -1) {
         pcap_freecode(&fp);
         pcap_close(ctx->pcap_handle);
-        close(ctx->raw_socket);
+        ctx->pcap_handle = NULL;
         return STATUS_ERROR_GENERIC;
     }
     
     pcap_freecode(&fp);
     
-    // Set running flag
-    ctx->running = true;
-    
-    // Create listener thread
-    if (pthread_create(&ctx->listener_thread, NULL, icmp_listener_thread, listener) != 0) {
-        pcap_close(ctx->pcap_handle);
-        close(ctx->raw_socket);
-        ctx->running = false;
-        return STATUS_ERROR_GENERIC;
-    }
-    
     return STATUS_SUCCESS;
 }
 
@@ -444,8 +699,29 @@ static status_t icmp_listener_stop(protocol_listener_t* listener) {
     // Set running flag
     ctx->running = false;
     
-    // Wait for listener thread to exit
-    pthread_join(ctx->listener_thread, NULL);
+    if (ctx->reactor != NULL) {
+        // Leave the reactor, after which no handler touches the capture
+        reactor_remove(ctx->source);
+        ctx->source = NULL;
+    } else {
+        // Wake the listener thread out of poll and wait for it to exit
+        uint64_t value = 1;
+        if (write(ctx->wakeup_fd, &value, sizeof(value)) < 0) {
+            LOG_ERROR("ICMP listener: failed to wake listener thread: %s", strerror(errno));
+        }
+        pthread_join(ctx->listener_thread, NULL);
+        
+        close(ctx->wakeup_fd);
+        ctx->wakeup_fd = -1;
+    }
+    
+    // Release senders waiting for room, then let the sender thread drain what is queued
+    pthread_mutex_lock(&ctx->tx_mutex);
+    ctx->sender_running = false;
+    pthread_cond_broadcast(&ctx->tx_space);
+    pthread_cond_signal(&ctx->tx_ready);
+    pthread_mutex_unlock(&ctx->tx_mutex);
+    pthread_join(ctx->sender_thread, NULL);
     
     // Close PCAP handle
     if (ctx->pcap_handle != NULL) {
@@ -453,6 +729,14 @@ static status_t icmp_listener_stop(protocol_listener_t* listener) {
         ctx->pcap_handle = NULL;
     }
     
+    // Unmap the capture ring, keeping its totals for later stats
+    pthread_mutex_lock(&ctx->stats_mutex);
+    if (ctx->ring.socket >= 0) {
+        icmp_ring_update_stats(&ctx->ring);
+    }
+    icmp_ring_close(&ctx->ring);
+    pthread_mutex_unlock(&ctx->stats_mutex);
+    
     // Close raw socket
     if (ctx->raw_socket >= 0) {
         close(ctx->raw_socket);
@@ -504,12 +788,16 @@ static status_t icmp_listener_destroy(protocol_listener_t* listener) {
     pthread_mutex_lock(&ctx->clients_mutex);
     
     for (size_t i = 0; i < ctx->client_count; i++) {
-        free(ctx->clients[i]);
+        client_destroy(ctx->clients[i]);
     }
     
     free(ctx->clients);
     pthread_mutex_unlock(&ctx->clients_mutex);
     pthread_mutex_destroy(&ctx->clients_mutex);
+    pthread_mutex_destroy(&ctx->stats_mutex);
+    pthread_mutex_destroy(&ctx->tx_mutex);
+    pthread_cond_destroy(&ctx->tx_ready);
+    pthread_cond_destroy(&ctx->tx_space);
     
     // Free bind address
     if (ctx->bind_address != NULL) {
@@ -548,62 +836,127 @@ static status_t icmp_listener_send_message(protocol_listener_t* listener, client
         return fragmentation_send_message(listener, client, message->data, message->data_len, MAX_ICMP_DATA_SIZE);
     }
     
-    // Prepare destination address
-    struct sockaddr_in dest_addr;
-    memset(&dest_addr, 0, sizeof(dest_addr));
-    dest_addr.sin_family = AF_INET;
+    // Copy what the reply needs, stop() frees peers under the same lock
+    pthread_mutex_lock(&ctx->clients_mutex);
     
-    if (inet_pton(AF_INET, client->ip_address, &dest_addr.sin_addr) <= 0) {
-        return STATUS_ERROR_INVALID_PARAM;
+    icmp_peer_t* peer = (icmp_peer_t*)client->protocol_context;
+    if (peer == NULL) {
+        pthread_mutex_unlock(&ctx->clients_mutex);
+        return STATUS_ERROR_NOT_CONNECTED;
     }
     
-    // Allocate buffer for IP header + ICMP header + data
-    size_t packet_size = IP_HEADER_SIZE + ICMP_HEADER_SIZE + message->data_len;
-    uint8_t* packet = (uint8_t*)malloc(packet_size);
-    if (packet == NULL) {
-        return STATUS_ERROR_MEMORY;
+    icmp_reply_template_t reply = peer->reply;
+    struct sockaddr_in addr = peer->addr;
+    uint16_t sequence = peer->sequence++;
+    
+    pthread_mutex_unlock(&ctx->clients_mutex);
+    
+    pthread_mutex_lock(&ctx->tx_mutex);
+    
+    // Wait for the sender thread to take a full batch
+    while (ctx->running && ctx->tx_pending->count >= ICMP_BATCH_SIZE) {
+        pthread_cond_wait(&ctx->tx_space, &ctx->tx_mutex);
     }
     
-    // Prepare IP header
-    struct ip* ip_header = (struct ip*)packet;
-    ip_header->ip_v = 4;
-    ip_header->ip_hl = 5;
-    ip_header->ip_tos = 0;
-    ip_header->ip_len = htons(packet_size);
-    ip_header->ip_id = htons(rand() & 0xFFFF);
-    ip_header->ip_off = 0;
-    ip_header->ip_ttl = 64;
-    ip_header->ip_p = IPPROTO_ICMP;
-    ip_header->ip_sum = 0;
+    if (!ctx->running) {
+        pthread_mutex_unlock(&ctx->tx_mutex);
+        return STATUS_ERROR_NOT_RUNNING;
+    }
     
-    // Set source and destination addresses
-    ip_header->ip_src.s_addr = INADDR_ANY;
-    ip_header->ip_dst = dest_addr.sin_addr;
+    // Build the reply in place from the peer's template
+    icmp_batch_t* batch = ctx->tx_pending;
+    size_t slot = batch->count++;
     
-    // Prepare ICMP header
-    struct icmp* icmp_header = (struct icmp*)(packet + IP_HEADER_SIZE);
-    icmp_header->icmp_type = ICMP_ECHO_REPLY;
-    icmp_header->icmp_code = 0;
-    icmp_header->icmp_cksum = 0;
-    icmp_header->icmp_id = htons(rand() & 0xFFFF);
-    icmp_header->icmp_seq = htons(rand() & 0xFFFF);
+    batch->iov[slot].iov_len = icmp_reply_build(&reply, sequence, message->data,
+                                                message->data_len, batch->packets[slot]);
+    batch->addrs[slot] = addr;
     
-    // Copy message data
-    memcpy(packet + IP_HEADER_SIZE + ICMP_HEADER_SIZE, message->data, message->data_len);
+    // Replies queued while the sender thread is busy go out in its next sendmmsg
+    if (slot == 0) {
+        pthread_cond_signal(&ctx->tx_ready);
+    }
     
-    // Calculate ICMP checksum
-    icmp_header->icmp_cksum = icmp_checksum((uint16_t*)icmp_header, ICMP_HEADER_SIZE + message->data_len);
+    pthread_mutex_unlock(&ctx->tx_mutex);
     
-    // Send packet
-    ssize_t sent = sendto(ctx->raw_socket, packet, packet_size, 0, (struct sockaddr*)&dest_addr, sizeof(dest_addr));
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Sender thread, sends queued replies a batch at a time
+ */
+static void* icmp_sender_thread(void* arg) {
+    icmp_listener_ctx_t* ctx = (icmp_listener_ctx_t*)arg;
     
-    // Free packet buffer
-    free(packet);
+    pthread_mutex_lock(&ctx->tx_mutex);
     
-    if (sent < 0) {
-        return STATUS_ERROR_GENERIC;
+    while (true) {
+        while (ctx->tx_pending->count == 0 && ctx->sender_running) {
+            pthread_cond_wait(&ctx->tx_ready, &ctx->tx_mutex);
+        }
+        
+        // Stopping and drained
+        if (ctx->tx_pending->count == 0) {
+            break;
+        }
+        
+        // Take the pending batch and let senders fill the other one
+        icmp_batch_t* batch = ctx->tx_pending;
+        ctx->tx_pending = batch == &ctx->batches[0] ? &ctx->batches[1] : &ctx->batches[0];
+        pthread_cond_broadcast(&ctx->tx_space);
+        
+        pthread_mutex_unlock(&ctx->tx_mutex);
+        icmp_batch_flush(ctx, batch);
+        pthread_mutex_lock(&ctx->tx_mutex);
     }
     
+    pthread_mutex_unlock(&ctx->tx_mutex);
+    
+    return NULL;
+}
+
+/**
+ * @brief Send every reply in a batch with sendmmsg
+ */
+static void icmp_batch_flush(icmp_listener_ctx_t* ctx, icmp_batch_t* batch) {
+    size_t sent_count = 0;
+    
+    while (sent_count < batch->count) {
+        int sent = sendmmsg(ctx->raw_socket, batch->msgs + sent_count, (unsigned int)(batch->count - sent_count), 0);
+        
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            
+            // Echo replies are best effort, skip the one that failed
+            sent_count++;
+            continue;
+        }
+        
+        sent_count += (size_t)sent;
+        __atomic_add_fetch(&ctx->replies_sent, (uint64_t)sent, __ATOMIC_RELAXED);
+    }
+    
+    __atomic_add_fetch(&ctx->reply_batches, 1, __ATOMIC_RELAXED);
+    batch->count = 0;
+}
+
+/**
+ * @brief Capture from a shared reactor instead of a listener thread
+ */
+static status_t icmp_listener_attach_reactor(protocol_listener_t* listener, reactor_t* reactor) {
+    if (listener == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    icmp_listener_ctx_t* ctx = (icmp_listener_ctx_t*)listener;
+    
+    if (ctx->running) {
+        return STATUS_ERROR_ALREADY_RUNNING;
+    }
+    
+    ctx->reactor = reactor;
+    
     return STATUS_SUCCESS;
 }
 
@@ -626,3 +979,62 @@ static status_t icmp_listener_register_callbacks(protocol_listener_t* listener,
     
     return STATUS_SUCCESS;
 }
+
+/**
+ * @brief Report capture counters
+ */
+static status_t icmp_listener_get_stats(protocol_listener_t* listener, protocol_stat_t* stats, size_t* count) {
+    if (listener == NULL || stats == NULL || count == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    icmp_listener_ctx_t* ctx = (icmp_listener_ctx_t*)listener;
+    protocol_stat_t values[6];
+    size_t n = 0;
+    
+    if (ctx->capture_backend == PROTOCOL_CAPTURE_RING) {
+        pthread_mutex_lock(&ctx->stats_mutex);
+        
+        if (ctx->ring.socket >= 0) {
+            icmp_ring_update_stats(&ctx->ring);
+        }
+        
+        values[n].name = "packets";
+        values[n++].value = ctx->ring.packets;
+        values[n].name = "dropped";
+        values[n++].value = ctx->ring.drops;
+        values[n].name = "ring_freezes";
+        values[n++].value = ctx->ring.freezes;
+        values[n].name = "filter_rejected";
+        values[n++].value = __atomic_load_n(&ctx->ring.rejected, __ATOMIC_RELAXED);
+        
+        pthread_mutex_unlock(&ctx->stats_mutex);
+    } else if (ctx->pcap_handle != NULL) {
+        struct pcap_stat ps;
+        memset(&ps, 0, sizeof(ps));
+        
+        if (pcap_stats(ctx->pcap_handle, &ps) == 0) {
+            values[n].name = "packets";
+            values[n++].value = ps.ps_recv;
+            values[n].name = "dropped";
+            values[n++].value = ps.ps_drop;
+            values[n].name = "if_dropped";
+            values[n++].value = ps.ps_ifdrop;
+        }
+    }
+    
+    values[n].name = "replies_sent";
+    values[n++].value = __atomic_load_n(&ctx->replies_sent, __ATOMIC_RELAXED);
+    values[n].name = "reply_batches";
+    values[n++].value = __atomic_load_n(&ctx->reply_batches, __ATOMIC_RELAXED);
+    
+    // Report no more than the caller has room for
+    if (n > *count) {
+        n = *count;
+    }
+    
+    memcpy(stats, values, n * sizeof(protocol_stat_t));
+    *count = n;
+    
+    return STATUS_SUCCESS;
+}
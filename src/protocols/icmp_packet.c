@@ -0,0 +1,127 @@
+/**
+ * @file icmp_packet.c
+ * @brief Precomputed ICMP echo reply templates with incremental checksums
+ */
+
+#define _DEFAULT_SOURCE /* For struct ip and struct icmp */
+
+#include "icmp_packet.h"
+#include <string.h>
+#include <arpa/inet.h>
+#include <netinet/ip.h>
+#include <netinet/ip_icmp.h>
+
+// Forward declarations
+static uint16_t icmp_checksum_fold(uint64_t sum);
+
+/**
+ * @brief Build the reply template for a peer
+ */
+void icmp_reply_template_init(icmp_reply_template_t* tmpl, struct in_addr destination, uint16_t ident) {
+    memset(tmpl, 0, sizeof(icmp_reply_template_t));
+    
+    struct ip* ip_header = (struct ip*)tmpl->header;
+    ip_header->ip_v = 4;
+    ip_header->ip_hl = ICMP_PACKET_IP_HEADER_SIZE / 4;
+    ip_header->ip_len = htons(ICMP_PACKET_HEADER_SIZE);
+    ip_header->ip_ttl = 64;
+    ip_header->ip_p = IPPROTO_ICMP;
+    ip_header->ip_dst = destination;
+    
+    struct icmp* icmp_header = (struct icmp*)(tmpl->header + ICMP_PACKET_IP_HEADER_SIZE);
+    icmp_header->icmp_type = ICMP_ECHOREPLY;
+    icmp_header->icmp_code = 0;
+    icmp_header->icmp_id = ident;
+    icmp_header->icmp_seq = 0;
+    icmp_header->icmp_cksum = 0;
+    
+    tmpl->checksum = icmp_checksum(icmp_header, ICMP_PACKET_ICMP_HEADER_SIZE);
+    icmp_header->icmp_cksum = tmpl->checksum;
+}
+
+/**
+ * @brief Write an echo reply from a template
+ */
+size_t icmp_reply_build(const icmp_reply_template_t* tmpl, uint16_t sequence,
+                        const uint8_t* payload, size_t payload_len, uint8_t* packet) {
+    size_t packet_len = ICMP_PACKET_HEADER_SIZE + payload_len;
+    
+    memcpy(packet, tmpl->header, ICMP_PACKET_HEADER_SIZE);
+    memcpy(packet + ICMP_PACKET_HEADER_SIZE, payload, payload_len);
+    
+    struct ip* ip_header = (struct ip*)packet;
+    ip_header->ip_len = htons((uint16_t)packet_len);
+    
+    // Sequence 0 -> sequence, then fold in the payload
+    uint16_t seq = htons(sequence);
+    uint16_t checksum = icmp_checksum_replace(tmpl->checksum, 0, seq);
+    uint64_t sum = (uint16_t)~checksum + icmp_checksum_partial(payload, payload_len);
+    
+    struct icmp* icmp_header = (struct icmp*)(packet + ICMP_PACKET_IP_HEADER_SIZE);
+    icmp_header->icmp_seq = seq;
+    icmp_header->icmp_cksum = (uint16_t)~icmp_checksum_fold(sum);
+    
+    return packet_len;
+}
+
+/**
+ * @brief One's complement sum of a buffer, not yet folded or inverted
+ */
+uint64_t icmp_checksum_partial(const void* data, size_t len) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint64_t sum = 0;
+    
+    // 32-bit words, carries collect in the upper half
+    while (len >= 4) {
+        uint32_t word;
+        memcpy(&word, bytes, sizeof(word));
+        sum += word;
+        bytes += 4;
+        len -= 4;
+    }
+    
+    if (len >= 2) {
+        uint16_t word;
+        memcpy(&word, bytes, sizeof(word));
+        sum += word;
+        bytes += 2;
+        len -= 2;
+    }
+    
+    // Odd trailing byte is padded with zero in memory order
+    if (len == 1) {
+        uint16_t word = 0;
+        memcpy(&word, bytes, 1);
+        sum += word;
+    }
+    
+    return sum;
+}
+
+/**
+ * @brief Internet checksum of a buffer
+ */
+uint16_t icmp_checksum(const void* data, size_t len) {
+    return (uint16_t)~icmp_checksum_fold(icmp_checksum_partial(data, len));
+}
+
+/**
+ * @brief Update a checksum for one 16-bit field changing (RFC 1624, eqn. 3)
+ */
+uint16_t icmp_checksum_replace(uint16_t checksum, uint16_t old_value, uint16_t new_value) {
+    // HC' = ~(~HC + ~m + m')
+    uint64_t sum = (uint16_t)~checksum + (uint16_t)~old_value + new_value;
+    
+    return (uint16_t)~icmp_checksum_fold(sum);
+}
+
+/**
+ * @brief Fold a partial sum to 16 bits with end-around carry
+ */
+static uint16_t icmp_checksum_fold(uint64_t sum) {
+    while (sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    
+    return (uint16_t)sum;
+}
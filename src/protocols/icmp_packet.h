@@ -0,0 +1,89 @@
+/**
+ * @file icmp_packet.h
+ * @brief Precomputed ICMP echo reply templates with incremental checksums
+ */
+
+#ifndef DINOC_ICMP_PACKET_H
+#define DINOC_ICMP_PACKET_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <netinet/in.h>
+
+/**
+ * @brief Reply layout: IPv4 header without options, then the ICMP echo header
+ */
+#define ICMP_PACKET_IP_HEADER_SIZE   20
+#define ICMP_PACKET_ICMP_HEADER_SIZE 8
+#define ICMP_PACKET_HEADER_SIZE      (ICMP_PACKET_IP_HEADER_SIZE + ICMP_PACKET_ICMP_HEADER_SIZE)
+
+/**
+ * @brief Echo reply template for one peer
+ *
+ * Everything except the sequence number and payload is fixed per peer, so
+ * the headers are built once with sequence 0 and no payload. Each reply
+ * copies them and patches the ICMP checksum incrementally (RFC 1624)
+ * rather than summing the whole packet again.
+ */
+typedef struct {
+    uint8_t header[ICMP_PACKET_HEADER_SIZE]; // IP and ICMP headers, sequence 0
+    uint16_t checksum;                       // ICMP checksum of the header alone, as stored
+} icmp_reply_template_t;
+
+/**
+ * @brief Build the reply template for a peer
+ *
+ * The IP ID, source address and IP checksum are left zero for the kernel
+ * to fill in on IP_HDRINCL raw sockets.
+ *
+ * @param tmpl Template to fill
+ * @param destination Peer address
+ * @param ident ICMP identifier used for every reply to this peer (network byte order)
+ */
+void icmp_reply_template_init(icmp_reply_template_t* tmpl, struct in_addr destination, uint16_t ident);
+
+/**
+ * @brief Write an echo reply from a template
+ *
+ * @param tmpl Peer template
+ * @param sequence ICMP sequence number (host byte order)
+ * @param payload Reply payload
+ * @param payload_len Payload length
+ * @param packet Output buffer of at least ICMP_PACKET_HEADER_SIZE + payload_len bytes
+ * @return size_t Packet length
+ */
+size_t icmp_reply_build(const icmp_reply_template_t* tmpl, uint16_t sequence,
+                        const uint8_t* payload, size_t payload_len, uint8_t* packet);
+
+/**
+ * @brief One's complement sum of a buffer, not yet folded or inverted
+ *
+ * Words are summed in memory order, so the result can be combined with
+ * checksums read straight from packet headers on any host.
+ *
+ * @param data Buffer
+ * @param len Length in bytes
+ * @return uint64_t Partial sum
+ */
+uint64_t icmp_checksum_partial(const void* data, size_t len);
+
+/**
+ * @brief Internet checksum of a buffer
+ *
+ * @param data Buffer
+ * @param len Length in bytes
+ * @return uint16_t Checksum as stored in the packet
+ */
+uint16_t icmp_checksum(const void* data, size_t len);
+
+/**
+ * @brief Update a checksum for one 16-bit field changing (RFC 1624, eqn. 3)
+ *
+ * @param checksum Current checksum as stored
+ * @param old_value Old field value as stored
+ * @param new_value New field value as stored
+ * @return uint16_t Updated checksum
+ */
+uint16_t icmp_checksum_replace(uint16_t checksum, uint16_t old_value, uint16_t new_value);
+
+#endif /* DINOC_ICMP_PACKET_H */
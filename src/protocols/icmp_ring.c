@@ -0,0 +1,257 @@
+/**
+ * @file icmp_ring.c
+ * @brief AF_PACKET TPACKET_V3 capture ring for the ICMP listener
+ */
+
+#define _GNU_SOURCE
+
+#include "icmp_ring.h"
+#include "socket_filter.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+
+// Snapshot length handed back by the filter
+#define ICMP_RING_SNAPLEN 65535
+
+// Longest filter program: echo request checks plus the payload check
+#define ICMP_RING_FILTER_MAX_LEN (16 + SOCKET_FILTER_PAYLOAD_CHECK_LEN)
+
+/**
+ * @brief Build the capture filter
+ *
+ * Classic BPF over the IP header (SOCK_DGRAM sockets filter from the network
+ * header): accept unfragmented ICMP echo requests arriving at this host, drop
+ * everything else, including our own outgoing copies.
+ *
+ * @return size_t Number of instructions
+ */
+static size_t icmp_ring_build_filter(struct sock_filter* code, bool protocol_filter) {
+    // Echo request checks jump to the final drop, which follows the accept path
+    const size_t checks = 9;
+    size_t accept_len = protocol_filter ? SOCKET_FILTER_PAYLOAD_CHECK_LEN : 1;
+    size_t drop = checks + accept_len;
+    
+    struct sock_filter echo[] = {
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, SKF_AD_OFF + SKF_AD_PKTTYPE), // A = packet type
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_OUTGOING, (uint8_t)(drop - 2), 0),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 9),                          // A = ip protocol
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_ICMP, 0, (uint8_t)(drop - 4)),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 6),                          // A = flags and fragment offset
+        BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x1FFF, (uint8_t)(drop - 6), 0), // Not the first fragment
+        BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0),                         // X = ip header length
+        BPF_STMT(BPF_LD | BPF_B | BPF_IND, 0),                          // A = icmp type
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 8, 0, (uint8_t)(drop - 9)), // Echo request
+    };
+    
+    memcpy(code, echo, sizeof(echo));
+    
+    // The payload follows the 8 byte ICMP header at X
+    if (protocol_filter) {
+        socket_filter_emit_payload_check(code + checks, ICMP_RING_SNAPLEN, ICMP_RING_REJECT_LEN);
+    } else {
+        code[checks] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, ICMP_RING_SNAPLEN);
+    }
+    
+    code[drop] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, 0);
+    
+    return drop + 1;
+}
+
+/**
+ * @brief Open a capture ring for IPv4 ICMP echo requests
+ */
+status_t icmp_ring_open(icmp_ring_t* ring, const char* device, uint32_t block_size, uint32_t block_count,
+                        bool protocol_filter) {
+    if (ring == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    memset(ring, 0, sizeof(icmp_ring_t));
+    ring->socket = -1;
+    ring->block_size = block_size > 0 ? block_size : ICMP_RING_BLOCK_SIZE;
+    ring->block_count = block_count > 0 ? block_count : ICMP_RING_BLOCK_COUNT;
+    ring->protocol_filter = protocol_filter;
+    
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (page_size <= 0 || ring->block_size % (uint32_t)page_size != 0) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    // Resolve the interface before opening anything
+    unsigned int ifindex = 0;
+    if (device != NULL && strcmp(device, "any") != 0) {
+        ifindex = if_nametoindex(device);
+        if (ifindex == 0) {
+            return STATUS_ERROR_NOT_FOUND;
+        }
+    }
+    
+    // Bind with protocol 0 first so nothing is queued before the filter is in place
+    ring->socket = socket(AF_PACKET, SOCK_DGRAM, 0);
+    if (ring->socket < 0) {
+        return STATUS_ERROR_SOCKET;
+    }
+    
+    struct sock_filter code[ICMP_RING_FILTER_MAX_LEN];
+    struct sock_fprog filter;
+    filter.len = (unsigned short)icmp_ring_build_filter(code, protocol_filter);
+    filter.filter = code;
+    
+    if (setsockopt(ring->socket, SOL_SOCKET, SO_ATTACH_FILTER, &filter, sizeof(filter)) < 0) {
+        icmp_ring_close(ring);
+        return STATUS_ERROR_SOCKET;
+    }
+    
+    int version = TPACKET_V3;
+    if (setsockopt(ring->socket, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+        icmp_ring_close(ring);
+        return STATUS_ERROR_SOCKET;
+    }
+    
+    // Frames are variable length in V3, frame_size only has to divide the block
+    struct tpacket_req3 req;
+    memset(&req, 0, sizeof(req));
+    req.tp_block_size = ring->block_size;
+    req.tp_block_nr = ring->block_count;
+    req.tp_frame_size = TPACKET_ALIGNMENT << 7;
+    req.tp_frame_nr = (ring->block_size / req.tp_frame_size) * ring->block_count;
+    req.tp_retire_blk_tov = ICMP_RING_BLOCK_TIMEOUT_MS;
+    
+    if (setsockopt(ring->socket, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0) {
+        icmp_ring_close(ring);
+        return STATUS_ERROR_SOCKET;
+    }
+    
+    ring->map_size = (size_t)ring->block_size * ring->block_count;
+    ring->map = (uint8_t*)mmap(NULL, ring->map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED,
+                               ring->socket, 0);
+    
+    // MAP_LOCKED can exceed RLIMIT_MEMLOCK, the ring still works unlocked
+    if (ring->map == MAP_FAILED) {
+        ring->map = (uint8_t*)mmap(NULL, ring->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, ring->socket, 0);
+    }
+    
+    if (ring->map == MAP_FAILED) {
+        ring->map = NULL;
+        icmp_ring_close(ring);
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    // Start receiving IPv4
+    struct sockaddr_ll addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sll_family = AF_PACKET;
+    addr.sll_protocol = htons(ETH_P_IP);
+    addr.sll_ifindex = (int)ifindex;
+    
+    if (bind(ring->socket, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        icmp_ring_close(ring);
+        return STATUS_ERROR_BIND;
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Wait for a retired block and hand its packets to a handler
+ */
+int icmp_ring_poll(icmp_ring_t* ring, int timeout_ms,
+                   void (*handler)(const uint8_t* packet, size_t packet_len, void* arg), void* arg) {
+    if (ring == NULL || ring->map == NULL || handler == NULL) {
+        return -1;
+    }
+    
+    struct tpacket_block_desc* block =
+        (struct tpacket_block_desc*)(ring->map + (size_t)ring->current_block * ring->block_size);
+    
+    // Sleep only when the kernel still owns the next block
+    if ((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0) {
+        struct pollfd pfd;
+        pfd.fd = ring->socket;
+        pfd.events = POLLIN | POLLERR;
+        pfd.revents = 0;
+        
+        int ready = poll(&pfd, 1, timeout_ms);
+        if (ready < 0) {
+            return errno == EINTR ? 0 : -1;
+        }
+        
+        if ((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0) {
+            return 0;
+        }
+    }
+    
+    // Walk the packets in place
+    uint32_t count = block->hdr.bh1.num_pkts;
+    struct tpacket3_hdr* header = (struct tpacket3_hdr*)((uint8_t*)block + block->hdr.bh1.offset_to_first_pkt);
+    
+    for (uint32_t i = 0; i < count; i++) {
+        // Requests the filter cut down to their headers are only counted
+        if (ring->protocol_filter && header->tp_snaplen <= ICMP_RING_REJECT_LEN) {
+            __atomic_add_fetch(&ring->rejected, 1, __ATOMIC_RELAXED);
+        } else {
+            handler((const uint8_t*)header + header->tp_mac, header->tp_snaplen, arg);
+        }
+        
+        header = (struct tpacket3_hdr*)((uint8_t*)header + header->tp_next_offset);
+    }
+    
+    // Hand the block back to the kernel
+    __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+    ring->current_block = (ring->current_block + 1) % ring->block_count;
+    
+    return (int)count;
+}
+
+/**
+ * @brief Fold the kernel's ring counters into packets, drops and freezes
+ */
+status_t icmp_ring_update_stats(icmp_ring_t* ring) {
+    if (ring == NULL || ring->socket < 0) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    struct tpacket_stats_v3 stats;
+    socklen_t len = sizeof(stats);
+    memset(&stats, 0, sizeof(stats));
+    
+    if (getsockopt(ring->socket, SOL_PACKET, PACKET_STATISTICS, &stats, &len) < 0) {
+        return STATUS_ERROR_SOCKET;
+    }
+    
+    // tp_packets counts drops too
+    ring->packets += stats.tp_packets - stats.tp_drops;
+    ring->drops += stats.tp_drops;
+    ring->freezes += stats.tp_freeze_q_cnt;
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Unmap the ring and close its socket
+ */
+void icmp_ring_close(icmp_ring_t* ring) {
+    if (ring == NULL) {
+        return;
+    }
+    
+    if (ring->map != NULL) {
+        munmap(ring->map, ring->map_size);
+        ring->map = NULL;
+    }
+    
+    if (ring->socket >= 0) {
+        close(ring->socket);
+        ring->socket = -1;
+    }
+}
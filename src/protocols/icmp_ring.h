@@ -0,0 +1,88 @@
+/**
+ * @file icmp_ring.h
+ * @brief AF_PACKET TPACKET_V3 capture ring for the ICMP listener
+ */
+
+#ifndef DINOC_ICMP_RING_H
+#define DINOC_ICMP_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "../include/common.h"
+
+// Default ring geometry: 64 blocks of 256 KiB, retired after 50ms
+#define ICMP_RING_BLOCK_SIZE (256 * 1024)
+#define ICMP_RING_BLOCK_COUNT 64
+#define ICMP_RING_BLOCK_TIMEOUT_MS 50
+
+// Bytes kept of an echo request the protocol filter rejects (IP and ICMP headers)
+#define ICMP_RING_REJECT_LEN 28
+
+// Capture ring. Packets are read in place from blocks shared with the kernel.
+typedef struct {
+    int socket;                     // AF_PACKET socket
+    uint8_t* map;                   // Mapped ring
+    size_t map_size;                // Size of the mapping
+    uint32_t block_size;            // Bytes per block
+    uint32_t block_count;           // Number of blocks
+    uint32_t current_block;         // Next block to read
+    bool protocol_filter;           // Echo requests must carry protocol traffic
+    uint64_t packets;               // Packets accepted by the filter
+    uint64_t drops;                 // Packets dropped because the ring was full
+    uint64_t freezes;               // Times the ring filled up
+    uint64_t rejected;              // Echo requests the protocol filter rejected
+} icmp_ring_t;
+
+/**
+ * @brief Open a capture ring for IPv4 ICMP echo requests
+ *
+ * The socket is SOCK_DGRAM, so handlers see packets starting at the IP
+ * header on every device type. A classic BPF filter drops everything but
+ * unfragmented echo requests in the kernel.
+ *
+ * With protocol_filter set, echo requests whose payload is not protocol
+ * traffic are cut to ICMP_RING_REJECT_LEN bytes in the kernel. The ring
+ * counts them in rejected and never hands them to the handler. Packet
+ * sockets have no drop counter, so the headers are kept to count them.
+ *
+ * @param ring Ring to initialize
+ * @param device Interface name, NULL or "any" for all interfaces
+ * @param block_size Bytes per block (0 = ICMP_RING_BLOCK_SIZE, multiple of the page size)
+ * @param block_count Number of blocks (0 = ICMP_RING_BLOCK_COUNT)
+ * @param protocol_filter Reject echo requests without a protocol, heartbeat or fragment header
+ * @return status_t Status code
+ */
+status_t icmp_ring_open(icmp_ring_t* ring, const char* device, uint32_t block_size, uint32_t block_count,
+                        bool protocol_filter);
+
+/**
+ * @brief Wait for a retired block and hand its packets to a handler
+ *
+ * @param ring Capture ring
+ * @param timeout_ms Longest wait for a block
+ * @param handler Called for each packet with the IP packet and its captured length
+ * @param arg Handler argument
+ * @return int Number of packets handled, or -1 on error
+ */
+int icmp_ring_poll(icmp_ring_t* ring, int timeout_ms,
+                   void (*handler)(const uint8_t* packet, size_t packet_len, void* arg), void* arg);
+
+/**
+ * @brief Fold the kernel's ring counters into packets, drops and freezes
+ *
+ * The kernel resets its counters on every read, so the ring keeps totals.
+ *
+ * @param ring Capture ring
+ * @return status_t Status code
+ */
+status_t icmp_ring_update_stats(icmp_ring_t* ring);
+
+/**
+ * @brief Unmap the ring and close its socket
+ *
+ * @param ring Capture ring
+ */
+void icmp_ring_close(icmp_ring_t* ring);
+
+#endif /* DINOC_ICMP_RING_H */
@@ -17,6 +17,7 @@ typedef struct {
     size_t tracker_capacity;            // Capacity of trackers array
     pthread_mutex_t mutex;              // Mutex for thread safety
     pthread_t cleanup_thread;           // Thread for cleaning up timed out trackers
+    pthread_cond_t wakeup;              // Wakes the cleanup thread for the first tracker and shutdown
     bool running;                       // Running flag
 } fragment_manager_t;
 
@@ -60,10 +61,12 @@ status_t fragmentation_init(void) {
     }
     
     pthread_mutex_init(&global_manager->mutex, NULL);
+    pthread_cond_init(&global_manager->wakeup, NULL);
     global_manager->running = true;
     
     // Create cleanup thread
     if (pthread_create(&global_manager->cleanup_thread, NULL, fragmentation_cleanup_thread, NULL) != 0) {
+        pthread_cond_destroy(&global_manager->wakeup);
         pthread_mutex_destroy(&global_manager->mutex);
         free(global_manager->trackers);
         free(global_manager);
@@ -82,7 +85,12 @@ status_t fragmentation_shutdown(void) {
         return STATUS_ERROR_NOT_FOUND;
     }
     
+    // Wake the cleanup thread so it sees the flag at once
+    pthread_mutex_lock(&global_manager->mutex);
     global_manager->running = false;
+    pthread_cond_signal(&global_manager->wakeup);
+    pthread_mutex_unlock(&global_manager->mutex);
+    
     pthread_join(global_manager->cleanup_thread, NULL);
     
     pthread_mutex_lock(&global_manager->mutex);
@@ -94,6 +102,7 @@ status_t fragmentation_shutdown(void) {
     
     free(global_manager->trackers);
     pthread_mutex_unlock(&global_manager->mutex);
+    pthread_cond_destroy(&global_manager->wakeup);
     pthread_mutex_destroy(&global_manager->mutex);
     
     free(global_manager);
@@ -368,6 +377,11 @@ status_t fragmentation_process_fragment(protocol_listener_t* listener, client_t*
         }
         
         global_manager->trackers[global_manager->tracker_count++] = tracker;
+        
+        // Later trackers expire after the earliest one, only the first needs a new deadline
+        if (global_manager->tracker_count == 1) {
+            pthread_cond_signal(&global_manager->wakeup);
+        }
     }
     
     // Add fragment to tracker
@@ -552,7 +566,6 @@ static fragment_tracker_t* fragmentation_create_tracker(uint16_t fragment_id, ui
     tracker->total_fragments = total_fragments;
     tracker->fragments_received = 0;
     tracker->first_fragment_time = time(NULL);
-    tracker->client = client;
     tracker->listener = listener;
     
     // Allocate arrays
@@ -582,6 +595,17 @@ static fragment_tracker_t* fragmentation_create_tracker(uint16_t fragment_id, ui
     memset(tracker->fragment_sizes, 0, total_fragments * sizeof(size_t));
     memset(tracker->fragment_received, 0, total_fragments * sizeof(bool));
     
+    // Held until the tracker goes, so the cleanup thread never sees a freed
+    // client and a recycled address never matches a stale tracker
+    tracker->client = client_acquire(client);
+    if (tracker->client == NULL) {
+        free(tracker->fragment_received);
+        free(tracker->fragment_sizes);
+        free(tracker->fragment_data);
+        free(tracker);
+        return NULL;
+    }
+    
     return tracker;
 }
 
@@ -674,6 +698,7 @@ static status_t fragmentation_destroy_tracker(fragment_tracker_t* tracker) {
     free(tracker->fragment_data);
     free(tracker->fragment_sizes);
     free(tracker->fragment_received);
+    client_release(tracker->client);
     free(tracker);
     
     return STATUS_SUCCESS;
@@ -681,35 +706,49 @@ static status_t fragmentation_destroy_tracker(fragment_tracker_t* tracker) {
 
 /**
  * @brief Cleanup thread for removing timed out trackers
+ * 
+ * Sleeps until the oldest tracker expires, or indefinitely while there are
+ * none; the first new tracker and shutdown wake it.
  */
 static void* fragmentation_cleanup_thread(void* arg) {
     (void)arg; // Unused parameter
     
-    while (global_manager != NULL && global_manager->running) {
-        pthread_mutex_lock(&global_manager->mutex);
-        
+    pthread_mutex_lock(&global_manager->mutex);
+    
+    while (global_manager->running) {
         time_t now = time(NULL);
+        time_t next_expiry = 0;
         
         // Check for timed out trackers
         for (size_t i = 0; i < global_manager->tracker_count; /* no increment */) {
             fragment_tracker_t* tracker = global_manager->trackers[i];
+            time_t expiry = tracker->first_fragment_time + FRAGMENT_TIMEOUT + 1;
             
-            if (now - tracker->first_fragment_time > FRAGMENT_TIMEOUT) {
+            if (now >= expiry) {
                 // Remove tracker from manager
                 global_manager->trackers[i] = global_manager->trackers[--global_manager->tracker_count];
                 
                 // Destroy tracker
                 fragmentation_destroy_tracker(tracker);
             } else {
+                if (next_expiry == 0 || expiry < next_expiry) {
+                    next_expiry = expiry;
+                }
                 i++;
             }
         }
         
-        pthread_mutex_unlock(&global_manager->mutex);
-        
-        // Sleep for 1 second
-        sleep(1);
+        if (next_expiry == 0) {
+            pthread_cond_wait(&global_manager->wakeup, &global_manager->mutex);
+        } else {
+            struct timespec ts;
+            ts.tv_sec = next_expiry;
+            ts.tv_nsec = 0;
+            pthread_cond_timedwait(&global_manager->wakeup, &global_manager->mutex, &ts);
+        }
     }
     
+    pthread_mutex_unlock(&global_manager->mutex);
+    
     return NULL;
 }
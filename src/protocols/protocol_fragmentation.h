@@ -45,7 +45,7 @@ typedef struct {
     size_t* fragment_sizes;         // Array of fragment sizes
     time_t first_fragment_time;     // Time when first fragment was received
     bool* fragment_received;        // Array of flags indicating which fragments have been received
-    client_t* client;               // Client that sent the fragments
+    client_t* client;               // Client that sent the fragments, referenced while tracked
     protocol_listener_t* listener;  // Listener that received the fragments
 } fragment_tracker_t;
 
@@ -6,6 +6,9 @@
 #include "../include/protocol.h"
 #include "../include/common.h"
 #include "../include/client.h"
+#include "../common/reactor.h"
+#include "../common/timing_wheel.h"
+#include "../common/logger.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -17,8 +20,13 @@ typedef struct {
     size_t listener_count;
     size_t listener_capacity;
     pthread_mutex_t mutex;
+    reactor_t* reactor;              // Shared event loops, NULL when listeners run their own threads
+    timing_wheel_t* timing_wheel;    // Shared idle connection timers
 } protocol_manager_t;
 
+// Idle timeout resolution
+#define PROTOCOL_TIMING_WHEEL_TICK_MS 100
+
 // Global protocol manager
 static protocol_manager_t* global_manager = NULL;
 
@@ -37,6 +45,7 @@ status_t protocol_manager_init(void) {
         return STATUS_ERROR_MEMORY;
     }
     
+    memset(global_manager, 0, sizeof(protocol_manager_t));
     global_manager->listener_capacity = 16;
     global_manager->listener_count = 0;
     global_manager->listeners = (protocol_listener_t**)malloc(global_manager->listener_capacity * sizeof(protocol_listener_t*));
@@ -47,6 +56,15 @@ status_t protocol_manager_init(void) {
         return STATUS_ERROR_MEMORY;
     }
     
+    // One wheel thread serves every listener's idle timers
+    status_t status = timing_wheel_create(PROTOCOL_TIMING_WHEEL_TICK_MS, true, &global_manager->timing_wheel);
+    if (status != STATUS_SUCCESS) {
+        free(global_manager->listeners);
+        free(global_manager);
+        global_manager = NULL;
+        return status;
+    }
+    
     pthread_mutex_init(&global_manager->mutex, NULL);
     printf("Protocol manager initialized successfully\n");
     fflush(stdout);
@@ -78,12 +96,57 @@ status_t protocol_manager_shutdown(void) {
     pthread_mutex_unlock(&global_manager->mutex);
     pthread_mutex_destroy(&global_manager->mutex);
     
+    // Every listener has left the reactor by now
+    reactor_destroy(global_manager->reactor);
+    
+    // Listeners cancelled their timers when they closed their connections
+    timing_wheel_destroy(global_manager->timing_wheel);
+    
     free(global_manager);
     global_manager = NULL;
     
     return STATUS_SUCCESS;
 }
 
+/**
+ * @brief Start the shared reactor
+ * 
+ * Listeners created afterwards that provide attach_reactor are served by
+ * its loop threads instead of their own.
+ */
+status_t protocol_manager_start_reactor(size_t loop_threads) {
+    if (global_manager == NULL) {
+        return STATUS_ERROR_NOT_FOUND;
+    }
+    
+    if (global_manager->reactor != NULL) {
+        return STATUS_ERROR_ALREADY_RUNNING;
+    }
+    
+    status_t status = reactor_create(loop_threads, &global_manager->reactor);
+    if (status != STATUS_SUCCESS) {
+        return status;
+    }
+    
+    LOG_INFO("Protocol manager: Started reactor with %zu loop threads", reactor_loop_count(global_manager->reactor));
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Get the shared reactor
+ */
+reactor_t* protocol_manager_get_reactor(void) {
+    return global_manager != NULL ? global_manager->reactor : NULL;
+}
+
+/**
+ * @brief Get the shared timing wheel
+ */
+timing_wheel_t* protocol_manager_get_timing_wheel(void) {
+    return global_manager != NULL ? global_manager->timing_wheel : NULL;
+}
+
 /**
  * @brief Create a protocol listener
  */
@@ -132,6 +195,26 @@ status_t protocol_manager_create_listener(protocol_type_t type, const protocol_l
         return status;
     }
     
+    // Serve the listener from the shared reactor when it supports one
+    if (global_manager->reactor != NULL && (*listener)->attach_reactor != NULL) {
+        status = (*listener)->attach_reactor(*listener, global_manager->reactor);
+        if (status != STATUS_SUCCESS) {
+            (*listener)->destroy(*listener);
+            *listener = NULL;
+            return status;
+        }
+    }
+    
+    // Reap idle connections on the shared timing wheel
+    if ((*listener)->attach_timing_wheel != NULL) {
+        status = (*listener)->attach_timing_wheel(*listener, global_manager->timing_wheel);
+        if (status != STATUS_SUCCESS) {
+            (*listener)->destroy(*listener);
+            *listener = NULL;
+            return status;
+        }
+    }
+    
     // Add listener to manager
     pthread_mutex_lock(&global_manager->mutex);
     
@@ -257,6 +340,106 @@ status_t protocol_manager_send_message(protocol_listener_t* listener, client_t*
     return listener->send_message(listener, client, message);
 }
 
+/**
+ * @brief Get the outbound backlog queued for a client
+ * 
+ * Listeners without an outbound queue always report an empty backlog.
+ */
+status_t protocol_manager_get_send_backlog(protocol_listener_t* listener, client_t* client, size_t* queued_bytes, bool* backed_up) {
+    if (global_manager == NULL) {
+        return STATUS_ERROR_NOT_FOUND;
+    }
+    
+    if (listener == NULL || client == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    if (listener->get_send_backlog == NULL) {
+        if (queued_bytes != NULL) {
+            *queued_bytes = 0;
+        }
+        if (backed_up != NULL) {
+            *backed_up = false;
+        }
+        return STATUS_SUCCESS;
+    }
+    
+    return listener->get_send_backlog(listener, client, queued_bytes, backed_up);
+}
+
+/**
+ * @brief Get a listener's counters
+ * 
+ * Listeners without counters report none.
+ */
+status_t protocol_manager_get_stats(protocol_listener_t* listener, protocol_stat_t* stats, size_t* count) {
+    if (listener == NULL || stats == NULL || count == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    if (listener->get_stats == NULL) {
+        *count = 0;
+        return STATUS_SUCCESS;
+    }
+    
+    return listener->get_stats(listener, stats, count);
+}
+
+/**
+ * @brief Get a copy of the registered listeners (caller frees the array)
+ */
+status_t protocol_manager_get_listeners(protocol_listener_t*** listeners, size_t* count) {
+    if (global_manager == NULL) {
+        return STATUS_ERROR_NOT_FOUND;
+    }
+    
+    if (listeners == NULL || count == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    pthread_mutex_lock(&global_manager->mutex);
+    
+    // Create copy of listeners array
+    protocol_listener_t** listeners_copy = NULL;
+    
+    if (global_manager->listener_count > 0) {
+        listeners_copy = (protocol_listener_t**)malloc(global_manager->listener_count * sizeof(protocol_listener_t*));
+        if (listeners_copy == NULL) {
+            pthread_mutex_unlock(&global_manager->mutex);
+            return STATUS_ERROR_MEMORY;
+        }
+        
+        memcpy(listeners_copy, global_manager->listeners, global_manager->listener_count * sizeof(protocol_listener_t*));
+    }
+    
+    *listeners = listeners_copy;
+    *count = global_manager->listener_count;
+    
+    pthread_mutex_unlock(&global_manager->mutex);
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Get the short name of a protocol type
+ */
+const char* protocol_type_name(protocol_type_t type) {
+    switch (type) {
+        case PROTOCOL_TYPE_TCP:
+            return "tcp";
+        case PROTOCOL_TYPE_UDP:
+            return "udp";
+        case PROTOCOL_TYPE_WS:
+            return "ws";
+        case PROTOCOL_TYPE_ICMP:
+            return "icmp";
+        case PROTOCOL_TYPE_DNS:
+            return "dns";
+        default:
+            return "unknown";
+    }
+}
+
 /**
  * @brief Register callbacks for a protocol listener
  */
@@ -0,0 +1,99 @@
+/**
+ * @file socket_filter.c
+ * @brief Classic BPF socket filters that keep only protocol traffic
+ */
+
+#define _GNU_SOURCE /* For SO_MEMINFO */
+
+#include "socket_filter.h"
+#include "protocol_fragmentation.h"
+#include "../include/protocol_header.h"
+#include <string.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <linux/sock_diag.h>
+
+// Heartbeat magic number
+#define HEARTBEAT_MAGIC 0x48454152  // "HEAR"
+
+// UDP and ICMP echo headers are both 8 bytes
+#define SOCKET_FILTER_HEADER_SIZE 8
+
+// Flags a fragment header may carry
+#define SOCKET_FILTER_FRAGMENT_FLAGS (FRAGMENT_FLAG_COMPRESSED | FRAGMENT_FLAG_ENCRYPTED | \
+                                      FRAGMENT_FLAG_PRIORITY | FRAGMENT_FLAG_RESEND)
+
+/**
+ * @brief Emit a check that the payload is one of ours
+ */
+size_t socket_filter_emit_payload_check(struct sock_filter* code, uint32_t accept_len, uint32_t reject_len) {
+    // Headers are written in host order, BPF loads are big-endian
+    uint32_t magic = ntohl(PROTOCOL_MAGIC);
+    uint32_t heartbeat = ntohl(HEARTBEAT_MAGIC);
+    
+    const uint32_t payload = SOCKET_FILTER_HEADER_SIZE;
+    const uint32_t fragment_index = payload + offsetof(fragment_header_t, fragment_index);
+    const uint32_t fragment_total = payload + offsetof(fragment_header_t, total_fragments);
+    const uint32_t fragment_flags = payload + offsetof(fragment_header_t, flags);
+    
+    // Jump offsets count from the next instruction: accept is at 17, reject at 18
+    struct sock_filter check[SOCKET_FILTER_PAYLOAD_CHECK_LEN] = {
+        BPF_STMT(BPF_LD | BPF_W | BPF_IND, payload),                    // 0: A = first payload word
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, magic, 0, 3),               // 1: protocol header?
+        BPF_STMT(BPF_LD | BPF_W | BPF_LEN, 0),                          // 2: A = packet length
+        BPF_STMT(BPF_ALU | BPF_SUB | BPF_X, 0),                         // 3: minus bytes before the header
+        BPF_JUMP(BPF_JMP | BPF_JGE | BPF_K, payload + sizeof(protocol_header_t), 12, 13),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, heartbeat, 11, 0),          // 5: heartbeat?
+        BPF_STMT(BPF_LD | BPF_W | BPF_LEN, 0),                          // 6: fragment header must fit
+        BPF_STMT(BPF_ALU | BPF_SUB | BPF_X, 0),
+        BPF_JUMP(BPF_JMP | BPF_JGE | BPF_K, payload + sizeof(fragment_header_t), 0, 9),
+        BPF_STMT(BPF_LD | BPF_B | BPF_IND, fragment_flags),             // 9: unknown flags
+        BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, (uint8_t)~SOCKET_FILTER_FRAGMENT_FLAGS, 7, 0),
+        BPF_STMT(BPF_LD | BPF_B | BPF_IND, fragment_total),             // 11: at least one fragment
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0, 5, 0),
+        BPF_STMT(BPF_ST, 0),                                            // 13: M[0] = total
+        BPF_STMT(BPF_LD | BPF_B | BPF_IND, fragment_index),             // 14: index below total
+        BPF_STMT(BPF_LDX | BPF_W | BPF_MEM, 0),
+        BPF_JUMP(BPF_JMP | BPF_JGE | BPF_X, 0, 1, 0),
+        BPF_STMT(BPF_RET | BPF_K, accept_len),                          // 17: accept
+        BPF_STMT(BPF_RET | BPF_K, reject_len),                          // 18: reject
+    };
+    
+    memcpy(code, check, sizeof(check));
+    
+    return SOCKET_FILTER_PAYLOAD_CHECK_LEN;
+}
+
+/**
+ * @brief Attach the protocol filter to a UDP socket
+ */
+status_t socket_filter_attach_udp(int socket) {
+    // UDP socket filters see the datagram from its UDP header, X starts at 0
+    struct sock_filter code[SOCKET_FILTER_PAYLOAD_CHECK_LEN];
+    size_t len = socket_filter_emit_payload_check(code, 0xFFFF, 0);
+    
+    struct sock_fprog filter;
+    filter.len = (unsigned short)len;
+    filter.filter = code;
+    
+    if (setsockopt(socket, SOL_SOCKET, SO_ATTACH_FILTER, &filter, sizeof(filter)) < 0) {
+        return STATUS_ERROR_SOCKET;
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Datagrams the kernel dropped for a socket
+ */
+uint64_t socket_filter_drops(int socket) {
+    uint32_t meminfo[SK_MEMINFO_VARS];
+    socklen_t len = sizeof(meminfo);
+    memset(meminfo, 0, sizeof(meminfo));
+    
+    if (getsockopt(socket, SOL_SOCKET, SO_MEMINFO, meminfo, &len) < 0 || len <= SK_MEMINFO_DROPS * sizeof(uint32_t)) {
+        return 0;
+    }
+    
+    return meminfo[SK_MEMINFO_DROPS];
+}
@@ -0,0 +1,60 @@
+/**
+ * @file socket_filter.h
+ * @brief Classic BPF socket filters that keep only protocol traffic
+ */
+
+#ifndef DINOC_SOCKET_FILTER_H
+#define DINOC_SOCKET_FILTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <linux/filter.h>
+#include "../include/common.h"
+
+/**
+ * @brief Instructions in the payload check emitted by socket_filter_emit_payload_check
+ */
+#define SOCKET_FILTER_PAYLOAD_CHECK_LEN 19
+
+/**
+ * @brief Emit a check that the payload is one of ours
+ *
+ * The payload must start 8 bytes after the offset held in X (the UDP or
+ * ICMP header), and is accepted when it starts with:
+ * - PROTOCOL_MAGIC followed by the rest of a protocol header
+ * - the heartbeat magic
+ * - a plausible fragment header (index below a non-zero total, known flags)
+ *
+ * The check ends in two returns: accept_len for protocol traffic and
+ * reject_len for everything else.
+ *
+ * @param code Output, at least SOCKET_FILTER_PAYLOAD_CHECK_LEN instructions
+ * @param accept_len Bytes kept for accepted packets
+ * @param reject_len Bytes kept for rejected packets (0 drops them)
+ * @return size_t Number of instructions written
+ */
+size_t socket_filter_emit_payload_check(struct sock_filter* code, uint32_t accept_len, uint32_t reject_len);
+
+/**
+ * @brief Attach the protocol filter to a UDP socket
+ *
+ * Rejected datagrams are dropped in the kernel before they are queued, so
+ * the receiving thread is never woken for them.
+ *
+ * @param socket UDP socket
+ * @return status_t Status code
+ */
+status_t socket_filter_attach_udp(int socket);
+
+/**
+ * @brief Datagrams the kernel dropped for a socket
+ *
+ * Counts filter rejections together with receive queue overflows, which
+ * the kernel does not tell apart (SO_MEMINFO, Linux 4.12+).
+ *
+ * @param socket Socket
+ * @return uint64_t Drops so far, 0 if unavailable
+ */
+uint64_t socket_filter_drops(int socket);
+
+#endif /* DINOC_SOCKET_FILTER_H */
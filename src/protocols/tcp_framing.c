@@ -0,0 +1,250 @@
+/**
+ * @file tcp_framing.c
+ * @brief Incremental length-prefixed frame reader for stream transports
+ */
+
+#include "tcp_framing.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Forward declarations
+static size_t tcp_frame_round_capacity(size_t capacity);
+static void tcp_frame_reader_copy_out(const tcp_frame_reader_t* reader, size_t offset, uint8_t* dest, size_t len);
+static status_t tcp_frame_reader_assembly_grow(tcp_frame_reader_t* reader);
+
+/**
+ * @brief Initialize a frame reader
+ */
+status_t tcp_frame_reader_init(tcp_frame_reader_t* reader, size_t capacity, uint32_t max_frame_size) {
+    if (reader == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    memset(reader, 0, sizeof(tcp_frame_reader_t));
+    
+    reader->capacity = tcp_frame_round_capacity(capacity > 0 ? capacity : TCP_FRAME_DEFAULT_CAPACITY);
+    reader->max_frame_size = max_frame_size > 0 ? max_frame_size : TCP_FRAME_DEFAULT_MAX_SIZE;
+    
+    reader->buffer = (uint8_t*)malloc(reader->capacity);
+    if (reader->buffer == NULL) {
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Release a frame reader's buffers
+ */
+void tcp_frame_reader_free(tcp_frame_reader_t* reader) {
+    if (reader == NULL) {
+        return;
+    }
+    
+    free(reader->buffer);
+    free(reader->scratch);
+    memset(reader, 0, sizeof(tcp_frame_reader_t));
+}
+
+/**
+ * @brief Get the contiguous free space at the tail of the ring
+ */
+status_t tcp_frame_reader_reserve(tcp_frame_reader_t* reader, uint8_t** data, size_t* len) {
+    if (reader == NULL || data == NULL || len == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    // The rest of an oversized frame goes straight into its assembly buffer
+    if (reader->scratch_used < reader->scratch_frame) {
+        if (reader->scratch_used == reader->scratch_capacity) {
+            status_t status = tcp_frame_reader_assembly_grow(reader);
+            if (status != STATUS_SUCCESS) {
+                return status;
+            }
+        }
+        
+        *data = reader->scratch + reader->scratch_used;
+        *len = reader->scratch_capacity - reader->scratch_used;
+        
+        return STATUS_SUCCESS;
+    }
+    
+    // Give back memory taken for an oversized frame once it has been consumed
+    if (reader->scratch_frame == 0 && reader->scratch_capacity > reader->capacity) {
+        free(reader->scratch);
+        reader->scratch = NULL;
+        reader->scratch_capacity = 0;
+    }
+    
+    if (reader->size == reader->capacity) {
+        return STATUS_ERROR_BUFFER_TOO_SMALL;
+    }
+    
+    size_t tail = (reader->head + reader->size) & (reader->capacity - 1);
+    size_t available = reader->capacity - reader->size;
+    size_t contiguous = reader->capacity - tail;
+    
+    *data = reader->buffer + tail;
+    *len = contiguous < available ? contiguous : available;
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Account for bytes written into a reserved region
+ */
+void tcp_frame_reader_commit(tcp_frame_reader_t* reader, size_t len) {
+    // Same test as reserve, nothing changes in between
+    if (reader->scratch_used < reader->scratch_frame) {
+        reader->scratch_used += len;
+    } else {
+        reader->size += len;
+    }
+}
+
+/**
+ * @brief Take the next complete frame
+ */
+status_t tcp_frame_reader_next(tcp_frame_reader_t* reader, const uint8_t** data, uint32_t* len) {
+    if (reader == NULL || data == NULL || len == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    // An oversized frame comes before anything buffered in the ring
+    if (reader->scratch_frame > 0) {
+        if (reader->scratch_used < reader->scratch_frame) {
+            return STATUS_ERROR_NOT_FOUND;
+        }
+        
+        *data = reader->scratch + TCP_FRAME_HEADER_SIZE;
+        *len = (uint32_t)(reader->scratch_frame - TCP_FRAME_HEADER_SIZE);
+        
+        reader->scratch_frame = 0;
+        reader->scratch_used = 0;
+        
+        return STATUS_SUCCESS;
+    }
+    
+    if (reader->size < TCP_FRAME_HEADER_SIZE) {
+        return STATUS_ERROR_NOT_FOUND;
+    }
+    
+    // Length prefix is in native byte order
+    uint32_t frame_len = 0;
+    tcp_frame_reader_copy_out(reader, 0, (uint8_t*)&frame_len, TCP_FRAME_HEADER_SIZE);
+    
+    if (frame_len > reader->max_frame_size) {
+        return STATUS_ERROR_INVALID_FORMAT;
+    }
+    
+    size_t total = TCP_FRAME_HEADER_SIZE + (size_t)frame_len;
+    
+    // Larger than the ring, move what has arrived into an assembly buffer for the rest
+    if (total > reader->capacity) {
+        reader->scratch_frame = total;
+        reader->scratch_used = 0;
+        
+        status_t status = tcp_frame_reader_assembly_grow(reader);
+        if (status != STATUS_SUCCESS) {
+            reader->scratch_frame = 0;
+            return status;
+        }
+        
+        tcp_frame_reader_copy_out(reader, 0, reader->scratch, reader->size);
+        reader->scratch_used = reader->size;
+        reader->size = 0;
+        reader->head = 0;
+        
+        return STATUS_ERROR_NOT_FOUND;
+    }
+    
+    if (reader->size < total) {
+        return STATUS_ERROR_NOT_FOUND;
+    }
+    
+    size_t start = (reader->head + TCP_FRAME_HEADER_SIZE) & (reader->capacity - 1);
+    
+    if (start + frame_len <= reader->capacity) {
+        // Contiguous, hand out the ring memory itself
+        *data = reader->buffer + start;
+    } else {
+        // Wrapped, linearise into the scratch buffer
+        if (reader->scratch_capacity < frame_len) {
+            uint8_t* scratch = (uint8_t*)realloc(reader->scratch, frame_len);
+            if (scratch == NULL) {
+                return STATUS_ERROR_MEMORY;
+            }
+            
+            reader->scratch = scratch;
+            reader->scratch_capacity = frame_len;
+        }
+        
+        tcp_frame_reader_copy_out(reader, TCP_FRAME_HEADER_SIZE, reader->scratch, frame_len);
+        *data = reader->scratch;
+    }
+    
+    *len = frame_len;
+    
+    // Consume the frame
+    reader->size -= total;
+    reader->head = reader->size > 0 ? (reader->head + total) & (reader->capacity - 1) : 0;
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Round a capacity up to a power of two
+ */
+static size_t tcp_frame_round_capacity(size_t capacity) {
+    size_t rounded = 64;
+    
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+    
+    return rounded;
+}
+
+/**
+ * @brief Copy buffered bytes starting at an offset from the head
+ */
+static void tcp_frame_reader_copy_out(const tcp_frame_reader_t* reader, size_t offset, uint8_t* dest, size_t len) {
+    size_t start = (reader->head + offset) & (reader->capacity - 1);
+    size_t first = reader->capacity - start;
+    
+    if (first >= len) {
+        memcpy(dest, reader->buffer + start, len);
+    } else {
+        memcpy(dest, reader->buffer + start, first);
+        memcpy(dest + first, reader->buffer, len - first);
+    }
+}
+
+/**
+ * @brief Grow the assembly buffer of an oversized frame
+ *
+ * Capacity at most doubles what has been received so far (or adds one ring's
+ * worth), capped at the frame's size, so memory follows the bytes actually sent.
+ */
+static status_t tcp_frame_reader_assembly_grow(tcp_frame_reader_t* reader) {
+    size_t received = reader->scratch_used > reader->size ? reader->scratch_used : reader->size;
+    size_t capacity = received + (received > reader->capacity ? received : reader->capacity);
+    
+    if (capacity > reader->scratch_frame) {
+        capacity = reader->scratch_frame;
+    }
+    
+    if (capacity <= reader->scratch_capacity) {
+        return STATUS_SUCCESS;
+    }
+    
+    uint8_t* scratch = (uint8_t*)realloc(reader->scratch, capacity);
+    if (scratch == NULL) {
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    reader->scratch = scratch;
+    reader->scratch_capacity = capacity;
+    
+    return STATUS_SUCCESS;
+}
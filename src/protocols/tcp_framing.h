@@ -0,0 +1,96 @@
+/**
+ * @file tcp_framing.h
+ * @brief Incremental length-prefixed frame reader for stream transports
+ */
+
+#ifndef DINOC_TCP_FRAMING_H
+#define DINOC_TCP_FRAMING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "../include/common.h"
+
+/**
+ * @brief Framing defaults
+ */
+#define TCP_FRAME_HEADER_SIZE       sizeof(uint32_t)
+#define TCP_FRAME_DEFAULT_CAPACITY  (16 * 1024)          // Ring size per connection
+#define TCP_FRAME_DEFAULT_MAX_SIZE  (16 * 1024 * 1024)   // Largest accepted frame
+#define TCP_SEND_DEFAULT_HIGH_WATER (4 * 1024 * 1024)    // Queued outbound bytes before sends are refused
+
+/**
+ * @brief Frame reader
+ *
+ * Bytes accumulate in a fixed power-of-two ring. Complete frames are
+ * returned in place when they are contiguous in the ring, and copied into a
+ * reusable scratch buffer only when they wrap. A frame larger than the ring
+ * is assembled in the scratch buffer instead, which grows only as the
+ * frame's bytes arrive and never past the frame's exact size, so a length
+ * prefix alone cannot make the reader allocate.
+ */
+typedef struct {
+    uint8_t* buffer;            // Ring storage
+    size_t capacity;            // Ring size (power of two)
+    size_t head;                // Offset of the first buffered byte
+    size_t size;                // Buffered bytes
+    uint32_t max_frame_size;    // Largest payload accepted
+    uint8_t* scratch;           // Linear copy of a wrapped frame, or an oversized frame being assembled
+    size_t scratch_capacity;
+    size_t scratch_used;        // Bytes of the oversized frame received, header included
+    size_t scratch_frame;       // Total size of the oversized frame, 0 when none
+} tcp_frame_reader_t;
+
+/**
+ * @brief Initialize a frame reader
+ *
+ * @param reader Frame reader
+ * @param capacity Initial ring capacity (0 = TCP_FRAME_DEFAULT_CAPACITY)
+ * @param max_frame_size Largest payload accepted (0 = TCP_FRAME_DEFAULT_MAX_SIZE)
+ * @return status_t Status code
+ */
+status_t tcp_frame_reader_init(tcp_frame_reader_t* reader, size_t capacity, uint32_t max_frame_size);
+
+/**
+ * @brief Release a frame reader's buffers
+ *
+ * @param reader Frame reader
+ */
+void tcp_frame_reader_free(tcp_frame_reader_t* reader);
+
+/**
+ * @brief Get the contiguous free space at the tail of the ring
+ *
+ * Lets callers recv() straight into the ring, followed by
+ * tcp_frame_reader_commit().
+ *
+ * @param reader Frame reader
+ * @param data Pointer to store the writable region
+ * @param len Pointer to store the region length
+ * @return status_t STATUS_ERROR_BUFFER_TOO_SMALL if the ring is full
+ */
+status_t tcp_frame_reader_reserve(tcp_frame_reader_t* reader, uint8_t** data, size_t* len);
+
+/**
+ * @brief Account for bytes written into a reserved region
+ *
+ * @param reader Frame reader
+ * @param len Bytes written
+ */
+void tcp_frame_reader_commit(tcp_frame_reader_t* reader, size_t len);
+
+/**
+ * @brief Take the next complete frame
+ *
+ * The returned payload stays valid until the reader is written to or
+ * tcp_frame_reader_next() is called again.
+ *
+ * @param reader Frame reader
+ * @param data Pointer to store the payload
+ * @param len Pointer to store the payload length
+ * @return status_t STATUS_SUCCESS, STATUS_ERROR_NOT_FOUND if more bytes are
+ *         needed, or STATUS_ERROR_INVALID_FORMAT if the frame exceeds the maximum size
+ */
+status_t tcp_frame_reader_next(tcp_frame_reader_t* reader, const uint8_t** data, uint32_t* len);
+
+#endif /* DINOC_TCP_FRAMING_H */
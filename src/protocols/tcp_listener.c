@@ -7,8 +7,13 @@
 
 #include "../include/protocol.h"
 #include "../include/client.h"
+#include "tcp_framing.h"
+#include "tcp_uring.h"
+#include "admission.h"
 #include "../common/logger.h"
 #include "../common/uuid.h"
+#include "../common/reactor.h"
+#include "../common/timing_wheel.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -17,33 +22,105 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <errno.h>
 
+// Epoll model defaults
+#define TCP_MAX_EPOLL_EVENTS 256
+
+// Frames coalesced into one sendmsg call
+#define TCP_MAX_SEND_IOVECS 64
+
 /**
- * @brief TCP listener context
+ * @brief TCP event loop (epoll model)
  */
 typedef struct {
-    char* bind_address;
-    uint16_t port;
+    int epoll_fd;
+    int wakeup_fd;
+    pthread_t thread;
+    protocol_listener_t* listener;
+} tcp_event_loop_t;
+
+/**
+ * @brief TCP acceptor (one per SO_REUSEPORT shard)
+ * 
+ * Each acceptor owns its listening socket, accept thread and the slice of
+ * clients it accepted, so accept storms and client bookkeeping do not
+ * serialise on a single lock.
+ */
+typedef struct {
+    protocol_listener_t* listener;
+    size_t index;
     int server_socket;
-    bool running;
     pthread_t accept_thread;
+    bool thread_started;
+    int cpu;                         // Core the accept thread is pinned to (-1 = unpinned)
+    size_t next_loop;
+    reactor_source_t* source;        // Server socket registration (shared reactor)
     pthread_mutex_t clients_mutex;
     client_t** clients;
     size_t clients_count;
     size_t clients_capacity;
+} tcp_acceptor_t;
+
+/**
+ * @brief TCP listener context
+ */
+typedef struct {
+    char* bind_address;
+    uint16_t port;
+    bool running;
+    tcp_acceptor_t* acceptors;
+    size_t acceptor_count;
+    protocol_io_model_t io_model;
+    tcp_event_loop_t* loops;
+    size_t loop_count;
+    size_t loops_running;
+    reactor_t* reactor;              // Shared event loops replacing loops and accept threads (epoll model)
+    timing_wheel_t* timing_wheel;    // Shared idle timers, NULL when connections are never reaped
+    uint32_t timeout_ms;             // Idle time before a connection is closed (0 = never)
+    uint32_t max_message_size;
+    size_t send_high_water;
+    pthread_mutex_t contexts_mutex;  // Guards client->protocol_context while senders take a reference
     void (*on_message_received)(protocol_listener_t*, client_t*, protocol_message_t*);
     void (*on_client_connected)(protocol_listener_t*, client_t*);
     void (*on_client_disconnected)(protocol_listener_t*, client_t*);
 } tcp_listener_context_t;
 
+/**
+ * @brief Queued outbound bytes (the unsent tail of one frame)
+ */
+typedef struct tcp_send_entry {
+    struct tcp_send_entry* next;
+    size_t len;
+    size_t offset;                   // Bytes already written
+    uint8_t data[];
+} tcp_send_entry_t;
+
 /**
  * @brief TCP client context
  */
 typedef struct {
     int socket;
     pthread_t thread;
-    bool running;
+    bool running;                    // Cleared under send_mutex before the socket is closed
+    int refs;                        // Owner plus in-flight senders, the last release frees the context
+    tcp_acceptor_t* acceptor;        // Acceptor shard tracking this client
+    tcp_event_loop_t* loop;          // Owning event loop (epoll model)
+    reactor_source_t* source;        // Registration on the shared reactor (epoll model)
+    int wake_fd;                     // Wakes the client thread to flush (thread model)
+    pthread_mutex_t send_mutex;      // Guards the send queue, keeps frames contiguous
+    tcp_send_entry_t* send_head;     // Frames waiting for the socket to become writable
+    tcp_send_entry_t* send_tail;
+    size_t send_queued;              // Bytes in the send queue
+    tcp_frame_reader_t reader;       // Inbound bytes awaiting a complete frame
+    timing_wheel_timer_t idle_timer; // Fires once per timeout, rearmed while the client is active
+    uint64_t last_activity_ms;       // Last receive, written by the I/O thread without a lock
 } tcp_client_context_t;
 
 // Forward declarations
@@ -55,10 +132,41 @@ static status_t tcp_listener_register_callbacks(protocol_listener_t* listener,
                                              void (*on_message_received)(protocol_listener_t*, client_t*, protocol_message_t*),
                                              void (*on_client_connected)(protocol_listener_t*, client_t*),
                                              void (*on_client_disconnected)(protocol_listener_t*, client_t*));
+static status_t tcp_listener_get_send_backlog(protocol_listener_t* listener, client_t* client, size_t* queued_bytes, bool* backed_up);
+static status_t tcp_listener_attach_reactor(protocol_listener_t* listener, reactor_t* reactor);
+static status_t tcp_listener_attach_timing_wheel(protocol_listener_t* listener, timing_wheel_t* wheel);
+static void tcp_client_idle_expired(timing_wheel_timer_t* timer, void* arg);
+static status_t tcp_acceptor_open(tcp_listener_context_t* context, tcp_acceptor_t* acceptor);
+static void tcp_acceptor_close_clients(protocol_listener_t* listener, tcp_acceptor_t* acceptor);
+static void tcp_acceptors_close(tcp_listener_context_t* context);
 static void* tcp_accept_thread(void* arg);
+static void tcp_accept_client(tcp_acceptor_t* acceptor, int client_socket, const struct sockaddr_in* client_addr);
+static status_t tcp_acceptors_attach(tcp_listener_context_t* context);
+static void tcp_reactor_accept(int fd, uint32_t events, void* arg);
+static void tcp_reactor_client(int fd, uint32_t events, void* arg);
 static void* tcp_client_thread(void* arg);
+static void* tcp_event_loop_thread(void* arg);
+static status_t tcp_event_loops_start(protocol_listener_t* listener);
+static void tcp_event_loops_stop(tcp_listener_context_t* context);
+static bool tcp_client_read_ready(protocol_listener_t* listener, client_t* client);
+static bool tcp_client_write_ready(client_t* client);
+static bool tcp_client_dispatch_frames(protocol_listener_t* listener, client_t* client);
+static status_t tcp_client_flush(tcp_client_context_t* client_context);
+static status_t tcp_client_queue(tcp_client_context_t* client_context, const uint32_t* size, const uint8_t* data, size_t offset);
+static void tcp_free_client_context(tcp_client_context_t* client_context);
+static tcp_client_context_t* tcp_client_context_acquire(tcp_listener_context_t* context, client_t* client);
+static void tcp_client_context_release(tcp_client_context_t* client_context);
+static void tcp_client_context_detach(tcp_listener_context_t* context, client_t* client);
+static void tcp_client_stop_sends(tcp_client_context_t* client_context);
 static void tcp_remove_client(tcp_listener_context_t* context, client_t* client, protocol_listener_t* listener);
 
+/**
+ * @brief Whether a client is served by its own thread (thread model)
+ */
+static inline bool tcp_client_threaded(const tcp_client_context_t* client_context) {
+    return client_context->loop == NULL && client_context->source == NULL;
+}
+
 /**
  * @brief Create a TCP listener
  */
@@ -67,6 +175,18 @@ status_t tcp_listener_create(const protocol_listener_config_t* config, protocol_
         return STATUS_ERROR_INVALID_PARAM;
     }
     
+    protocol_io_model_t io_model = config->io_model;
+    
+    // Use the io_uring backend when the kernel provides it
+    if (io_model == PROTOCOL_IO_MODEL_URING) {
+        if (tcp_uring_supported()) {
+            return tcp_uring_listener_create(config, listener);
+        }
+        
+        LOG_WARN("io_uring is not available, TCP listener falls back to the epoll model");
+        io_model = PROTOCOL_IO_MODEL_EPOLL;
+    }
+    
     // Create listener
     protocol_listener_t* new_listener = (protocol_listener_t*)malloc(sizeof(protocol_listener_t));
     if (new_listener == NULL) {
@@ -84,26 +204,69 @@ status_t tcp_listener_create(const protocol_listener_config_t* config, protocol_
     memset(context, 0, sizeof(tcp_listener_context_t));
     context->bind_address = strdup(config->bind_address);
     context->port = config->port;
-    context->server_socket = -1;
     context->running = false;
+    context->io_model = io_model;
+    context->timeout_ms = config->timeout_ms;
+    context->max_message_size = config->max_message_size;
+    context->send_high_water = config->send_high_water > 0 ? config->send_high_water : TCP_SEND_DEFAULT_HIGH_WATER;
+    context->loop_count = config->loop_threads;
+    
+    if (context->loop_count == 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        context->loop_count = cores > 0 ? (size_t)cores : 1;
+    }
+    
+    context->acceptor_count = config->acceptor_shards > 1 ? config->acceptor_shards : 1;
     
-    // Initialize mutex
-    if (pthread_mutex_init(&context->clients_mutex, NULL) != 0) {
+    // Create acceptors
+    context->acceptors = (tcp_acceptor_t*)calloc(context->acceptor_count, sizeof(tcp_acceptor_t));
+    if (context->acceptors == NULL) {
         free(context->bind_address);
         free(context);
         free(new_listener);
-        return STATUS_ERROR_THREAD;
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    
+    for (size_t i = 0; i < context->acceptor_count; i++) {
+        tcp_acceptor_t* acceptor = &context->acceptors[i];
+        acceptor->listener = new_listener;
+        acceptor->index = i;
+        acceptor->server_socket = -1;
+        acceptor->next_loop = i;
+        acceptor->cpu = context->acceptor_count > 1 && cores > 0 ? (int)(i % (size_t)cores) : -1;
+        
+        // Initialize mutex
+        if (pthread_mutex_init(&acceptor->clients_mutex, NULL) != 0) {
+            context->acceptor_count = i;
+            tcp_acceptors_close(context);
+            free(context->bind_address);
+            free(context);
+            free(new_listener);
+            return STATUS_ERROR_THREAD;
+        }
+        
+        // Initialize clients array
+        acceptor->clients_capacity = 10;
+        acceptor->clients = (client_t**)malloc(acceptor->clients_capacity * sizeof(client_t*));
+        if (acceptor->clients == NULL) {
+            pthread_mutex_destroy(&acceptor->clients_mutex);
+            context->acceptor_count = i;
+            tcp_acceptors_close(context);
+            free(context->bind_address);
+            free(context);
+            free(new_listener);
+            return STATUS_ERROR_MEMORY;
+        }
     }
     
-    // Initialize clients array
-    context->clients_capacity = 10;
-    context->clients = (client_t**)malloc(context->clients_capacity * sizeof(client_t*));
-    if (context->clients == NULL) {
-        pthread_mutex_destroy(&context->clients_mutex);
+    if (pthread_mutex_init(&context->contexts_mutex, NULL) != 0) {
+        tcp_acceptors_close(context);
         free(context->bind_address);
         free(context);
         free(new_listener);
-        return STATUS_ERROR_MEMORY;
+        return STATUS_ERROR_THREAD;
     }
     
     // Initialize listener
@@ -116,6 +279,13 @@ status_t tcp_listener_create(const protocol_listener_config_t* config, protocol_
     new_listener->destroy = tcp_listener_destroy;
     new_listener->send_message = tcp_listener_send_message;
     new_listener->register_callbacks = tcp_listener_register_callbacks;
+    new_listener->get_send_backlog = tcp_listener_get_send_backlog;
+    new_listener->attach_timing_wheel = tcp_listener_attach_timing_wheel;
+    
+    // Thread model clients keep their own threads
+    if (io_model == PROTOCOL_IO_MODEL_EPOLL) {
+        new_listener->attach_reactor = tcp_listener_attach_reactor;
+    }
     
     *listener = new_listener;
     
@@ -143,24 +313,110 @@ static status_t tcp_listener_start(protocol_listener_t* listener) {
         return STATUS_ERROR_ALREADY_RUNNING;
     }
     
+    // Open listening sockets (one per acceptor shard)
+    for (size_t i = 0; i < context->acceptor_count; i++) {
+        status_t status = tcp_acceptor_open(context, &context->acceptors[i]);
+        if (status != STATUS_SUCCESS) {
+            for (size_t j = 0; j < i; j++) {
+                close(context->acceptors[j].server_socket);
+                context->acceptors[j].server_socket = -1;
+            }
+            return status;
+        }
+    }
+    
+    LOG_INFO("TCP listener started on %s:%d", context->bind_address, context->port);
+    fprintf(stderr, "TCP listener: Listening on socket\n");
+    fflush(stderr);
+    
+    // Set running flag
+    context->running = true;
+    
+    // Shared reactor: acceptors and clients are served by its loops
+    if (context->reactor != NULL) {
+        status_t status = tcp_acceptors_attach(context);
+        if (status != STATUS_SUCCESS) {
+            tcp_listener_stop(listener);
+        }
+        return status;
+    }
+    
+    // Create event loops
+    if (context->io_model == PROTOCOL_IO_MODEL_EPOLL) {
+        status_t status = tcp_event_loops_start(listener);
+        if (status != STATUS_SUCCESS) {
+            LOG_ERROR("Failed to start TCP event loops");
+            context->running = false;
+            for (size_t i = 0; i < context->acceptor_count; i++) {
+                close(context->acceptors[i].server_socket);
+                context->acceptors[i].server_socket = -1;
+            }
+            return status;
+        }
+        
+        LOG_INFO("TCP listener: Started %zu epoll event loops", context->loop_count);
+    }
+    
+    // Create accept threads
+    for (size_t i = 0; i < context->acceptor_count; i++) {
+        tcp_acceptor_t* acceptor = &context->acceptors[i];
+        
+        if (pthread_create(&acceptor->accept_thread, NULL, tcp_accept_thread, acceptor) != 0) {
+            LOG_ERROR("Failed to create accept thread: %s", strerror(errno));
+            fprintf(stderr, "TCP listener start failed: thread creation error: %s\n", strerror(errno));
+            fflush(stderr);
+            tcp_listener_stop(listener);
+            return STATUS_ERROR_THREAD;
+        }
+        
+        acceptor->thread_started = true;
+        
+        // Pin sharded acceptors so the kernel's REUSEPORT spread maps onto cores
+        if (acceptor->cpu >= 0) {
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            CPU_SET(acceptor->cpu, &cpuset);
+            
+            if (pthread_setaffinity_np(acceptor->accept_thread, sizeof(cpuset), &cpuset) != 0) {
+                LOG_WARN("Failed to pin TCP acceptor %zu to core %d", i, acceptor->cpu);
+            }
+        }
+    }
+    
+    if (context->acceptor_count > 1) {
+        LOG_INFO("TCP listener: Started %zu SO_REUSEPORT acceptor shards", context->acceptor_count);
+    }
+    
+    fprintf(stderr, "TCP listener: Created accept thread\n");
+    fflush(stderr);
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Open, bind and listen on an acceptor's server socket
+ */
+static status_t tcp_acceptor_open(tcp_listener_context_t* context, tcp_acceptor_t* acceptor) {
     // Create server socket
-    context->server_socket = socket(AF_INET, SOCK_STREAM, 0);
-    LOG_INFO("TCP listener: Created server socket: %d", context->server_socket);
-    fprintf(stderr, "TCP listener: Created server socket: %d\n", context->server_socket);
+    acceptor->server_socket = socket(AF_INET, SOCK_STREAM, 0);
+    LOG_INFO("TCP listener: Created server socket: %d", acceptor->server_socket);
+    fprintf(stderr, "TCP listener: Created server socket: %d\n", acceptor->server_socket);
     fflush(stderr);
-    if (context->server_socket < 0) {
+    if (acceptor->server_socket < 0) {
         LOG_ERROR("Failed to create server socket: %s", strerror(errno));
         return STATUS_ERROR_SOCKET;
     }
     
     // Set socket options
     int opt = 1;
-    if (setsockopt(context->server_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+    if (setsockopt(acceptor->server_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0 ||
+        (context->acceptor_count > 1 &&
+         setsockopt(acceptor->server_socket, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0)) {
         fprintf(stderr, "TCP listener start failed: setsockopt error: %s\n", strerror(errno));
         fflush(stderr);
         LOG_ERROR("Failed to set socket options: %s", strerror(errno));
-        close(context->server_socket);
-        context->server_socket = -1;
+        close(acceptor->server_socket);
+        acceptor->server_socket = -1;
         return STATUS_ERROR_SOCKET;
     }
     
@@ -179,13 +435,13 @@ static status_t tcp_listener_start(protocol_listener_t* listener) {
     fprintf(stderr, "TCP listener: Binding to %s:%d\n", context->bind_address, context->port);
     fflush(stderr);
     
-    if (bind(context->server_socket, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+    if (bind(acceptor->server_socket, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
         LOG_ERROR("Failed to bind socket: %s", strerror(errno));
         fprintf(stderr, "TCP listener start failed: bind error for %s:%d: %s\n", 
                 context->bind_address, context->port, strerror(errno));
         fflush(stderr);
-        close(context->server_socket);
-        context->server_socket = -1;
+        close(acceptor->server_socket);
+        acceptor->server_socket = -1;
         return STATUS_ERROR_BIND;
     }
     
@@ -193,37 +449,16 @@ static status_t tcp_listener_start(protocol_listener_t* listener) {
     fprintf(stderr, "TCP listener: Bound socket to %s:%d\n", context->bind_address, context->port);
     fflush(stderr);
     
-    // Listen for connections
-    if (listen(context->server_socket, 5) < 0) {
+    // Listen for connections (deep backlog to absorb reconnect storms)
+    if (listen(acceptor->server_socket, SOMAXCONN) < 0) {
         fprintf(stderr, "TCP listener start failed: listen error: %s\n", strerror(errno));
         fflush(stderr);
         LOG_ERROR("Failed to listen on socket: %s", strerror(errno));
-        close(context->server_socket);
-        context->server_socket = -1;
+        close(acceptor->server_socket);
+        acceptor->server_socket = -1;
         return STATUS_ERROR_LISTEN;
     }
     
-    LOG_INFO("TCP listener started on %s:%d", context->bind_address, context->port);
-    fprintf(stderr, "TCP listener: Listening on socket\n");
-    fflush(stderr);
-    
-    // Set running flag
-    context->running = true;
-    
-    // Create accept thread
-    if (pthread_create(&context->accept_thread, NULL, tcp_accept_thread, listener) != 0) {
-        LOG_ERROR("Failed to create accept thread: %s", strerror(errno));
-        fprintf(stderr, "TCP listener start failed: thread creation error: %s\n", strerror(errno));
-        fflush(stderr);
-        close(context->server_socket);
-        context->server_socket = -1;
-        context->running = false;
-        return STATUS_ERROR_THREAD;
-    }
-    
-    fprintf(stderr, "TCP listener: Created accept thread\n");
-    fflush(stderr);
-    
     return STATUS_SUCCESS;
 }
 
@@ -245,24 +480,74 @@ static status_t tcp_listener_stop(protocol_listener_t* listener) {
     // Set running flag
     context->running = false;
     
-    // Close server socket
-    if (context->server_socket >= 0) {
-        close(context->server_socket);
-        context->server_socket = -1;
+    // Close server sockets (shutdown wakes the blocked accept calls)
+    for (size_t i = 0; i < context->acceptor_count; i++) {
+        tcp_acceptor_t* acceptor = &context->acceptors[i];
+        
+        // Leave the reactor first, no accept handler runs afterwards
+        reactor_remove(acceptor->source);
+        acceptor->source = NULL;
+        
+        if (acceptor->server_socket >= 0) {
+            shutdown(acceptor->server_socket, SHUT_RDWR);
+            close(acceptor->server_socket);
+            acceptor->server_socket = -1;
+        }
+    }
+    
+    // Wait for accept threads to finish
+    for (size_t i = 0; i < context->acceptor_count; i++) {
+        tcp_acceptor_t* acceptor = &context->acceptors[i];
+        
+        if (acceptor->thread_started) {
+            pthread_join(acceptor->accept_thread, NULL);
+            acceptor->thread_started = false;
+        }
     }
     
-    // Wait for accept thread to finish
-    pthread_join(context->accept_thread, NULL);
+    // Stop event loops so no loop thread touches the clients below
+    tcp_event_loops_stop(context);
     
     // Close client connections
-    pthread_mutex_lock(&context->clients_mutex);
+    for (size_t i = 0; i < context->acceptor_count; i++) {
+        tcp_acceptor_close_clients(listener, &context->acceptors[i]);
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Close every client tracked by an acceptor
+ */
+static void tcp_acceptor_close_clients(protocol_listener_t* listener, tcp_acceptor_t* acceptor) {
+    tcp_listener_context_t* context = (tcp_listener_context_t*)listener->protocol_context;
     
-    for (size_t i = 0; i < context->clients_count; i++) {
-        client_t* client = context->clients[i];
+    // Detach clients from the array so exiting client threads find nothing to remove
+    pthread_mutex_lock(&acceptor->clients_mutex);
+    size_t clients_count = acceptor->clients_count;
+    acceptor->clients_count = 0;
+    pthread_mutex_unlock(&acceptor->clients_mutex);
+    
+    for (size_t i = 0; i < clients_count; i++) {
+        client_t* client = acceptor->clients[i];
         tcp_client_context_t* client_context = (tcp_client_context_t*)client->protocol_context;
         
         // Set running flag
-        client_context->running = false;
+        tcp_client_stop_sends(client_context);
+        
+        // Wait out an idle timeout or handler still running for the client
+        timing_wheel_cancel(context->timing_wheel, &client_context->idle_timer);
+        reactor_remove(client_context->source);
+        
+        // Wake the client thread before waiting for it
+        if (client_context->socket >= 0) {
+            shutdown(client_context->socket, SHUT_RDWR);
+        }
+        
+        // Wait for thread to finish
+        if (tcp_client_threaded(client_context)) {
+            pthread_join(client_context->thread, NULL);
+        }
         
         // Close socket
         if (client_context->socket >= 0) {
@@ -270,25 +555,28 @@ static status_t tcp_listener_stop(protocol_listener_t* listener) {
             client_context->socket = -1;
         }
         
-        // Wait for thread to finish
-        pthread_join(client_context->thread, NULL);
-        
         // Free client context
-        free(client_context);
-        client->protocol_context = NULL;
+        tcp_client_context_detach(context, client);
         
         // Notify client disconnected
         if (context->on_client_disconnected != NULL) {
             context->on_client_disconnected(listener, client);
         }
     }
+}
+
+/**
+ * @brief Release acceptor client arrays and locks
+ */
+static void tcp_acceptors_close(tcp_listener_context_t* context) {
+    for (size_t i = 0; i < context->acceptor_count; i++) {
+        free(context->acceptors[i].clients);
+        pthread_mutex_destroy(&context->acceptors[i].clients_mutex);
+    }
     
-    // Clear clients array
-    context->clients_count = 0;
-    
-    pthread_mutex_unlock(&context->clients_mutex);
-    
-    return STATUS_SUCCESS;
+    free(context->acceptors);
+    context->acceptors = NULL;
+    context->acceptor_count = 0;
 }
 
 /**
@@ -306,11 +594,9 @@ static status_t tcp_listener_destroy(protocol_listener_t* listener) {
         tcp_listener_stop(listener);
     }
     
-    // Free clients array
-    free(context->clients);
-    
-    // Destroy mutex
-    pthread_mutex_destroy(&context->clients_mutex);
+    // Free acceptors
+    tcp_acceptors_close(context);
+    pthread_mutex_destroy(&context->contexts_mutex);
     
     // Free bind address
     free(context->bind_address);
@@ -326,221 +612,592 @@ static status_t tcp_listener_destroy(protocol_listener_t* listener) {
 
 /**
  * @brief Send message to client
+ * 
+ * Never blocks: the length prefix and payload go out in one sendmsg call, and
+ * whatever the socket does not take is queued and flushed by the client's
+ * event loop once the socket is writable. Returns STATUS_ERROR_WOULD_BLOCK
+ * while the queue is at the listener's high-water mark.
  */
 static status_t tcp_listener_send_message(protocol_listener_t* listener, client_t* client, protocol_message_t* message) {
-    if (listener == NULL || listener->protocol_context == NULL || client == NULL || client->protocol_context == NULL || message == NULL) {
+    if (listener == NULL || listener->protocol_context == NULL || client == NULL || message == NULL) {
         return STATUS_ERROR_INVALID_PARAM;
     }
     
-    tcp_client_context_t* client_context = (tcp_client_context_t*)client->protocol_context;
+    tcp_listener_context_t* context = (tcp_listener_context_t*)listener->protocol_context;
+    
+    // Keep the context alive even if the client disconnects meanwhile
+    tcp_client_context_t* client_context = tcp_client_context_acquire(context, client);
+    if (client_context == NULL) {
+        return STATUS_ERROR_NOT_CONNECTED;
+    }
+    
+    uint32_t size = message->data_len;
+    size_t frame_len = TCP_FRAME_HEADER_SIZE + (size_t)size;
+    size_t offset = 0;
+    status_t status = STATUS_SUCCESS;
+    
+    pthread_mutex_lock(&client_context->send_mutex);
     
-    // Check if client is running
+    // Check if client is running, the socket stays open while it is
     if (!client_context->running) {
+        pthread_mutex_unlock(&client_context->send_mutex);
+        tcp_client_context_release(client_context);
         return STATUS_ERROR_NOT_RUNNING;
     }
     
-    // Send message size
-    uint32_t size = message->data_len;
-    if (send(client_context->socket, &size, sizeof(size), 0) != sizeof(size)) {
-        return STATUS_ERROR_SEND;
+    // Client is not draining its socket, let the caller back off
+    if (client_context->send_queued >= context->send_high_water) {
+        pthread_mutex_unlock(&client_context->send_mutex);
+        tcp_client_context_release(client_context);
+        return STATUS_ERROR_WOULD_BLOCK;
+    }
+    
+    // Nothing queued ahead of this frame, try to write it straight away
+    if (client_context->send_head == NULL) {
+        struct iovec iov[2];
+        iov[0].iov_base = &size;
+        iov[0].iov_len = TCP_FRAME_HEADER_SIZE;
+        iov[1].iov_base = message->data;
+        iov[1].iov_len = size;
+        
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = size > 0 ? 2 : 1;
+        
+        ssize_t sent;
+        do {
+            sent = sendmsg(client_context->socket, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        } while (sent < 0 && errno == EINTR);
+        
+        if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            pthread_mutex_unlock(&client_context->send_mutex);
+            tcp_client_context_release(client_context);
+            return STATUS_ERROR_SEND;
+        }
+        
+        offset = sent > 0 ? (size_t)sent : 0;
     }
     
-    // Send message data
-    if (send(client_context->socket, message->data, size, 0) != size) {
-        return STATUS_ERROR_SEND;
+    // Queue the unsent remainder
+    if (offset < frame_len) {
+        status = tcp_client_queue(client_context, &size, message->data, offset);
+        
+        // Thread model clients only poll for writability while something is queued
+        if (status == STATUS_SUCCESS && tcp_client_threaded(client_context)) {
+            uint64_t value = 1;
+            if (write(client_context->wake_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+                LOG_ERROR("Failed to wake TCP client thread: %s", strerror(errno));
+            }
+        }
     }
     
-    return STATUS_SUCCESS;
+    pthread_mutex_unlock(&client_context->send_mutex);
+    tcp_client_context_release(client_context);
+    
+    return status;
 }
 
 /**
- * @brief Register callbacks
+ * @brief Get the outbound bytes queued for a client
  */
-static status_t tcp_listener_register_callbacks(protocol_listener_t* listener,
-                                             void (*on_message_received)(protocol_listener_t*, client_t*, protocol_message_t*),
-                                             void (*on_client_connected)(protocol_listener_t*, client_t*),
-                                             void (*on_client_disconnected)(protocol_listener_t*, client_t*)) {
-    if (listener == NULL || listener->protocol_context == NULL) {
+static status_t tcp_listener_get_send_backlog(protocol_listener_t* listener, client_t* client, size_t* queued_bytes, bool* backed_up) {
+    if (listener == NULL || listener->protocol_context == NULL || client == NULL) {
         return STATUS_ERROR_INVALID_PARAM;
     }
     
     tcp_listener_context_t* context = (tcp_listener_context_t*)listener->protocol_context;
     
-    context->on_message_received = on_message_received;
-    context->on_client_connected = on_client_connected;
-    context->on_client_disconnected = on_client_disconnected;
+    tcp_client_context_t* client_context = tcp_client_context_acquire(context, client);
+    if (client_context == NULL) {
+        return STATUS_ERROR_NOT_CONNECTED;
+    }
+    
+    pthread_mutex_lock(&client_context->send_mutex);
+    size_t queued = client_context->send_queued;
+    pthread_mutex_unlock(&client_context->send_mutex);
+    
+    tcp_client_context_release(client_context);
+    
+    if (queued_bytes != NULL) {
+        *queued_bytes = queued;
+    }
+    
+    if (backed_up != NULL) {
+        *backed_up = queued >= context->send_high_water;
+    }
     
     return STATUS_SUCCESS;
 }
 
 /**
- * @brief Accept thread function
+ * @brief Append the unsent part of a frame to the send queue (caller holds send_mutex)
  */
-static void* tcp_accept_thread(void* arg) {
-    protocol_listener_t* listener = (protocol_listener_t*)arg;
-    tcp_listener_context_t* context = (tcp_listener_context_t*)listener->protocol_context;
+static status_t tcp_client_queue(tcp_client_context_t* client_context, const uint32_t* size, const uint8_t* data, size_t offset) {
+    size_t frame_len = TCP_FRAME_HEADER_SIZE + (size_t)*size;
+    size_t len = frame_len - offset;
     
-    while (context->running) {
-        // Accept connection
-        struct sockaddr_in client_addr;
-        socklen_t client_addr_len = sizeof(client_addr);
-        
-        int client_socket = accept(context->server_socket, (struct sockaddr*)&client_addr, &client_addr_len);
-        if (client_socket < 0) {
-            if (context->running) {
-                LOG_ERROR("Failed to accept connection: %s", strerror(errno));
-            }
-            continue;
-        }
-        
-        // Create client
-        client_t* client = NULL;
-        status_t status = client_register(listener, NULL, &client);
-        if (status != STATUS_SUCCESS || client == NULL) {
-            LOG_ERROR("Failed to create client");
-            close(client_socket);
-            continue;
-            
-        }
+    tcp_send_entry_t* entry = (tcp_send_entry_t*)malloc(sizeof(tcp_send_entry_t) + len);
+    if (entry == NULL) {
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    memset(entry, 0, sizeof(tcp_send_entry_t));
+    entry->len = len;
+    
+    // Rest of the length prefix, if the socket took less than that
+    uint8_t* ptr = entry->data;
+    if (offset < TCP_FRAME_HEADER_SIZE) {
+        memcpy(ptr, (const uint8_t*)size + offset, TCP_FRAME_HEADER_SIZE - offset);
+        ptr += TCP_FRAME_HEADER_SIZE - offset;
+        offset = TCP_FRAME_HEADER_SIZE;
+    }
+    
+    memcpy(ptr, data + (offset - TCP_FRAME_HEADER_SIZE), frame_len - offset);
+    
+    if (client_context->send_tail != NULL) {
+        client_context->send_tail->next = entry;
+    } else {
+        client_context->send_head = entry;
+    }
+    
+    client_context->send_tail = entry;
+    client_context->send_queued += len;
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Write queued frames until the queue drains or the socket would block
+ * 
+ * Up to TCP_MAX_SEND_IOVECS frames are coalesced into each sendmsg call.
+ * Caller holds send_mutex.
+ */
+static status_t tcp_client_flush(tcp_client_context_t* client_context) {
+    while (client_context->send_head != NULL) {
+        struct iovec iov[TCP_MAX_SEND_IOVECS];
+        int iov_count = 0;
         
-        // Create client context
-        tcp_client_context_t* client_context = (tcp_client_context_t*)malloc(sizeof(tcp_client_context_t));
-        if (client_context == NULL) {
-            LOG_ERROR("Failed to create client context");
-            client_destroy(client);
-            close(client_socket);
-            continue;
+        for (tcp_send_entry_t* entry = client_context->send_head;
+             entry != NULL && iov_count < TCP_MAX_SEND_IOVECS;
+             entry = entry->next) {
+            iov[iov_count].iov_base = entry->data + entry->offset;
+            iov[iov_count].iov_len = entry->len - entry->offset;
+            iov_count++;
         }
         
-        // Initialize client context
-        memset(client_context, 0, sizeof(tcp_client_context_t));
-        client_context->socket = client_socket;
-        client_context->running = true;
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = (size_t)iov_count;
         
-        // Set client protocol context
-        client->protocol_context = client_context;
+        ssize_t sent = sendmsg(client_context->socket, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
         
-        // Add client to array
-        pthread_mutex_lock(&context->clients_mutex);
-        
-        if (context->clients_count >= context->clients_capacity) {
-            size_t new_capacity = context->clients_capacity * 2;
-            client_t** new_clients = (client_t**)realloc(context->clients, new_capacity * sizeof(client_t*));
-            if (new_clients == NULL) {
-                LOG_ERROR("Failed to resize clients array");
-                pthread_mutex_unlock(&context->clients_mutex);
-                free(client_context);
-                client_destroy(client);
-                close(client_socket);
+        if (sent < 0) {
+            if (errno == EINTR) {
                 continue;
             }
             
-            context->clients = new_clients;
-            context->clients_capacity = new_capacity;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return STATUS_SUCCESS;
+            }
+            
+            return STATUS_ERROR_SEND;
         }
         
-        context->clients[context->clients_count++] = client;
-        
-        pthread_mutex_unlock(&context->clients_mutex);
+        client_context->send_queued -= (size_t)sent;
         
-        // Create client thread
-        if (pthread_create(&client_context->thread, NULL, tcp_client_thread, arg) != 0) {
-            LOG_ERROR("Failed to create client thread");
-            tcp_remove_client(context, client, listener);
-            continue;
+        // Release fully written frames
+        size_t remaining = (size_t)sent;
+        while (remaining > 0) {
+            tcp_send_entry_t* entry = client_context->send_head;
+            size_t unsent = entry->len - entry->offset;
+            
+            if (remaining < unsent) {
+                entry->offset += remaining;
+                break;
+            }
+            
+            remaining -= unsent;
+            client_context->send_head = entry->next;
+            free(entry);
         }
         
-        // Notify client connected
-        if (context->on_client_connected != NULL) {
-            context->on_client_connected(listener, client);
+        if (client_context->send_head == NULL) {
+            client_context->send_tail = NULL;
         }
     }
     
-    return NULL;
+    return STATUS_SUCCESS;
 }
 
 /**
- * @brief Client thread function
+ * @brief Serve acceptors and clients from a shared reactor instead of private loops (epoll model)
  */
-static void* tcp_client_thread(void* arg) {
-    protocol_listener_t* listener = (protocol_listener_t*)arg;
+static status_t tcp_listener_attach_reactor(protocol_listener_t* listener, reactor_t* reactor) {
+    if (listener == NULL || listener->protocol_context == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
     tcp_listener_context_t* context = (tcp_listener_context_t*)listener->protocol_context;
     
-    // Find client
-    client_t* client = NULL;
-    tcp_client_context_t* client_context = NULL;
+    if (context->running) {
+        return STATUS_ERROR_ALREADY_RUNNING;
+    }
     
-    pthread_mutex_lock(&context->clients_mutex);
+    context->reactor = reactor;
     
-    for (size_t i = 0; i < context->clients_count; i++) {
-        client_t* c = context->clients[i];
-        tcp_client_context_t* cc = (tcp_client_context_t*)c->protocol_context;
-        
-        if (cc->thread == pthread_self()) {
-            client = c;
-            client_context = cc;
-            break;
-        }
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Close connections idle for the listener timeout using a shared timing wheel
+ */
+static status_t tcp_listener_attach_timing_wheel(protocol_listener_t* listener, timing_wheel_t* wheel) {
+    if (listener == NULL || listener->protocol_context == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
     }
     
-    pthread_mutex_unlock(&context->clients_mutex);
+    tcp_listener_context_t* context = (tcp_listener_context_t*)listener->protocol_context;
     
-    if (client == NULL || client_context == NULL) {
-        LOG_ERROR("Failed to find client");
-        return NULL;
+    if (context->running) {
+        return STATUS_ERROR_ALREADY_RUNNING;
     }
     
-    while (client_context->running) {
-        // Receive message size
-        uint32_t size = 0;
-        ssize_t bytes_received = recv(client_context->socket, &size, sizeof(size), 0);
-        
-        if (bytes_received <= 0) {
-            if (client_context->running) {
-                LOG_ERROR("Failed to receive message size: %s", strerror(errno));
-            }
-            break;
-        }
-        
-        if (bytes_received != sizeof(size)) {
-            LOG_ERROR("Invalid message size received");
-            break;
-        }
-        
-        // Allocate message data
-        uint8_t* data = (uint8_t*)malloc(size);
-        if (data == NULL) {
-            LOG_ERROR("Failed to allocate message data");
-            break;
-        }
-        
-        // Receive message data
-        bytes_received = recv(client_context->socket, data, size, 0);
+    context->timing_wheel = wheel;
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Register callbacks
+ */
+static status_t tcp_listener_register_callbacks(protocol_listener_t* listener,
+                                             void (*on_message_received)(protocol_listener_t*, client_t*, protocol_message_t*),
+                                             void (*on_client_connected)(protocol_listener_t*, client_t*),
+                                             void (*on_client_disconnected)(protocol_listener_t*, client_t*)) {
+    if (listener == NULL || listener->protocol_context == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    tcp_listener_context_t* context = (tcp_listener_context_t*)listener->protocol_context;
+    
+    context->on_message_received = on_message_received;
+    context->on_client_connected = on_client_connected;
+    context->on_client_disconnected = on_client_disconnected;
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Accept thread function
+ */
+static void* tcp_accept_thread(void* arg) {
+    tcp_acceptor_t* acceptor = (tcp_acceptor_t*)arg;
+    protocol_listener_t* listener = acceptor->listener;
+    tcp_listener_context_t* context = (tcp_listener_context_t*)listener->protocol_context;
+    
+    while (context->running) {
+        // Accept connection
+        struct sockaddr_in client_addr;
+        socklen_t client_addr_len = sizeof(client_addr);
         
-        if (bytes_received <= 0) {
-            LOG_ERROR("Failed to receive message data: %s", strerror(errno));
-            free(data);
-            break;
+        int client_socket = accept(acceptor->server_socket, (struct sockaddr*)&client_addr, &client_addr_len);
+        if (client_socket < 0) {
+            if (context->running) {
+                LOG_ERROR("Failed to accept connection: %s", strerror(errno));
+            }
+            continue;
+        }
+        
+        tcp_accept_client(acceptor, client_socket, &client_addr);
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief Set up a newly accepted connection and hand it to its event loop or thread
+ */
+static void tcp_accept_client(tcp_acceptor_t* acceptor, int client_socket, const struct sockaddr_in* client_addr) {
+    protocol_listener_t* listener = acceptor->listener;
+    tcp_listener_context_t* context = (tcp_listener_context_t*)listener->protocol_context;
+    
+    // Refuse over-limit connections before a client, context or thread is created
+    if (!admission_allow(client_addr)) {
+        close(client_socket);
+        return;
+    }
+    
+    // Create client
+    client_t* client = NULL;
+    status_t status = client_register(listener, NULL, &client);
+    if (status != STATUS_SUCCESS || client == NULL) {
+        LOG_ERROR("Failed to create client");
+        close(client_socket);
+        return;
+    }
+    
+    // Create client context
+    tcp_client_context_t* client_context = (tcp_client_context_t*)malloc(sizeof(tcp_client_context_t));
+    if (client_context == NULL) {
+        LOG_ERROR("Failed to create client context");
+        client_destroy(client);
+        close(client_socket);
+        return;
+    }
+    
+    // Initialize client context
+    memset(client_context, 0, sizeof(tcp_client_context_t));
+    client_context->socket = client_socket;
+    client_context->running = true;
+    client_context->refs = 1;
+    client_context->acceptor = acceptor;
+    client_context->wake_fd = -1;
+    client_context->last_activity_ms = timing_wheel_now_ms();
+    timing_wheel_timer_init(&client_context->idle_timer, tcp_client_idle_expired, client_context);
+    
+    if (tcp_frame_reader_init(&client_context->reader, 0, context->max_message_size) != STATUS_SUCCESS) {
+        LOG_ERROR("Failed to create client frame reader");
+        free(client_context);
+        client_destroy(client);
+        close(client_socket);
+        return;
+    }
+    
+    pthread_mutex_init(&client_context->send_mutex, NULL);
+    
+    // Set client protocol context
+    client->protocol_context = client_context;
+    
+    // Add client to array
+    pthread_mutex_lock(&acceptor->clients_mutex);
+    
+    if (acceptor->clients_count >= acceptor->clients_capacity) {
+        size_t new_capacity = acceptor->clients_capacity * 2;
+        client_t** new_clients = (client_t**)realloc(acceptor->clients, new_capacity * sizeof(client_t*));
+        if (new_clients == NULL) {
+            LOG_ERROR("Failed to resize clients array");
+            pthread_mutex_unlock(&acceptor->clients_mutex);
+            tcp_client_stop_sends(client_context);
+            tcp_client_context_detach(context, client);
+            client_destroy(client);
+            close(client_socket);
+            return;
+        }
+        
+        acceptor->clients = new_clients;
+        acceptor->clients_capacity = new_capacity;
+    }
+    
+    acceptor->clients[acceptor->clients_count++] = client;
+    
+    pthread_mutex_unlock(&acceptor->clients_mutex);
+    
+    // Sends never block, in either I/O model
+    int flags = fcntl(client_socket, F_GETFL, 0);
+    if (flags < 0 || fcntl(client_socket, F_SETFL, flags | O_NONBLOCK) < 0) {
+        LOG_ERROR("Failed to make client socket non-blocking: %s", strerror(errno));
+        tcp_remove_client(context, client, listener);
+        return;
+    }
+    
+    // One timer per connection, activity only moves a timestamp
+    if (context->timing_wheel != NULL && context->timeout_ms > 0 &&
+        timing_wheel_schedule(context->timing_wheel, &client_context->idle_timer, context->timeout_ms) != STATUS_SUCCESS) {
+        LOG_ERROR("Failed to arm client idle timer");
+        tcp_remove_client(context, client, listener);
+        return;
+    }
+    
+    // Hand the connection to an event loop
+    if (context->reactor != NULL) {
+        // Notify before registering so no message can precede the connect event
+        if (context->on_client_connected != NULL) {
+            context->on_client_connected(listener, client);
         }
         
-        if (bytes_received != size) {
-            LOG_ERROR("Invalid message data received");
-            free(data);
+        if (reactor_add(context->reactor, reactor_next_loop(context->reactor), client_socket,
+                        EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, tcp_reactor_client, client,
+                        &client_context->source) != STATUS_SUCCESS) {
+            tcp_remove_client(context, client, listener);
+        }
+        
+        return;
+    }
+    
+    if (context->io_model == PROTOCOL_IO_MODEL_EPOLL) {
+        tcp_event_loop_t* loop = &context->loops[acceptor->next_loop++ % context->loops_running];
+        
+        client_context->loop = loop;
+        
+        // Notify before registering so no message can precede the connect event
+        if (context->on_client_connected != NULL) {
+            context->on_client_connected(listener, client);
+        }
+        
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.ptr = client;
+        
+        if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, client_socket, &event) < 0) {
+            LOG_ERROR("Failed to register client with event loop: %s", strerror(errno));
+            tcp_remove_client(context, client, listener);
+        }
+        
+        return;
+    }
+    
+    client_context->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (client_context->wake_fd < 0) {
+        LOG_ERROR("Failed to create client wakeup eventfd: %s", strerror(errno));
+        tcp_remove_client(context, client, listener);
+        return;
+    }
+    
+    // Create client thread
+    if (pthread_create(&client_context->thread, NULL, tcp_client_thread, client) != 0) {
+        LOG_ERROR("Failed to create client thread");
+        tcp_remove_client(context, client, listener);
+        return;
+    }
+    
+    // Notify client connected
+    if (context->on_client_connected != NULL) {
+        context->on_client_connected(listener, client);
+    }
+}
+
+/**
+ * @brief Register every acceptor's server socket with the reactor
+ */
+static status_t tcp_acceptors_attach(tcp_listener_context_t* context) {
+    size_t first_loop = reactor_next_loop(context->reactor);
+    
+    for (size_t i = 0; i < context->acceptor_count; i++) {
+        tcp_acceptor_t* acceptor = &context->acceptors[i];
+        
+        // The handler accepts until the backlog is empty
+        int flags = fcntl(acceptor->server_socket, F_GETFL, 0);
+        if (flags < 0 || fcntl(acceptor->server_socket, F_SETFL, flags | O_NONBLOCK) < 0) {
+            LOG_ERROR("Failed to make server socket non-blocking: %s", strerror(errno));
+            return STATUS_ERROR_SOCKET;
+        }
+        
+        status_t status = reactor_add(context->reactor, first_loop + i, acceptor->server_socket, EPOLLIN,
+                                      tcp_reactor_accept, acceptor, &acceptor->source);
+        if (status != STATUS_SUCCESS) {
+            return status;
+        }
+    }
+    
+    LOG_INFO("TCP listener: %zu acceptors served by the shared reactor", context->acceptor_count);
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Reactor handler: connections are waiting on a server socket
+ */
+static void tcp_reactor_accept(int fd, uint32_t events, void* arg) {
+    (void)events;
+    tcp_acceptor_t* acceptor = (tcp_acceptor_t*)arg;
+    tcp_listener_context_t* context = (tcp_listener_context_t*)acceptor->listener->protocol_context;
+    
+    while (context->running) {
+        struct sockaddr_in client_addr;
+        socklen_t client_addr_len = sizeof(client_addr);
+        
+        int client_socket = accept(fd, (struct sockaddr*)&client_addr, &client_addr_len);
+        if (client_socket < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_ERROR("Failed to accept connection: %s", strerror(errno));
+            }
+            return;
+        }
+        
+        tcp_accept_client(acceptor, client_socket, &client_addr);
+    }
+}
+
+/**
+ * @brief Reactor handler: a client socket is readable or writable
+ */
+static void tcp_reactor_client(int fd, uint32_t events, void* arg) {
+    (void)fd;
+    client_t* client = (client_t*)arg;
+    protocol_listener_t* listener = client->listener;
+    tcp_listener_context_t* context = (tcp_listener_context_t*)listener->protocol_context;
+    
+    bool keep = true;
+    
+    if (events & EPOLLOUT) {
+        keep = tcp_client_write_ready(client);
+    }
+    
+    if (keep && (events & ~(uint32_t)EPOLLOUT)) {
+        keep = tcp_client_read_ready(listener, client);
+    }
+    
+    if (!keep) {
+        tcp_remove_client(context, client, listener);
+    }
+}
+
+/**
+ * @brief Client thread function
+ */
+static void* tcp_client_thread(void* arg) {
+    client_t* client = (client_t*)arg;
+    protocol_listener_t* listener = client->listener;
+    tcp_listener_context_t* context = (tcp_listener_context_t*)listener->protocol_context;
+    tcp_client_context_t* client_context = (tcp_client_context_t*)client->protocol_context;
+    
+    while (client_context->running) {
+        struct pollfd fds[2];
+        fds[0].fd = client_context->socket;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd = client_context->wake_fd;
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+        
+        // Wait for writability only while frames are queued
+        pthread_mutex_lock(&client_context->send_mutex);
+        if (client_context->send_head != NULL) {
+            fds[0].events |= POLLOUT;
+        }
+        pthread_mutex_unlock(&client_context->send_mutex);
+        
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            
+            LOG_ERROR("Failed to poll client socket: %s", strerror(errno));
             break;
         }
         
-        // Create message
-        protocol_message_t message;
-        message.data = data;
-        message.data_len = size;
+        if (fds[1].revents & POLLIN) {
+            uint64_t value;
+            if (read(client_context->wake_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+                LOG_ERROR("Failed to drain TCP client wakeup: %s", strerror(errno));
+            }
+        }
         
-        // Notify message received
-        if (context->on_message_received != NULL) {
-            context->on_message_received(listener, client, &message);
+        if ((fds[0].revents & POLLOUT) && !tcp_client_write_ready(client)) {
+            break;
         }
         
-        // Free message data
-        free(data);
+        // Receive and notify every complete message
+        if ((fds[0].revents & (POLLIN | POLLHUP | POLLERR)) && !tcp_client_read_ready(listener, client)) {
+            break;
+        }
     }
     
     // Remove client
@@ -553,14 +1210,18 @@ static void* tcp_client_thread(void* arg) {
  * @brief Remove client from array
  */
 static void tcp_remove_client(tcp_listener_context_t* context, client_t* client, protocol_listener_t* listener) {
-    pthread_mutex_lock(&context->clients_mutex);
+    // Get client context
+    tcp_client_context_t* client_context = (tcp_client_context_t*)client->protocol_context;
+    tcp_acceptor_t* acceptor = client_context->acceptor;
+    
+    pthread_mutex_lock(&acceptor->clients_mutex);
     
     // Find client index
     size_t index = 0;
     bool found = false;
     
-    for (size_t i = 0; i < context->clients_count; i++) {
-        if (context->clients[i] == client) {
+    for (size_t i = 0; i < acceptor->clients_count; i++) {
+        if (acceptor->clients[i] == client) {
             index = i;
             found = true;
             break;
@@ -568,39 +1229,46 @@ static void tcp_remove_client(tcp_listener_context_t* context, client_t* client,
     }
     
     if (!found) {
-        pthread_mutex_unlock(&context->clients_mutex);
+        pthread_mutex_unlock(&acceptor->clients_mutex);
         return;
     }
     
-    // Get client context
-    tcp_client_context_t* client_context = (tcp_client_context_t*)client->protocol_context;
-    
     // Set running flag
-    client_context->running = false;
+    tcp_client_stop_sends(client_context);
     
-    // Close socket
-    if (client_context->socket >= 0) {
+    // The idle timer shuts the socket down, settle it before the socket is closed
+    timing_wheel_cancel(context->timing_wheel, &client_context->idle_timer);
+    
+    // Close socket (reactor clients close it once unregistered, so the number is not reused before)
+    if (client_context->socket >= 0 && client_context->source == NULL) {
         close(client_context->socket);
         client_context->socket = -1;
     }
     
     // Remove client from array
-    for (size_t i = index; i < context->clients_count - 1; i++) {
-        context->clients[i] = context->clients[i + 1];
+    for (size_t i = index; i < acceptor->clients_count - 1; i++) {
+        acceptor->clients[i] = acceptor->clients[i + 1];
     }
     
-    context->clients_count--;
+    acceptor->clients_count--;
+    
+    pthread_mutex_unlock(&acceptor->clients_mutex);
     
-    pthread_mutex_unlock(&context->clients_mutex);
+    // Leave the reactor outside the lock, its loops may be waiting for it
+    if (client_context->source != NULL) {
+        reactor_remove(client_context->source);
+        client_context->source = NULL;
+        close(client_context->socket);
+        client_context->socket = -1;
+    }
     
     // Wait for thread to finish if not current thread
-    if (!pthread_equal(client_context->thread, pthread_self())) {
+    else if (client_context->loop == NULL && !pthread_equal(client_context->thread, pthread_self())) {
         pthread_join(client_context->thread, NULL);
     }
     
     // Free client context
-    free(client_context);
-    client->protocol_context = NULL;
+    tcp_client_context_detach(context, client);
     
     // Notify client disconnected
     if (context->on_client_disconnected != NULL) {
@@ -610,3 +1278,343 @@ static void tcp_remove_client(tcp_listener_context_t* context, client_t* client,
     // Destroy client
     client_destroy(client);
 }
+
+/**
+ * @brief Free client context
+ */
+static void tcp_free_client_context(tcp_client_context_t* client_context) {
+    // Drop frames the client never read
+    tcp_send_entry_t* entry = client_context->send_head;
+    while (entry != NULL) {
+        tcp_send_entry_t* next = entry->next;
+        free(entry);
+        entry = next;
+    }
+    
+    if (client_context->wake_fd >= 0) {
+        close(client_context->wake_fd);
+    }
+    
+    pthread_mutex_destroy(&client_context->send_mutex);
+    tcp_frame_reader_free(&client_context->reader);
+    free(client_context);
+}
+
+/**
+ * @brief Take a reference on a client context for a sender
+ * 
+ * @return tcp_client_context_t* NULL once the client has been torn down
+ */
+static tcp_client_context_t* tcp_client_context_acquire(tcp_listener_context_t* context, client_t* client) {
+    pthread_mutex_lock(&context->contexts_mutex);
+    
+    tcp_client_context_t* client_context = (tcp_client_context_t*)client->protocol_context;
+    if (client_context != NULL) {
+        __atomic_add_fetch(&client_context->refs, 1, __ATOMIC_RELAXED);
+    }
+    
+    pthread_mutex_unlock(&context->contexts_mutex);
+    
+    return client_context;
+}
+
+/**
+ * @brief Drop a reference on a client context, freeing it with the last one
+ */
+static void tcp_client_context_release(tcp_client_context_t* client_context) {
+    if (__atomic_sub_fetch(&client_context->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        tcp_free_client_context(client_context);
+    }
+}
+
+/**
+ * @brief Unpublish a client's context and drop the owner's reference
+ */
+static void tcp_client_context_detach(tcp_listener_context_t* context, client_t* client) {
+    pthread_mutex_lock(&context->contexts_mutex);
+    tcp_client_context_t* client_context = (tcp_client_context_t*)client->protocol_context;
+    client->protocol_context = NULL;
+    pthread_mutex_unlock(&context->contexts_mutex);
+    
+    tcp_client_context_release(client_context);
+}
+
+/**
+ * @brief Clear the running flag under send_mutex
+ * 
+ * A sender holding a reference checks the flag under the same lock, so none
+ * is still writing once this returns and the socket can be closed.
+ */
+static void tcp_client_stop_sends(tcp_client_context_t* client_context) {
+    pthread_mutex_lock(&client_context->send_mutex);
+    client_context->running = false;
+    pthread_mutex_unlock(&client_context->send_mutex);
+}
+
+/**
+ * @brief Idle timer expiry (timing wheel thread)
+ * 
+ * Receives only record their time, so a client that was active since the
+ * timer was armed gets it rearmed for the rest of its timeout. An idle
+ * client's socket is shut down and its event loop or thread removes it as
+ * for any other disconnect.
+ */
+static void tcp_client_idle_expired(timing_wheel_timer_t* timer, void* arg) {
+    tcp_client_context_t* client_context = (tcp_client_context_t*)arg;
+    tcp_listener_context_t* context = (tcp_listener_context_t*)client_context->acceptor->listener->protocol_context;
+    
+    // A receive racing with this check may stamp a time after now_ms
+    uint64_t last_activity_ms = __atomic_load_n(&client_context->last_activity_ms, __ATOMIC_RELAXED);
+    uint64_t now_ms = timing_wheel_now_ms();
+    uint64_t idle_ms = now_ms > last_activity_ms ? now_ms - last_activity_ms : 0;
+    
+    if (idle_ms < context->timeout_ms) {
+        timing_wheel_schedule(context->timing_wheel, timer, context->timeout_ms - idle_ms);
+        return;
+    }
+    
+    LOG_INFO("Closing TCP client idle for %llu ms", (unsigned long long)idle_ms);
+    shutdown(client_context->socket, SHUT_RDWR);
+}
+
+/**
+ * @brief Start epoll event loops
+ */
+static status_t tcp_event_loops_start(protocol_listener_t* listener) {
+    tcp_listener_context_t* context = (tcp_listener_context_t*)listener->protocol_context;
+    
+    context->loops = (tcp_event_loop_t*)calloc(context->loop_count, sizeof(tcp_event_loop_t));
+    if (context->loops == NULL) {
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    context->loops_running = 0;
+    
+    for (size_t i = 0; i < context->loop_count; i++) {
+        tcp_event_loop_t* loop = &context->loops[i];
+        loop->listener = listener;
+        
+        loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (loop->epoll_fd < 0) {
+            LOG_ERROR("Failed to create epoll instance: %s", strerror(errno));
+            tcp_event_loops_stop(context);
+            return STATUS_ERROR_SOCKET;
+        }
+        
+        loop->wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (loop->wakeup_fd < 0) {
+            LOG_ERROR("Failed to create wakeup eventfd: %s", strerror(errno));
+            close(loop->epoll_fd);
+            tcp_event_loops_stop(context);
+            return STATUS_ERROR_SOCKET;
+        }
+        
+        // The wakeup descriptor is the only registration without a client pointer
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.ptr = NULL;
+        
+        if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, loop->wakeup_fd, &event) < 0 ||
+            pthread_create(&loop->thread, NULL, tcp_event_loop_thread, loop) != 0) {
+            LOG_ERROR("Failed to start TCP event loop %zu", i);
+            close(loop->wakeup_fd);
+            close(loop->epoll_fd);
+            tcp_event_loops_stop(context);
+            return STATUS_ERROR_THREAD;
+        }
+        
+        context->loops_running++;
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Wake, join and release epoll event loops
+ */
+static void tcp_event_loops_stop(tcp_listener_context_t* context) {
+    if (context->loops == NULL) {
+        return;
+    }
+    
+    for (size_t i = 0; i < context->loops_running; i++) {
+        tcp_event_loop_t* loop = &context->loops[i];
+        uint64_t value = 1;
+        
+        if (write(loop->wakeup_fd, &value, sizeof(value)) < 0) {
+            LOG_ERROR("Failed to wake TCP event loop %zu: %s", i, strerror(errno));
+        }
+        
+        pthread_join(loop->thread, NULL);
+        close(loop->wakeup_fd);
+        close(loop->epoll_fd);
+    }
+    
+    free(context->loops);
+    context->loops = NULL;
+    context->loops_running = 0;
+}
+
+/**
+ * @brief Event loop thread function (epoll model)
+ */
+static void* tcp_event_loop_thread(void* arg) {
+    tcp_event_loop_t* loop = (tcp_event_loop_t*)arg;
+    protocol_listener_t* listener = loop->listener;
+    tcp_listener_context_t* context = (tcp_listener_context_t*)listener->protocol_context;
+    struct epoll_event events[TCP_MAX_EPOLL_EVENTS];
+    
+    while (context->running) {
+        int count = epoll_wait(loop->epoll_fd, events, TCP_MAX_EPOLL_EVENTS, -1);
+        
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            
+            LOG_ERROR("TCP event loop wait failed: %s", strerror(errno));
+            break;
+        }
+        
+        for (int i = 0; i < count; i++) {
+            client_t* client = (client_t*)events[i].data.ptr;
+            
+            // Wakeup request, the running flag is re-checked by the loop
+            if (client == NULL) {
+                uint64_t value;
+                if (read(loop->wakeup_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+                    LOG_ERROR("Failed to drain TCP event loop wakeup: %s", strerror(errno));
+                }
+                continue;
+            }
+            
+            bool keep = true;
+            
+            if (events[i].events & EPOLLOUT) {
+                keep = tcp_client_write_ready(client);
+            }
+            
+            if (keep && (events[i].events & ~(uint32_t)EPOLLOUT)) {
+                keep = tcp_client_read_ready(listener, client);
+            }
+            
+            if (!keep) {
+                tcp_remove_client(context, client, listener);
+            }
+        }
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief Drain a readable non-blocking client socket
+ * 
+ * Reads until the socket would block (required by edge-triggered epoll) and
+ * dispatches every complete length-prefixed frame.
+ * 
+ * @return bool False if the connection must be closed
+ */
+static bool tcp_client_read_ready(protocol_listener_t* listener, client_t* client) {
+    tcp_client_context_t* client_context = (tcp_client_context_t*)client->protocol_context;
+    
+    while (client_context->running) {
+        uint8_t* buffer = NULL;
+        size_t buffer_len = 0;
+        
+        if (tcp_frame_reader_reserve(&client_context->reader, &buffer, &buffer_len) != STATUS_SUCCESS) {
+            LOG_ERROR("Failed to reserve receive buffer");
+            return false;
+        }
+        
+        ssize_t bytes_received = recv(client_context->socket, buffer, buffer_len, 0);
+        
+        if (bytes_received == 0) {
+            return false;
+        }
+        
+        if (bytes_received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            }
+            
+            LOG_ERROR("Failed to receive message: %s", strerror(errno));
+            return false;
+        }
+        
+        tcp_frame_reader_commit(&client_context->reader, (size_t)bytes_received);
+        __atomic_store_n(&client_context->last_activity_ms, timing_wheel_now_ms(), __ATOMIC_RELAXED);
+        
+        if (!tcp_client_dispatch_frames(listener, client)) {
+            return false;
+        }
+    }
+    
+    return false;
+}
+
+/**
+ * @brief Flush a writable client socket
+ * 
+ * @return bool False if the connection must be closed
+ */
+static bool tcp_client_write_ready(client_t* client) {
+    tcp_client_context_t* client_context = (tcp_client_context_t*)client->protocol_context;
+    
+    pthread_mutex_lock(&client_context->send_mutex);
+    status_t status = tcp_client_flush(client_context);
+    pthread_mutex_unlock(&client_context->send_mutex);
+    
+    if (status != STATUS_SUCCESS) {
+        LOG_ERROR("Failed to send queued data: %s", strerror(errno));
+        return false;
+    }
+    
+    return true;
+}
+
+/**
+ * @brief Notify every complete frame buffered for a client
+ * 
+ * Frames are handed to the callback in place, without a per-message copy.
+ * 
+ * @return bool False if the connection must be closed
+ */
+static bool tcp_client_dispatch_frames(protocol_listener_t* listener, client_t* client) {
+    tcp_listener_context_t* context = (tcp_listener_context_t*)listener->protocol_context;
+    tcp_client_context_t* client_context = (tcp_client_context_t*)client->protocol_context;
+    
+    while (true) {
+        const uint8_t* data = NULL;
+        uint32_t data_len = 0;
+        
+        status_t status = tcp_frame_reader_next(&client_context->reader, &data, &data_len);
+        
+        if (status == STATUS_ERROR_NOT_FOUND) {
+            return true;
+        }
+        
+        if (status == STATUS_ERROR_INVALID_FORMAT) {
+            LOG_ERROR("Message exceeds the maximum size of %u bytes", client_context->reader.max_frame_size);
+            return false;
+        }
+        
+        if (status != STATUS_SUCCESS) {
+            LOG_ERROR("Failed to read message: %d", status);
+            return false;
+        }
+        
+        protocol_message_t message;
+        message.data = (uint8_t*)data;
+        message.data_len = data_len;
+        
+        if (context->on_message_received != NULL) {
+            context->on_message_received(listener, client, &message);
+        }
+    }
+}
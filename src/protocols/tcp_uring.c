@@ -0,0 +1,1382 @@
+/**
+ * @file tcp_uring.c
+ * @brief io_uring backend for the TCP protocol listener
+ *
+ * A single ring thread drives the whole listener: a multishot accept,
+ * recv from a provided buffer ring and linked sends of the 4-byte length
+ * prefix plus payload. The ring is driven through the raw system calls so
+ * no liburing dependency is needed.
+ */
+
+#define _GNU_SOURCE /* For strdup */
+
+#include "tcp_uring.h"
+#include "tcp_framing.h"
+#include "admission.h"
+#include "../include/client.h"
+#include "../common/logger.h"
+#include "../common/uuid.h"
+#include "../common/timing_wheel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <linux/io_uring.h>
+#include <errno.h>
+
+// Ring defaults
+#define TCP_URING_ENTRIES 1024
+#define TCP_URING_BUFFER_COUNT 256     // Must be a power of two
+#define TCP_URING_BUFFER_SIZE 16384
+#define TCP_URING_BUFFER_GROUP 0
+
+/**
+ * @brief Operation kinds carried in SQE user_data
+ */
+typedef enum {
+    TCP_URING_OP_ACCEPT,
+    TCP_URING_OP_RECV,
+    TCP_URING_OP_SEND,
+    TCP_URING_OP_CANCEL
+} tcp_uring_op_type_t;
+
+typedef struct tcp_uring_conn tcp_uring_conn_t;
+
+/**
+ * @brief Operation header, the address is used as SQE user_data
+ */
+typedef struct {
+    tcp_uring_op_type_t type;
+    tcp_uring_conn_t* conn;
+} tcp_uring_op_t;
+
+/**
+ * @brief Outbound frame (length prefix and payload sent as a linked pair)
+ */
+typedef struct tcp_uring_send {
+    tcp_uring_op_t op;
+    struct tcp_uring_send* next;
+    int pending;                     // Completions still outstanding
+    bool failed;
+    uint32_t size;                   // Length prefix, native byte order
+    uint8_t data[];
+} tcp_uring_send_t;
+
+/**
+ * @brief Connection state (client protocol context)
+ */
+struct tcp_uring_conn {
+    client_t* client;
+    int socket;
+    bool running;                    // Cleared under send_mutex before the connection is removed
+    int refs;                        // Ring thread plus in-flight senders, the last release frees the state
+    tcp_uring_op_t recv_op;
+    bool recv_armed;
+    pthread_mutex_t send_mutex;
+    tcp_uring_send_t* send_head;     // Frame in flight, followed by queued frames
+    tcp_uring_send_t* send_tail;
+    size_t send_queued;              // Bytes of the frames in send_head..send_tail
+    bool send_armed;
+    tcp_frame_reader_t reader;       // Inbound bytes awaiting a complete frame
+    timing_wheel_timer_t idle_timer; // Fires once per timeout, rearmed while the client is active
+    uint64_t last_activity_ms;       // Last receive (ring thread)
+};
+
+/**
+ * @brief Mapped io_uring instance
+ */
+typedef struct {
+    int fd;
+    bool single_mmap;
+    void* sq_ptr;
+    size_t sq_size;
+    void* cq_ptr;
+    size_t cq_size;
+    struct io_uring_sqe* sqes;
+    size_t sqes_size;
+    unsigned sq_entries;
+    unsigned* sq_khead;
+    unsigned* sq_ktail;
+    unsigned* sq_kmask;
+    unsigned* sq_array;
+    unsigned sq_tail;
+    unsigned sq_submitted;
+    unsigned* cq_khead;
+    unsigned* cq_ktail;
+    unsigned* cq_kmask;
+    struct io_uring_cqe* cqes;
+    pthread_mutex_t sq_mutex;        // Serialises submitters
+} tcp_uring_ring_t;
+
+/**
+ * @brief io_uring TCP listener context
+ */
+typedef struct {
+    char* bind_address;
+    uint16_t port;
+    int server_socket;
+    bool running;
+    pthread_t ring_thread;
+    timing_wheel_t* timing_wheel;    // Shared idle timers, NULL when connections are never reaped
+    uint32_t timeout_ms;             // Idle time before a connection is closed (0 = never)
+    uint32_t max_message_size;
+    size_t send_high_water;
+    tcp_uring_ring_t ring;
+    struct io_uring_buf_ring* buf_ring;
+    size_t buf_ring_size;
+    uint16_t buf_tail;
+    uint8_t* buffers;
+    tcp_uring_op_t accept_op;
+    bool accept_armed;
+    tcp_uring_op_t cancel_op;
+    pthread_mutex_t clients_mutex;
+    client_t** clients;
+    size_t clients_count;
+    size_t clients_capacity;
+    void (*on_message_received)(protocol_listener_t*, client_t*, protocol_message_t*);
+    void (*on_client_connected)(protocol_listener_t*, client_t*);
+    void (*on_client_disconnected)(protocol_listener_t*, client_t*);
+} tcp_uring_context_t;
+
+// Forward declarations
+static status_t tcp_uring_listener_start(protocol_listener_t* listener);
+static status_t tcp_uring_listener_stop(protocol_listener_t* listener);
+static status_t tcp_uring_listener_destroy(protocol_listener_t* listener);
+static status_t tcp_uring_listener_send_message(protocol_listener_t* listener, client_t* client, protocol_message_t* message);
+static status_t tcp_uring_listener_get_send_backlog(protocol_listener_t* listener, client_t* client, size_t* queued_bytes, bool* backed_up);
+static status_t tcp_uring_listener_attach_timing_wheel(protocol_listener_t* listener, timing_wheel_t* wheel);
+static status_t tcp_uring_listener_register_callbacks(protocol_listener_t* listener,
+                                                   void (*on_message_received)(protocol_listener_t*, client_t*, protocol_message_t*),
+                                                   void (*on_client_connected)(protocol_listener_t*, client_t*),
+                                                   void (*on_client_disconnected)(protocol_listener_t*, client_t*));
+static status_t tcp_uring_ring_init(tcp_uring_ring_t* ring, unsigned entries);
+static void tcp_uring_ring_close(tcp_uring_ring_t* ring);
+static struct io_uring_sqe* tcp_uring_get_sqe(tcp_uring_ring_t* ring);
+static status_t tcp_uring_submit(tcp_uring_ring_t* ring);
+static status_t tcp_uring_buffers_init(tcp_uring_context_t* context);
+static void tcp_uring_buffers_close(tcp_uring_context_t* context);
+static void tcp_uring_buffer_recycle(tcp_uring_context_t* context, uint16_t bid);
+static status_t tcp_uring_arm_accept(tcp_uring_context_t* context);
+static status_t tcp_uring_arm_recv(tcp_uring_context_t* context, tcp_uring_conn_t* conn);
+static status_t tcp_uring_submit_send(tcp_uring_context_t* context, tcp_uring_send_t* send);
+static void* tcp_uring_thread(void* arg);
+static void tcp_uring_handle_accept(protocol_listener_t* listener, int32_t res, uint32_t flags);
+static void tcp_uring_handle_recv(protocol_listener_t* listener, tcp_uring_conn_t* conn, int32_t res, uint32_t flags);
+static void tcp_uring_handle_send(protocol_listener_t* listener, tcp_uring_send_t* send, int32_t res);
+static bool tcp_uring_consume(protocol_listener_t* listener, tcp_uring_conn_t* conn, const uint8_t* data, size_t len);
+static void tcp_uring_add_client(protocol_listener_t* listener, int client_socket);
+static void tcp_uring_close_client(protocol_listener_t* listener, tcp_uring_conn_t* conn);
+static void tcp_uring_remove_client(protocol_listener_t* listener, tcp_uring_conn_t* conn);
+static tcp_uring_conn_t* tcp_uring_conn_acquire(tcp_uring_context_t* context, client_t* client);
+static void tcp_uring_conn_release(tcp_uring_conn_t* conn);
+static void tcp_uring_idle_expired(timing_wheel_timer_t* timer, void* arg);
+
+/**
+ * @brief Check whether the running kernel supports the io_uring backend
+ */
+bool tcp_uring_supported(void) {
+    tcp_uring_ring_t ring;
+    
+    if (tcp_uring_ring_init(&ring, 8) != STATUS_SUCCESS) {
+        return false;
+    }
+    
+    bool supported = false;
+    
+    // Probe the opcodes the backend relies on
+    size_t probe_size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe* probe = (struct io_uring_probe*)calloc(1, probe_size);
+    
+    if (probe != NULL && syscall(__NR_io_uring_register, ring.fd, IORING_REGISTER_PROBE, probe, 256) == 0) {
+        const uint8_t required[] = { IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SEND, IORING_OP_ASYNC_CANCEL };
+        supported = true;
+        
+        for (size_t i = 0; i < sizeof(required); i++) {
+            if (required[i] > probe->last_op || !(probe->ops[required[i]].flags & IO_URING_OP_SUPPORTED)) {
+                supported = false;
+            }
+        }
+    }
+    
+    free(probe);
+    
+    // Provided buffer rings arrived together with multishot accept (5.19)
+    size_t buf_ring_size = 8 * sizeof(struct io_uring_buf);
+    void* buf_ring = MAP_FAILED;
+    
+    if (supported) {
+        buf_ring = mmap(NULL, buf_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        
+        struct io_uring_buf_reg reg;
+        memset(&reg, 0, sizeof(reg));
+        reg.ring_addr = (uint64_t)(uintptr_t)buf_ring;
+        reg.ring_entries = 8;
+        reg.bgid = TCP_URING_BUFFER_GROUP;
+        
+        if (buf_ring == MAP_FAILED ||
+            syscall(__NR_io_uring_register, ring.fd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+            supported = false;
+        }
+    }
+    
+    tcp_uring_ring_close(&ring);
+    
+    if (buf_ring != MAP_FAILED) {
+        munmap(buf_ring, buf_ring_size);
+    }
+    
+    return supported;
+}
+
+/**
+ * @brief Create a TCP listener driven by a single io_uring instance
+ */
+status_t tcp_uring_listener_create(const protocol_listener_config_t* config, protocol_listener_t** listener) {
+    if (config == NULL || listener == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    // Create listener
+    protocol_listener_t* new_listener = (protocol_listener_t*)malloc(sizeof(protocol_listener_t));
+    if (new_listener == NULL) {
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    // Create context
+    tcp_uring_context_t* context = (tcp_uring_context_t*)malloc(sizeof(tcp_uring_context_t));
+    if (context == NULL) {
+        free(new_listener);
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    // Initialize context
+    memset(context, 0, sizeof(tcp_uring_context_t));
+    context->bind_address = strdup(config->bind_address);
+    context->port = config->port;
+    context->timeout_ms = config->timeout_ms;
+    context->max_message_size = config->max_message_size;
+    context->send_high_water = config->send_high_water > 0 ? config->send_high_water : TCP_SEND_DEFAULT_HIGH_WATER;
+    context->server_socket = -1;
+    context->running = false;
+    context->accept_op.type = TCP_URING_OP_ACCEPT;
+    context->cancel_op.type = TCP_URING_OP_CANCEL;
+    
+    // Initialize mutex
+    if (pthread_mutex_init(&context->clients_mutex, NULL) != 0) {
+        free(context->bind_address);
+        free(context);
+        free(new_listener);
+        return STATUS_ERROR_THREAD;
+    }
+    
+    // Initialize clients array
+    context->clients_capacity = 10;
+    context->clients = (client_t**)malloc(context->clients_capacity * sizeof(client_t*));
+    if (context->clients == NULL) {
+        pthread_mutex_destroy(&context->clients_mutex);
+        free(context->bind_address);
+        free(context);
+        free(new_listener);
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    // Initialize listener
+    memset(new_listener, 0, sizeof(protocol_listener_t));
+    uuid_generate_wrapper(new_listener->id);
+    new_listener->protocol_type = PROTOCOL_TYPE_TCP;
+    new_listener->protocol_context = context;
+    new_listener->start = tcp_uring_listener_start;
+    new_listener->stop = tcp_uring_listener_stop;
+    new_listener->destroy = tcp_uring_listener_destroy;
+    new_listener->send_message = tcp_uring_listener_send_message;
+    new_listener->register_callbacks = tcp_uring_listener_register_callbacks;
+    new_listener->get_send_backlog = tcp_uring_listener_get_send_backlog;
+    new_listener->attach_timing_wheel = tcp_uring_listener_attach_timing_wheel;
+    
+    *listener = new_listener;
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Start io_uring TCP listener
+ */
+static status_t tcp_uring_listener_start(protocol_listener_t* listener) {
+    if (listener == NULL || listener->protocol_context == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    tcp_uring_context_t* context = (tcp_uring_context_t*)listener->protocol_context;
+    
+    // Check if already running
+    if (context->running) {
+        return STATUS_ERROR_ALREADY_RUNNING;
+    }
+    
+    // Set up ring and receive buffers
+    status_t status = tcp_uring_ring_init(&context->ring, TCP_URING_ENTRIES);
+    if (status != STATUS_SUCCESS) {
+        LOG_ERROR("Failed to set up io_uring: %s", strerror(errno));
+        return status;
+    }
+    
+    status = tcp_uring_buffers_init(context);
+    if (status != STATUS_SUCCESS) {
+        LOG_ERROR("Failed to register io_uring buffer ring");
+        tcp_uring_ring_close(&context->ring);
+        return status;
+    }
+    
+    // Create server socket
+    context->server_socket = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (context->server_socket < 0) {
+        LOG_ERROR("Failed to create server socket: %s", strerror(errno));
+        status = STATUS_ERROR_SOCKET;
+        goto fail;
+    }
+    
+    int opt = 1;
+    if (setsockopt(context->server_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+        LOG_ERROR("Failed to set socket options: %s", strerror(errno));
+        status = STATUS_ERROR_SOCKET;
+        goto fail;
+    }
+    
+    // Bind socket
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = inet_addr(context->bind_address);
+    if (server_addr.sin_addr.s_addr == INADDR_NONE) {
+        server_addr.sin_addr.s_addr = INADDR_ANY;
+    }
+    
+    server_addr.sin_port = htons(context->port);
+    
+    if (bind(context->server_socket, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+        LOG_ERROR("Failed to bind socket: %s", strerror(errno));
+        status = STATUS_ERROR_BIND;
+        goto fail;
+    }
+    
+    if (listen(context->server_socket, SOMAXCONN) < 0) {
+        LOG_ERROR("Failed to listen on socket: %s", strerror(errno));
+        status = STATUS_ERROR_LISTEN;
+        goto fail;
+    }
+    
+    // Set running flag
+    context->running = true;
+    
+    status = tcp_uring_arm_accept(context);
+    if (status != STATUS_SUCCESS) {
+        LOG_ERROR("Failed to submit io_uring accept");
+        context->running = false;
+        goto fail;
+    }
+    
+    // Create ring thread
+    if (pthread_create(&context->ring_thread, NULL, tcp_uring_thread, listener) != 0) {
+        LOG_ERROR("Failed to create io_uring thread: %s", strerror(errno));
+        context->running = false;
+        status = STATUS_ERROR_THREAD;
+        goto fail;
+    }
+    
+    LOG_INFO("TCP listener started on %s:%d (io_uring)", context->bind_address, context->port);
+    
+    return STATUS_SUCCESS;
+
+fail:
+    // Closing the ring cancels the accept if it was submitted
+    tcp_uring_ring_close(&context->ring);
+    tcp_uring_buffers_close(context);
+    
+    if (context->server_socket >= 0) {
+        close(context->server_socket);
+        context->server_socket = -1;
+    }
+    
+    context->accept_armed = false;
+    
+    return status;
+}
+
+/**
+ * @brief Stop io_uring TCP listener
+ */
+static status_t tcp_uring_listener_stop(protocol_listener_t* listener) {
+    if (listener == NULL || listener->protocol_context == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    tcp_uring_context_t* context = (tcp_uring_context_t*)listener->protocol_context;
+    
+    // Check if running
+    if (!context->running) {
+        return STATUS_ERROR_NOT_RUNNING;
+    }
+    
+    // Set running flag and shut every connection down; the ring thread
+    // reaps them as their receives complete
+    pthread_mutex_lock(&context->clients_mutex);
+    
+    context->running = false;
+    
+    for (size_t i = 0; i < context->clients_count; i++) {
+        tcp_uring_conn_t* conn = (tcp_uring_conn_t*)context->clients[i]->protocol_context;
+        shutdown(conn->socket, SHUT_RDWR);
+    }
+    
+    pthread_mutex_unlock(&context->clients_mutex);
+    
+    // Cancel the multishot accept, its completion also wakes the ring thread
+    pthread_mutex_lock(&context->ring.sq_mutex);
+    
+    struct io_uring_sqe* sqe = tcp_uring_get_sqe(&context->ring);
+    if (sqe != NULL) {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = (uint64_t)(uintptr_t)&context->accept_op;
+        sqe->user_data = (uint64_t)(uintptr_t)&context->cancel_op;
+    }
+    
+    if (sqe == NULL || tcp_uring_submit(&context->ring) != STATUS_SUCCESS) {
+        LOG_ERROR("Failed to cancel io_uring accept");
+    }
+    
+    pthread_mutex_unlock(&context->ring.sq_mutex);
+    
+    // Wait for ring thread to drain
+    pthread_join(context->ring_thread, NULL);
+    
+    close(context->server_socket);
+    context->server_socket = -1;
+    
+    tcp_uring_ring_close(&context->ring);
+    tcp_uring_buffers_close(context);
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Destroy io_uring TCP listener
+ */
+static status_t tcp_uring_listener_destroy(protocol_listener_t* listener) {
+    if (listener == NULL || listener->protocol_context == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    tcp_uring_context_t* context = (tcp_uring_context_t*)listener->protocol_context;
+    
+    // Stop listener if running
+    if (context->running) {
+        tcp_uring_listener_stop(listener);
+    }
+    
+    free(context->clients);
+    pthread_mutex_destroy(&context->clients_mutex);
+    free(context->bind_address);
+    free(context);
+    free(listener);
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Queue a message for a client
+ *
+ * Frames for one connection are sent strictly one after another, each as a
+ * linked length/payload pair, so concurrent senders never interleave.
+ * Returns STATUS_ERROR_WOULD_BLOCK while the queue is at the high-water mark.
+ */
+static status_t tcp_uring_listener_send_message(protocol_listener_t* listener, client_t* client, protocol_message_t* message) {
+    if (listener == NULL || listener->protocol_context == NULL || client == NULL || message == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    tcp_uring_context_t* context = (tcp_uring_context_t*)listener->protocol_context;
+    
+    // Keep the connection state alive even if the client disconnects meanwhile
+    tcp_uring_conn_t* conn = tcp_uring_conn_acquire(context, client);
+    if (conn == NULL) {
+        return STATUS_ERROR_NOT_CONNECTED;
+    }
+    
+    tcp_uring_send_t* send = (tcp_uring_send_t*)malloc(sizeof(tcp_uring_send_t) + message->data_len);
+    if (send == NULL) {
+        tcp_uring_conn_release(conn);
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    memset(send, 0, sizeof(tcp_uring_send_t));
+    send->op.type = TCP_URING_OP_SEND;
+    send->op.conn = conn;
+    send->size = (uint32_t)message->data_len;
+    send->pending = message->data_len > 0 ? 2 : 1;
+    memcpy(send->data, message->data, message->data_len);
+    
+    pthread_mutex_lock(&conn->send_mutex);
+    
+    if (!conn->running) {
+        pthread_mutex_unlock(&conn->send_mutex);
+        tcp_uring_conn_release(conn);
+        free(send);
+        return STATUS_ERROR_NOT_RUNNING;
+    }
+    
+    // Client is not draining its socket, let the caller back off
+    if (conn->send_queued >= context->send_high_water) {
+        pthread_mutex_unlock(&conn->send_mutex);
+        tcp_uring_conn_release(conn);
+        free(send);
+        return STATUS_ERROR_WOULD_BLOCK;
+    }
+    
+    status_t status = STATUS_SUCCESS;
+    
+    if (!conn->send_armed) {
+        status = tcp_uring_submit_send(context, send);
+        conn->send_armed = status == STATUS_SUCCESS;
+    }
+    
+    if (status == STATUS_SUCCESS) {
+        if (conn->send_tail != NULL) {
+            conn->send_tail->next = send;
+        } else {
+            conn->send_head = send;
+        }
+        conn->send_tail = send;
+        conn->send_queued += TCP_FRAME_HEADER_SIZE + (size_t)send->size;
+    }
+    
+    pthread_mutex_unlock(&conn->send_mutex);
+    tcp_uring_conn_release(conn);
+    
+    if (status != STATUS_SUCCESS) {
+        free(send);
+        return STATUS_ERROR_SEND;
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Get the outbound bytes queued for a client
+ */
+static status_t tcp_uring_listener_get_send_backlog(protocol_listener_t* listener, client_t* client, size_t* queued_bytes, bool* backed_up) {
+    if (listener == NULL || listener->protocol_context == NULL || client == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    tcp_uring_context_t* context = (tcp_uring_context_t*)listener->protocol_context;
+    
+    tcp_uring_conn_t* conn = tcp_uring_conn_acquire(context, client);
+    if (conn == NULL) {
+        return STATUS_ERROR_NOT_CONNECTED;
+    }
+    
+    pthread_mutex_lock(&conn->send_mutex);
+    size_t queued = conn->send_queued;
+    pthread_mutex_unlock(&conn->send_mutex);
+    
+    tcp_uring_conn_release(conn);
+    
+    if (queued_bytes != NULL) {
+        *queued_bytes = queued;
+    }
+    
+    if (backed_up != NULL) {
+        *backed_up = queued >= context->send_high_water;
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Close connections idle for the listener timeout using a shared timing wheel
+ */
+static status_t tcp_uring_listener_attach_timing_wheel(protocol_listener_t* listener, timing_wheel_t* wheel) {
+    if (listener == NULL || listener->protocol_context == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    tcp_uring_context_t* context = (tcp_uring_context_t*)listener->protocol_context;
+    
+    if (context->running) {
+        return STATUS_ERROR_ALREADY_RUNNING;
+    }
+    
+    context->timing_wheel = wheel;
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Register callbacks
+ */
+static status_t tcp_uring_listener_register_callbacks(protocol_listener_t* listener,
+                                                   void (*on_message_received)(protocol_listener_t*, client_t*, protocol_message_t*),
+                                                   void (*on_client_connected)(protocol_listener_t*, client_t*),
+                                                   void (*on_client_disconnected)(protocol_listener_t*, client_t*)) {
+    if (listener == NULL || listener->protocol_context == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    tcp_uring_context_t* context = (tcp_uring_context_t*)listener->protocol_context;
+    
+    context->on_message_received = on_message_received;
+    context->on_client_connected = on_client_connected;
+    context->on_client_disconnected = on_client_disconnected;
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Set up and map an io_uring instance
+ */
+static status_t tcp_uring_ring_init(tcp_uring_ring_t* ring, unsigned entries) {
+    memset(ring, 0, sizeof(tcp_uring_ring_t));
+    
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = entries * 4;
+    
+    ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0) {
+        return STATUS_ERROR;
+    }
+    
+    ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    
+    if (ring->single_mmap) {
+        if (ring->cq_size > ring->sq_size) {
+            ring->sq_size = ring->cq_size;
+        }
+        ring->cq_size = ring->sq_size;
+    }
+    
+    ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ptr == MAP_FAILED) {
+        close(ring->fd);
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    if (ring->single_mmap) {
+        ring->cq_ptr = ring->sq_ptr;
+    } else {
+        ring->cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ptr == MAP_FAILED) {
+            munmap(ring->sq_ptr, ring->sq_size);
+            close(ring->fd);
+            return STATUS_ERROR_MEMORY;
+        }
+    }
+    
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = (struct io_uring_sqe*)mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        if (!ring->single_mmap) {
+            munmap(ring->cq_ptr, ring->cq_size);
+        }
+        munmap(ring->sq_ptr, ring->sq_size);
+        close(ring->fd);
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    uint8_t* sq = (uint8_t*)ring->sq_ptr;
+    uint8_t* cq = (uint8_t*)ring->cq_ptr;
+    
+    ring->sq_entries = params.sq_entries;
+    ring->sq_khead = (unsigned*)(sq + params.sq_off.head);
+    ring->sq_ktail = (unsigned*)(sq + params.sq_off.tail);
+    ring->sq_kmask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+    ring->sq_tail = *ring->sq_ktail;
+    ring->sq_submitted = ring->sq_tail;
+    ring->cq_khead = (unsigned*)(cq + params.cq_off.head);
+    ring->cq_ktail = (unsigned*)(cq + params.cq_off.tail);
+    ring->cq_kmask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    
+    pthread_mutex_init(&ring->sq_mutex, NULL);
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Unmap and close an io_uring instance
+ */
+static void tcp_uring_ring_close(tcp_uring_ring_t* ring) {
+    if (ring->sqes == NULL) {
+        return;
+    }
+    
+    munmap(ring->sqes, ring->sqes_size);
+    if (!ring->single_mmap) {
+        munmap(ring->cq_ptr, ring->cq_size);
+    }
+    munmap(ring->sq_ptr, ring->sq_size);
+    close(ring->fd);
+    pthread_mutex_destroy(&ring->sq_mutex);
+    
+    memset(ring, 0, sizeof(tcp_uring_ring_t));
+}
+
+/**
+ * @brief Get a cleared submission entry (caller holds sq_mutex)
+ */
+static struct io_uring_sqe* tcp_uring_get_sqe(tcp_uring_ring_t* ring) {
+    unsigned head = __atomic_load_n(ring->sq_khead, __ATOMIC_ACQUIRE);
+    
+    if (ring->sq_tail - head >= ring->sq_entries) {
+        return NULL;
+    }
+    
+    unsigned index = ring->sq_tail & *ring->sq_kmask;
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+    
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    ring->sq_array[index] = index;
+    ring->sq_tail++;
+    
+    return sqe;
+}
+
+/**
+ * @brief Submit queued entries (caller holds sq_mutex)
+ *
+ * On failure the unsubmitted entries are withdrawn so callers can release
+ * the memory they reference.
+ */
+static status_t tcp_uring_submit(tcp_uring_ring_t* ring) {
+    __atomic_store_n(ring->sq_ktail, ring->sq_tail, __ATOMIC_RELEASE);
+    
+    while (ring->sq_submitted != ring->sq_tail) {
+        int submitted = (int)syscall(__NR_io_uring_enter, ring->fd, ring->sq_tail - ring->sq_submitted, 0, 0, NULL, 0);
+        
+        if (submitted < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            
+            ring->sq_tail = ring->sq_submitted;
+            __atomic_store_n(ring->sq_ktail, ring->sq_tail, __ATOMIC_RELEASE);
+            return STATUS_ERROR;
+        }
+        
+        ring->sq_submitted += (unsigned)submitted;
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Allocate and register the provided receive buffer ring
+ */
+static status_t tcp_uring_buffers_init(tcp_uring_context_t* context) {
+    context->buf_ring_size = TCP_URING_BUFFER_COUNT * sizeof(struct io_uring_buf);
+    context->buf_ring = (struct io_uring_buf_ring*)mmap(NULL, context->buf_ring_size, PROT_READ | PROT_WRITE,
+                                                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (context->buf_ring == MAP_FAILED) {
+        context->buf_ring = NULL;
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    context->buffers = (uint8_t*)malloc((size_t)TCP_URING_BUFFER_COUNT * TCP_URING_BUFFER_SIZE);
+    if (context->buffers == NULL) {
+        tcp_uring_buffers_close(context);
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)context->buf_ring;
+    reg.ring_entries = TCP_URING_BUFFER_COUNT;
+    reg.bgid = TCP_URING_BUFFER_GROUP;
+    
+    if (syscall(__NR_io_uring_register, context->ring.fd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+        tcp_uring_buffers_close(context);
+        return STATUS_ERROR;
+    }
+    
+    context->buf_tail = 0;
+    
+    for (uint16_t bid = 0; bid < TCP_URING_BUFFER_COUNT; bid++) {
+        tcp_uring_buffer_recycle(context, bid);
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Release the receive buffer ring (after the ring is closed)
+ */
+static void tcp_uring_buffers_close(tcp_uring_context_t* context) {
+    if (context->buf_ring != NULL) {
+        munmap(context->buf_ring, context->buf_ring_size);
+        context->buf_ring = NULL;
+    }
+    
+    free(context->buffers);
+    context->buffers = NULL;
+}
+
+/**
+ * @brief Hand a receive buffer back to the kernel (ring thread only)
+ */
+static void tcp_uring_buffer_recycle(tcp_uring_context_t* context, uint16_t bid) {
+    struct io_uring_buf* buf = &context->buf_ring->bufs[context->buf_tail & (TCP_URING_BUFFER_COUNT - 1)];
+    
+    buf->addr = (uint64_t)(uintptr_t)(context->buffers + (size_t)bid * TCP_URING_BUFFER_SIZE);
+    buf->len = TCP_URING_BUFFER_SIZE;
+    buf->bid = bid;
+    
+    context->buf_tail++;
+    __atomic_store_n(&context->buf_ring->tail, context->buf_tail, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Submit the multishot accept (ring thread, or before it starts)
+ */
+static status_t tcp_uring_arm_accept(tcp_uring_context_t* context) {
+    pthread_mutex_lock(&context->ring.sq_mutex);
+    
+    status_t status = STATUS_ERROR;
+    struct io_uring_sqe* sqe = tcp_uring_get_sqe(&context->ring);
+    
+    if (sqe != NULL) {
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = context->server_socket;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->accept_flags = SOCK_CLOEXEC;
+        sqe->user_data = (uint64_t)(uintptr_t)&context->accept_op;
+        status = tcp_uring_submit(&context->ring);
+    }
+    
+    pthread_mutex_unlock(&context->ring.sq_mutex);
+    
+    context->accept_armed = status == STATUS_SUCCESS;
+    
+    return status;
+}
+
+/**
+ * @brief Submit a buffer-select receive for a connection (ring thread only)
+ */
+static status_t tcp_uring_arm_recv(tcp_uring_context_t* context, tcp_uring_conn_t* conn) {
+    pthread_mutex_lock(&context->ring.sq_mutex);
+    
+    status_t status = STATUS_ERROR;
+    struct io_uring_sqe* sqe = tcp_uring_get_sqe(&context->ring);
+    
+    if (sqe != NULL) {
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = conn->socket;
+        sqe->len = TCP_URING_BUFFER_SIZE;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = TCP_URING_BUFFER_GROUP;
+        sqe->user_data = (uint64_t)(uintptr_t)&conn->recv_op;
+        status = tcp_uring_submit(&context->ring);
+    }
+    
+    pthread_mutex_unlock(&context->ring.sq_mutex);
+    
+    conn->recv_armed = status == STATUS_SUCCESS;
+    
+    return status;
+}
+
+/**
+ * @brief Submit a frame as a linked length/payload send pair (caller holds send_mutex)
+ */
+static status_t tcp_uring_submit_send(tcp_uring_context_t* context, tcp_uring_send_t* send) {
+    tcp_uring_conn_t* conn = send->op.conn;
+    
+    pthread_mutex_lock(&context->ring.sq_mutex);
+    
+    status_t status = STATUS_ERROR;
+    struct io_uring_sqe* size_sqe = tcp_uring_get_sqe(&context->ring);
+    struct io_uring_sqe* data_sqe = send->size > 0 && size_sqe != NULL ? tcp_uring_get_sqe(&context->ring) : NULL;
+    
+    if (size_sqe != NULL && (send->size == 0 || data_sqe != NULL)) {
+        // MSG_WAITALL makes io_uring retry short sends on the stream socket
+        size_sqe->opcode = IORING_OP_SEND;
+        size_sqe->fd = conn->socket;
+        size_sqe->addr = (uint64_t)(uintptr_t)&send->size;
+        size_sqe->len = sizeof(send->size);
+        size_sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+        size_sqe->user_data = (uint64_t)(uintptr_t)&send->op;
+        
+        if (data_sqe != NULL) {
+            size_sqe->flags = IOSQE_IO_LINK;
+            
+            data_sqe->opcode = IORING_OP_SEND;
+            data_sqe->fd = conn->socket;
+            data_sqe->addr = (uint64_t)(uintptr_t)send->data;
+            data_sqe->len = send->size;
+            data_sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+            data_sqe->user_data = (uint64_t)(uintptr_t)&send->op;
+        }
+        
+        status = tcp_uring_submit(&context->ring);
+    } else if (size_sqe != NULL) {
+        // Withdraw the lone entry, the pair must go in together
+        context->ring.sq_tail = context->ring.sq_submitted;
+    }
+    
+    pthread_mutex_unlock(&context->ring.sq_mutex);
+    
+    return status;
+}
+
+/**
+ * @brief Ring thread function
+ */
+static void* tcp_uring_thread(void* arg) {
+    protocol_listener_t* listener = (protocol_listener_t*)arg;
+    tcp_uring_context_t* context = (tcp_uring_context_t*)listener->protocol_context;
+    tcp_uring_ring_t* ring = &context->ring;
+    
+    while (true) {
+        // Exit once stopped and every operation has drained
+        pthread_mutex_lock(&context->clients_mutex);
+        bool active = context->running || context->accept_armed || context->clients_count > 0;
+        pthread_mutex_unlock(&context->clients_mutex);
+        
+        if (!active) {
+            break;
+        }
+        
+        int result = (int)syscall(__NR_io_uring_enter, ring->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+        if (result < 0 && errno != EINTR) {
+            LOG_ERROR("io_uring wait failed: %s", strerror(errno));
+            break;
+        }
+        
+        unsigned head = *ring->cq_khead;
+        unsigned tail = __atomic_load_n(ring->cq_ktail, __ATOMIC_ACQUIRE);
+        
+        while (head != tail) {
+            struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_kmask];
+            tcp_uring_op_t* op = (tcp_uring_op_t*)(uintptr_t)cqe->user_data;
+            int32_t res = cqe->res;
+            uint32_t flags = cqe->flags;
+            
+            head++;
+            __atomic_store_n(ring->cq_khead, head, __ATOMIC_RELEASE);
+            
+            switch (op->type) {
+                case TCP_URING_OP_ACCEPT:
+                    tcp_uring_handle_accept(listener, res, flags);
+                    break;
+                
+                case TCP_URING_OP_RECV:
+                    tcp_uring_handle_recv(listener, op->conn, res, flags);
+                    break;
+                
+                case TCP_URING_OP_SEND:
+                    tcp_uring_handle_send(listener, (tcp_uring_send_t*)op, res);
+                    break;
+                
+                case TCP_URING_OP_CANCEL:
+                    break;
+            }
+        }
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief Handle a multishot accept completion
+ */
+static void tcp_uring_handle_accept(protocol_listener_t* listener, int32_t res, uint32_t flags) {
+    tcp_uring_context_t* context = (tcp_uring_context_t*)listener->protocol_context;
+    
+    if (!(flags & IORING_CQE_F_MORE)) {
+        context->accept_armed = false;
+    }
+    
+    if (res >= 0) {
+        tcp_uring_add_client(listener, res);
+    } else if (res != -ECANCELED && context->running) {
+        LOG_ERROR("Failed to accept connection: %s", strerror(-res));
+    }
+    
+    // The kernel ends multishot accepts on errors, re-arm while running
+    if (!context->accept_armed && context->running) {
+        if (tcp_uring_arm_accept(context) != STATUS_SUCCESS) {
+            LOG_ERROR("Failed to re-arm io_uring accept");
+        }
+    }
+}
+
+/**
+ * @brief Handle a receive completion
+ */
+static void tcp_uring_handle_recv(protocol_listener_t* listener, tcp_uring_conn_t* conn, int32_t res, uint32_t flags) {
+    tcp_uring_context_t* context = (tcp_uring_context_t*)listener->protocol_context;
+    bool keep = false;
+    
+    conn->recv_armed = false;
+    
+    if (flags & IORING_CQE_F_BUFFER) {
+        uint16_t bid = (uint16_t)(flags >> IORING_CQE_BUFFER_SHIFT);
+        
+        if (res > 0) {
+            __atomic_store_n(&conn->last_activity_ms, timing_wheel_now_ms(), __ATOMIC_RELAXED);
+            keep = tcp_uring_consume(listener, conn, context->buffers + (size_t)bid * TCP_URING_BUFFER_SIZE, (size_t)res);
+        }
+        
+        tcp_uring_buffer_recycle(context, bid);
+    } else if (res == -ENOBUFS) {
+        // Every buffer was in use, they have been recycled by now
+        keep = true;
+    } else if (res < 0 && res != -ECONNRESET && conn->running) {
+        LOG_ERROR("Failed to receive message: %s", strerror(-res));
+    }
+    
+    if (keep && conn->running && tcp_uring_arm_recv(context, conn) == STATUS_SUCCESS) {
+        return;
+    }
+    
+    tcp_uring_close_client(listener, conn);
+}
+
+/**
+ * @brief Handle a send completion
+ */
+static void tcp_uring_handle_send(protocol_listener_t* listener, tcp_uring_send_t* send, int32_t res) {
+    tcp_uring_context_t* context = (tcp_uring_context_t*)listener->protocol_context;
+    tcp_uring_conn_t* conn = send->op.conn;
+    
+    if (res < 0) {
+        send->failed = true;
+    }
+    
+    if (--send->pending > 0) {
+        return;
+    }
+    
+    bool failed = send->failed;
+    
+    pthread_mutex_lock(&conn->send_mutex);
+    
+    conn->send_head = send->next;
+    if (conn->send_head == NULL) {
+        conn->send_tail = NULL;
+    }
+    
+    conn->send_queued -= TCP_FRAME_HEADER_SIZE + (size_t)send->size;
+    conn->send_armed = false;
+    
+    if (!failed && conn->running && conn->send_head != NULL) {
+        conn->send_armed = tcp_uring_submit_send(context, conn->send_head) == STATUS_SUCCESS;
+        failed = !conn->send_armed;
+    }
+    
+    pthread_mutex_unlock(&conn->send_mutex);
+    
+    free(send);
+    
+    if (failed || !conn->running) {
+        tcp_uring_close_client(listener, conn);
+    }
+}
+
+/**
+ * @brief Feed received bytes through the length-prefix framing
+ *
+ * @return bool False if the connection must be closed
+ */
+static bool tcp_uring_consume(protocol_listener_t* listener, tcp_uring_conn_t* conn, const uint8_t* data, size_t len) {
+    tcp_uring_context_t* context = (tcp_uring_context_t*)listener->protocol_context;
+    
+    while (len > 0) {
+        uint8_t* buffer = NULL;
+        size_t buffer_len = 0;
+        
+        if (tcp_frame_reader_reserve(&conn->reader, &buffer, &buffer_len) != STATUS_SUCCESS) {
+            LOG_ERROR("Failed to reserve receive buffer");
+            return false;
+        }
+        
+        if (buffer_len > len) {
+            buffer_len = len;
+        }
+        
+        memcpy(buffer, data, buffer_len);
+        tcp_frame_reader_commit(&conn->reader, buffer_len);
+        data += buffer_len;
+        len -= buffer_len;
+        
+        // Notify every complete message
+        while (true) {
+            const uint8_t* frame = NULL;
+            uint32_t frame_len = 0;
+            
+            status_t status = tcp_frame_reader_next(&conn->reader, &frame, &frame_len);
+            
+            if (status == STATUS_ERROR_NOT_FOUND) {
+                break;
+            }
+            
+            if (status != STATUS_SUCCESS) {
+                LOG_ERROR("Failed to read message: %d", status);
+                return false;
+            }
+            
+            protocol_message_t message;
+            message.data = (uint8_t*)frame;
+            message.data_len = frame_len;
+            
+            if (context->on_message_received != NULL) {
+                context->on_message_received(listener, conn->client, &message);
+            }
+        }
+    }
+    
+    return true;
+}
+
+/**
+ * @brief Track an accepted connection and start receiving on it
+ */
+static void tcp_uring_add_client(protocol_listener_t* listener, int client_socket) {
+    tcp_uring_context_t* context = (tcp_uring_context_t*)listener->protocol_context;
+    
+    // Multishot accepts carry no peer address, admission control looks it up
+    if (!admission_allow_socket(client_socket)) {
+        close(client_socket);
+        return;
+    }
+    
+    // Create client
+    client_t* client = NULL;
+    status_t status = client_register(listener, NULL, &client);
+    if (status != STATUS_SUCCESS || client == NULL) {
+        LOG_ERROR("Failed to create client");
+        close(client_socket);
+        return;
+    }
+    
+    // Create connection state
+    tcp_uring_conn_t* conn = (tcp_uring_conn_t*)malloc(sizeof(tcp_uring_conn_t));
+    if (conn == NULL) {
+        LOG_ERROR("Failed to create client context");
+        client_destroy(client);
+        close(client_socket);
+        return;
+    }
+    
+    memset(conn, 0, sizeof(tcp_uring_conn_t));
+    conn->client = client;
+    conn->socket = client_socket;
+    conn->running = true;
+    conn->refs = 1;
+    conn->recv_op.type = TCP_URING_OP_RECV;
+    conn->recv_op.conn = conn;
+    conn->last_activity_ms = timing_wheel_now_ms();
+    timing_wheel_timer_init(&conn->idle_timer, tcp_uring_idle_expired, conn);
+    
+    if (tcp_frame_reader_init(&conn->reader, 0, context->max_message_size) != STATUS_SUCCESS) {
+        LOG_ERROR("Failed to create client frame reader");
+        free(conn);
+        client_destroy(client);
+        close(client_socket);
+        return;
+    }
+    
+    pthread_mutex_init(&conn->send_mutex, NULL);
+    
+    // Add client to array, unless stop() has already shut connections down
+    pthread_mutex_lock(&context->clients_mutex);
+    
+    if (!context->running) {
+        pthread_mutex_unlock(&context->clients_mutex);
+        pthread_mutex_destroy(&conn->send_mutex);
+        tcp_frame_reader_free(&conn->reader);
+        free(conn);
+        client_destroy(client);
+        close(client_socket);
+        return;
+    }
+    
+    if (context->clients_count >= context->clients_capacity) {
+        size_t new_capacity = context->clients_capacity * 2;
+        client_t** new_clients = (client_t**)realloc(context->clients, new_capacity * sizeof(client_t*));
+        if (new_clients == NULL) {
+            LOG_ERROR("Failed to resize clients array");
+            pthread_mutex_unlock(&context->clients_mutex);
+            pthread_mutex_destroy(&conn->send_mutex);
+            tcp_frame_reader_free(&conn->reader);
+            free(conn);
+            client_destroy(client);
+            close(client_socket);
+            return;
+        }
+        
+        context->clients = new_clients;
+        context->clients_capacity = new_capacity;
+    }
+    
+    context->clients[context->clients_count++] = client;
+    
+    // Published with the array entry, so senders never see a half-added connection
+    client->protocol_context = conn;
+    
+    pthread_mutex_unlock(&context->clients_mutex);
+    
+    // Notify client connected
+    if (context->on_client_connected != NULL) {
+        context->on_client_connected(listener, client);
+    }
+    
+    // One timer per connection, receives only move a timestamp
+    if (context->timing_wheel != NULL && context->timeout_ms > 0 &&
+        timing_wheel_schedule(context->timing_wheel, &conn->idle_timer, context->timeout_ms) != STATUS_SUCCESS) {
+        LOG_ERROR("Failed to arm client idle timer");
+    }
+    
+    if (tcp_uring_arm_recv(context, conn) != STATUS_SUCCESS) {
+        LOG_ERROR("Failed to submit io_uring receive");
+        tcp_uring_close_client(listener, conn);
+    }
+}
+
+/**
+ * @brief Begin closing a connection, it is removed once no operation is in flight
+ */
+static void tcp_uring_close_client(protocol_listener_t* listener, tcp_uring_conn_t* conn) {
+    pthread_mutex_lock(&conn->send_mutex);
+    
+    if (conn->running) {
+        conn->running = false;
+        
+        // Fail any send still in flight
+        shutdown(conn->socket, SHUT_RDWR);
+    }
+    
+    bool idle = !conn->send_armed && !conn->recv_armed;
+    
+    pthread_mutex_unlock(&conn->send_mutex);
+    
+    if (idle) {
+        tcp_uring_remove_client(listener, conn);
+    }
+}
+
+/**
+ * @brief Remove a drained connection (ring thread only)
+ */
+static void tcp_uring_remove_client(protocol_listener_t* listener, tcp_uring_conn_t* conn) {
+    tcp_uring_context_t* context = (tcp_uring_context_t*)listener->protocol_context;
+    client_t* client = conn->client;
+    
+    // Remove client from array, new senders find no connection after this
+    pthread_mutex_lock(&context->clients_mutex);
+    
+    for (size_t i = 0; i < context->clients_count; i++) {
+        if (context->clients[i] == client) {
+            for (size_t j = i; j < context->clients_count - 1; j++) {
+                context->clients[j] = context->clients[j + 1];
+            }
+            context->clients_count--;
+            break;
+        }
+    }
+    
+    client->protocol_context = NULL;
+    
+    pthread_mutex_unlock(&context->clients_mutex);
+    
+    // The idle timer shuts the socket down, settle it before the socket is closed;
+    // senders still holding a reference see running cleared and submit nothing
+    timing_wheel_cancel(context->timing_wheel, &conn->idle_timer);
+    close(conn->socket);
+    conn->socket = -1;
+    
+    tcp_uring_conn_release(conn);
+    
+    // Notify client disconnected
+    if (context->on_client_disconnected != NULL) {
+        context->on_client_disconnected(listener, client);
+    }
+    
+    // Destroy client
+    client_destroy(client);
+}
+
+/**
+ * @brief Take a reference on a client's connection state for a sender
+ * 
+ * @return tcp_uring_conn_t* NULL once the connection has been removed
+ */
+static tcp_uring_conn_t* tcp_uring_conn_acquire(tcp_uring_context_t* context, client_t* client) {
+    pthread_mutex_lock(&context->clients_mutex);
+    
+    tcp_uring_conn_t* conn = (tcp_uring_conn_t*)client->protocol_context;
+    if (conn != NULL) {
+        __atomic_add_fetch(&conn->refs, 1, __ATOMIC_RELAXED);
+    }
+    
+    pthread_mutex_unlock(&context->clients_mutex);
+    
+    return conn;
+}
+
+/**
+ * @brief Drop a reference on connection state, freeing it with the last one
+ */
+static void tcp_uring_conn_release(tcp_uring_conn_t* conn) {
+    if (__atomic_sub_fetch(&conn->refs, 1, __ATOMIC_ACQ_REL) > 0) {
+        return;
+    }
+    
+    // Drop frames that were never submitted
+    tcp_uring_send_t* send = conn->send_head;
+    while (send != NULL) {
+        tcp_uring_send_t* next = send->next;
+        free(send);
+        send = next;
+    }
+    
+    tcp_frame_reader_free(&conn->reader);
+    pthread_mutex_destroy(&conn->send_mutex);
+    free(conn);
+}
+
+/**
+ * @brief Idle timer expiry (timing wheel thread)
+ * 
+ * A connection that received since the timer was armed gets it rearmed for
+ * the rest of its timeout; an idle one is shut down, which completes its
+ * receive and lets the ring thread remove it.
+ */
+static void tcp_uring_idle_expired(timing_wheel_timer_t* timer, void* arg) {
+    tcp_uring_conn_t* conn = (tcp_uring_conn_t*)arg;
+    tcp_uring_context_t* context = (tcp_uring_context_t*)conn->client->listener->protocol_context;
+    
+    // A receive racing with this check may stamp a time after now_ms
+    uint64_t last_activity_ms = __atomic_load_n(&conn->last_activity_ms, __ATOMIC_RELAXED);
+    uint64_t now_ms = timing_wheel_now_ms();
+    uint64_t idle_ms = now_ms > last_activity_ms ? now_ms - last_activity_ms : 0;
+    
+    if (idle_ms < context->timeout_ms) {
+        timing_wheel_schedule(context->timing_wheel, timer, context->timeout_ms - idle_ms);
+        return;
+    }
+    
+    LOG_INFO("Closing TCP client idle for %llu ms", (unsigned long long)idle_ms);
+    shutdown(conn->socket, SHUT_RDWR);
+}
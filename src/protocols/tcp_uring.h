@@ -0,0 +1,34 @@
+/**
+ * @file tcp_uring.h
+ * @brief io_uring backend for the TCP protocol listener
+ */
+
+#ifndef DINOC_TCP_URING_H
+#define DINOC_TCP_URING_H
+
+#include <stdbool.h>
+#include "../include/common.h"
+#include "../include/protocol.h"
+
+/**
+ * @brief Check whether the running kernel supports the io_uring backend
+ *
+ * Requires multishot accept, recv/send and provided buffer rings (Linux 5.19+),
+ * and that io_uring is not disabled by policy.
+ *
+ * @return bool True if tcp_uring_listener_create can be used
+ */
+bool tcp_uring_supported(void);
+
+/**
+ * @brief Create a TCP listener driven by a single io_uring instance
+ *
+ * Speaks the same length-prefixed framing as tcp_listener_create.
+ *
+ * @param config Listener configuration
+ * @param listener Pointer to store created listener
+ * @return status_t Status code
+ */
+status_t tcp_uring_listener_create(const protocol_listener_config_t* config, protocol_listener_t** listener);
+
+#endif /* DINOC_TCP_URING_H */
@@ -10,34 +10,99 @@
 #include "../include/client.h"
 #include "../common/uuid.h"
 #include "../common/logger.h"
+#include "../common/reactor.h"
+#include "udp_sessions.h"
+#include "admission.h"
+#include "socket_filter.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <sched.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <sys/timerfd.h>
 
 // Heartbeat magic number
 #define HEARTBEAT_MAGIC 0x48454152  // "HEAR"
 
+// Batched I/O limits
+#define UDP_BATCH_SIZE 32                 // Datagrams per recvmmsg/sendmmsg call
+#define UDP_MAX_DATAGRAM 65536            // Receive slot size (largest UDP payload)
+#define UDP_TX_SLAB_SIZE (256 * 1024)     // Reply bytes held back for one sendmmsg call
+
+// Idle sessions are swept at most this often
+#define UDP_SESSION_SWEEP_MS 1000
+
+// Batched datagram I/O state, owned by the receive thread
+typedef struct {
+    // Receive side: one slab slot per datagram, dispatched in place
+    struct mmsghdr rx_msgs[UDP_BATCH_SIZE];
+    struct iovec rx_iov[UDP_BATCH_SIZE];
+    struct sockaddr_in rx_addrs[UDP_BATCH_SIZE];
+    uint8_t* rx_slab;
+    
+    // Send side: replies queued while a received batch is dispatched
+    struct mmsghdr tx_msgs[UDP_BATCH_SIZE];
+    struct iovec tx_iov[UDP_BATCH_SIZE];
+    struct sockaddr_in tx_addrs[UDP_BATCH_SIZE];
+    uint8_t* tx_slab;
+    size_t tx_count;
+    size_t tx_used;
+    bool dispatching;
+} udp_batch_t;
+
+// UDP receive worker (one per SO_REUSEPORT socket)
+//
+// The kernel hashes each peer's 4-tuple onto one socket of the group, so a
+// worker sees all of its peers' datagrams and owns their sessions outright:
+// the session shard is only touched by the worker thread, without a lock.
+typedef struct {
+    protocol_listener_t* listener;
+    size_t index;
+    int socket;
+    pthread_t thread;
+    bool thread_started;
+    int cpu;                         // Core the worker is pinned to (-1 = unpinned)
+    udp_batch_t* batch;
+    udp_session_table_t sessions;    // Peers whose datagrams hash to this socket
+    uint64_t last_sweep_ms;
+    pthread_t dispatch_thread;       // Thread dispatching the current batch
+    
+    // Reactor mode: the socket and sweep timer share one loop, so the shard stays single-threaded
+    reactor_source_t* source;
+    reactor_source_t* sweep_source;
+    int sweep_fd;
+} udp_worker_t;
+
+// Peer state (client protocol context)
+typedef struct {
+    struct sockaddr_in addr;         // Must be first, read as the client's address
+    udp_worker_t* worker;            // Worker whose socket the peer talks to
+} udp_peer_t;
+
 // UDP listener context
 typedef struct {
-    int server_socket;
     bool running;
-    pthread_t receive_thread;
-    pthread_mutex_t clients_mutex;
-    client_t** clients;
-    size_t client_count;
-    size_t client_capacity;
+    udp_worker_t* workers;
+    size_t worker_count;
+    reactor_t* reactor;              // Shared event loops, NULL for per-worker threads
     
     // Configuration
     char* bind_address;
     uint16_t port;
     uint32_t timeout_ms;
+    bool socket_filter;              // Drop non-protocol datagrams in the kernel
+    
+    // Drops counted on sockets that have since been closed
+    uint64_t closed_socket_drops;
+    
+    // Guards the clients' peers, which the session sweep frees while senders read them
+    pthread_mutex_t peers_mutex;
     
     // Callbacks
     void (*on_message_received)(protocol_listener_t*, client_t*, protocol_message_t*);
@@ -54,9 +119,22 @@ static status_t udp_listener_register_callbacks(protocol_listener_t* listener,
                                              void (*on_message_received)(protocol_listener_t*, client_t*, protocol_message_t*),
                                              void (*on_client_connected)(protocol_listener_t*, client_t*),
                                              void (*on_client_disconnected)(protocol_listener_t*, client_t*));
+static status_t udp_listener_get_stats(protocol_listener_t* listener, protocol_stat_t* stats, size_t* count);
+static status_t udp_listener_attach_reactor(protocol_listener_t* listener, reactor_t* reactor);
+static status_t udp_worker_open(udp_listener_context_t* context, udp_worker_t* worker);
+static void udp_workers_close(udp_listener_context_t* context);
 static void* udp_receive_thread(void* arg);
-static client_t* udp_find_or_create_client(udp_listener_context_t* context, struct sockaddr_in* addr, socklen_t addr_len);
-static void udp_remove_client(udp_listener_context_t* context, client_t* client);
+static int udp_worker_receive(udp_worker_t* worker, int flags);
+static status_t udp_workers_attach(udp_listener_context_t* context);
+static void udp_workers_detach(udp_listener_context_t* context);
+static void udp_reactor_readable(int fd, uint32_t events, void* arg);
+static void udp_reactor_sweep(int fd, uint32_t events, void* arg);
+static udp_batch_t* udp_batch_create(void);
+static void udp_batch_destroy(udp_batch_t* batch);
+static bool udp_batch_queue(udp_batch_t* batch, const struct sockaddr_in* addr, const uint8_t* data, size_t len);
+static void udp_batch_flush(udp_worker_t* worker);
+static client_t* udp_find_or_create_client(udp_worker_t* worker, struct sockaddr_in* addr, uint64_t now_ms);
+static void udp_session_closed(client_t* client, void* arg);
 
 /**
  * @brief Create a UDP listener
@@ -81,27 +159,42 @@ status_t udp_listener_create(const protocol_listener_config_t* config, protocol_
     
     // Initialize context
     memset(context, 0, sizeof(udp_listener_context_t));
-    context->server_socket = -1;
     context->running = false;
-    pthread_mutex_init(&context->clients_mutex, NULL);
+    context->worker_count = config->workers > 1 ? config->workers : 1;
+    pthread_mutex_init(&context->peers_mutex, NULL);
     
-    context->client_capacity = 16;
-    context->client_count = 0;
-    context->clients = (client_t**)malloc(context->client_capacity * sizeof(client_t*));
-    
-    if (context->clients == NULL) {
-        pthread_mutex_destroy(&context->clients_mutex);
+    // Create workers
+    context->workers = (udp_worker_t*)calloc(context->worker_count, sizeof(udp_worker_t));
+    if (context->workers == NULL) {
         free(context);
         free(new_listener);
         return STATUS_ERROR_MEMORY;
     }
     
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    
+    for (size_t i = 0; i < context->worker_count; i++) {
+        udp_worker_t* worker = &context->workers[i];
+        worker->listener = new_listener;
+        worker->index = i;
+        worker->socket = -1;
+        worker->sweep_fd = -1;
+        worker->cpu = context->worker_count > 1 && cores > 0 ? (int)(i % (size_t)cores) : -1;
+        
+        if (udp_session_table_init(&worker->sessions, UDP_SESSION_DEFAULT_CAPACITY) != STATUS_SUCCESS) {
+            context->worker_count = i;
+            udp_workers_close(context);
+            free(context);
+            free(new_listener);
+            return STATUS_ERROR_MEMORY;
+        }
+    }
+    
     // Copy configuration
     if (config->bind_address != NULL) {
         context->bind_address = strdup(config->bind_address);
         if (context->bind_address == NULL) {
-            free(context->clients);
-            pthread_mutex_destroy(&context->clients_mutex);
+            udp_workers_close(context);
             free(context);
             free(new_listener);
             return STATUS_ERROR_MEMORY;
@@ -109,8 +202,7 @@ status_t udp_listener_create(const protocol_listener_config_t* config, protocol_
     } else {
         context->bind_address = strdup("0.0.0.0");
         if (context->bind_address == NULL) {
-            free(context->clients);
-            pthread_mutex_destroy(&context->clients_mutex);
+            udp_workers_close(context);
             free(context);
             free(new_listener);
             return STATUS_ERROR_MEMORY;
@@ -119,8 +211,10 @@ status_t udp_listener_create(const protocol_listener_config_t* config, protocol_
     
     context->port = config->port > 0 ? config->port : 8080;
     context->timeout_ms = config->timeout_ms > 0 ? config->timeout_ms : 30000;
+    context->socket_filter = config->socket_filter;
     
     // Initialize listener
+    memset(new_listener, 0, sizeof(protocol_listener_t));
     uuid_generate_compat(&new_listener->id);
     new_listener->protocol_type = PROTOCOL_TYPE_UDP;
     new_listener->protocol_context = context;
@@ -131,6 +225,8 @@ status_t udp_listener_create(const protocol_listener_config_t* config, protocol_
     new_listener->destroy = udp_listener_destroy;
     new_listener->send_message = udp_listener_send_message;
     new_listener->register_callbacks = udp_listener_register_callbacks;
+    new_listener->get_stats = udp_listener_get_stats;
+    new_listener->attach_reactor = udp_listener_attach_reactor;
     
     *listener = new_listener;
     
@@ -152,17 +248,87 @@ static status_t udp_listener_start(protocol_listener_t* listener) {
         return STATUS_ERROR_ALREADY_RUNNING;
     }
     
+    // Open sockets (one per worker)
+    for (size_t i = 0; i < context->worker_count; i++) {
+        status_t status = udp_worker_open(context, &context->workers[i]);
+        if (status != STATUS_SUCCESS) {
+            for (size_t j = 0; j < i; j++) {
+                close(context->workers[j].socket);
+                context->workers[j].socket = -1;
+                udp_batch_destroy(context->workers[j].batch);
+                context->workers[j].batch = NULL;
+            }
+            return status;
+        }
+    }
+    
+    // Set running flag
+    context->running = true;
+    
+    // Shared reactor: no threads of our own
+    if (context->reactor != NULL) {
+        status_t status = udp_workers_attach(context);
+        if (status != STATUS_SUCCESS) {
+            udp_listener_stop(listener);
+        }
+        return status;
+    }
+    
+    // Create receive threads
+    for (size_t i = 0; i < context->worker_count; i++) {
+        udp_worker_t* worker = &context->workers[i];
+        
+        if (pthread_create(&worker->thread, NULL, udp_receive_thread, worker) != 0) {
+            LOG_ERROR("Failed to create UDP receive thread: %s", strerror(errno));
+            udp_listener_stop(listener);
+            return STATUS_ERROR_THREAD;
+        }
+        
+        worker->thread_started = true;
+        
+        // Pin workers so each socket of the group is served from its own core
+        if (worker->cpu >= 0) {
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            CPU_SET(worker->cpu, &cpuset);
+            
+            if (pthread_setaffinity_np(worker->thread, sizeof(cpuset), &cpuset) != 0) {
+                LOG_WARN("Failed to pin UDP worker %zu to core %d", i, worker->cpu);
+            }
+        }
+    }
+    
+    if (context->worker_count > 1) {
+        LOG_INFO("UDP listener: Started %zu SO_REUSEPORT workers", context->worker_count);
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Open and bind a worker's socket and allocate its batch buffers
+ */
+static status_t udp_worker_open(udp_listener_context_t* context, udp_worker_t* worker) {
     // Create server socket
-    context->server_socket = socket(AF_INET, SOCK_DGRAM, 0);
-    if (context->server_socket < 0) {
+    worker->socket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (worker->socket < 0) {
         return STATUS_ERROR_SOCKET;
     }
     
     // Set socket options
     int opt = 1;
-    if (setsockopt(context->server_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
-        close(context->server_socket);
-        context->server_socket = -1;
+    if (setsockopt(worker->socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0 ||
+        (context->worker_count > 1 &&
+         setsockopt(worker->socket, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0)) {
+        close(worker->socket);
+        worker->socket = -1;
+        return STATUS_ERROR_SOCKET;
+    }
+    
+    // Attach the filter before binding so no junk is queued ahead of it
+    if (context->socket_filter && socket_filter_attach_udp(worker->socket) != STATUS_SUCCESS) {
+        close(worker->socket);
+        worker->socket = -1;
         return STATUS_ERROR_SOCKET;
     }
     
@@ -173,21 +339,18 @@ static status_t udp_listener_start(protocol_listener_t* listener) {
     server_addr.sin_addr.s_addr = inet_addr(context->bind_address);
     server_addr.sin_port = htons(context->port);
     
-    if (bind(context->server_socket, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-        close(context->server_socket);
-        context->server_socket = -1;
+    if (bind(worker->socket, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+        close(worker->socket);
+        worker->socket = -1;
         return STATUS_ERROR_BIND;
     }
     
-    // Set running flag
-    context->running = true;
-    
-    // Create receive thread
-    if (pthread_create(&context->receive_thread, NULL, udp_receive_thread, listener) != 0) {
-        close(context->server_socket);
-        context->server_socket = -1;
-        context->running = false;
-        return STATUS_ERROR_THREAD;
+    // Preallocate batch buffers
+    worker->batch = udp_batch_create();
+    if (worker->batch == NULL) {
+        close(worker->socket);
+        worker->socket = -1;
+        return STATUS_ERROR_MEMORY;
     }
     
     return STATUS_SUCCESS;
@@ -211,42 +374,56 @@ static status_t udp_listener_stop(protocol_listener_t* listener) {
     // Set running flag
     context->running = false;
     
-    // Close server socket
-    if (context->server_socket >= 0) {
-        close(context->server_socket);
-        context->server_socket = -1;
-    }
+    // Leave the reactor, after which no handler touches the workers
+    udp_workers_detach(context);
     
-    // Wait for receive thread to exit
-    pthread_join(context->receive_thread, NULL);
-    
-    // Clean up clients
-    pthread_mutex_lock(&context->clients_mutex);
+    // Wake the receive threads (shutdown ends a blocked recvmmsg)
+    for (size_t i = 0; i < context->worker_count; i++) {
+        if (context->workers[i].socket >= 0) {
+            shutdown(context->workers[i].socket, SHUT_RDWR);
+        }
+    }
     
-    for (size_t i = 0; i < context->client_count; i++) {
-        client_t* client = context->clients[i];
+    for (size_t i = 0; i < context->worker_count; i++) {
+        udp_worker_t* worker = &context->workers[i];
         
-        // Update client state
-        client_update_state(client, CLIENT_STATE_DISCONNECTED);
-        
-        // Call client disconnected callback
-        if (context->on_client_disconnected != NULL) {
-            context->on_client_disconnected(listener, client);
+        // Wait for receive thread to exit
+        if (worker->thread_started) {
+            pthread_join(worker->thread, NULL);
+            worker->thread_started = false;
         }
         
-        // Free protocol context
-        if (client->protocol_context != NULL) {
-            free(client->protocol_context);
-            client->protocol_context = NULL;
+        // Close server socket, keeping its drop count
+        if (worker->socket >= 0) {
+            context->closed_socket_drops += socket_filter_drops(worker->socket);
+            close(worker->socket);
+            worker->socket = -1;
         }
+        
+        // Free batch buffers
+        udp_batch_destroy(worker->batch);
+        worker->batch = NULL;
+        
+        // Clean up clients
+        udp_session_table_expire(&worker->sessions, udp_session_now_ms(), 0, udp_session_closed, worker);
     }
     
-    context->client_count = 0;
-    pthread_mutex_unlock(&context->clients_mutex);
-    
     return STATUS_SUCCESS;
 }
 
+/**
+ * @brief Release worker session shards
+ */
+static void udp_workers_close(udp_listener_context_t* context) {
+    for (size_t i = 0; i < context->worker_count; i++) {
+        udp_session_table_free(&context->workers[i].sessions);
+    }
+    
+    free(context->workers);
+    context->workers = NULL;
+    context->worker_count = 0;
+}
+
 /**
  * @brief Destroy UDP listener
  */
@@ -267,11 +444,10 @@ static status_t udp_listener_destroy(protocol_listener_t* listener) {
         free(context->bind_address);
     }
     
-    // Free clients array
-    free(context->clients);
+    // Free workers
+    udp_workers_close(context);
     
-    // Destroy mutex
-    pthread_mutex_destroy(&context->clients_mutex);
+    pthread_mutex_destroy(&context->peers_mutex);
     
     // Free context
     free(context);
@@ -297,15 +473,39 @@ static status_t udp_listener_send_message(protocol_listener_t* listener, client_
         return STATUS_ERROR_NOT_RUNNING;
     }
     
-    // Get client address from protocol context
-    if (client->protocol_context == NULL) {
-        return STATUS_ERROR_INVALID_PARAM;
+    // Get client address from protocol context, the sweep may free it once the lock is dropped
+    pthread_mutex_lock(&context->peers_mutex);
+    
+    udp_peer_t* peer = (udp_peer_t*)client->protocol_context;
+    
+    if (peer == NULL) {
+        pthread_mutex_unlock(&context->peers_mutex);
+        return STATUS_ERROR_NOT_CONNECTED;
     }
     
-    struct sockaddr_in* client_addr = (struct sockaddr_in*)client->protocol_context;
+    udp_worker_t* worker = peer->worker;
+    struct sockaddr_in addr = peer->addr;
+    struct sockaddr_in* client_addr = &addr;
+    
+    pthread_mutex_unlock(&context->peers_mutex);
+    
+    // Replies made while the owning worker dispatches a batch go out together. Only
+    // that thread may look at the batch, stop frees it under any other.
+    if (pthread_equal(pthread_self(), worker->dispatch_thread) && worker->batch->dispatching) {
+        if (udp_batch_queue(worker->batch, client_addr, message->data, message->data_len)) {
+            return STATUS_SUCCESS;
+        }
+        
+        // Batch is full, send what is queued and try again
+        udp_batch_flush(worker);
+        
+        if (udp_batch_queue(worker->batch, client_addr, message->data, message->data_len)) {
+            return STATUS_SUCCESS;
+        }
+    }
     
-    // Send message
-    ssize_t sent = sendto(context->server_socket, message->data, message->data_len, 0,
+    // Send from the socket the peer talks to, so replies keep its 4-tuple
+    ssize_t sent = sendto(worker->socket, message->data, message->data_len, 0,
                          (struct sockaddr*)client_addr, sizeof(struct sockaddr_in));
     
     if (sent != (ssize_t)message->data_len) {
@@ -336,60 +536,106 @@ static status_t udp_listener_register_callbacks(protocol_listener_t* listener,
 }
 
 /**
- * @brief Receive thread function
+ * @brief Receive thread function (one per worker)
+ * 
+ * Pulls up to UDP_BATCH_SIZE datagrams per recvmmsg call into the batch slab
+ * and dispatches them in place. Replies sent from the callbacks are queued
+ * and written with a single sendmmsg call once the batch is dispatched.
  */
 static void* udp_receive_thread(void* arg) {
-    protocol_listener_t* listener = (protocol_listener_t*)arg;
+    udp_worker_t* worker = (udp_worker_t*)arg;
+    protocol_listener_t* listener = worker->listener;
     udp_listener_context_t* context = (udp_listener_context_t*)listener->protocol_context;
     
-    // Set socket timeout
-    struct timeval tv;
-    tv.tv_sec = 1;
-    tv.tv_usec = 0;
-    
-    if (setsockopt(context->server_socket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) < 0) {
-        perror("setsockopt");
-    }
-    
-    // Buffer for receiving data
-    uint8_t buffer[65536];
+    // Receive timeout in force: only while there are sessions to sweep
+    bool timed = false;
     
     while (context->running) {
-        // Receive data
-        struct sockaddr_in client_addr;
-        socklen_t client_addr_len = sizeof(client_addr);
+        // Drop sessions that have been silent for the listener timeout
+        uint64_t sweep_ms = udp_session_now_ms();
+        if (sweep_ms - worker->last_sweep_ms >= UDP_SESSION_SWEEP_MS) {
+            udp_session_table_expire(&worker->sessions, sweep_ms, context->timeout_ms, udp_session_closed, worker);
+            worker->last_sweep_ms = sweep_ms;
+        }
         
-        ssize_t recv_len = recvfrom(context->server_socket, buffer, sizeof(buffer), 0,
-                                   (struct sockaddr*)&client_addr, &client_addr_len);
+        // Block without a timeout while idle, stop wakes the receive through shutdown()
+        bool want_timed = worker->sessions.count > 0;
+        if (want_timed != timed) {
+            struct timeval tv;
+            tv.tv_sec = want_timed ? 1 : 0;
+            tv.tv_usec = 0;
+            
+            if (setsockopt(worker->socket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) < 0) {
+                perror("setsockopt");
+            }
+            timed = want_timed;
+        }
+        
+        // Block for the first datagram, then take whatever else is queued
+        int count = udp_worker_receive(worker, MSG_WAITFORONE);
         
-        if (recv_len < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        // Woken by stop
+        if (!context->running) {
+            break;
+        }
+        
+        if (count < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
                 // Timeout, continue
                 continue;
             }
             
-            perror("recvfrom");
+            if (context->running) {
+                perror("recvmmsg");
+            }
             break;
         }
-        
-        // Create client
-        client_t* client = NULL;
-        status_t status = client_register(listener, NULL, &client);
-        if (status != STATUS_SUCCESS || client == NULL) {
-            LOG_ERROR("Failed to create client");
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief Receive one batch of up to UDP_BATCH_SIZE datagrams and dispatch it
+ * 
+ * @param worker Worker
+ * @param flags recvmmsg flags (MSG_WAITFORONE in a worker thread, MSG_DONTWAIT from the reactor)
+ * @return int Datagrams received, -1 with errno set on failure
+ */
+static int udp_worker_receive(udp_worker_t* worker, int flags) {
+    protocol_listener_t* listener = worker->listener;
+    udp_listener_context_t* context = (udp_listener_context_t*)listener->protocol_context;
+    udp_batch_t* batch = worker->batch;
+    
+    // Reset the slots the previous call filled in
+    for (int i = 0; i < UDP_BATCH_SIZE; i++) {
+        batch->rx_msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+        batch->rx_msgs[i].msg_len = 0;
+    }
+    
+    int count = recvmmsg(worker->socket, batch->rx_msgs, UDP_BATCH_SIZE, flags, NULL);
+    
+    if (count <= 0 || !context->running) {
+        return count;
+    }
+    
+    uint64_t now_ms = udp_session_now_ms();
+    
+    worker->dispatch_thread = pthread_self();
+    batch->dispatching = true;
+    
+    for (int i = 0; i < count; i++) {
+        // Find or create the client for the sender's address
+        client_t* client = udp_find_or_create_client(worker, &batch->rx_addrs[i], now_ms);
+        if (client == NULL) {
+            // Refused by admission control, or the client could not be created
             continue;
         }
         
-        // Create message
+        // Message points into the slab, valid until the next recvmmsg
         protocol_message_t message;
-        message.data = (uint8_t*)malloc(recv_len);
-        
-        if (message.data == NULL) {
-            continue;
-        }
-        
-        memcpy(message.data, buffer, recv_len);
-        message.data_len = recv_len;
+        message.data = (uint8_t*)batch->rx_iov[i].iov_base;
+        message.data_len = batch->rx_msgs[i].msg_len;
         
         // Check if this is a heartbeat message
         if (message.data_len == sizeof(uint32_t) && 
@@ -408,53 +654,260 @@ static void* udp_receive_thread(void* arg) {
                 context->on_message_received(listener, client, &message);
             }
         }
+    }
+    
+    batch->dispatching = false;
+    
+    // Send the replies queued by the callbacks
+    udp_batch_flush(worker);
+    
+    return count;
+}
+
+/**
+ * @brief Register every worker's socket and sweep timer with the reactor
+ */
+static status_t udp_workers_attach(udp_listener_context_t* context) {
+    size_t first_loop = reactor_next_loop(context->reactor);
+    
+    for (size_t i = 0; i < context->worker_count; i++) {
+        udp_worker_t* worker = &context->workers[i];
+        size_t loop = first_loop + i;
+        
+        worker->sweep_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (worker->sweep_fd < 0) {
+            LOG_ERROR("Failed to create UDP session sweep timer: %s", strerror(errno));
+            return STATUS_ERROR_SOCKET;
+        }
         
-        // Free message data
-        free(message.data);
+        struct itimerspec interval;
+        memset(&interval, 0, sizeof(interval));
+        interval.it_value.tv_sec = UDP_SESSION_SWEEP_MS / 1000;
+        interval.it_value.tv_nsec = (UDP_SESSION_SWEEP_MS % 1000) * 1000000L;
+        interval.it_interval = interval.it_value;
+        
+        if (timerfd_settime(worker->sweep_fd, 0, &interval, NULL) < 0 ||
+            reactor_add(context->reactor, loop, worker->socket, EPOLLIN, udp_reactor_readable, worker, &worker->source) != STATUS_SUCCESS ||
+            reactor_add(context->reactor, loop, worker->sweep_fd, EPOLLIN, udp_reactor_sweep, worker, &worker->sweep_source) != STATUS_SUCCESS) {
+            LOG_ERROR("Failed to register UDP worker %zu with the reactor", i);
+            return STATUS_ERROR_SOCKET;
+        }
     }
     
-    return NULL;
+    LOG_INFO("UDP listener: %zu workers served by the shared reactor", context->worker_count);
+    
+    return STATUS_SUCCESS;
 }
 
 /**
- * @brief Find or create client
+ * @brief Remove workers from the reactor
+ */
+static void udp_workers_detach(udp_listener_context_t* context) {
+    for (size_t i = 0; i < context->worker_count; i++) {
+        udp_worker_t* worker = &context->workers[i];
+        
+        reactor_remove(worker->source);
+        worker->source = NULL;
+        reactor_remove(worker->sweep_source);
+        worker->sweep_source = NULL;
+        
+        if (worker->sweep_fd >= 0) {
+            close(worker->sweep_fd);
+            worker->sweep_fd = -1;
+        }
+    }
+}
+
+/**
+ * @brief Reactor handler: a worker socket is readable
+ * 
+ * One batch per call keeps the loop's other sources responsive, the
+ * level-triggered registration calls back while datagrams remain.
+ */
+static void udp_reactor_readable(int fd, uint32_t events, void* arg) {
+    (void)fd;
+    (void)events;
+    
+    if (udp_worker_receive((udp_worker_t*)arg, MSG_DONTWAIT) < 0 &&
+        errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        LOG_ERROR("UDP receive failed: %s", strerror(errno));
+    }
+}
+
+/**
+ * @brief Reactor handler: drop sessions that have been silent for the listener timeout
+ */
+static void udp_reactor_sweep(int fd, uint32_t events, void* arg) {
+    (void)events;
+    udp_worker_t* worker = (udp_worker_t*)arg;
+    udp_listener_context_t* context = (udp_listener_context_t*)worker->listener->protocol_context;
+    
+    uint64_t expirations;
+    if (read(fd, &expirations, sizeof(expirations)) < 0) {
+        return;
+    }
+    
+    uint64_t now_ms = udp_session_now_ms();
+    udp_session_table_expire(&worker->sessions, now_ms, context->timeout_ms, udp_session_closed, worker);
+    worker->last_sweep_ms = now_ms;
+}
+
+/**
+ * @brief Serve the listener from a shared reactor instead of worker threads
+ */
+static status_t udp_listener_attach_reactor(protocol_listener_t* listener, reactor_t* reactor) {
+    if (listener == NULL || listener->protocol_context == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    udp_listener_context_t* context = (udp_listener_context_t*)listener->protocol_context;
+    
+    if (context->running) {
+        return STATUS_ERROR_ALREADY_RUNNING;
+    }
+    
+    context->reactor = reactor;
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Allocate batch buffers and point the message headers at them
  */
-static client_t* udp_find_or_create_client(udp_listener_context_t* context, struct sockaddr_in* addr, socklen_t addr_len) {
-    pthread_mutex_lock(&context->clients_mutex);
+static udp_batch_t* udp_batch_create(void) {
+    udp_batch_t* batch = (udp_batch_t*)malloc(sizeof(udp_batch_t));
+    if (batch == NULL) {
+        return NULL;
+    }
+    
+    memset(batch, 0, sizeof(udp_batch_t));
+    
+    batch->rx_slab = (uint8_t*)malloc((size_t)UDP_BATCH_SIZE * UDP_MAX_DATAGRAM);
+    batch->tx_slab = (uint8_t*)malloc(UDP_TX_SLAB_SIZE);
+    
+    if (batch->rx_slab == NULL || batch->tx_slab == NULL) {
+        udp_batch_destroy(batch);
+        return NULL;
+    }
     
-    // Find existing client
-    for (size_t i = 0; i < context->client_count; i++) {
-        client_t* client = context->clients[i];
+    for (int i = 0; i < UDP_BATCH_SIZE; i++) {
+        batch->rx_iov[i].iov_base = batch->rx_slab + (size_t)i * UDP_MAX_DATAGRAM;
+        batch->rx_iov[i].iov_len = UDP_MAX_DATAGRAM;
+        batch->rx_msgs[i].msg_hdr.msg_iov = &batch->rx_iov[i];
+        batch->rx_msgs[i].msg_hdr.msg_iovlen = 1;
+        batch->rx_msgs[i].msg_hdr.msg_name = &batch->rx_addrs[i];
+        batch->rx_msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
         
-        if (client->protocol_context != NULL) {
-            struct sockaddr_in* client_addr = (struct sockaddr_in*)client->protocol_context;
-            
-            if (client_addr->sin_addr.s_addr == addr->sin_addr.s_addr &&
-                client_addr->sin_port == addr->sin_port) {
-                pthread_mutex_unlock(&context->clients_mutex);
-                return client;
+        batch->tx_msgs[i].msg_hdr.msg_iov = &batch->tx_iov[i];
+        batch->tx_msgs[i].msg_hdr.msg_iovlen = 1;
+        batch->tx_msgs[i].msg_hdr.msg_name = &batch->tx_addrs[i];
+        batch->tx_msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+    }
+    
+    return batch;
+}
+
+/**
+ * @brief Free batch buffers
+ */
+static void udp_batch_destroy(udp_batch_t* batch) {
+    if (batch == NULL) {
+        return;
+    }
+    
+    free(batch->rx_slab);
+    free(batch->tx_slab);
+    free(batch);
+}
+
+/**
+ * @brief Copy a reply into the send batch
+ * 
+ * @return bool False if the batch has no room for it
+ */
+static bool udp_batch_queue(udp_batch_t* batch, const struct sockaddr_in* addr, const uint8_t* data, size_t len) {
+    if (batch->tx_count >= UDP_BATCH_SIZE || len > UDP_TX_SLAB_SIZE - batch->tx_used) {
+        return false;
+    }
+    
+    uint8_t* slot = batch->tx_slab + batch->tx_used;
+    memcpy(slot, data, len);
+    
+    batch->tx_iov[batch->tx_count].iov_base = slot;
+    batch->tx_iov[batch->tx_count].iov_len = len;
+    memcpy(&batch->tx_addrs[batch->tx_count], addr, sizeof(struct sockaddr_in));
+    
+    batch->tx_count++;
+    batch->tx_used += len;
+    
+    return true;
+}
+
+/**
+ * @brief Send every queued reply with sendmmsg
+ */
+static void udp_batch_flush(udp_worker_t* worker) {
+    udp_batch_t* batch = worker->batch;
+    size_t sent_count = 0;
+    
+    while (sent_count < batch->tx_count) {
+        int sent = sendmmsg(worker->socket, batch->tx_msgs + sent_count,
+                            (unsigned int)(batch->tx_count - sent_count), 0);
+        
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
             }
+            
+            // Datagram delivery is best effort, skip the one that failed
+            LOG_ERROR("Failed to send UDP reply: %s", strerror(errno));
+            sent_count++;
+            continue;
         }
+        
+        sent_count += (size_t)sent;
     }
     
-    pthread_mutex_unlock(&context->clients_mutex);
+    batch->tx_count = 0;
+    batch->tx_used = 0;
+}
+
+/**
+ * @brief Find or create client
+ */
+static client_t* udp_find_or_create_client(udp_worker_t* worker, struct sockaddr_in* addr, uint64_t now_ms) {
+    protocol_listener_t* listener = worker->listener;
+    udp_listener_context_t* context = (udp_listener_context_t*)listener->protocol_context;
+    
+    // Find existing session
+    client_t* existing = udp_session_table_lookup(&worker->sessions, addr, now_ms);
+    if (existing != NULL) {
+        return existing;
+    }
+    
+    // Over-limit sources are dropped before anything is allocated
+    if (!admission_allow_at(addr, now_ms)) {
+        return NULL;
+    }
     
     // Create client context
-    void* protocol_context = malloc(sizeof(struct sockaddr_in));
-    if (protocol_context == NULL) {
+    udp_peer_t* peer = (udp_peer_t*)malloc(sizeof(udp_peer_t));
+    if (peer == NULL) {
+        LOG_ERROR("Failed to create client");
         return NULL;
     }
     
     // Set protocol context
-    memcpy(protocol_context, addr, sizeof(struct sockaddr_in));
+    memcpy(&peer->addr, addr, sizeof(struct sockaddr_in));
+    peer->worker = worker;
     
     // Register client
     client_t* client = NULL;
-    protocol_listener_t* listener = (protocol_listener_t*)context;
-    status_t status = client_register(listener, protocol_context, &client);
+    status_t status = client_register(listener, peer, &client);
     
     if (status != STATUS_SUCCESS) {
-        free(protocol_context);
+        LOG_ERROR("Failed to create client");
+        free(peer);
         return NULL;
     }
     
@@ -466,25 +919,22 @@ static client_t* udp_find_or_create_client(udp_listener_context_t* context, stru
     inet_ntop(AF_INET, &addr->sin_addr, ip_str, sizeof(ip_str));
     client_update_info(client, NULL, ip_str, NULL);
     
-    // Add client to array
-    pthread_mutex_lock(&context->clients_mutex);
+    // Add session
+    status = udp_session_table_insert(&worker->sessions, addr, client, now_ms);
     
-    if (context->client_count >= context->client_capacity) {
-        size_t new_capacity = context->client_capacity * 2;
-        client_t** new_clients = (client_t**)realloc(context->clients, new_capacity * sizeof(client_t*));
+    if (status != STATUS_SUCCESS) {
+        LOG_ERROR("Failed to add UDP session: %d", status);
+        client_update_state(client, CLIENT_STATE_DISCONNECTED);
         
-        if (new_clients == NULL) {
-            pthread_mutex_unlock(&context->clients_mutex);
-            return client;  // Still return the client, just don't add to array
-        }
+        pthread_mutex_lock(&context->peers_mutex);
+        client->protocol_context = NULL;
+        pthread_mutex_unlock(&context->peers_mutex);
         
-        context->clients = new_clients;
-        context->client_capacity = new_capacity;
+        free(peer);
+        client_destroy(client);
+        return NULL;
     }
     
-    context->clients[context->client_count++] = client;
-    pthread_mutex_unlock(&context->clients_mutex);
-    
     // Call client connected callback
     if (context->on_client_connected != NULL) {
         context->on_client_connected(listener, client);
@@ -494,17 +944,62 @@ static client_t* udp_find_or_create_client(udp_listener_context_t* context, stru
 }
 
 /**
- * @brief Remove client from array
+ * @brief Tear down a client whose session was removed
  */
-static void udp_remove_client(udp_listener_context_t* context, client_t* client) {
-    pthread_mutex_lock(&context->clients_mutex);
+static void udp_session_closed(client_t* client, void* arg) {
+    udp_worker_t* worker = (udp_worker_t*)arg;
+    protocol_listener_t* listener = worker->listener;
+    udp_listener_context_t* context = (udp_listener_context_t*)listener->protocol_context;
     
-    for (size_t i = 0; i < context->client_count; i++) {
-        if (context->clients[i] == client) {
-            context->clients[i] = context->clients[--context->client_count];
-            break;
+    // Update client state
+    client_update_state(client, CLIENT_STATE_DISCONNECTED);
+    
+    // Call client disconnected callback
+    if (context->on_client_disconnected != NULL) {
+        context->on_client_disconnected(listener, client);
+    }
+    
+    // Free protocol context once no sender can be reading it
+    pthread_mutex_lock(&context->peers_mutex);
+    
+    udp_peer_t* peer = (udp_peer_t*)client->protocol_context;
+    client->protocol_context = NULL;
+    
+    pthread_mutex_unlock(&context->peers_mutex);
+    
+    free(peer);
+    
+    // A returning peer registers as a new client
+    client_destroy(client);
+}
+
+/**
+ * @brief Report kernel drop counters
+ */
+static status_t udp_listener_get_stats(protocol_listener_t* listener, protocol_stat_t* stats, size_t* count) {
+    if (listener == NULL || listener->protocol_context == NULL || stats == NULL || count == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    // Nothing fits, report nothing
+    if (*count < 1) {
+        *count = 0;
+        return STATUS_SUCCESS;
+    }
+    
+    udp_listener_context_t* context = (udp_listener_context_t*)listener->protocol_context;
+    uint64_t drops = context->closed_socket_drops;
+    
+    for (size_t i = 0; i < context->worker_count; i++) {
+        if (context->workers[i].socket >= 0) {
+            drops += socket_filter_drops(context->workers[i].socket);
         }
     }
     
-    pthread_mutex_unlock(&context->clients_mutex);
+    // Filter rejections and receive queue overflows, the kernel counts them together
+    stats[0].name = "kernel_drops";
+    stats[0].value = drops;
+    *count = 1;
+    
+    return STATUS_SUCCESS;
 }
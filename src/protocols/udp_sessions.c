@@ -0,0 +1,270 @@
+/**
+ * @file udp_sessions.c
+ * @brief UDP peer session table keyed by source address
+ */
+
+#define _GNU_SOURCE /* For getrandom */
+
+#include "udp_sessions.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/random.h>
+
+// Forward declarations
+static size_t udp_session_hash(const udp_session_table_t* table, uint32_t addr, uint16_t port);
+static size_t udp_session_find(const udp_session_table_t* table, uint32_t addr, uint16_t port, bool* found);
+static void udp_session_delete_slot(udp_session_table_t* table, size_t index);
+static status_t udp_session_table_grow(udp_session_table_t* table);
+
+/**
+ * @brief Initialize a session table
+ */
+status_t udp_session_table_init(udp_session_table_t* table, size_t capacity) {
+    if (table == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    memset(table, 0, sizeof(udp_session_table_t));
+    
+    // Round up to a power of two
+    table->capacity = 16;
+    while (table->capacity < (capacity > 0 ? capacity : UDP_SESSION_DEFAULT_CAPACITY)) {
+        table->capacity <<= 1;
+    }
+    
+    table->slots = (udp_session_t*)calloc(table->capacity, sizeof(udp_session_t));
+    if (table->slots == NULL) {
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    // Random seed, falling back to something that still differs per run
+    if (getrandom(&table->seed, sizeof(table->seed), GRND_NONBLOCK) != sizeof(table->seed)) {
+        table->seed = (uint64_t)time(NULL) ^ (uint64_t)(uintptr_t)table->slots;
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Release a session table
+ */
+void udp_session_table_free(udp_session_table_t* table) {
+    if (table == NULL) {
+        return;
+    }
+    
+    free(table->slots);
+    memset(table, 0, sizeof(udp_session_table_t));
+}
+
+/**
+ * @brief Find the client for a source address and refresh its idle timer
+ */
+client_t* udp_session_table_lookup(udp_session_table_t* table, const struct sockaddr_in* addr, uint64_t now_ms) {
+    if (table == NULL || addr == NULL) {
+        return NULL;
+    }
+    
+    bool found = false;
+    size_t index = udp_session_find(table, addr->sin_addr.s_addr, addr->sin_port, &found);
+    
+    if (!found) {
+        return NULL;
+    }
+    
+    table->slots[index].last_seen_ms = now_ms;
+    
+    return table->slots[index].client;
+}
+
+/**
+ * @brief Add a session
+ */
+status_t udp_session_table_insert(udp_session_table_t* table, const struct sockaddr_in* addr, client_t* client, uint64_t now_ms) {
+    if (table == NULL || addr == NULL || client == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
+    // Keep the load factor under 3/4 so probe runs stay short
+    if ((table->count + 1) * 4 > table->capacity * 3) {
+        status_t status = udp_session_table_grow(table);
+        if (status != STATUS_SUCCESS) {
+            return status;
+        }
+    }
+    
+    bool found = false;
+    size_t index = udp_session_find(table, addr->sin_addr.s_addr, addr->sin_port, &found);
+    
+    if (found) {
+        return STATUS_ERROR_ALREADY_EXISTS;
+    }
+    
+    udp_session_t* session = &table->slots[index];
+    session->addr = addr->sin_addr.s_addr;
+    session->port = addr->sin_port;
+    session->used = true;
+    session->last_seen_ms = now_ms;
+    session->client = client;
+    
+    table->count++;
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Remove the session for a source address
+ */
+client_t* udp_session_table_remove(udp_session_table_t* table, const struct sockaddr_in* addr) {
+    if (table == NULL || addr == NULL) {
+        return NULL;
+    }
+    
+    bool found = false;
+    size_t index = udp_session_find(table, addr->sin_addr.s_addr, addr->sin_port, &found);
+    
+    if (!found) {
+        return NULL;
+    }
+    
+    client_t* client = table->slots[index].client;
+    udp_session_delete_slot(table, index);
+    
+    return client;
+}
+
+/**
+ * @brief Remove sessions idle for at least idle_ms
+ */
+size_t udp_session_table_expire(udp_session_table_t* table, uint64_t now_ms, uint64_t idle_ms,
+                                void (*on_expired)(client_t* client, void* arg), void* arg) {
+    if (table == NULL) {
+        return 0;
+    }
+    
+    size_t removed = 0;
+    size_t index = 0;
+    
+    while (index < table->capacity) {
+        udp_session_t* session = &table->slots[index];
+        
+        if (!session->used || session->last_seen_ms + idle_ms > now_ms) {
+            index++;
+            continue;
+        }
+        
+        client_t* client = session->client;
+        
+        // Deletion shifts a later entry into this slot, so look at it again
+        udp_session_delete_slot(table, index);
+        removed++;
+        
+        if (on_expired != NULL) {
+            on_expired(client, arg);
+        }
+    }
+    
+    return removed;
+}
+
+/**
+ * @brief Get the monotonic time used for session idle timers
+ */
+uint64_t udp_session_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Hash a source address (splitmix64 finaliser over the seeded key)
+ */
+static size_t udp_session_hash(const udp_session_table_t* table, uint32_t addr, uint16_t port) {
+    uint64_t x = (((uint64_t)addr << 16) | port) ^ table->seed;
+    
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    
+    return (size_t)x & (table->capacity - 1);
+}
+
+/**
+ * @brief Probe for a source address
+ *
+ * @return size_t Slot holding the address, or the empty slot ending the probe
+ */
+static size_t udp_session_find(const udp_session_table_t* table, uint32_t addr, uint16_t port, bool* found) {
+    size_t mask = table->capacity - 1;
+    size_t index = udp_session_hash(table, addr, port);
+    
+    while (table->slots[index].used) {
+        if (table->slots[index].addr == addr && table->slots[index].port == port) {
+            *found = true;
+            return index;
+        }
+        
+        index = (index + 1) & mask;
+    }
+    
+    *found = false;
+    return index;
+}
+
+/**
+ * @brief Empty a slot, shifting later entries of the probe run back into it
+ */
+static void udp_session_delete_slot(udp_session_table_t* table, size_t index) {
+    size_t mask = table->capacity - 1;
+    size_t hole = index;
+    size_t next = (hole + 1) & mask;
+    
+    while (table->slots[next].used) {
+        size_t home = udp_session_hash(table, table->slots[next].addr, table->slots[next].port);
+        
+        // Move the entry unless the hole lies before its home slot
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            table->slots[hole] = table->slots[next];
+            hole = next;
+        }
+        
+        next = (next + 1) & mask;
+    }
+    
+    memset(&table->slots[hole], 0, sizeof(udp_session_t));
+    table->count--;
+}
+
+/**
+ * @brief Double the table and rehash every session
+ */
+static status_t udp_session_table_grow(udp_session_table_t* table) {
+    size_t old_capacity = table->capacity;
+    udp_session_t* old_slots = table->slots;
+    
+    udp_session_t* slots = (udp_session_t*)calloc(old_capacity * 2, sizeof(udp_session_t));
+    if (slots == NULL) {
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    table->slots = slots;
+    table->capacity = old_capacity * 2;
+    
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (!old_slots[i].used) {
+            continue;
+        }
+        
+        bool found = false;
+        size_t index = udp_session_find(table, old_slots[i].addr, old_slots[i].port, &found);
+        table->slots[index] = old_slots[i];
+    }
+    
+    free(old_slots);
+    
+    return STATUS_SUCCESS;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file udp_sessions.h
+ * @brief UDP peer session table keyed by source address
+ */
+
+#ifndef DINOC_UDP_SESSIONS_H
+#define DINOC_UDP_SESSIONS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <netinet/in.h>
+#include "../include/common.h"
+
+/**
+ * @brief Session table defaults
+ */
+#define UDP_SESSION_DEFAULT_CAPACITY 64
+
+/**
+ * @brief Session (one per source address and port)
+ */
+typedef struct {
+    uint32_t addr;              // IPv4 address, network byte order
+    uint16_t port;              // Port, network byte order
+    bool used;
+    uint64_t last_seen_ms;      // Monotonic time of the last datagram
+    client_t* client;
+} udp_session_t;
+
+/**
+ * @brief Session table
+ *
+ * Open addressing with linear probing and backward-shift deletion, so
+ * lookups stay constant time without tombstones. The hash is seeded per
+ * table so spoofed source addresses cannot be chosen to collide. Not
+ * thread safe, callers serialise access.
+ */
+typedef struct {
+    udp_session_t* slots;
+    size_t capacity;            // Power of two
+    size_t count;
+    uint64_t seed;
+} udp_session_table_t;
+
+/**
+ * @brief Initialize a session table
+ *
+ * @param table Session table
+ * @param capacity Initial slot count (0 = UDP_SESSION_DEFAULT_CAPACITY)
+ * @return status_t Status code
+ */
+status_t udp_session_table_init(udp_session_table_t* table, size_t capacity);
+
+/**
+ * @brief Release a session table (clients are not touched)
+ *
+ * @param table Session table
+ */
+void udp_session_table_free(udp_session_table_t* table);
+
+/**
+ * @brief Find the client for a source address and refresh its idle timer
+ *
+ * @param table Session table
+ * @param addr Source address
+ * @param now_ms Current time from udp_session_now_ms()
+ * @return client_t* Client, or NULL if there is no session
+ */
+client_t* udp_session_table_lookup(udp_session_table_t* table, const struct sockaddr_in* addr, uint64_t now_ms);
+
+/**
+ * @brief Add a session, growing the table as needed
+ *
+ * @param table Session table
+ * @param addr Source address
+ * @param client Client for the address
+ * @param now_ms Current time from udp_session_now_ms()
+ * @return status_t STATUS_ERROR_ALREADY_EXISTS if the address has a session
+ */
+status_t udp_session_table_insert(udp_session_table_t* table, const struct sockaddr_in* addr, client_t* client, uint64_t now_ms);
+
+/**
+ * @brief Remove the session for a source address
+ *
+ * @param table Session table
+ * @param addr Source address
+ * @return client_t* Client of the removed session, or NULL if there was none
+ */
+client_t* udp_session_table_remove(udp_session_table_t* table, const struct sockaddr_in* addr);
+
+/**
+ * @brief Remove sessions idle for at least idle_ms
+ *
+ * @param table Session table
+ * @param now_ms Current time from udp_session_now_ms()
+ * @param idle_ms Idle time before a session expires (0 = remove every session)
+ * @param on_expired Called with the client of each removed session (may be NULL)
+ * @param arg Passed through to on_expired
+ * @return size_t Number of sessions removed
+ */
+size_t udp_session_table_expire(udp_session_table_t* table, uint64_t now_ms, uint64_t idle_ms,
+                                void (*on_expired)(client_t* client, void* arg), void* arg);
+
+/**
+ * @brief Get the monotonic time used for session idle timers
+ *
+ * @return uint64_t Milliseconds
+ */
+uint64_t udp_session_now_ms(void);
+
+#endif /* DINOC_UDP_SESSIONS_H */
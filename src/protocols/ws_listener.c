@@ -9,7 +9,9 @@
 #include "../include/common.h"
 #include "../include/client.h"
 #include "../common/uuid.h"
+#include "../common/timing_wheel.h"
 #include "protocol_fragmentation.h"
+#include "admission.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -20,15 +22,81 @@
 // Heartbeat magic number
 #define HEARTBEAT_MAGIC 0x48454152  // "HEAR"
 
-// WebSocket listener context
+// Send buffers
+#define WS_FRAME_POOL_SIZE 4096                          // Payload bytes of a pooled send buffer
+#define WS_FRAME_POOL_PREALLOC 64                        // Pooled send buffers allocated up front
+#define WS_FRAME_POOL_MAX 1024                           // Most idle send buffers kept for reuse
+#define WS_SEND_DEFAULT_HIGH_WATER (4 * 1024 * 1024)     // Queued outbound bytes before sends are refused
+
+// permessage-deflate
+#define WS_DEFLATE_EXTENSION "permessage-deflate"
+#define WS_DEFLATE_DEFAULT_WINDOW_BITS 15                // zlib defaults
+#define WS_DEFLATE_DEFAULT_MEM_LEVEL 8
+
+// Queued outbound message, payload preceded by the LWS_PRE bytes lws_write needs
+typedef struct ws_frame {
+    struct ws_frame* next;           // Next frame in the queue or pool
+    size_t len;                      // Payload length
+    size_t capacity;                 // Payload capacity after the LWS_PRE padding
+    uint8_t buffer[];                // LWS_PRE padding followed by the payload
+} ws_frame_t;
+
+// Connection state shared with sending threads (client protocol context)
+typedef struct ws_connection {
+    struct lws* wsi;                 // Connection, only touched on its service thread
+    int tsi;                         // Service thread owning the connection
+    ws_frame_t* send_head;           // First queued frame
+    ws_frame_t* send_tail;           // Last queued frame
+    size_t send_queued;              // Queued payload bytes
+    bool write_pending;              // On its service thread's pending list
+    struct ws_connection* next_pending; // Next connection on the pending list
+    struct ws_listener_ctx* ctx;     // Listener, for the idle timer
+    timing_wheel_timer_t idle_timer; // Fires once per timeout, rearmed while the client is active
+    uint64_t last_activity_ms;       // Last receive, written on the service thread without a lock
+    bool idle_close;                 // Idle timeout hit, closed by the next writeable callback
+} ws_connection_t;
+
+// Service thread
 typedef struct {
+    pthread_t thread;                // Thread running lws_service_tsi
+    struct ws_listener_ctx* ctx;     // Listener
+    int tsi;                         // Service thread index
+} ws_service_t;
+
+// WebSocket listener context
+typedef struct ws_listener_ctx {
+    protocol_listener_t base;        // Listener interface (must be first)
     struct lws_context* context;     // libwebsockets context
     struct lws_vhost* vhost;         // libwebsockets vhost
-    pthread_t listener_thread;       // Listener thread
     bool running;                    // Running flag
     char* bind_address;              // Bind address
     uint16_t port;                   // Port
-    uint32_t timeout_ms;             // Timeout in milliseconds
+    uint32_t timeout_ms;             // Idle time before a connection is closed (0 = never)
+    timing_wheel_t* timing_wheel;    // Shared idle timers, NULL when connections are never reaped
+    
+    // Service threads
+    uint32_t service_threads;        // Requested service threads (0 = one per core)
+    ws_service_t* services;          // Running service threads
+    size_t service_count;            // Number of running service threads
+    
+    // Send queues
+    pthread_mutex_t send_mutex;      // Protects the queues, pending lists and frame pool
+    ws_connection_t** pending;       // Per service thread connections waiting for a writeable callback
+    ws_frame_t* frame_pool;          // Idle WS_FRAME_POOL_SIZE send buffers
+    size_t frame_pool_count;         // Number of idle send buffers
+    size_t send_high_water;          // Queued bytes per connection before sends are refused
+    
+    // Compression
+    bool deflate;                    // Offer permessage-deflate
+    uint32_t deflate_window_bits;    // Server compression window (9-15)
+    uint32_t deflate_mem_level;      // zlib memory level (1-9)
+    uint64_t deflate_connections;    // Connections that negotiated permessage-deflate
+    uint64_t tx_bytes;               // Payload bytes written
+    uint64_t tx_deflate_in_bytes;    // Payload bytes written through the compressor
+    uint64_t tx_deflate_out_bytes;   // Compressed bytes those produced
+    uint64_t rx_bytes;               // Payload bytes received, after decompression
+    uint64_t rx_deflate_in_bytes;    // Compressed bytes received
+    uint64_t rx_deflate_out_bytes;   // Payload bytes those inflated to
     
     // Callbacks
     void (*on_message_received)(protocol_listener_t*, client_t*, protocol_message_t*);
@@ -52,12 +120,27 @@ typedef struct {
     size_t rx_buffer_capacity;       // Receive buffer capacity
 } ws_session_data_t;
 
+// Service thread index of the calling thread, callbacks run on the thread owning the connection
+static _Thread_local int ws_service_tsi = 0;
+
+// Compressed bytes produced by the lws_write in progress on this thread (-1 = not compressed)
+static _Thread_local int64_t ws_tx_deflated = -1;
+
 // Forward declarations
 static void* ws_listener_thread(void* arg);
+static ws_frame_t* ws_frame_alloc(ws_listener_ctx_t* ctx, size_t len);
+static void ws_frame_release(ws_listener_ctx_t* ctx, ws_frame_t* frame);
+static void ws_connection_close(ws_listener_ctx_t* ctx, ws_connection_t* conn);
+static void ws_request_writes(ws_listener_ctx_t* ctx, int tsi);
+static void ws_listener_stop_services(ws_listener_ctx_t* ctx, size_t started);
 static status_t ws_listener_start(protocol_listener_t* listener);
 static status_t ws_listener_stop(protocol_listener_t* listener);
 static status_t ws_listener_destroy(protocol_listener_t* listener);
 static status_t ws_listener_send_message(protocol_listener_t* listener, client_t* client, protocol_message_t* message);
+static status_t ws_listener_get_send_backlog(protocol_listener_t* listener, client_t* client, size_t* queued_bytes, bool* backed_up);
+static status_t ws_listener_get_stats(protocol_listener_t* listener, protocol_stat_t* stats, size_t* count);
+static status_t ws_listener_attach_timing_wheel(protocol_listener_t* listener, timing_wheel_t* wheel);
+static void ws_connection_idle_expired(timing_wheel_timer_t* timer, void* arg);
 static status_t ws_listener_register_callbacks(protocol_listener_t* listener,
                                              void (*on_message_received)(protocol_listener_t*, client_t*, protocol_message_t*),
                                              void (*on_client_connected)(protocol_listener_t*, client_t*),
@@ -79,6 +162,72 @@ static const struct lws_protocols ws_protocols[] = {
     { NULL, NULL, 0, 0, 0, NULL, 0 } // terminator
 };
 
+// permessage-deflate, wrapped to count bytes on both sides of the compressor
+static int ws_deflate_callback(struct lws_context* context, const struct lws_extension* ext, struct lws* wsi,
+                               enum lws_extension_callback_reasons reason, void* user, void* in, size_t len);
+
+static const struct lws_extension ws_extensions[] = {
+    {
+        WS_DEFLATE_EXTENSION,
+        ws_deflate_callback,
+        WS_DEFLATE_EXTENSION "; client_max_window_bits"
+    },
+    { NULL, NULL, NULL } // terminator
+};
+
+/**
+ * @brief permessage-deflate extension callback
+ *
+ * Hands everything to lws' implementation and records how many bytes went
+ * into and came out of zlib. Outbound counts are credited per message by
+ * the writeable callback, which knows the uncompressed length.
+ */
+static int ws_deflate_callback(struct lws_context* context, const struct lws_extension* ext, struct lws* wsi,
+                               enum lws_extension_callback_reasons reason, void* user, void* in, size_t len) {
+    ws_listener_ctx_t* ctx = (ws_listener_ctx_t*)lws_context_user(context);
+    struct lws_ext_pm_deflate_rx_ebufs* ebufs = (struct lws_ext_pm_deflate_rx_ebufs*)in;
+    int rx_in = 0;
+    
+    if (reason == LWS_EXT_CB_PAYLOAD_RX && ebufs != NULL) {
+        rx_in = ebufs->eb_in.len;
+    }
+    
+    int result = lws_extension_callback_pm_deflate(context, ext, wsi, reason, user, in, len);
+    
+    if (ctx == NULL || result < 0) {
+        return result;
+    }
+    
+    switch (reason) {
+        case LWS_EXT_CB_CONSTRUCT:
+            __atomic_add_fetch(&ctx->deflate_connections, 1, __ATOMIC_RELAXED);
+            break;
+        
+        case LWS_EXT_CB_PAYLOAD_TX:
+            // May run several times per message while lws drains the compressor
+            if (ebufs != NULL && ebufs->eb_out.len > 0) {
+                ws_tx_deflated = (ws_tx_deflated < 0 ? 0 : ws_tx_deflated) + ebufs->eb_out.len;
+            }
+            break;
+        
+        case LWS_EXT_CB_PAYLOAD_RX:
+            if (ebufs != NULL) {
+                if (rx_in > ebufs->eb_in.len) {
+                    __atomic_add_fetch(&ctx->rx_deflate_in_bytes, (uint64_t)(rx_in - ebufs->eb_in.len), __ATOMIC_RELAXED);
+                }
+                if (ebufs->eb_out.len > 0) {
+                    __atomic_add_fetch(&ctx->rx_deflate_out_bytes, (uint64_t)ebufs->eb_out.len, __ATOMIC_RELAXED);
+                }
+            }
+            break;
+        
+        default:
+            break;
+    }
+    
+    return result;
+}
+
 /**
  * @brief WebSocket callback function
  */
@@ -87,6 +236,13 @@ static int ws_callback(struct lws* wsi, enum lws_callback_reasons reason,
     ws_session_data_t* session = (ws_session_data_t*)user;
     
     switch (reason) {
+        case LWS_CALLBACK_FILTER_NETWORK_CONNECTION:
+            // Accepted socket, before the HTTP upgrade or any allocation; non-zero closes it
+            if (!admission_allow_socket((int)(intptr_t)in)) {
+                return -1;
+            }
+            break;
+        
         case LWS_CALLBACK_PROTOCOL_INIT:
             // Protocol initialization
             break;
@@ -105,27 +261,40 @@ static int ws_callback(struct lws* wsi, enum lws_callback_reasons reason,
                 }
                 
                 // Create protocol context
-                void* protocol_context = malloc(sizeof(struct lws*));
-                if (protocol_context == NULL) {
+                ws_connection_t* conn = (ws_connection_t*)malloc(sizeof(ws_connection_t));
+                if (conn == NULL) {
                     return -1;
                 }
                 
-                // Set protocol context
-                struct lws** wsi_ptr = (struct lws**)protocol_context;
-                *wsi_ptr = wsi;
+                memset(conn, 0, sizeof(ws_connection_t));
+                conn->wsi = wsi;
+                conn->tsi = ws_service_tsi;
+                conn->ctx = ctx;
+                conn->last_activity_ms = timing_wheel_now_ms();
+                timing_wheel_timer_init(&conn->idle_timer, ws_connection_idle_expired, conn);
                 
                 // Register client
                 client_t* client = NULL;
-                status_t status = client_register((protocol_listener_t*)ctx, protocol_context, &client);
+                status_t status = client_register((protocol_listener_t*)ctx, conn, &client);
                 
                 if (status != STATUS_SUCCESS) {
-                    free(protocol_context);
+                    free(conn);
                     return -1;
                 }
                 
                 // Update client state
                 client_update_state(client, CLIENT_STATE_CONNECTED);
                 
+                // Tune the compressor before its first use, the window can only shrink after negotiation
+                if (ctx->deflate) {
+                    char value[8];
+                    
+                    snprintf(value, sizeof(value), "%u", ctx->deflate_window_bits);
+                    lws_set_extension_option(wsi, WS_DEFLATE_EXTENSION, "server_max_window_bits", value);
+                    snprintf(value, sizeof(value), "%u", ctx->deflate_mem_level);
+                    lws_set_extension_option(wsi, WS_DEFLATE_EXTENSION, "mem_level", value);
+                }
+                
                 // Get client IP address
                 char client_ip[128];
                 lws_get_peer_simple(wsi, client_ip, sizeof(client_ip));
@@ -149,7 +318,7 @@ static int ws_callback(struct lws* wsi, enum lws_callback_reasons reason,
                     
                     if (new_clients == NULL) {
                         pthread_mutex_unlock(&ctx->clients_mutex);
-                        free(client);
+                        client_destroy(client);
                         return -1;
                     }
                     
@@ -160,6 +329,11 @@ static int ws_callback(struct lws* wsi, enum lws_callback_reasons reason,
                 ctx->clients[ctx->client_count++] = client;
                 pthread_mutex_unlock(&ctx->clients_mutex);
                 
+                // One timer per connection, receives only move a timestamp
+                if (ctx->timing_wheel != NULL && ctx->timeout_ms > 0) {
+                    timing_wheel_schedule(ctx->timing_wheel, &conn->idle_timer, ctx->timeout_ms);
+                }
+                
                 // Call client connected callback
                 if (ctx->on_client_connected != NULL) {
                     ctx->on_client_connected((protocol_listener_t*)ctx, client);
@@ -201,10 +375,15 @@ static int ws_callback(struct lws* wsi, enum lws_callback_reasons reason,
                 
                 pthread_mutex_unlock(&ctx->clients_mutex);
                 
-                // Free protocol context
-                if (session->client->protocol_context != NULL) {
-                    free(session->client->protocol_context);
-                    session->client->protocol_context = NULL;
+                // Detach the connection so senders stop queueing to it, then free it
+                pthread_mutex_lock(&ctx->send_mutex);
+                ws_connection_t* conn = (ws_connection_t*)session->client->protocol_context;
+                session->client->protocol_context = NULL;
+                pthread_mutex_unlock(&ctx->send_mutex);
+                
+                if (conn != NULL) {
+                    timing_wheel_cancel(ctx->timing_wheel, &conn->idle_timer);
+                    ws_connection_close(ctx, conn);
                 }
                 
                 session->client = NULL;
@@ -234,7 +413,14 @@ static int ws_callback(struct lws* wsi, enum lws_callback_reasons reason,
                 }
                 
                 // Update client last seen time
-                session->client->last_seen_time = time(NULL);
+                client_touch(session->client);
+                
+                // The connection is only freed on this thread
+                ws_connection_t* conn = (ws_connection_t*)session->client->protocol_context;
+                if (conn != NULL) {
+                    __atomic_store_n(&conn->last_activity_ms, timing_wheel_now_ms(), __ATOMIC_RELAXED);
+                }
+                __atomic_add_fetch(&ctx->rx_bytes, (uint64_t)len, __ATOMIC_RELAXED);
                 
                 // Check if this is a fragmented message
                 const size_t remaining = lws_remaining_packet_payload(wsi);
@@ -298,7 +484,79 @@ static int ws_callback(struct lws* wsi, enum lws_callback_reasons reason,
             break;
             
         case LWS_CALLBACK_SERVER_WRITEABLE:
-            // Ready to send data
+            // Ready to send data, one frame per callback
+            {
+                if (session == NULL || session->client == NULL || !session->established) {
+                    break;
+                }
+                
+                ws_listener_ctx_t* ctx = (ws_listener_ctx_t*)lws_get_vhost_user(lws_get_vhost(wsi));
+                if (ctx == NULL) {
+                    break;
+                }
+                
+                // The connection is only freed on this thread, so it stays valid outside the lock
+                pthread_mutex_lock(&ctx->send_mutex);
+                
+                ws_connection_t* conn = (ws_connection_t*)session->client->protocol_context;
+                
+                // Idle timeout, let lws close the connection
+                if (conn != NULL && conn->idle_close) {
+                    pthread_mutex_unlock(&ctx->send_mutex);
+                    return -1;
+                }
+                
+                ws_frame_t* frame = conn != NULL ? conn->send_head : NULL;
+                
+                if (frame != NULL) {
+                    conn->send_head = frame->next;
+                    if (conn->send_head == NULL) {
+                        conn->send_tail = NULL;
+                    }
+                    conn->send_queued -= frame->len;
+                }
+                
+                pthread_mutex_unlock(&ctx->send_mutex);
+                
+                if (frame == NULL) {
+                    break;
+                }
+                
+                size_t frame_len = frame->len;
+                
+                ws_tx_deflated = -1;
+                int written = lws_write(wsi, frame->buffer + LWS_PRE, frame_len, LWS_WRITE_BINARY);
+                
+                __atomic_add_fetch(&ctx->tx_bytes, (uint64_t)frame_len, __ATOMIC_RELAXED);
+                if (ws_tx_deflated >= 0) {
+                    __atomic_add_fetch(&ctx->tx_deflate_in_bytes, (uint64_t)frame_len, __ATOMIC_RELAXED);
+                    __atomic_add_fetch(&ctx->tx_deflate_out_bytes, (uint64_t)ws_tx_deflated, __ATOMIC_RELAXED);
+                }
+                
+                pthread_mutex_lock(&ctx->send_mutex);
+                ws_frame_release(ctx, frame);
+                bool more = conn->send_head != NULL;
+                pthread_mutex_unlock(&ctx->send_mutex);
+                
+                // A short write means lws gave up on the connection
+                if (written < (int)frame_len) {
+                    return -1;
+                }
+                
+                if (more) {
+                    lws_callback_on_writable(wsi);
+                }
+            }
+            break;
+            
+        case LWS_CALLBACK_EVENT_WAIT_CANCELLED:
+            // Woken by a sender on another thread
+            {
+                ws_listener_ctx_t* ctx = (ws_listener_ctx_t*)lws_context_user(lws_get_context(wsi));
+                if (ctx != NULL) {
+                    ws_request_writes(ctx, ws_service_tsi);
+                }
+            }
             break;
             
         default:
@@ -309,20 +567,136 @@ static int ws_callback(struct lws* wsi, enum lws_callback_reasons reason,
 }
 
 /**
- * @brief WebSocket listener thread
+ * @brief WebSocket service thread, one per lws service thread index
  */
 static void* ws_listener_thread(void* arg) {
-    protocol_listener_t* listener = (protocol_listener_t*)arg;
-    ws_listener_ctx_t* ctx = (ws_listener_ctx_t*)listener;
+    ws_service_t* service = (ws_service_t*)arg;
+    ws_listener_ctx_t* ctx = service->ctx;
+    
+    ws_service_tsi = service->tsi;
     
     // Run event loop
     while (ctx->running) {
-        lws_service(ctx->context, 100);
+        lws_service_tsi(ctx->context, 100, service->tsi);
     }
     
     return NULL;
 }
 
+/**
+ * @brief Get a send buffer for len payload bytes, from the pool when it fits
+ */
+static ws_frame_t* ws_frame_alloc(ws_listener_ctx_t* ctx, size_t len) {
+    ws_frame_t* frame = NULL;
+    
+    if (len <= WS_FRAME_POOL_SIZE) {
+        pthread_mutex_lock(&ctx->send_mutex);
+        
+        frame = ctx->frame_pool;
+        if (frame != NULL) {
+            ctx->frame_pool = frame->next;
+            ctx->frame_pool_count--;
+        }
+        
+        pthread_mutex_unlock(&ctx->send_mutex);
+        
+        if (frame != NULL) {
+            frame->next = NULL;
+            return frame;
+        }
+    }
+    
+    size_t capacity = len > WS_FRAME_POOL_SIZE ? len : WS_FRAME_POOL_SIZE;
+    
+    frame = (ws_frame_t*)malloc(sizeof(ws_frame_t) + LWS_PRE + capacity);
+    if (frame == NULL) {
+        return NULL;
+    }
+    
+    memset(frame, 0, sizeof(ws_frame_t));
+    frame->capacity = capacity;
+    
+    return frame;
+}
+
+/**
+ * @brief Return a send buffer to the pool (caller holds send_mutex)
+ */
+static void ws_frame_release(ws_listener_ctx_t* ctx, ws_frame_t* frame) {
+    // Oversized buffers are one-offs, and the pool stops growing past WS_FRAME_POOL_MAX
+    if (frame->capacity != WS_FRAME_POOL_SIZE || ctx->frame_pool_count >= WS_FRAME_POOL_MAX) {
+        free(frame);
+        return;
+    }
+    
+    frame->len = 0;
+    frame->next = ctx->frame_pool;
+    ctx->frame_pool = frame;
+    ctx->frame_pool_count++;
+}
+
+/**
+ * @brief Drop a closed connection's queue and free it (on its service thread)
+ */
+static void ws_connection_close(ws_listener_ctx_t* ctx, ws_connection_t* conn) {
+    pthread_mutex_lock(&ctx->send_mutex);
+    
+    // Unlink from the pending list
+    if (conn->write_pending && ctx->pending != NULL) {
+        ws_connection_t** link = &ctx->pending[conn->tsi];
+        
+        while (*link != NULL && *link != conn) {
+            link = &(*link)->next_pending;
+        }
+        
+        if (*link == conn) {
+            *link = conn->next_pending;
+        }
+    }
+    
+    while (conn->send_head != NULL) {
+        ws_frame_t* frame = conn->send_head;
+        conn->send_head = frame->next;
+        ws_frame_release(ctx, frame);
+    }
+    
+    pthread_mutex_unlock(&ctx->send_mutex);
+    
+    free(conn);
+}
+
+/**
+ * @brief Ask for writeable callbacks on a service thread's connections with queued frames
+ *
+ * lws_callback_on_writable may only be called from the thread servicing
+ * the connection, so senders park connections on the owning thread's
+ * pending list and wake it with lws_cancel_service.
+ */
+static void ws_request_writes(ws_listener_ctx_t* ctx, int tsi) {
+    pthread_mutex_lock(&ctx->send_mutex);
+    
+    if (ctx->pending == NULL || tsi < 0 || (size_t)tsi >= ctx->service_count) {
+        pthread_mutex_unlock(&ctx->send_mutex);
+        return;
+    }
+    
+    ws_connection_t* conn = ctx->pending[tsi];
+    ctx->pending[tsi] = NULL;
+    
+    // Connections are only freed on this thread, so the list is stable once detached
+    while (conn != NULL) {
+        ws_connection_t* next = conn->next_pending;
+        
+        conn->write_pending = false;
+        conn->next_pending = NULL;
+        lws_callback_on_writable(conn->wsi);
+        
+        conn = next;
+    }
+    
+    pthread_mutex_unlock(&ctx->send_mutex);
+}
+
 /**
  * @brief Create a WebSocket protocol listener
  */
@@ -336,6 +710,12 @@ status_t ws_listener_create(const protocol_listener_config_t* config, protocol_l
         return STATUS_ERROR_INVALID_PARAM;
     }
     
+    // zlib's raw deflate needs at least a 512 byte window (0 = default)
+    if ((config->ws_deflate_window_bits != 0 && (config->ws_deflate_window_bits < 9 || config->ws_deflate_window_bits > 15)) ||
+        config->ws_deflate_mem_level > 9) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
+    
     // Create listener context
     ws_listener_ctx_t* ctx = (ws_listener_ctx_t*)malloc(sizeof(ws_listener_ctx_t));
     if (ctx == NULL) {
@@ -348,6 +728,11 @@ status_t ws_listener_create(const protocol_listener_config_t* config, protocol_l
     // Copy config
     ctx->port = config->port;
     ctx->timeout_ms = config->timeout_ms;
+    ctx->service_threads = config->loop_threads;
+    ctx->send_high_water = config->send_high_water > 0 ? config->send_high_water : WS_SEND_DEFAULT_HIGH_WATER;
+    ctx->deflate = config->ws_deflate;
+    ctx->deflate_window_bits = config->ws_deflate_window_bits > 0 ? config->ws_deflate_window_bits : WS_DEFLATE_DEFAULT_WINDOW_BITS;
+    ctx->deflate_mem_level = config->ws_deflate_mem_level > 0 ? config->ws_deflate_mem_level : WS_DEFLATE_DEFAULT_MEM_LEVEL;
     
     if (config->bind_address != NULL) {
         ctx->bind_address = strdup(config->bind_address);
@@ -370,8 +755,19 @@ status_t ws_listener_create(const protocol_listener_config_t* config, protocol_l
         return STATUS_ERROR_MEMORY;
     }
     
-    // Initialize mutex
+    // Initialize mutexes
     pthread_mutex_init(&ctx->clients_mutex, NULL);
+    pthread_mutex_init(&ctx->send_mutex, NULL);
+    
+    // Preallocate send buffers so steady-state sends do not hit malloc
+    for (size_t i = 0; i < WS_FRAME_POOL_PREALLOC; i++) {
+        ws_frame_t* frame = ws_frame_alloc(ctx, WS_FRAME_POOL_SIZE);
+        if (frame == NULL) {
+            break;
+        }
+        
+        ws_frame_release(ctx, frame);
+    }
     
     // Set function pointers
     protocol_listener_t* base = (protocol_listener_t*)ctx;
@@ -379,6 +775,9 @@ status_t ws_listener_create(const protocol_listener_config_t* config, protocol_l
     base->stop = ws_listener_stop;
     base->destroy = ws_listener_destroy;
     base->send_message = ws_listener_send_message;
+    base->get_send_backlog = ws_listener_get_send_backlog;
+    base->get_stats = ws_listener_get_stats;
+    base->attach_timing_wheel = ws_listener_attach_timing_wheel;
     base->register_callbacks = ws_listener_register_callbacks;
     
     // Set protocol type
@@ -417,16 +816,45 @@ static status_t ws_listener_start(protocol_listener_t* listener) {
     info.options = LWS_SERVER_OPTION_HTTP_HEADERS_SECURITY_BEST_PRACTICES_ENFORCE;
     info.user = ctx;
     
+    if (ctx->deflate) {
+        info.extensions = ws_extensions;
+    }
+    
+    // One service thread per core unless configured, lws caps it at LWS_MAX_SMP
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    info.count_threads = ctx->service_threads > 0 ? ctx->service_threads : (cores > 0 ? (unsigned int)cores : 1);
+    
     ctx->context = lws_create_context(&info);
     if (ctx->context == NULL) {
         return STATUS_ERROR_GENERIC;
     }
     
+    size_t service_count = (size_t)lws_get_count_threads(ctx->context);
+    if (service_count == 0) {
+        service_count = 1;
+    }
+    
+    ctx->services = (ws_service_t*)calloc(service_count, sizeof(ws_service_t));
+    ws_connection_t** pending = (ws_connection_t**)calloc(service_count, sizeof(ws_connection_t*));
+    
+    if (ctx->services == NULL || pending == NULL) {
+        free(ctx->services);
+        free(pending);
+        ctx->services = NULL;
+        lws_context_destroy(ctx->context);
+        ctx->context = NULL;
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    pthread_mutex_lock(&ctx->send_mutex);
+    ctx->pending = pending;
+    ctx->service_count = service_count;
+    pthread_mutex_unlock(&ctx->send_mutex);
+    
     // Get vhost
     ctx->vhost = lws_get_vhost_by_name(ctx->context, "dinoc-server");
     if (ctx->vhost == NULL) {
-        lws_context_destroy(ctx->context);
-        ctx->context = NULL;
+        ws_listener_stop_services(ctx, 0);
         return STATUS_ERROR_GENERIC;
     }
     
@@ -437,17 +865,48 @@ static status_t ws_listener_start(protocol_listener_t* listener) {
     // Set running flag
     ctx->running = true;
     
-    // Create listener thread
-    if (pthread_create(&ctx->listener_thread, NULL, ws_listener_thread, listener) != 0) {
-        lws_context_destroy(ctx->context);
-        ctx->context = NULL;
-        ctx->running = false;
-        return STATUS_ERROR_GENERIC;
+    // Create service threads
+    for (size_t i = 0; i < ctx->service_count; i++) {
+        ctx->services[i].ctx = ctx;
+        ctx->services[i].tsi = (int)i;
+        
+        if (pthread_create(&ctx->services[i].thread, NULL, ws_listener_thread, &ctx->services[i]) != 0) {
+            ctx->running = false;
+            ws_listener_stop_services(ctx, i);
+            return STATUS_ERROR_THREAD;
+        }
     }
     
     return STATUS_SUCCESS;
 }
 
+/**
+ * @brief Join the first started service threads and tear down the lws context
+ */
+static void ws_listener_stop_services(ws_listener_ctx_t* ctx, size_t started) {
+    // Wake threads blocked in lws_service_tsi so they see running == false
+    if (started > 0) {
+        lws_cancel_service(ctx->context);
+    }
+    
+    for (size_t i = 0; i < started; i++) {
+        pthread_join(ctx->services[i].thread, NULL);
+    }
+    
+    // Closing connections still uses the pending lists, free them afterwards
+    lws_context_destroy(ctx->context);
+    ctx->context = NULL;
+    
+    pthread_mutex_lock(&ctx->send_mutex);
+    free(ctx->pending);
+    ctx->pending = NULL;
+    ctx->service_count = 0;
+    pthread_mutex_unlock(&ctx->send_mutex);
+    
+    free(ctx->services);
+    ctx->services = NULL;
+}
+
 /**
  * @brief Stop WebSocket listener
  */
@@ -466,14 +925,8 @@ static status_t ws_listener_stop(protocol_listener_t* listener) {
     // Set running flag
     ctx->running = false;
     
-    // Wait for listener thread to exit
-    pthread_join(ctx->listener_thread, NULL);
-    
-    // Destroy libwebsockets context
-    if (ctx->context != NULL) {
-        lws_context_destroy(ctx->context);
-        ctx->context = NULL;
-    }
+    // Wait for the service threads and destroy the libwebsockets context
+    ws_listener_stop_services(ctx, ctx->service_count);
     
     return STATUS_SUCCESS;
 }
@@ -497,13 +950,22 @@ static status_t ws_listener_destroy(protocol_listener_t* listener) {
     pthread_mutex_lock(&ctx->clients_mutex);
     
     for (size_t i = 0; i < ctx->client_count; i++) {
-        free(ctx->clients[i]);
+        client_destroy(ctx->clients[i]);
     }
     
     free(ctx->clients);
     pthread_mutex_unlock(&ctx->clients_mutex);
     pthread_mutex_destroy(&ctx->clients_mutex);
     
+    // Free pooled send buffers
+    while (ctx->frame_pool != NULL) {
+        ws_frame_t* frame = ctx->frame_pool;
+        ctx->frame_pool = frame->next;
+        free(frame);
+    }
+    
+    pthread_mutex_destroy(&ctx->send_mutex);
+    
     // Free bind address
     if (ctx->bind_address != NULL) {
         free(ctx->bind_address);
@@ -517,6 +979,11 @@ static status_t ws_listener_destroy(protocol_listener_t* listener) {
 
 /**
  * @brief Send message to WebSocket client
+ *
+ * Safe from any thread: the message is copied into an LWS_PRE-padded
+ * buffer and queued, and the connection's service thread writes it from
+ * its writeable callback. Returns STATUS_ERROR_WOULD_BLOCK while the
+ * queue is at the listener's high-water mark.
  */
 static status_t ws_listener_send_message(protocol_listener_t* listener, client_t* client, protocol_message_t* message) {
     if (listener == NULL || client == NULL || message == NULL || message->data == NULL || message->data_len == 0) {
@@ -530,35 +997,178 @@ static status_t ws_listener_send_message(protocol_listener_t* listener, client_t
         return STATUS_ERROR_NOT_RUNNING;
     }
     
-    // Get WebSocket connection from protocol context
-    if (client->protocol_context == NULL) {
+    // Copy outside the lock
+    ws_frame_t* frame = ws_frame_alloc(ctx, message->data_len);
+    if (frame == NULL) {
+        return STATUS_ERROR_MEMORY;
+    }
+    
+    memcpy(frame->buffer + LWS_PRE, message->data, message->data_len);
+    frame->len = message->data_len;
+    
+    pthread_mutex_lock(&ctx->send_mutex);
+    
+    // Cleared under the lock when the connection closes
+    ws_connection_t* conn = (ws_connection_t*)client->protocol_context;
+    if (conn == NULL || ctx->pending == NULL) {
+        ws_frame_release(ctx, frame);
+        pthread_mutex_unlock(&ctx->send_mutex);
+        return STATUS_ERROR_NOT_CONNECTED;
+    }
+    
+    // Client is not draining its connection, let the caller back off
+    if (conn->send_queued >= ctx->send_high_water) {
+        ws_frame_release(ctx, frame);
+        pthread_mutex_unlock(&ctx->send_mutex);
+        return STATUS_ERROR_WOULD_BLOCK;
+    }
+    
+    if (conn->send_tail != NULL) {
+        conn->send_tail->next = frame;
+    } else {
+        conn->send_head = frame;
+    }
+    conn->send_tail = frame;
+    conn->send_queued += frame->len;
+    
+    // Park the connection for its service thread, once per wakeup
+    bool wake = false;
+    if (!conn->write_pending) {
+        conn->write_pending = true;
+        conn->next_pending = ctx->pending[conn->tsi];
+        ctx->pending[conn->tsi] = conn;
+        wake = true;
+    }
+    
+    pthread_mutex_unlock(&ctx->send_mutex);
+    
+    if (wake) {
+        lws_cancel_service(ctx->context);
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Close connections idle for the listener timeout using a shared timing wheel
+ */
+static status_t ws_listener_attach_timing_wheel(protocol_listener_t* listener, timing_wheel_t* wheel) {
+    if (listener == NULL) {
         return STATUS_ERROR_INVALID_PARAM;
     }
     
-    struct lws* wsi = *((struct lws**)client->protocol_context);
-    if (wsi == NULL) {
+    ws_listener_ctx_t* ctx = (ws_listener_ctx_t*)listener;
+    
+    if (ctx->running) {
+        return STATUS_ERROR_ALREADY_RUNNING;
+    }
+    
+    ctx->timing_wheel = wheel;
+    
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Idle timer expiry (timing wheel thread)
+ * 
+ * A connection that received since the timer was armed gets it rearmed for
+ * the rest of its timeout. An idle one is flagged and parked for a
+ * writeable callback, since only its service thread may close it.
+ */
+static void ws_connection_idle_expired(timing_wheel_timer_t* timer, void* arg) {
+    ws_connection_t* conn = (ws_connection_t*)arg;
+    ws_listener_ctx_t* ctx = conn->ctx;
+    
+    // A receive racing with this check may stamp a time after now_ms
+    uint64_t last_activity_ms = __atomic_load_n(&conn->last_activity_ms, __ATOMIC_RELAXED);
+    uint64_t now_ms = timing_wheel_now_ms();
+    uint64_t idle_ms = now_ms > last_activity_ms ? now_ms - last_activity_ms : 0;
+    
+    if (idle_ms < ctx->timeout_ms) {
+        timing_wheel_schedule(ctx->timing_wheel, timer, ctx->timeout_ms - idle_ms);
+        return;
+    }
+    
+    pthread_mutex_lock(&ctx->send_mutex);
+    
+    if (ctx->pending == NULL) {
+        pthread_mutex_unlock(&ctx->send_mutex);
+        return;
+    }
+    
+    conn->idle_close = true;
+    
+    if (!conn->write_pending) {
+        conn->write_pending = true;
+        conn->next_pending = ctx->pending[conn->tsi];
+        ctx->pending[conn->tsi] = conn;
+    }
+    
+    pthread_mutex_unlock(&ctx->send_mutex);
+    
+    lws_cancel_service(ctx->context);
+}
+
+/**
+ * @brief Get the outbound bytes queued for a client
+ */
+static status_t ws_listener_get_send_backlog(protocol_listener_t* listener, client_t* client, size_t* queued_bytes, bool* backed_up) {
+    if (listener == NULL || client == NULL) {
         return STATUS_ERROR_INVALID_PARAM;
     }
     
-    // Allocate buffer with LWS_PRE bytes at the beginning
-    uint8_t* buffer = (uint8_t*)malloc(LWS_PRE + message->data_len);
-    if (buffer == NULL) {
-        return STATUS_ERROR_MEMORY;
+    ws_listener_ctx_t* ctx = (ws_listener_ctx_t*)listener;
+    
+    pthread_mutex_lock(&ctx->send_mutex);
+    
+    ws_connection_t* conn = (ws_connection_t*)client->protocol_context;
+    size_t queued = conn != NULL ? conn->send_queued : 0;
+    
+    pthread_mutex_unlock(&ctx->send_mutex);
+    
+    if (conn == NULL) {
+        return STATUS_ERROR_NOT_CONNECTED;
     }
     
-    // Copy message data
-    memcpy(buffer + LWS_PRE, message->data, message->data_len);
+    if (queued_bytes != NULL) {
+        *queued_bytes = queued;
+    }
     
-    // Send message
-    int result = lws_write(wsi, buffer + LWS_PRE, message->data_len, LWS_WRITE_BINARY);
+    if (backed_up != NULL) {
+        *backed_up = queued >= ctx->send_high_water;
+    }
     
-    // Free buffer
-    free(buffer);
+    return STATUS_SUCCESS;
+}
+
+/**
+ * @brief Report traffic and compression counters
+ */
+static status_t ws_listener_get_stats(protocol_listener_t* listener, protocol_stat_t* stats, size_t* count) {
+    if (listener == NULL || stats == NULL || count == NULL) {
+        return STATUS_ERROR_INVALID_PARAM;
+    }
     
-    if (result < 0) {
-        return STATUS_ERROR_GENERIC;
+    ws_listener_ctx_t* ctx = (ws_listener_ctx_t*)listener;
+    
+    protocol_stat_t values[] = {
+        { "tx_bytes", __atomic_load_n(&ctx->tx_bytes, __ATOMIC_RELAXED) },
+        { "rx_bytes", __atomic_load_n(&ctx->rx_bytes, __ATOMIC_RELAXED) },
+        { "deflate_connections", __atomic_load_n(&ctx->deflate_connections, __ATOMIC_RELAXED) },
+        { "tx_deflate_in_bytes", __atomic_load_n(&ctx->tx_deflate_in_bytes, __ATOMIC_RELAXED) },
+        { "tx_deflate_out_bytes", __atomic_load_n(&ctx->tx_deflate_out_bytes, __ATOMIC_RELAXED) },
+        { "rx_deflate_in_bytes", __atomic_load_n(&ctx->rx_deflate_in_bytes, __ATOMIC_RELAXED) },
+        { "rx_deflate_out_bytes", __atomic_load_n(&ctx->rx_deflate_out_bytes, __ATOMIC_RELAXED) },
+    };
+    
+    size_t n = sizeof(values) / sizeof(values[0]);
+    if (n > *count) {
+        n = *count;
     }
     
+    memcpy(stats, values, n * sizeof(protocol_stat_t));
+    *count = n;
+    
     return STATUS_SUCCESS;
 }
 
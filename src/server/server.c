@@ -11,9 +11,11 @@
 #include "../include/task.h"
 #include "../include/module.h"
 #include "../include/console.h"
+#include "../include/api.h"
 #include "../common/logger.h"
 #include "../common/config.h"
 #include "../common/uuid.h"
+#include "../protocols/admission.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -62,6 +64,24 @@ status_t server_init(const server_config_t* config) {
         return status;
     }
     
+    // Listeners created below are served by the reactor's loops
+    if (server_config.reactor_threads > 0) {
+        status = protocol_manager_start_reactor(server_config.reactor_threads);
+        if (status != STATUS_SUCCESS) {
+            protocol_manager_shutdown();
+            logger_shutdown();
+            return status;
+        }
+    }
+    
+    // Every listener checks these limits before registering a client
+    admission_config_t admission_config;
+    admission_config.rate = server_config.admission_rate;
+    admission_config.burst = server_config.admission_burst;
+    admission_config.subnet_rate = server_config.admission_subnet_rate;
+    admission_config.subnet_burst = server_config.admission_subnet_burst;
+    admission_configure(&admission_config);
+    
     status = client_manager_init();
     if (status != STATUS_SUCCESS) {
         protocol_manager_shutdown();
@@ -129,6 +149,12 @@ status_t server_start(void) {
         memset(&config, 0, sizeof(config));
         config.bind_address = server_config.bind_address;
         config.port = server_config.tcp_port;
+        config.io_model = server_config.tcp_io_model;
+        config.loop_threads = server_config.tcp_loop_threads;
+        config.acceptor_shards = server_config.tcp_acceptor_shards;
+        config.max_message_size = server_config.tcp_max_message_size;
+        config.send_high_water = server_config.tcp_send_high_water;
+        config.timeout_ms = server_config.idle_timeout_ms;
         
         LOG_INFO("Creating TCP listener on %s:%d", config.bind_address, config.port);
         fprintf(stderr, "Creating TCP listener on %s:%d\n", config.bind_address, config.port);
@@ -156,6 +182,8 @@ status_t server_start(void) {
         memset(&config, 0, sizeof(config));
         config.bind_address = server_config.bind_address;
         config.port = server_config.udp_port;
+        config.workers = server_config.udp_workers;
+        config.socket_filter = server_config.udp_socket_filter;
         
         LOG_INFO("Creating UDP listener on %s:%d", config.bind_address, config.port);
         fprintf(stderr, "Creating UDP listener on %s:%d\n", config.bind_address, config.port);
@@ -184,6 +212,11 @@ status_t server_start(void) {
         config.bind_address = server_config.bind_address;
         config.port = server_config.ws_port;
         config.ws_path = "/";
+        config.loop_threads = server_config.ws_service_threads;
+        config.ws_deflate = server_config.ws_deflate;
+        config.ws_deflate_window_bits = server_config.ws_deflate_window_bits;
+        config.ws_deflate_mem_level = server_config.ws_deflate_mem_level;
+        config.timeout_ms = server_config.idle_timeout_ms;
         
         LOG_INFO("Creating WebSocket listener on %s:%d", config.bind_address, config.port);
         fprintf(stderr, "Creating WebSocket listener on %s:%d\n", config.bind_address, config.port);
@@ -210,6 +243,8 @@ status_t server_start(void) {
     if (server_config.enable_icmp) {
         memset(&config, 0, sizeof(config));
         config.pcap_device = server_config.pcap_device;
+        config.capture_backend = server_config.icmp_capture;
+        config.socket_filter = server_config.icmp_socket_filter;
         
         LOG_INFO("Creating ICMP listener on device %s", config.pcap_device);
         fprintf(stderr, "Creating ICMP listener on device %s\n", config.pcap_device);
@@ -262,10 +297,24 @@ status_t server_start(void) {
     
     // Start HTTP API server
     if (server_config.enable_http_api) {
-        status = http_server_start(server_config.bind_address, server_config.http_api_port);
+        status = http_server_init(server_config.bind_address, server_config.http_api_port);
+        if (status == STATUS_SUCCESS) {
+            status = http_server_start();
+        }
+        
         if (status != STATUS_SUCCESS) {
             LOG_ERROR("Failed to start HTTP API server");
             fprintf(stderr, "Failed to start HTTP API server\n");
+            http_server_shutdown();
+            return status;
+        }
+        
+        // Listener counters and admission rejections
+        status = register_listener_api_handlers();
+        if (status != STATUS_SUCCESS) {
+            LOG_ERROR("Failed to register listener API handlers: %d", status);
+            fprintf(stderr, "Failed to register listener API handlers: %d\n", status);
+            http_server_shutdown();
             return status;
         }
         
@@ -317,8 +366,8 @@ status_t server_stop(void) {
     
     // Stop HTTP API if enabled
     if (server_config.enable_http_api) {
-        // TODO: Implement HTTP API
-        LOG_INFO("HTTP API not implemented yet");
+        http_server_shutdown();
+        LOG_INFO("HTTP API server stopped");
     }
     
     // Stop protocol listeners
@@ -595,18 +644,149 @@ status_t server_load_config(const char* config_file, server_config_t* config) {
         config->tcp_port = (uint16_t)tcp_port;
     }
     
+    char tcp_io_model[32] = {0};
+    status = config_get_string("tcp_io_model", tcp_io_model, sizeof(tcp_io_model));
+    if (status == STATUS_SUCCESS && tcp_io_model[0] != '\0') {
+        if (strcmp(tcp_io_model, "epoll") == 0) {
+            config->tcp_io_model = PROTOCOL_IO_MODEL_EPOLL;
+        } else if (strcmp(tcp_io_model, "uring") == 0) {
+            config->tcp_io_model = PROTOCOL_IO_MODEL_URING;
+        } else if (strcmp(tcp_io_model, "thread") == 0) {
+            config->tcp_io_model = PROTOCOL_IO_MODEL_THREAD;
+        } else {
+            LOG_WARN("Unknown tcp_io_model '%s', using thread model", tcp_io_model);
+            config->tcp_io_model = PROTOCOL_IO_MODEL_THREAD;
+        }
+    }
+    
+    int64_t tcp_loop_threads = 0;
+    status = config_get_int("tcp_loop_threads", &tcp_loop_threads);
+    if (status == STATUS_SUCCESS && tcp_loop_threads >= 0) {
+        config->tcp_loop_threads = (uint32_t)tcp_loop_threads;
+    }
+    
+    int64_t tcp_acceptor_shards = 0;
+    status = config_get_int("tcp_acceptor_shards", &tcp_acceptor_shards);
+    if (status == STATUS_SUCCESS) {
+        if (tcp_acceptor_shards < 0) {
+            long cores = sysconf(_SC_NPROCESSORS_ONLN);
+            tcp_acceptor_shards = cores > 0 ? cores : 1;
+        }
+        config->tcp_acceptor_shards = (uint32_t)tcp_acceptor_shards;
+    }
+    
+    int64_t tcp_max_message_size = 0;
+    status = config_get_int("tcp_max_message_size", &tcp_max_message_size);
+    if (status == STATUS_SUCCESS && tcp_max_message_size > 0 && tcp_max_message_size <= UINT32_MAX) {
+        config->tcp_max_message_size = (uint32_t)tcp_max_message_size;
+    }
+    
+    int64_t tcp_send_high_water = 0;
+    status = config_get_int("tcp_send_high_water", &tcp_send_high_water);
+    if (status == STATUS_SUCCESS && tcp_send_high_water > 0 && tcp_send_high_water <= UINT32_MAX) {
+        config->tcp_send_high_water = (uint32_t)tcp_send_high_water;
+    }
+    
+    int64_t reactor_threads = 0;
+    status = config_get_int("reactor_threads", &reactor_threads);
+    if (status == STATUS_SUCCESS) {
+        if (reactor_threads < 0) {
+            long cores = sysconf(_SC_NPROCESSORS_ONLN);
+            reactor_threads = cores > 0 ? cores : 1;
+        }
+        config->reactor_threads = (uint32_t)reactor_threads;
+    }
+    
+    int64_t admission_rate = 0;
+    status = config_get_int("admission_rate", &admission_rate);
+    if (status == STATUS_SUCCESS && admission_rate >= 0 && admission_rate <= UINT32_MAX) {
+        config->admission_rate = (uint32_t)admission_rate;
+    }
+    
+    int64_t admission_burst = 0;
+    status = config_get_int("admission_burst", &admission_burst);
+    if (status == STATUS_SUCCESS && admission_burst >= 0 && admission_burst <= UINT32_MAX) {
+        config->admission_burst = (uint32_t)admission_burst;
+    }
+    
+    int64_t admission_subnet_rate = 0;
+    status = config_get_int("admission_subnet_rate", &admission_subnet_rate);
+    if (status == STATUS_SUCCESS && admission_subnet_rate >= 0 && admission_subnet_rate <= UINT32_MAX) {
+        config->admission_subnet_rate = (uint32_t)admission_subnet_rate;
+    }
+    
+    int64_t admission_subnet_burst = 0;
+    status = config_get_int("admission_subnet_burst", &admission_subnet_burst);
+    if (status == STATUS_SUCCESS && admission_subnet_burst >= 0 && admission_subnet_burst <= UINT32_MAX) {
+        config->admission_subnet_burst = (uint32_t)admission_subnet_burst;
+    }
+    
+    int64_t idle_timeout_ms = 0;
+    status = config_get_int("idle_timeout_ms", &idle_timeout_ms);
+    if (status == STATUS_SUCCESS && idle_timeout_ms >= 0 && idle_timeout_ms <= UINT32_MAX) {
+        config->idle_timeout_ms = (uint32_t)idle_timeout_ms;
+    }
+    
     int64_t udp_port = 0;
     status = config_get_int("udp_port", &udp_port);
     if (status == STATUS_SUCCESS && udp_port > 0) {
         config->udp_port = (uint16_t)udp_port;
     }
     
+    int64_t udp_workers = 0;
+    status = config_get_int("udp_workers", &udp_workers);
+    if (status == STATUS_SUCCESS) {
+        if (udp_workers < 0) {
+            long cores = sysconf(_SC_NPROCESSORS_ONLN);
+            udp_workers = cores > 0 ? cores : 1;
+        }
+        config->udp_workers = (uint32_t)udp_workers;
+    }
+    
+    bool udp_socket_filter = false;
+    status = config_get_bool("udp_socket_filter", &udp_socket_filter);
+    if (status == STATUS_SUCCESS) {
+        config->udp_socket_filter = udp_socket_filter;
+    }
+    
     int64_t ws_port = 0;
     status = config_get_int("ws_port", &ws_port);
     if (status == STATUS_SUCCESS && ws_port > 0) {
         config->ws_port = (uint16_t)ws_port;
     }
     
+    int64_t ws_service_threads = 0;
+    status = config_get_int("ws_service_threads", &ws_service_threads);
+    if (status == STATUS_SUCCESS && ws_service_threads >= 0) {
+        config->ws_service_threads = (uint32_t)ws_service_threads;
+    }
+    
+    bool ws_deflate = false;
+    status = config_get_bool("ws_deflate", &ws_deflate);
+    if (status == STATUS_SUCCESS) {
+        config->ws_deflate = ws_deflate;
+    }
+    
+    int64_t ws_deflate_window_bits = 0;
+    status = config_get_int("ws_deflate_window_bits", &ws_deflate_window_bits);
+    if (status == STATUS_SUCCESS) {
+        if (ws_deflate_window_bits >= 9 && ws_deflate_window_bits <= 15) {
+            config->ws_deflate_window_bits = (uint32_t)ws_deflate_window_bits;
+        } else {
+            LOG_WARN("ws_deflate_window_bits must be between 9 and 15, using the default");
+        }
+    }
+    
+    int64_t ws_deflate_mem_level = 0;
+    status = config_get_int("ws_deflate_mem_level", &ws_deflate_mem_level);
+    if (status == STATUS_SUCCESS) {
+        if (ws_deflate_mem_level >= 1 && ws_deflate_mem_level <= 9) {
+            config->ws_deflate_mem_level = (uint32_t)ws_deflate_mem_level;
+        } else {
+            LOG_WARN("ws_deflate_mem_level must be between 1 and 9, using the default");
+        }
+    }
+    
     int64_t dns_port = 0;
     status = config_get_int("dns_port", &dns_port);
     if (status == STATUS_SUCCESS && dns_port > 0) {
@@ -631,6 +811,25 @@ status_t server_load_config(const char* config_file, server_config_t* config) {
         config->pcap_device = strdup(pcap_device);
     }
     
+    char icmp_capture[32] = {0};
+    status = config_get_string("icmp_capture", icmp_capture, sizeof(icmp_capture));
+    if (status == STATUS_SUCCESS && icmp_capture[0] != '\0') {
+        if (strcmp(icmp_capture, "ring") == 0) {
+            config->icmp_capture = PROTOCOL_CAPTURE_RING;
+        } else if (strcmp(icmp_capture, "pcap") == 0) {
+            config->icmp_capture = PROTOCOL_CAPTURE_PCAP;
+        } else {
+            LOG_WARN("Unknown icmp_capture '%s', using pcap", icmp_capture);
+            config->icmp_capture = PROTOCOL_CAPTURE_PCAP;
+        }
+    }
+    
+    bool icmp_socket_filter = false;
+    status = config_get_bool("icmp_socket_filter", &icmp_socket_filter);
+    if (status == STATUS_SUCCESS) {
+        config->icmp_socket_filter = icmp_socket_filter;
+    }
+    
     int64_t http_api_port = 0;
     status = config_get_int("http_api_port", &http_api_port);
     if (status == STATUS_SUCCESS && http_api_port > 0) {
@@ -11,6 +11,7 @@
 #include <string.h>
 #include <pthread.h>
 #include <unistd.h>
+#include <time.h>
 
 // Task manager structure
 typedef struct {
@@ -19,6 +20,7 @@ typedef struct {
     size_t task_capacity;           // Capacity of tasks array
     pthread_mutex_t mutex;          // Mutex for thread safety
     pthread_t timeout_thread;       // Thread for checking timeouts
+    pthread_cond_t wakeup;          // Wakes the timeout thread for new deadlines and shutdown
     bool running;                   // Running flag
 } task_manager_t;
 
@@ -27,6 +29,7 @@ static task_manager_t* global_manager = NULL;
 
 // Forward declaration for the timeout thread function
 static void* task_timeout_thread(void* arg);
+static time_t task_deadline(const task_t* task);
 
 /**
  * @brief Initialize task manager
@@ -52,10 +55,12 @@ status_t task_manager_init(void) {
     }
     
     pthread_mutex_init(&global_manager->mutex, NULL);
+    pthread_cond_init(&global_manager->wakeup, NULL);
     global_manager->running = true;
     
     // Create timeout thread
     if (pthread_create(&global_manager->timeout_thread, NULL, task_timeout_thread, NULL) != 0) {
+        pthread_cond_destroy(&global_manager->wakeup);
         pthread_mutex_destroy(&global_manager->mutex);
         free(global_manager->tasks);
         free(global_manager);
@@ -74,7 +79,12 @@ status_t task_manager_shutdown(void) {
         return STATUS_ERROR_NOT_FOUND;
     }
     
+    // Wake the timeout thread so it sees the flag at once
+    pthread_mutex_lock(&global_manager->mutex);
     global_manager->running = false;
+    pthread_cond_signal(&global_manager->wakeup);
+    pthread_mutex_unlock(&global_manager->mutex);
+    
     pthread_join(global_manager->timeout_thread, NULL);
     
     pthread_mutex_lock(&global_manager->mutex);
@@ -86,6 +96,7 @@ status_t task_manager_shutdown(void) {
     
     free(global_manager->tasks);
     pthread_mutex_unlock(&global_manager->mutex);
+    pthread_cond_destroy(&global_manager->wakeup);
     pthread_mutex_destroy(&global_manager->mutex);
     
     free(global_manager);
@@ -157,6 +168,12 @@ status_t task_create(const uuid_t* client_id, task_type_t type,
     }
     
     global_manager->tasks[global_manager->task_count++] = new_task;
+    
+    // The new deadline may be earlier than the one the timeout thread waits for
+    if (new_task->timeout > 0) {
+        pthread_cond_signal(&global_manager->wakeup);
+    }
+    
     pthread_mutex_unlock(&global_manager->mutex);
     
     *task = new_task;
@@ -363,32 +380,69 @@ status_t task_get_for_client(const uuid_t* client_id, task_t*** tasks, size_t* c
     return STATUS_SUCCESS;
 }
 
+/**
+ * @brief First second at which task_is_timed_out holds, 0 for tasks that cannot time out
+ */
+static time_t task_deadline(const task_t* task) {
+    if (task->timeout == 0 ||
+        task->state == TASK_STATE_COMPLETED ||
+        task->state == TASK_STATE_FAILED ||
+        task->state == TASK_STATE_TIMEOUT) {
+        return 0;
+    }
+    
+    time_t start_time = task->sent_time > 0 ? task->sent_time : task->created_time;
+    
+    return start_time + (time_t)task->timeout + 1;
+}
+
 /**
  * @brief Task timeout thread
+ * 
+ * Sleeps until the earliest pending deadline, or indefinitely while no task
+ * can time out. task_create and shutdown wake it; deadlines that moved later
+ * (a task was sent) only cost an early wakeup.
  */
 static void* task_timeout_thread(void* arg) {
-    while (global_manager != NULL && global_manager->running) {
-        pthread_mutex_lock(&global_manager->mutex);
+    (void)arg;
+    
+    pthread_mutex_lock(&global_manager->mutex);
+    
+    while (global_manager->running) {
+        time_t now = time(NULL);
+        time_t next_deadline = 0;
         
-        // Check for timed out tasks
+        // Time out due tasks and find the next deadline
         for (size_t i = 0; i < global_manager->task_count; i++) {
             task_t* task = global_manager->tasks[i];
+            time_t deadline = task_deadline(task);
             
-            if (task->state != TASK_STATE_COMPLETED && 
-                task->state != TASK_STATE_FAILED &&
-                task->state != TASK_STATE_TIMEOUT &&
-                task_is_timed_out(task)) {
-                
+            if (deadline == 0) {
+                continue;
+            }
+            
+            if (task_is_timed_out(task)) {
                 task_update_state(task, TASK_STATE_TIMEOUT);
                 task_set_error(task, "Task timed out");
+                continue;
+            }
+            
+            if (next_deadline == 0 || deadline < next_deadline) {
+                next_deadline = deadline;
             }
         }
         
-        pthread_mutex_unlock(&global_manager->mutex);
-        
-        // Sleep for 1 second
-        sleep(1);
+        if (next_deadline == 0) {
+            pthread_cond_wait(&global_manager->wakeup, &global_manager->mutex);
+        } else {
+            struct timespec ts;
+            ts.tv_sec = next_deadline > now ? next_deadline : now + 1;
+            ts.tv_nsec = 0;
+            pthread_cond_timedwait(&global_manager->wakeup, &global_manager->mutex, &ts);
+        }
     }
     
+    pthread_mutex_unlock(&global_manager->mutex);
+    
     return NULL;
 }
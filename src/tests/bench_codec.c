@@ -0,0 +1,163 @@
+/**
+ * @file bench_codec.c
+ * @brief Microbenchmark of the hex and base32 codecs against the old TXT loops
+ */
+
+#include "../common/codec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Benchmark configuration
+#define BENCH_DATA_SIZE (64 * 1024)
+#define BENCH_ROUNDS 200
+#define BENCH_TXT_LENGTH 255
+
+// Keeps the optimiser from dropping the work
+static volatile uint8_t sink;
+
+/**
+ * @brief Get the monotonic time in seconds
+ */
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Former DNS TXT encoder: sprintf per byte into per-record heap strings
+ */
+static void legacy_encode(const uint8_t* data, size_t data_len) {
+    size_t record_count = (data_len + BENCH_TXT_LENGTH - 1) / BENCH_TXT_LENGTH;
+    char** records = (char**)malloc(record_count * sizeof(char*));
+    
+    for (size_t i = 0; i < record_count; i++) {
+        size_t offset = i * BENCH_TXT_LENGTH;
+        size_t chunk_size = data_len - offset < BENCH_TXT_LENGTH ? data_len - offset : BENCH_TXT_LENGTH;
+        
+        records[i] = (char*)malloc(chunk_size * 2 + 1);
+        for (size_t j = 0; j < chunk_size; j++) {
+            sprintf(&records[i][j * 2], "%02x", data[offset + j]);
+        }
+        records[i][chunk_size * 2] = '\0';
+    }
+    
+    sink ^= (uint8_t)records[0][0];
+    
+    for (size_t i = 0; i < record_count; i++) {
+        free(records[i]);
+    }
+    free(records);
+}
+
+/**
+ * @brief Former DNS TXT decoder: strtol per digit pair into a heap buffer
+ */
+static void legacy_decode(const char* text, size_t text_len) {
+    uint8_t* buffer = (uint8_t*)malloc(text_len / 2);
+    
+    for (size_t j = 0; j < text_len; j += 2) {
+        char hex[3] = { text[j], text[j + 1], '\0' };
+        buffer[j / 2] = (uint8_t)strtol(hex, NULL, 16);
+    }
+    
+    sink ^= buffer[0];
+    free(buffer);
+}
+
+/**
+ * @brief Print one benchmark line
+ */
+static void report(const char* name, double seconds) {
+    double bytes = (double)BENCH_DATA_SIZE * BENCH_ROUNDS;
+    printf("  %-24s %9.1f MB/s\n", name, bytes / seconds / 1e6);
+}
+
+/**
+ * @brief Main function
+ */
+int main(void) {
+    uint8_t* data = (uint8_t*)malloc(BENCH_DATA_SIZE);
+    uint8_t* decoded = (uint8_t*)malloc(BENCH_DATA_SIZE);
+    char* text = (char*)malloc(BENCH_DATA_SIZE * 2);
+    size_t decoded_len = 0;
+    
+    if (data == NULL || decoded == NULL || text == NULL) {
+        printf("Out of memory\n");
+        return 1;
+    }
+    
+    for (size_t i = 0; i < BENCH_DATA_SIZE; i++) {
+        data[i] = (uint8_t)(i * 131 + 7);
+    }
+    
+    printf("Codec throughput over %d KiB, %d rounds (%s kernels)\n",
+           BENCH_DATA_SIZE / 1024, BENCH_ROUNDS, codec_simd_level());
+    
+    // Encoding
+    double start = now_seconds();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        legacy_encode(data, BENCH_DATA_SIZE);
+    }
+    report("hex encode (legacy)", now_seconds() - start);
+    
+    start = now_seconds();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        codec_hex_encode_scalar(data, BENCH_DATA_SIZE, text);
+        sink ^= (uint8_t)text[round];
+    }
+    report("hex encode (scalar)", now_seconds() - start);
+    
+    start = now_seconds();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        codec_hex_encode(data, BENCH_DATA_SIZE, text);
+        sink ^= (uint8_t)text[round];
+    }
+    report("hex encode (simd)", now_seconds() - start);
+    
+    // Decoding
+    start = now_seconds();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        legacy_decode(text, BENCH_DATA_SIZE * 2);
+    }
+    report("hex decode (legacy)", now_seconds() - start);
+    
+    start = now_seconds();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        codec_hex_decode_scalar(text, BENCH_DATA_SIZE * 2, decoded, &decoded_len);
+        sink ^= decoded[round];
+    }
+    report("hex decode (scalar)", now_seconds() - start);
+    
+    start = now_seconds();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        codec_hex_decode(text, BENCH_DATA_SIZE * 2, decoded, &decoded_len);
+        sink ^= decoded[round];
+    }
+    report("hex decode (simd)", now_seconds() - start);
+    
+    // Base32
+    size_t text_len = 0;
+    
+    start = now_seconds();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        text_len = codec_base32_encode(data, BENCH_DATA_SIZE, text);
+        sink ^= (uint8_t)text[round];
+    }
+    report("base32 encode", now_seconds() - start);
+    
+    start = now_seconds();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        codec_base32_decode(text, text_len, decoded, &decoded_len);
+        sink ^= decoded[round];
+    }
+    report("base32 decode", now_seconds() - start);
+    
+    free(text);
+    free(decoded);
+    free(data);
+    
+    return 0;
+}
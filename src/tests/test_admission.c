@@ -0,0 +1,280 @@
+/**
+ * @file test_admission.c
+ * @brief Test program for listener admission control
+ */
+
+#include "../protocols/admission.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+
+/**
+ * @brief Build an IPv4 source address
+ */
+static struct sockaddr_in make_addr(const char* ip) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    inet_pton(AF_INET, ip, &addr.sin_addr);
+    
+    return addr;
+}
+
+/**
+ * @brief Current monotonic time, the buckets were filled at configure time
+ */
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Configure limits or exit
+ */
+static void configure(uint32_t rate, uint32_t burst, uint32_t subnet_rate, uint32_t subnet_burst) {
+    admission_config_t config;
+    config.rate = rate;
+    config.burst = burst;
+    config.subnet_rate = subnet_rate;
+    config.subnet_burst = subnet_burst;
+    
+    if (admission_configure(&config) != STATUS_SUCCESS) {
+        printf("Failed to configure admission control\n");
+        exit(1);
+    }
+}
+
+/**
+ * @brief Test that no limits admit everything without counting
+ */
+static void test_unlimited(void) {
+    printf("Testing unlimited admission...\n");
+    
+    configure(0, 0, 0, 0);
+    struct sockaddr_in addr = make_addr("10.0.0.1");
+    
+    for (int i = 0; i < 10000; i++) {
+        if (!admission_allow(&addr)) {
+            printf("Session %d refused without limits\n", i);
+            exit(1);
+        }
+    }
+    
+    admission_stats_t stats;
+    admission_get_stats(&stats);
+    
+    if (stats.admitted != 0 || stats.rejected_global != 0 || stats.rejected_subnet != 0) {
+        printf("Counters moved without limits\n");
+        exit(1);
+    }
+    
+    printf("Unlimited admission test passed\n");
+}
+
+/**
+ * @brief Test the global bucket's burst and refill
+ */
+static void test_global_bucket(void) {
+    printf("Testing global bucket...\n");
+    
+    configure(10, 5, 0, 0);
+    uint64_t start = now_ms();
+    
+    // Sources in different subnets share the global bucket
+    char ip[INET_ADDRSTRLEN];
+    int admitted = 0;
+    
+    for (int i = 0; i < 20; i++) {
+        snprintf(ip, sizeof(ip), "10.%d.0.1", i);
+        struct sockaddr_in addr = make_addr(ip);
+        
+        if (admission_allow_at(&addr, start)) {
+            admitted++;
+        }
+    }
+    
+    if (admitted != 5) {
+        printf("Burst admitted %d sessions, expected 5\n", admitted);
+        exit(1);
+    }
+    
+    // 10 per second: one token every 100 ms
+    struct sockaddr_in addr = make_addr("192.168.1.1");
+    
+    if (admission_allow_at(&addr, start + 50)) {
+        printf("Session admitted before a token was earned\n");
+        exit(1);
+    }
+    
+    if (!admission_allow_at(&addr, start + 100)) {
+        printf("Session refused after a token was earned\n");
+        exit(1);
+    }
+    
+    // A long idle period refills only up to the burst
+    admitted = 0;
+    for (int i = 0; i < 20; i++) {
+        if (admission_allow_at(&addr, start + 60000)) {
+            admitted++;
+        }
+    }
+    
+    if (admitted != 5) {
+        printf("Refilled bucket admitted %d sessions, expected 5\n", admitted);
+        exit(1);
+    }
+    
+    admission_stats_t stats;
+    admission_get_stats(&stats);
+    
+    if (stats.admitted != 11 || stats.rejected_global != 31 || stats.rejected_subnet != 0) {
+        printf("Unexpected counters: admitted %llu, global %llu, subnet %llu\n",
+               (unsigned long long)stats.admitted, (unsigned long long)stats.rejected_global,
+               (unsigned long long)stats.rejected_subnet);
+        exit(1);
+    }
+    
+    printf("Global bucket test passed\n");
+}
+
+/**
+ * @brief Test that one /24 is limited without affecting others
+ */
+static void test_subnet_bucket(void) {
+    printf("Testing per-subnet bucket...\n");
+    
+    configure(0, 0, 1, 3);
+    uint64_t start = now_ms();
+    
+    // Hosts of one /24 share a bucket
+    char ip[INET_ADDRSTRLEN];
+    int admitted = 0;
+    
+    for (int i = 1; i <= 10; i++) {
+        snprintf(ip, sizeof(ip), "172.16.5.%d", i);
+        struct sockaddr_in addr = make_addr(ip);
+        
+        if (admission_allow_at(&addr, start)) {
+            admitted++;
+        }
+    }
+    
+    if (admitted != 3) {
+        printf("Subnet burst admitted %d sessions, expected 3\n", admitted);
+        exit(1);
+    }
+    
+    // The neighbouring /24 has its own bucket
+    struct sockaddr_in other = make_addr("172.16.6.1");
+    
+    if (!admission_allow_at(&other, start)) {
+        printf("Neighbouring subnet was refused\n");
+        exit(1);
+    }
+    
+    // Non-IPv4 peers are only charged to the global bucket, which is unlimited here
+    if (!admission_allow_at(NULL, start)) {
+        printf("Peer without an IPv4 address was refused\n");
+        exit(1);
+    }
+    
+    admission_stats_t stats;
+    admission_get_stats(&stats);
+    
+    if (stats.rejected_subnet != 7 || stats.tracked_subnets != 2) {
+        printf("Unexpected counters: subnet %llu, tracked %llu\n",
+               (unsigned long long)stats.rejected_subnet, (unsigned long long)stats.tracked_subnets);
+        exit(1);
+    }
+    
+    printf("Per-subnet bucket test passed\n");
+}
+
+/**
+ * @brief Test that a refusal by one bucket does not charge the other
+ */
+static void test_no_partial_charge(void) {
+    printf("Testing refusals charge neither bucket...\n");
+    
+    configure(1, 2, 1, 1);
+    uint64_t start = now_ms();
+    
+    struct sockaddr_in a = make_addr("10.1.1.1");
+    struct sockaddr_in b = make_addr("10.2.2.2");
+    
+    // Subnet A spends its only token, its refusals leave the global bucket alone
+    if (!admission_allow_at(&a, start) || admission_allow_at(&a, start) || admission_allow_at(&a, start)) {
+        printf("Subnet bucket did not limit its source\n");
+        exit(1);
+    }
+    
+    // One global token remains for subnet B
+    if (!admission_allow_at(&b, start)) {
+        printf("Subnet refusals consumed global tokens\n");
+        exit(1);
+    }
+    
+    admission_stats_t stats;
+    admission_get_stats(&stats);
+    
+    if (stats.admitted != 2 || stats.rejected_subnet != 2 || stats.rejected_global != 0) {
+        printf("Unexpected counters: admitted %llu, global %llu, subnet %llu\n",
+               (unsigned long long)stats.admitted, (unsigned long long)stats.rejected_global,
+               (unsigned long long)stats.rejected_subnet);
+        exit(1);
+    }
+    
+    printf("Partial charge test passed\n");
+}
+
+/**
+ * @brief Test that the subnet table stays bounded under many sources
+ */
+static void test_subnet_eviction(void) {
+    printf("Testing subnet table bound...\n");
+    
+    configure(0, 0, 1, 1);
+    uint64_t start = now_ms();
+    
+    char ip[INET_ADDRSTRLEN];
+    
+    for (int i = 0; i < ADMISSION_SUBNET_SLOTS * 4; i++) {
+        snprintf(ip, sizeof(ip), "10.%d.%d.1", (i >> 8) & 0xFF, i & 0xFF);
+        struct sockaddr_in addr = make_addr(ip);
+        
+        // Every new subnet starts with a full bucket
+        if (!admission_allow_at(&addr, start + (uint64_t)i)) {
+            printf("New subnet %s was refused\n", ip);
+            exit(1);
+        }
+    }
+    
+    admission_stats_t stats;
+    admission_get_stats(&stats);
+    
+    if (stats.tracked_subnets > ADMISSION_SUBNET_SLOTS) {
+        printf("Tracked %llu subnets in %d slots\n", (unsigned long long)stats.tracked_subnets, ADMISSION_SUBNET_SLOTS);
+        exit(1);
+    }
+    
+    printf("Subnet table bound test passed\n");
+}
+
+/**
+ * @brief Main function
+ */
+int main(void) {
+    test_unlimited();
+    test_global_bucket();
+    test_subnet_bucket();
+    test_no_partial_charge();
+    test_subnet_eviction();
+    
+    printf("All tests completed successfully\n");
+    
+    return 0;
+}
@@ -0,0 +1,384 @@
+/**
+ * @file test_client_registry.c
+ * @brief Test program for the client registry hash index
+ */
+
+#include "../include/client.h"
+#include "../include/protocol.h"
+#include "../include/common.h"
+#include "../common/uuid.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <uuid/uuid.h>
+
+// Test configuration
+#define TEST_CLIENTS 100000
+
+/**
+ * @brief Register clients or exit
+ */
+static client_t** register_clients(protocol_listener_t* listener, size_t count) {
+    client_t** registered = (client_t**)calloc(count, sizeof(client_t*));
+    if (registered == NULL) {
+        printf("Failed to allocate client list\n");
+        exit(1);
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        if (client_register(listener, NULL, &registered[i]) != STATUS_SUCCESS || registered[i] == NULL) {
+            printf("Failed to register client %zu\n", i);
+            exit(1);
+        }
+    }
+    
+    return registered;
+}
+
+/**
+ * @brief Test lookups across table growth
+ */
+static void test_find(client_t** registered, size_t count) {
+    printf("Testing lookups over %zu clients...\n", count);
+    
+    for (size_t i = 0; i < count; i++) {
+        uuid_t id;
+        uuid_copy(id, registered[i]->id);
+        
+        client_t* found = client_find(&id);
+        
+        if (found != registered[i]) {
+            printf("Client %zu not found by its ID\n", i);
+            exit(1);
+        }
+        
+        client_release(found);
+    }
+    
+    // An unknown ID misses
+    uuid_t unknown;
+    uuid_generate(unknown);
+    
+    if (client_find(&unknown) != NULL) {
+        printf("Unknown ID found a client\n");
+        exit(1);
+    }
+    
+    printf("Lookup test passed\n");
+}
+
+/**
+ * @brief Test that client_get_all returns each registered client once
+ */
+static void test_get_all(client_t** registered, size_t count) {
+    printf("Testing client_get_all...\n");
+    
+    client_t** all = NULL;
+    size_t all_count = 0;
+    
+    if (client_get_all(&all, &all_count) != STATUS_SUCCESS || all_count != count) {
+        printf("client_get_all returned %zu clients, expected %zu\n", all_count, count);
+        exit(1);
+    }
+    
+    // Mark each registered client off through its heartbeat interval
+    for (size_t i = 0; i < count; i++) {
+        registered[i]->heartbeat_interval = 0;
+    }
+    
+    for (size_t i = 0; i < all_count; i++) {
+        if (all[i]->heartbeat_interval != 0) {
+            printf("Client returned twice by client_get_all\n");
+            exit(1);
+        }
+        all[i]->heartbeat_interval = 1;
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        if (registered[i]->heartbeat_interval != 1) {
+            printf("Client %zu missing from client_get_all\n", i);
+            exit(1);
+        }
+        registered[i]->heartbeat_interval = 60;
+    }
+    
+    for (size_t i = 0; i < all_count; i++) {
+        client_release(all[i]);
+    }
+    
+    free(all);
+    
+    printf("client_get_all test passed\n");
+}
+
+/**
+ * @brief Test that a snapshot stays fixed while the registry changes
+ */
+static void test_snapshot(protocol_listener_t* listener, size_t count) {
+    printf("Testing snapshots...\n");
+    
+    const client_snapshot_t* before = client_snapshot_acquire();
+    if (before == NULL || before->count != count) {
+        printf("Snapshot has %zu clients, expected %zu\n", before != NULL ? before->count : 0, count);
+        exit(1);
+    }
+    
+    // An unchanged registry reuses the published snapshot
+    const client_snapshot_t* again = client_snapshot_acquire();
+    if (again != before) {
+        printf("Unchanged registry rebuilt its snapshot\n");
+        exit(1);
+    }
+    client_snapshot_release(again);
+    
+    client_t* extra = NULL;
+    if (client_register(listener, NULL, &extra) != STATUS_SUCCESS) {
+        printf("Failed to register extra client\n");
+        exit(1);
+    }
+    
+    const client_snapshot_t* after = client_snapshot_acquire();
+    if (after == NULL || after->count != count + 1 || before->count != count) {
+        printf("Snapshots have %zu and %zu clients after one registration\n",
+               before->count, after != NULL ? after->count : 0);
+        exit(1);
+    }
+    
+    // The old snapshot is still readable while held
+    for (size_t i = 0; i < before->count; i++) {
+        if (before->clients[i] == extra) {
+            printf("Old snapshot picked up a new client\n");
+            exit(1);
+        }
+    }
+    
+    client_snapshot_release(after);
+    client_snapshot_release(before);
+    client_destroy(extra);
+    
+    printf("Snapshot test passed\n");
+}
+
+/**
+ * @brief Test that references and snapshots keep a destroyed client readable
+ */
+static void test_references(protocol_listener_t* listener) {
+    printf("Testing client references...\n");
+    
+    client_t* client = NULL;
+    if (client_register(listener, NULL, &client) != STATUS_SUCCESS ||
+        client_update_info(client, "before", NULL, NULL) != STATUS_SUCCESS) {
+        printf("Failed to register client\n");
+        exit(1);
+    }
+    
+    uuid_t id;
+    uuid_copy(id, client->id);
+    
+    client_t* held = client_find(&id);
+    const client_snapshot_t* snapshot = client_snapshot_acquire();
+    
+    if (held != client || snapshot == NULL) {
+        printf("Failed to find client or take a snapshot\n");
+        exit(1);
+    }
+    
+    client_destroy(client);
+    
+    if (client_find(&id) != NULL) {
+        printf("Destroyed client still found\n");
+        exit(1);
+    }
+    
+    // The reference keeps it usable, renaming included
+    if (client_update_info(held, "after", NULL, NULL) != STATUS_SUCCESS || strcmp(held->hostname, "after") != 0) {
+        printf("Held client not usable after destroy\n");
+        exit(1);
+    }
+    
+    client_release(held);
+    
+    // The last reference is gone but the snapshot still shows it, and it cannot be revived
+    bool listed = false;
+    for (size_t i = 0; i < snapshot->count; i++) {
+        if (snapshot->clients[i] == held) {
+            listed = true;
+        }
+    }
+    
+    if (!listed || strcmp(held->hostname, "after") != 0 || client_acquire(held) != NULL) {
+        printf("Snapshot lost a released client or it was revived\n");
+        exit(1);
+    }
+    
+    client_snapshot_release(snapshot);
+    
+    printf("Reference test passed\n");
+}
+
+/**
+ * @brief Count the clients a state sweep reports, or exit if it disagrees with the clients
+ */
+static size_t check_states(client_t** registered, size_t count) {
+    size_t states[CLIENT_STATE_COUNT];
+    size_t expected[CLIENT_STATE_COUNT];
+    size_t total = 0;
+    
+    memset(expected, 0, sizeof(expected));
+    
+    for (size_t i = 0; i < count; i++) {
+        if (registered[i] != NULL) {
+            expected[registered[i]->state]++;
+        }
+    }
+    
+    client_count_states(states);
+    
+    for (size_t i = 0; i < CLIENT_STATE_COUNT; i++) {
+        if (states[i] != expected[i]) {
+            printf("Sweep counted %zu clients in state %zu, expected %zu\n", states[i], i, expected[i]);
+            exit(1);
+        }
+        total += states[i];
+    }
+    
+    return total;
+}
+
+/**
+ * @brief Test sweeps over the registry's hot-field columns
+ */
+static void test_sweeps(client_t** registered, size_t count) {
+    printf("Testing state and idle sweeps...\n");
+    
+    // Every third client goes active
+    for (size_t i = 0; i < count; i += 3) {
+        client_update_state(registered[i], CLIENT_STATE_ACTIVE);
+    }
+    
+    if (check_states(registered, count) != count) {
+        printf("State sweep missed clients\n");
+        exit(1);
+    }
+    
+    // Nobody has been idle for an hour, everybody was last seen before the next second
+    client_t** idle = NULL;
+    size_t idle_count = 0;
+    
+    if (client_get_idle(time(NULL) - 3600, &idle, &idle_count) != STATUS_SUCCESS || idle_count != 0) {
+        printf("Idle sweep returned %zu clients seen recently\n", idle_count);
+        exit(1);
+    }
+    
+    if (client_get_idle(time(NULL) + 1, &idle, &idle_count) != STATUS_SUCCESS || idle_count != count) {
+        printf("Idle sweep returned %zu clients, expected %zu\n", idle_count, count);
+        exit(1);
+    }
+    
+    for (size_t i = 0; i < idle_count; i++) {
+        client_release(idle[i]);
+    }
+    
+    free(idle);
+    
+    printf("Sweep test passed\n");
+}
+
+/**
+ * @brief Test that destroyed clients leave the registry and the rest stay
+ */
+static void test_destroy(client_t** registered, size_t count) {
+    printf("Testing destroy unlinks clients...\n");
+    
+    uuid_t* ids = (uuid_t*)malloc(count * sizeof(uuid_t));
+    if (ids == NULL) {
+        printf("Failed to allocate IDs\n");
+        exit(1);
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        uuid_copy(ids[i], registered[i]->id);
+    }
+    
+    // Destroy every other client
+    for (size_t i = 0; i < count; i += 2) {
+        client_destroy(registered[i]);
+        registered[i] = NULL;
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        client_t* found = client_find(&ids[i]);
+        
+        if (found != registered[i]) {
+            printf("Client %zu %s after destroying half\n", i, registered[i] == NULL ? "still found" : "lost");
+            exit(1);
+        }
+        
+        client_release(found);
+    }
+    
+    client_t** all = NULL;
+    size_t all_count = 0;
+    
+    if (client_get_all(&all, &all_count) != STATUS_SUCCESS || all_count != count / 2) {
+        printf("client_get_all returned %zu clients after destroying half\n", all_count);
+        exit(1);
+    }
+    
+    // Slots freed by destroy were filled from the end of each stripe's columns
+    if (check_states(registered, count) != count / 2) {
+        printf("State sweep still sees destroyed clients\n");
+        exit(1);
+    }
+    
+    for (size_t i = 0; i < all_count; i++) {
+        client_release(all[i]);
+    }
+    
+    free(all);
+    free(ids);
+    
+    printf("Destroy test passed\n");
+}
+
+/**
+ * @brief Main function
+ */
+int main(void) {
+    // Client IDs stay zeroed without the UUID generator
+    uuid_init();
+    
+    if (client_manager_init() != STATUS_SUCCESS) {
+        printf("Failed to initialize client manager\n");
+        return 1;
+    }
+    
+    protocol_listener_t* listener = (protocol_listener_t*)malloc(sizeof(protocol_listener_t));
+    if (listener == NULL) {
+        printf("Failed to allocate memory for mock listener\n");
+        return 1;
+    }
+    
+    memset(listener, 0, sizeof(protocol_listener_t));
+    listener->protocol_type = PROTOCOL_TYPE_TCP;
+    
+    client_t** registered = register_clients(listener, TEST_CLIENTS);
+    
+    test_find(registered, TEST_CLIENTS);
+    test_get_all(registered, TEST_CLIENTS);
+    test_snapshot(listener, TEST_CLIENTS);
+    test_references(listener);
+    test_sweeps(registered, TEST_CLIENTS);
+    test_destroy(registered, TEST_CLIENTS);
+    
+    // Shutdown destroys the clients still registered
+    client_manager_shutdown();
+    
+    free(registered);
+    free(listener);
+    
+    printf("All tests completed successfully\n");
+    
+    return 0;
+}
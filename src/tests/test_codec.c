@@ -0,0 +1,173 @@
+/**
+ * @file test_codec.c
+ * @brief Test program for the hex and base32 codecs
+ */
+
+#include "../common/codec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Test configuration
+#define TEST_MAX_LEN 300
+
+/**
+ * @brief Fill a buffer with a repeatable byte pattern
+ */
+static void fill(uint8_t* data, size_t len, unsigned seed) {
+    for (size_t i = 0; i < len; i++) {
+        seed = seed * 1103515245 + 12345;
+        data[i] = (uint8_t)(seed >> 16);
+    }
+}
+
+/**
+ * @brief Test hex round trips against the scalar reference at every length
+ */
+static void test_hex_round_trip(void) {
+    printf("Testing hex round trips (%s kernels)...\n", codec_simd_level());
+    
+    uint8_t data[TEST_MAX_LEN];
+    uint8_t decoded[TEST_MAX_LEN];
+    char hex[TEST_MAX_LEN * 2];
+    char reference[TEST_MAX_LEN * 2];
+    
+    for (size_t len = 0; len <= TEST_MAX_LEN; len++) {
+        fill(data, len, (unsigned)len);
+        
+        size_t hex_len = codec_hex_encode(data, len, hex);
+        codec_hex_encode_scalar(data, len, reference);
+        
+        if (hex_len != len * 2 || memcmp(hex, reference, hex_len) != 0) {
+            printf("Hex encoding of %zu bytes differs from the scalar loop\n", len);
+            exit(1);
+        }
+        
+        size_t decoded_len = 0;
+        if (codec_hex_decode(hex, hex_len, decoded, &decoded_len) != STATUS_SUCCESS ||
+            decoded_len != len || memcmp(decoded, data, len) != 0) {
+            printf("Hex round trip of %zu bytes failed\n", len);
+            exit(1);
+        }
+    }
+    
+    printf("Hex round trip test passed\n");
+}
+
+/**
+ * @brief Test hex decoding of mixed case and rejection of every bad position
+ */
+static void test_hex_invalid(void) {
+    printf("Testing hex validation...\n");
+    
+    uint8_t data[TEST_MAX_LEN];
+    uint8_t decoded[TEST_MAX_LEN];
+    char hex[TEST_MAX_LEN * 2];
+    
+    fill(data, sizeof(data), 7);
+    codec_hex_encode(data, sizeof(data), hex);
+    
+    // Resolvers may change the case of query names
+    for (size_t i = 0; i < sizeof(hex); i += 3) {
+        if (hex[i] >= 'a' && hex[i] <= 'f') {
+            hex[i] = (char)(hex[i] - 'a' + 'A');
+        }
+    }
+    
+    size_t decoded_len = 0;
+    if (codec_hex_decode(hex, sizeof(hex), decoded, &decoded_len) != STATUS_SUCCESS ||
+        memcmp(decoded, data, sizeof(data)) != 0) {
+        printf("Mixed case hex was not decoded\n");
+        exit(1);
+    }
+    
+    // Characters just outside the digit and letter ranges, at every position
+    const char bad[] = { '/', ':', '`', 'g', '@', 'G', ' ', 0x10, (char)0x80, (char)0xC6 };
+    
+    for (size_t i = 0; i < sizeof(hex); i++) {
+        char saved = hex[i];
+        hex[i] = bad[i % sizeof(bad)];
+        
+        if (codec_hex_decode(hex, sizeof(hex), decoded, &decoded_len) != STATUS_ERROR_INVALID_FORMAT) {
+            printf("Invalid character 0x%02x at %zu was accepted\n", (unsigned char)hex[i], i);
+            exit(1);
+        }
+        
+        hex[i] = saved;
+    }
+    
+    if (codec_hex_decode(hex, 5, decoded, &decoded_len) != STATUS_ERROR_INVALID_FORMAT) {
+        printf("Odd length hex was accepted\n");
+        exit(1);
+    }
+    
+    printf("Hex validation test passed\n");
+}
+
+/**
+ * @brief Test base32 against the RFC 4648 vectors and round trips
+ */
+static void test_base32(void) {
+    printf("Testing base32...\n");
+    
+    const char* inputs[] = { "", "f", "fo", "foo", "foob", "fooba", "foobar" };
+    const char* outputs[] = { "", "my", "mzxq", "mzxw6", "mzxw6yq", "mzxw6ytb", "mzxw6ytboi" };
+    
+    char text[TEST_MAX_LEN * 2];
+    uint8_t decoded[TEST_MAX_LEN];
+    size_t decoded_len = 0;
+    
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+        size_t len = codec_base32_encode((const uint8_t*)inputs[i], strlen(inputs[i]), text);
+        
+        if (len != strlen(outputs[i]) || memcmp(text, outputs[i], len) != 0) {
+            printf("Base32 of \"%s\" is %.*s\n", inputs[i], (int)len, text);
+            exit(1);
+        }
+    }
+    
+    // Upper case decodes the same
+    if (codec_base32_decode("MZXW6YTBOI", 10, decoded, &decoded_len) != STATUS_SUCCESS ||
+        decoded_len != 6 || memcmp(decoded, "foobar", 6) != 0) {
+        printf("Upper case base32 was not decoded\n");
+        exit(1);
+    }
+    
+    uint8_t data[TEST_MAX_LEN];
+    
+    for (size_t len = 0; len <= TEST_MAX_LEN; len++) {
+        fill(data, len, (unsigned)len + 1000);
+        
+        size_t text_len = codec_base32_encode(data, len, text);
+        
+        if (text_len != CODEC_BASE32_ENCODED_LEN(len) ||
+            codec_base32_decode(text, text_len, decoded, &decoded_len) != STATUS_SUCCESS ||
+            decoded_len != len || memcmp(decoded, data, len) != 0) {
+            printf("Base32 round trip of %zu bytes failed\n", len);
+            exit(1);
+        }
+    }
+    
+    // Impossible lengths, characters outside the alphabet and non-zero padding bits
+    if (codec_base32_decode("mzx", 3, decoded, &decoded_len) != STATUS_ERROR_INVALID_FORMAT ||
+        codec_base32_decode("mzxw1", 5, decoded, &decoded_len) != STATUS_ERROR_INVALID_FORMAT ||
+        codec_base32_decode("mz", 2, decoded, &decoded_len) != STATUS_ERROR_INVALID_FORMAT) {
+        printf("Invalid base32 was accepted\n");
+        exit(1);
+    }
+    
+    printf("Base32 test passed\n");
+}
+
+/**
+ * @brief Main function
+ */
+int main(void) {
+    test_hex_round_trip();
+    test_hex_invalid();
+    test_base32();
+    
+    printf("All tests completed successfully\n");
+    
+    return 0;
+}
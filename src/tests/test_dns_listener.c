@@ -6,26 +6,37 @@
 #include "../include/protocol.h"
 #include "../include/common.h"
 #include "../include/client.h"
+#include "../common/reactor.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/socket.h>
 #include <arpa/inet.h>
-#include <netdb.h>
-#include <ares.h>
 
 // Test configuration
+#define TEST_BIND_ADDRESS "127.0.0.1"
 #define TEST_DOMAIN "test.example.com"
-#define TEST_PORT 53
+#define TEST_PORT 5354
 #define TEST_MESSAGE "Hello, DNS!"
 #define TEST_TIMEOUT_MS 5000
+#define TEST_QUERIES 20000
+#define TEST_REACTOR_LOOPS 2
+
+// Query types
+#define TYPE_A 1
+#define TYPE_TXT 16
 
 // Global variables
 static protocol_listener_t* listener = NULL;
 static client_t* test_client = NULL;
 static bool message_received = false;
+static bool response_received = false;
+static int messages_dispatched = 0;
 static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
 
@@ -35,7 +46,6 @@ static void on_client_connected(protocol_listener_t* listener, client_t* client)
 static void on_client_disconnected(protocol_listener_t* listener, client_t* client);
 static void* client_thread(void* arg);
 static void cleanup(void);
-static void dns_query_callback(void* arg, int status, int timeouts, unsigned char* abuf, int alen);
 
 /**
  * @brief Signal handler
@@ -60,13 +70,14 @@ static void cleanup(void) {
 /**
  * @brief Test DNS listener creation
  */
-static void test_dns_listener_create(void) {
-    printf("Testing DNS listener creation...\n");
+static void test_dns_listener_create(reactor_t* reactor) {
+    printf("Testing DNS listener creation%s...\n", reactor != NULL ? " (shared reactor)" : "");
     
     // Create listener configuration
     protocol_listener_config_t config;
     memset(&config, 0, sizeof(config));
     
+    config.bind_address = TEST_BIND_ADDRESS;
     config.domain = TEST_DOMAIN;
     config.port = TEST_PORT;
     config.timeout_ms = TEST_TIMEOUT_MS;
@@ -88,6 +99,13 @@ static void test_dns_listener_create(void) {
         exit(1);
     }
     
+    // Serve the socket from the reactor's loops instead of a listener thread
+    if (reactor != NULL && listener->attach_reactor(listener, reactor) != STATUS_SUCCESS) {
+        printf("Failed to attach the reactor\n");
+        listener->destroy(listener);
+        exit(1);
+    }
+    
     printf("DNS listener created successfully\n");
 }
 
@@ -172,94 +190,378 @@ static void test_dns_message_send_receive(void) {
     // Wait for client thread to exit
     pthread_join(thread, NULL);
     
+    if (!response_received) {
+        printf("Echo was not delivered in the TXT answer\n");
+        cleanup();
+        exit(1);
+    }
+    
     printf("DNS message test completed successfully\n");
 }
 
 /**
- * @brief Client thread function
+ * @brief Build a query for <nonce>.<hex data>.<domain> (stub resolver)
+ */
+static size_t build_query(uint8_t* out, uint16_t id, uint16_t qtype, const char* nonce,
+                          const uint8_t* data, size_t data_len, const char* domain) {
+    static const char digits[] = "0123456789abcdef";
+    size_t len = 0;
+    
+    // Header: recursion desired, one question
+    uint8_t header[12] = { (uint8_t)(id >> 8), (uint8_t)id, 0x01, 0x00, 0, 1, 0, 0, 0, 0, 0, 0 };
+    memcpy(out, header, sizeof(header));
+    len = sizeof(header);
+    
+    // Nonce label
+    out[len++] = (uint8_t)strlen(nonce);
+    memcpy(out + len, nonce, strlen(nonce));
+    len += strlen(nonce);
+    
+    // Hex data labels of up to 62 digits
+    for (size_t offset = 0; offset < data_len; offset += 31) {
+        size_t chunk = data_len - offset < 31 ? data_len - offset : 31;
+        out[len++] = (uint8_t)(chunk * 2);
+        
+        for (size_t i = 0; i < chunk; i++) {
+            out[len++] = (uint8_t)digits[data[offset + i] >> 4];
+            out[len++] = (uint8_t)digits[data[offset + i] & 0x0F];
+        }
+    }
+    
+    // Domain labels
+    const char* label = domain;
+    while (*label != '\0') {
+        const char* dot = strchr(label, '.');
+        size_t label_len = dot != NULL ? (size_t)(dot - label) : strlen(label);
+        
+        out[len++] = (uint8_t)label_len;
+        memcpy(out + len, label, label_len);
+        len += label_len;
+        label += label_len + (dot != NULL ? 1 : 0);
+    }
+    
+    out[len++] = 0;
+    out[len++] = (uint8_t)(qtype >> 8);
+    out[len++] = (uint8_t)qtype;
+    out[len++] = 0;
+    out[len++] = 1;
+    
+    return len;
+}
+
+/**
+ * @brief Create a stub resolver socket pointed at the listener
+ */
+static int stub_socket(void) {
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    
+    if (sock < 0) {
+        perror("socket");
+        return -1;
+    }
+    
+    struct timeval tv;
+    tv.tv_sec = 5;
+    tv.tv_usec = 0;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = inet_addr(TEST_BIND_ADDRESS);
+    server_addr.sin_port = htons(TEST_PORT);
+    
+    if (connect(sock, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+        perror("connect");
+        close(sock);
+        return -1;
+    }
+    
+    return sock;
+}
+
+/**
+ * @brief Send a query and wait for the response with the same ID
+ * 
+ * @return ssize_t Response length, or -1 on timeout
+ */
+static ssize_t exchange(int sock, const uint8_t* query, size_t query_len, uint8_t* response, size_t response_size) {
+    if (send(sock, query, query_len, 0) != (ssize_t)query_len) {
+        return -1;
+    }
+    
+    while (true) {
+        ssize_t len = recv(sock, response, response_size, 0);
+        
+        if (len < 12) {
+            return -1;
+        }
+        
+        if (response[0] == query[0] && response[1] == query[1]) {
+            return len;
+        }
+    }
+}
+
+/**
+ * @brief Find the RDATA of the first answer in a response
+ * 
+ * @return const uint8_t* RDATA, or NULL if there is no answer
+ */
+static const uint8_t* first_answer(const uint8_t* response, size_t len, uint16_t* rdlength) {
+    if (((response[6] << 8) | response[7]) == 0) {
+        return NULL;
+    }
+    
+    // Skip the question
+    size_t offset = 12;
+    while (offset < len && response[offset] != 0) {
+        offset += 1 + response[offset];
+    }
+    offset += 1 + 4;
+    
+    // Name pointer, type, class, TTL
+    offset += 2 + 2 + 2 + 4;
+    
+    if (offset + 2 > len) {
+        return NULL;
+    }
+    
+    *rdlength = (uint16_t)((response[offset] << 8) | response[offset + 1]);
+    return response + offset + 2;
+}
+
+/**
+ * @brief Client thread function (stub resolver on loopback)
  */
 static void* client_thread(void* arg) {
     // Sleep for a bit to allow server to start
     sleep(1);
     
-    // Initialize ARES
-    ares_channel channel;
-    int status = ares_library_init(ARES_LIB_INIT_ALL);
-    
-    if (status != ARES_SUCCESS) {
-        printf("Failed to initialize ARES: %s\n", ares_strerror(status));
+    int sock = stub_socket();
+    if (sock < 0) {
         return NULL;
     }
     
-    struct ares_options options;
-    memset(&options, 0, sizeof(options));
+    // Send the message upstream in a TXT query
+    uint8_t query[512];
+    uint8_t response[512];
+    size_t query_len = build_query(query, 0x1234, TYPE_TXT, "n1", (const uint8_t*)TEST_MESSAGE,
+                                   strlen(TEST_MESSAGE), TEST_DOMAIN);
+    
+    ssize_t response_len = exchange(sock, query, query_len, response, sizeof(response));
     
-    options.flags = ARES_FLAG_STAYOPEN;
-    options.timeout = 1000;
-    options.tries = 3;
-    options.servers = NULL;
-    options.nservers = 0;
+    if (response_len < 0) {
+        printf("No response to the TXT query\n");
+        close(sock);
+        return NULL;
+    }
     
-    status = ares_init_options(&channel, &options, ARES_OPT_FLAGS | ARES_OPT_TIMEOUT | ARES_OPT_TRIES);
+    // The echo queued by the callback comes back in the same answer
+    uint16_t rdlength = 0;
+    const uint8_t* rdata = first_answer(response, (size_t)response_len, &rdlength);
     
-    if (status != ARES_SUCCESS) {
-        printf("Failed to initialize ARES channel: %s\n", ares_strerror(status));
-        ares_library_cleanup();
+    if (rdata == NULL || rdlength < 1 || rdata[0] != strlen(TEST_MESSAGE) * 2 ||
+        strncmp((const char*)rdata + 1, "48656c6c6f2c20444e5321", rdata[0]) != 0) {
+        printf("Unexpected TXT answer\n");
+        close(sock);
         return NULL;
     }
     
-    // Set DNS server
-    struct ares_addr_node server;
-    server.next = NULL;
-    server.family = AF_INET;
-    server.addr.addr4.s_addr = inet_addr("127.0.0.1");
+    printf("Response received: %.*s\n", rdata[0], rdata + 1);
+    response_received = true;
     
-    ares_set_servers(channel, &server);
+    close(sock);
     
-    // Perform DNS query
-    ares_query(channel, TEST_DOMAIN, ns_c_in, ns_t_txt, dns_query_callback, NULL);
+    return NULL;
+}
+
+/**
+ * @brief Test response codes and A acknowledgements
+ */
+static void test_dns_responses(void) {
+    printf("Testing DNS responses...\n");
+    
+    int sock = stub_socket();
+    if (sock < 0) {
+        cleanup();
+        exit(1);
+    }
     
-    // Process DNS events
-    fd_set read_fds, write_fds;
-    int nfds = 0;
+    uint8_t query[512];
+    uint8_t response[512];
     
-    struct timeval tv, *tvp;
-    time_t start_time = time(NULL);
+    // Names outside the domain are refused
+    size_t query_len = build_query(query, 1, TYPE_A, "n2", NULL, 0, "example.org");
+    ssize_t response_len = exchange(sock, query, query_len, response, sizeof(response));
     
-    while (time(NULL) - start_time < 5 && !message_received) {
-        FD_ZERO(&read_fds);
-        FD_ZERO(&write_fds);
-        
-        tvp = ares_timeout(channel, NULL, &tv);
-        ares_fds(channel, &read_fds, &write_fds);
-        nfds = ares_socket_max(channel, nfds);
-        
-        if (nfds > 0) {
-            select(nfds + 1, &read_fds, &write_fds, NULL, tvp);
-            ares_process(channel, &read_fds, &write_fds);
-        } else {
-            // No file descriptors, sleep a bit
-            usleep(100000);
+    if (response_len < 0 || (response[2] & 0x80) == 0 || (response[3] & 0x0F) != 5) {
+        printf("Out-of-zone query was not refused\n");
+        close(sock);
+        cleanup();
+        exit(1);
+    }
+    
+    // Data labels that are not hex do not exist
+    query_len = build_query(query, 2, TYPE_A, "n3", NULL, 0, "zz." TEST_DOMAIN);
+    response_len = exchange(sock, query, query_len, response, sizeof(response));
+    
+    if (response_len < 0 || (response[3] & 0x0F) != 3) {
+        printf("Invalid data label did not return NXDOMAIN\n");
+        close(sock);
+        cleanup();
+        exit(1);
+    }
+    
+    // A queries are acknowledged with 10.0.x.y, x.y = queued messages (case-insensitive domain)
+    query_len = build_query(query, 3, TYPE_A, "n4", NULL, 0, "TEST.Example.COM");
+    response_len = exchange(sock, query, query_len, response, sizeof(response));
+    
+    uint16_t rdlength = 0;
+    const uint8_t* rdata = response_len > 0 ? first_answer(response, (size_t)response_len, &rdlength) : NULL;
+    
+    if (rdata == NULL || (response[3] & 0x0F) != 0 || (response[2] & 0x04) == 0 || rdlength != 4 || rdata[0] != 10) {
+        printf("Unexpected A answer\n");
+        close(sock);
+        cleanup();
+        exit(1);
+    }
+    
+    // A TXT poll with nothing queued has no answer
+    query_len = build_query(query, 4, TYPE_TXT, "n5", NULL, 0, TEST_DOMAIN);
+    response_len = exchange(sock, query, query_len, response, sizeof(response));
+    
+    if (response_len < 0 || (response[3] & 0x0F) != 0 || response[6] != 0 || response[7] != 0) {
+        printf("Unexpected answer to an empty poll\n");
+        close(sock);
+        cleanup();
+        exit(1);
+    }
+    
+    close(sock);
+    
+    printf("DNS responses test completed successfully\n");
+}
+
+/**
+ * @brief Look up a listener counter
+ */
+static uint64_t get_stat(const char* name) {
+    protocol_stat_t stats[PROTOCOL_MAX_STATS];
+    size_t count = PROTOCOL_MAX_STATS;
+    
+    if (protocol_manager_get_stats(listener, stats, &count) == STATUS_SUCCESS) {
+        for (size_t i = 0; i < count; i++) {
+            if (strcmp(stats[i].name, name) == 0) {
+                return stats[i].value;
+            }
         }
     }
     
-    // Clean up
-    ares_destroy(channel);
-    ares_library_cleanup();
+    printf("Missing listener counter: %s\n", name);
+    cleanup();
+    exit(1);
+}
+
+/**
+ * @brief Test retransmitted queries are answered from the cache
+ */
+static void test_dns_cache(void) {
+    printf("Testing DNS response cache...\n");
     
-    return NULL;
+    int sock = stub_socket();
+    if (sock < 0) {
+        cleanup();
+        exit(1);
+    }
+    
+    uint8_t query[512];
+    uint8_t first[512];
+    uint8_t retry[512];
+    uint64_t hits = get_stat("cache_hits");
+    int dispatched = messages_dispatched;
+    
+    // Upstream data whose echo is returned in the answer
+    size_t query_len = build_query(query, 100, TYPE_TXT, "c1", (const uint8_t*)"cached", 6, TEST_DOMAIN);
+    ssize_t first_len = exchange(sock, query, query_len, first, sizeof(first));
+    
+    // A resolver retry carries a new ID but the same question
+    query[0] = 0;
+    query[1] = 101;
+    ssize_t retry_len = exchange(sock, query, query_len, retry, sizeof(retry));
+    
+    if (first_len < 0 || retry_len != first_len || memcmp(first + 2, retry + 2, (size_t)first_len - 2) != 0) {
+        printf("Retransmitted query got a different answer\n");
+        close(sock);
+        cleanup();
+        exit(1);
+    }
+    
+    if (messages_dispatched != dispatched + 1 || get_stat("cache_hits") != hits + 1) {
+        printf("Retransmitted query was dispatched again\n");
+        close(sock);
+        cleanup();
+        exit(1);
+    }
+    
+    close(sock);
+    
+    printf("DNS cache test completed successfully (hits=%llu misses=%llu)\n",
+           (unsigned long long)get_stat("cache_hits"), (unsigned long long)get_stat("cache_misses"));
 }
 
 /**
- * @brief DNS query callback
+ * @brief Test query throughput with a window of queries in flight
  */
-static void dns_query_callback(void* arg, int status, int timeouts, unsigned char* abuf, int alen) {
-    if (status != ARES_SUCCESS) {
-        printf("DNS query failed: %s\n", ares_strerror(status));
-        return;
+static void test_dns_throughput(void) {
+    printf("Testing DNS query throughput...\n");
+    
+    int sock = stub_socket();
+    if (sock < 0) {
+        cleanup();
+        exit(1);
+    }
+    
+    uint8_t query[512];
+    uint8_t response[512];
+    int sent = 0;
+    int received = 0;
+    
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    
+    while (received < TEST_QUERIES) {
+        // Keep up to 16 queries in flight
+        while (sent < TEST_QUERIES && sent - received < 16) {
+            char nonce[16];
+            snprintf(nonce, sizeof(nonce), "q%d", sent);
+            size_t query_len = build_query(query, (uint16_t)sent, TYPE_A, nonce, NULL, 0, TEST_DOMAIN);
+            
+            if (send(sock, query, query_len, 0) != (ssize_t)query_len) {
+                perror("send");
+                close(sock);
+                cleanup();
+                exit(1);
+            }
+            sent++;
+        }
+        
+        if (recv(sock, response, sizeof(response), 0) < 12) {
+            printf("Timeout after %d of %d responses\n", received, TEST_QUERIES);
+            close(sock);
+            cleanup();
+            exit(1);
+        }
+        received++;
     }
     
-    printf("DNS query completed successfully\n");
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    
+    close(sock);
+    
+    printf("DNS throughput test completed: %d queries in %.3f s (%.0f queries/s)\n",
+           TEST_QUERIES, seconds, TEST_QUERIES / seconds);
 }
 
 /**
@@ -267,6 +569,7 @@ static void dns_query_callback(void* arg, int status, int timeouts, unsigned cha
  */
 static void on_message_received(protocol_listener_t* listener, client_t* client, protocol_message_t* message) {
     printf("Message received: %.*s\n", (int)message->data_len, message->data);
+    messages_dispatched++;
     
     // Check if this is the test message
     if (message->data_len == strlen(TEST_MESSAGE) &&
@@ -315,13 +618,32 @@ int main(int argc, char** argv) {
         return 1;
     }
     
-    // Run tests
-    test_dns_listener_create();
-    test_dns_listener_start_stop();
-    test_dns_message_send_receive();
+    reactor_t* reactor = NULL;
+    status = reactor_create(TEST_REACTOR_LOOPS, &reactor);
     
-    // Clean up
-    cleanup();
+    if (status != STATUS_SUCCESS) {
+        printf("Failed to create reactor: %d\n", status);
+        return 1;
+    }
+    
+    // Run tests with a listener thread, then on the shared reactor
+    for (int pass = 0; pass < 2; pass++) {
+        message_received = false;
+        response_received = false;
+        messages_dispatched = 0;
+        
+        test_dns_listener_create(pass == 0 ? NULL : reactor);
+        test_dns_listener_start_stop();
+        test_dns_message_send_receive();
+        test_dns_responses();
+        test_dns_cache();
+        test_dns_throughput();
+        
+        // Clean up
+        cleanup();
+    }
+    
+    reactor_destroy(reactor);
     protocol_manager_shutdown();
     
     printf("All tests completed successfully\n");
@@ -0,0 +1,172 @@
+/**
+ * @file test_epoch.c
+ * @brief Test program for epoch-based reclamation
+ */
+
+#include "../common/epoch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+// Test configuration
+#define TEST_READERS 4
+#define TEST_SWAPS 20000
+#define TEST_MAGIC 0x45504f43u  // "EPOC"
+
+// Shared object readers check for use after release
+typedef struct {
+    uint32_t magic;
+    uint64_t value;
+} test_object_t;
+
+static test_object_t* shared = NULL;
+static int released = 0;
+static bool stop = false;
+
+/**
+ * @brief Poison and free a retired object
+ */
+static void test_release(void* ptr) {
+    test_object_t* object = (test_object_t*)ptr;
+    
+    object->magic = 0;
+    free(object);
+    __atomic_add_fetch(&released, 1, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Allocate an object or exit
+ */
+static test_object_t* test_object(uint64_t value) {
+    test_object_t* object = (test_object_t*)malloc(sizeof(test_object_t));
+    if (object == NULL) {
+        printf("Failed to allocate object\n");
+        exit(1);
+    }
+    
+    object->magic = TEST_MAGIC;
+    object->value = value;
+    
+    return object;
+}
+
+/**
+ * @brief Test that a read section holds back release until it ends
+ */
+static void test_deferred_release(void) {
+    printf("Testing release deferred by a reader...\n");
+    
+    released = 0;
+    
+    if (epoch_enter() != STATUS_SUCCESS) {
+        printf("Failed to enter read section\n");
+        exit(1);
+    }
+    
+    // Nested sections end with the outermost one
+    epoch_enter();
+    epoch_exit();
+    
+    test_object_t* object = test_object(1);
+    epoch_retire(object, test_release);
+    
+    // Plenty of chances to advance, none can while this thread reads
+    for (int i = 0; i < 10; i++) {
+        epoch_retire(test_object(2), test_release);
+    }
+    
+    if (released != 0 || object->magic != TEST_MAGIC) {
+        printf("Object released inside a read section\n");
+        exit(1);
+    }
+    
+    epoch_exit();
+    epoch_barrier();
+    
+    if (released != 11) {
+        printf("Barrier left %d objects unreleased\n", 11 - released);
+        exit(1);
+    }
+    
+    printf("Deferred release test passed\n");
+}
+
+/**
+ * @brief Reader thread: repeatedly load the shared object and check it is live
+ */
+static void* reader_thread(void* arg) {
+    uint64_t* reads = (uint64_t*)arg;
+    
+    while (!__atomic_load_n(&stop, __ATOMIC_ACQUIRE)) {
+        epoch_enter();
+        
+        test_object_t* object = __atomic_load_n(&shared, __ATOMIC_ACQUIRE);
+        
+        if (object->magic != TEST_MAGIC) {
+            printf("Reader saw a released object\n");
+            exit(1);
+        }
+        
+        (*reads)++;
+        
+        epoch_exit();
+    }
+    
+    return NULL;
+}
+
+/**
+ * @brief Test a writer swapping and retiring an object under concurrent readers
+ */
+static void test_concurrent_readers(void) {
+    printf("Testing concurrent readers...\n");
+    
+    pthread_t readers[TEST_READERS];
+    uint64_t reads[TEST_READERS];
+    
+    released = 0;
+    shared = test_object(0);
+    memset(reads, 0, sizeof(reads));
+    
+    for (int i = 0; i < TEST_READERS; i++) {
+        if (pthread_create(&readers[i], NULL, reader_thread, &reads[i]) != 0) {
+            printf("Failed to start reader\n");
+            exit(1);
+        }
+    }
+    
+    for (uint64_t i = 1; i <= TEST_SWAPS; i++) {
+        test_object_t* old = __atomic_exchange_n(&shared, test_object(i), __ATOMIC_ACQ_REL);
+        epoch_retire(old, test_release);
+    }
+    
+    __atomic_store_n(&stop, true, __ATOMIC_RELEASE);
+    
+    for (int i = 0; i < TEST_READERS; i++) {
+        pthread_join(readers[i], NULL);
+    }
+    
+    epoch_barrier();
+    
+    if (released != TEST_SWAPS) {
+        printf("Released %d of %d retired objects\n", released, TEST_SWAPS);
+        exit(1);
+    }
+    
+    free(shared);
+    
+    printf("Concurrent readers test passed\n");
+}
+
+/**
+ * @brief Main function
+ */
+int main(void) {
+    test_deferred_release();
+    test_concurrent_readers();
+    
+    printf("All tests completed successfully\n");
+    
+    return 0;
+}
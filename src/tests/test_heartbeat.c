@@ -268,6 +268,25 @@ static void test_heartbeat_timeout(void) {
         exit(1);
     }
     
+    // The heartbeat wheel marks it inactive within a second of the deadline
+    for (int i = 0; i < 30 && client->state == CLIENT_STATE_ACTIVE; i++) {
+        usleep(100000);
+    }
+    
+    if (client->state != CLIENT_STATE_INACTIVE) {
+        printf("Timed out client not marked inactive: %d\n", client->state);
+        free(listener);
+        exit(1);
+    }
+    
+    // A heartbeat brings it back
+    status = client_heartbeat(client);
+    if (status != STATUS_SUCCESS || client->state != CLIENT_STATE_ACTIVE) {
+        printf("Heartbeat did not reactivate client\n");
+        free(listener);
+        exit(1);
+    }
+    
     printf("Heartbeat timeout detection test passed\n");
     
     // Clean up
@@ -16,11 +16,15 @@
 #include <netinet/ip_icmp.h>
 #include <netinet/ip.h>
 #include <sys/socket.h>
+#include <errno.h>
+#include <time.h>
 
 // Test configuration
 #define TEST_PCAP_DEVICE "any"
 #define TEST_MESSAGE "Hello, ICMP!"
 #define TEST_TIMEOUT_MS 5000
+#define TEST_RING_ECHOES 32
+#define TEST_RING_ID 0x7E57
 
 // Global variables
 static protocol_listener_t* listener = NULL;
@@ -36,6 +40,7 @@ static void on_client_disconnected(protocol_listener_t* listener, client_t* clie
 static void* client_thread(void* arg);
 static void cleanup(void);
 static uint16_t calculate_checksum(uint16_t* addr, int len);
+static void on_ring_message(protocol_listener_t* listener, client_t* client, protocol_message_t* message);
 
 /**
  * @brief Signal handler
@@ -295,6 +300,106 @@ static void* client_thread(void* arg) {
     return NULL;
 }
 
+/**
+ * @brief Test the ring capture backend and template replies sent with sendmmsg
+ */
+static void test_icmp_ring_replies(void) {
+    printf("Testing ICMP ring backend replies...\n");
+    
+    protocol_listener_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.pcap_device = "lo";
+    config.capture_backend = PROTOCOL_CAPTURE_RING;
+    
+    protocol_listener_t* ring_listener = NULL;
+    if (icmp_listener_create(&config, &ring_listener) != STATUS_SUCCESS ||
+        ring_listener->register_callbacks(ring_listener, on_ring_message, NULL, NULL) != STATUS_SUCCESS ||
+        ring_listener->start(ring_listener) != STATUS_SUCCESS) {
+        printf("Failed to start ICMP ring listener\n");
+        exit(1);
+    }
+    
+    int sock = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
+    struct timeval tv = { 0, 200 * 1000 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    
+    struct sockaddr_in dest_addr;
+    memset(&dest_addr, 0, sizeof(dest_addr));
+    dest_addr.sin_family = AF_INET;
+    dest_addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    
+    // Echo requests with odd and even payload lengths
+    for (int i = 0; i < TEST_RING_ECHOES; i++) {
+        char packet[sizeof(struct icmphdr) + 64];
+        memset(packet, 0, sizeof(packet));
+        
+        struct icmphdr* icmp = (struct icmphdr*)packet;
+        icmp->type = ICMP_ECHO;
+        icmp->un.echo.id = htons(TEST_RING_ID);
+        icmp->un.echo.sequence = htons((uint16_t)i);
+        
+        int data_len = snprintf(packet + sizeof(struct icmphdr), 64, "ring-%d%.*s", i, i, "abcdefghijklmnopqrstuvwxyzabcdefgh");
+        icmp->checksum = calculate_checksum((uint16_t*)icmp, (int)sizeof(struct icmphdr) + data_len);
+        
+        sendto(sock, packet, sizeof(struct icmphdr) + data_len, 0, (struct sockaddr*)&dest_addr, sizeof(dest_addr));
+    }
+    
+    // The kernel answers with our ID too, listener replies carry the peer's own ID
+    int replies = 0;
+    time_t start_time = time(NULL);
+    
+    while (replies < TEST_RING_ECHOES && time(NULL) - start_time < 5) {
+        char recv_buffer[1024];
+        ssize_t recv_len = recv(sock, recv_buffer, sizeof(recv_buffer), 0);
+        if (recv_len <= 0) {
+            continue;
+        }
+        
+        struct iphdr* ip_reply = (struct iphdr*)recv_buffer;
+        struct icmphdr* icmp_reply = (struct icmphdr*)(recv_buffer + ip_reply->ihl * 4);
+        int icmp_len = (int)recv_len - ip_reply->ihl * 4;
+        
+        if (icmp_reply->type != ICMP_ECHOREPLY || ntohs(icmp_reply->un.echo.id) == TEST_RING_ID ||
+            icmp_len < (int)sizeof(struct icmphdr) + 5 || memcmp(icmp_reply + 1, "ring-", 5) != 0) {
+            continue;
+        }
+        
+        // A valid checksum sums the message to zero
+        if (calculate_checksum((uint16_t*)icmp_reply, icmp_len) != 0) {
+            printf("Reply %d has a bad checksum\n", replies);
+            exit(1);
+        }
+        
+        replies++;
+    }
+    
+    close(sock);
+    
+    // Stopping joins the sender thread, so its counters are final
+    ring_listener->stop(ring_listener);
+    
+    protocol_stat_t stats[PROTOCOL_MAX_STATS];
+    size_t stat_count = 0;
+    uint64_t replies_sent = 0;
+    
+    ring_listener->get_stats(ring_listener, stats, &stat_count);
+    for (size_t i = 0; i < stat_count; i++) {
+        if (strcmp(stats[i].name, "replies_sent") == 0) {
+            replies_sent = stats[i].value;
+        }
+    }
+    
+    ring_listener->destroy(ring_listener);
+    
+    if (replies < TEST_RING_ECHOES || replies_sent < TEST_RING_ECHOES) {
+        printf("Expected %d replies, received %d (sent %llu)\n", TEST_RING_ECHOES, replies,
+               (unsigned long long)replies_sent);
+        exit(1);
+    }
+    
+    printf("ICMP ring backend reply test passed\n");
+}
+
 /**
  * @brief Calculate IP checksum
  */
@@ -340,6 +445,13 @@ static void on_message_received(protocol_listener_t* listener, client_t* client,
     listener->send_message(listener, client, message);
 }
 
+/**
+ * @brief Ring listener message callback, echoes each request back
+ */
+static void on_ring_message(protocol_listener_t* listener, client_t* client, protocol_message_t* message) {
+    listener->send_message(listener, client, message);
+}
+
 /**
  * @brief Client connected callback
  */
@@ -381,6 +493,10 @@ int main(int argc, char** argv) {
     
     // Clean up
     cleanup();
+    
+    // Runs alone so no other listener answers its echo requests
+    test_icmp_ring_replies();
+    
     protocol_manager_shutdown();
     
     printf("All tests completed successfully\n");
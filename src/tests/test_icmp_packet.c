@@ -0,0 +1,153 @@
+/**
+ * @file test_icmp_packet.c
+ * @brief Test program for ICMP reply templates and incremental checksums
+ */
+
+#define _DEFAULT_SOURCE /* For struct ip and struct icmp */
+
+#include "../protocols/icmp_packet.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <netinet/ip.h>
+#include <netinet/ip_icmp.h>
+
+// Test configuration
+#define TEST_MAX_PAYLOAD 1400
+
+/**
+ * @brief Reference checksum: plain 16-bit loop over the buffer
+ */
+static uint16_t reference_checksum(const uint8_t* data, size_t len) {
+    uint32_t sum = 0;
+    
+    for (size_t i = 0; i + 1 < len; i += 2) {
+        uint16_t word;
+        memcpy(&word, data + i, sizeof(word));
+        sum += word;
+    }
+    
+    if (len % 2 == 1) {
+        uint16_t word = 0;
+        memcpy(&word, data + len - 1, 1);
+        sum += word;
+    }
+    
+    while (sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    
+    return (uint16_t)~sum;
+}
+
+/**
+ * @brief Test replies built from a template against a full checksum
+ */
+static void test_reply_build(void) {
+    printf("Testing template replies...\n");
+    
+    icmp_reply_template_t tmpl;
+    struct in_addr destination;
+    inet_pton(AF_INET, "10.1.2.3", &destination);
+    icmp_reply_template_init(&tmpl, destination, htons(0xBEEF));
+    
+    uint8_t payload[TEST_MAX_PAYLOAD];
+    uint8_t packet[ICMP_PACKET_HEADER_SIZE + TEST_MAX_PAYLOAD];
+    unsigned seed = 1;
+    
+    for (size_t i = 0; i < sizeof(payload); i++) {
+        seed = seed * 1103515245 + 12345;
+        payload[i] = (uint8_t)(seed >> 16);
+    }
+    
+    for (size_t len = 0; len <= TEST_MAX_PAYLOAD; len++) {
+        uint16_t sequence = (uint16_t)(len * 7919);
+        size_t packet_len = icmp_reply_build(&tmpl, sequence, payload, len, packet);
+        
+        const struct ip* ip_header = (const struct ip*)packet;
+        struct icmp* icmp_header = (struct icmp*)(packet + ICMP_PACKET_IP_HEADER_SIZE);
+        
+        if (packet_len != ICMP_PACKET_HEADER_SIZE + len || ntohs(ip_header->ip_len) != packet_len ||
+            ip_header->ip_dst.s_addr != destination.s_addr || icmp_header->icmp_type != ICMP_ECHOREPLY ||
+            ntohs(icmp_header->icmp_id) != 0xBEEF || ntohs(icmp_header->icmp_seq) != sequence ||
+            memcmp(packet + ICMP_PACKET_HEADER_SIZE, payload, len) != 0) {
+            printf("Reply with %zu payload bytes has wrong fields\n", len);
+            exit(1);
+        }
+        
+        // A valid checksum sums the ICMP message to zero
+        if (reference_checksum((const uint8_t*)icmp_header, ICMP_PACKET_ICMP_HEADER_SIZE + len) != 0) {
+            printf("Reply with %zu payload bytes has a bad checksum\n", len);
+            exit(1);
+        }
+        
+        uint16_t stored = icmp_header->icmp_cksum;
+        icmp_header->icmp_cksum = 0;
+        
+        if (reference_checksum((const uint8_t*)icmp_header, ICMP_PACKET_ICMP_HEADER_SIZE + len) != stored) {
+            printf("Incremental checksum differs from a full sum at %zu bytes\n", len);
+            exit(1);
+        }
+    }
+    
+    printf("Template reply test passed\n");
+}
+
+/**
+ * @brief Test single field updates against recomputing the checksum
+ */
+static void test_checksum_replace(void) {
+    printf("Testing incremental checksum updates...\n");
+    
+    uint8_t data[64];
+    unsigned seed = 99;
+    
+    for (int round = 0; round < 100000; round++) {
+        for (size_t i = 0; i < sizeof(data); i++) {
+            seed = seed * 1103515245 + 12345;
+            data[i] = (uint8_t)(seed >> 16);
+        }
+        
+        // Include the all-zero and all-one values that trip naive updates
+        if (round % 10 == 0) {
+            memset(data, round % 20 == 0 ? 0x00 : 0xFF, sizeof(data));
+        }
+        
+        size_t field = (seed >> 8) % (sizeof(data) / 2);
+        uint16_t old_value;
+        uint16_t new_value = (uint16_t)(seed ^ (seed >> 11));
+        memcpy(&old_value, data + field * 2, sizeof(old_value));
+        
+        uint16_t checksum = icmp_checksum(data, sizeof(data));
+        if (checksum != reference_checksum(data, sizeof(data))) {
+            printf("Checksum differs from the reference loop\n");
+            exit(1);
+        }
+        
+        memcpy(data + field * 2, &new_value, sizeof(new_value));
+        
+        uint16_t updated = icmp_checksum_replace(checksum, old_value, new_value);
+        
+        // 0x0000 and 0xFFFF are the same one's complement value
+        uint16_t expected = reference_checksum(data, sizeof(data));
+        if (updated != expected && !((updated == 0 || updated == 0xFFFF) && (expected == 0 || expected == 0xFFFF))) {
+            printf("Incremental update 0x%04x, recomputed 0x%04x\n", updated, expected);
+            exit(1);
+        }
+    }
+    
+    printf("Incremental checksum test passed\n");
+}
+
+/**
+ * @brief Main function
+ */
+int main(void) {
+    test_reply_build();
+    test_checksum_replace();
+    
+    printf("All tests completed successfully\n");
+    
+    return 0;
+}
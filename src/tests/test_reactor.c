@@ -0,0 +1,308 @@
+/**
+ * @file test_reactor.c
+ * @brief Test program for the shared epoll reactor
+ */
+
+#include "../common/reactor.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+// Test configuration
+#define TEST_LOOPS 4
+#define TEST_SOURCES 8
+#define TEST_WRITES 100
+#define TEST_WAIT_MS 2000
+
+// Per-source handler state
+typedef struct {
+    int pipe_fds[2];
+    reactor_source_t* source;
+    int calls;
+    bool in_handler;
+    bool remove_self;
+    useconds_t delay_us;
+    pthread_t thread;
+} test_source_t;
+
+/**
+ * @brief Open a pipe for a test source
+ */
+static void test_source_open(test_source_t* test) {
+    memset(test, 0, sizeof(test_source_t));
+    
+    if (pipe(test->pipe_fds) < 0) {
+        perror("pipe");
+        exit(1);
+    }
+}
+
+/**
+ * @brief Close a test source's pipe
+ */
+static void test_source_close(test_source_t* test) {
+    close(test->pipe_fds[0]);
+    close(test->pipe_fds[1]);
+}
+
+/**
+ * @brief Make a test source readable
+ */
+static void test_source_poke(test_source_t* test) {
+    char byte = 'x';
+    
+    if (write(test->pipe_fds[1], &byte, 1) != 1) {
+        perror("write");
+        exit(1);
+    }
+}
+
+/**
+ * @brief Wait until a handler has run at least a number of times
+ */
+static bool wait_calls(test_source_t* test, int calls) {
+    for (int i = 0; i < TEST_WAIT_MS; i++) {
+        if (__atomic_load_n(&test->calls, __ATOMIC_ACQUIRE) >= calls) {
+            return true;
+        }
+        usleep(1000);
+    }
+    
+    return false;
+}
+
+/**
+ * @brief Handler draining one byte per call
+ */
+static void test_handler(int fd, uint32_t events, void* arg) {
+    (void)events;
+    test_source_t* test = (test_source_t*)arg;
+    
+    __atomic_store_n(&test->in_handler, true, __ATOMIC_RELEASE);
+    test->thread = pthread_self();
+    
+    char byte;
+    if (read(fd, &byte, 1) != 1) {
+        perror("read");
+    }
+    
+    if (test->delay_us > 0) {
+        usleep(test->delay_us);
+    }
+    
+    if (test->remove_self) {
+        reactor_remove(test->source);
+    }
+    
+    __atomic_add_fetch(&test->calls, 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&test->in_handler, false, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Test that readiness is dispatched to the handler
+ */
+static void test_dispatch(void) {
+    printf("Testing reactor dispatch...\n");
+    
+    reactor_t* reactor = NULL;
+    if (reactor_create(1, &reactor) != STATUS_SUCCESS || reactor_loop_count(reactor) != 1) {
+        printf("Failed to create reactor\n");
+        exit(1);
+    }
+    
+    test_source_t test;
+    test_source_open(&test);
+    
+    if (reactor_add(reactor, 0, test.pipe_fds[0], EPOLLIN, test_handler, &test, &test.source) != STATUS_SUCCESS) {
+        printf("Failed to add source\n");
+        exit(1);
+    }
+    
+    // Level-triggered: every queued byte is handled, one per call
+    for (int i = 0; i < TEST_WRITES; i++) {
+        test_source_poke(&test);
+    }
+    
+    if (!wait_calls(&test, TEST_WRITES)) {
+        printf("Handler ran %d of %d times\n", test.calls, TEST_WRITES);
+        exit(1);
+    }
+    
+    reactor_remove(test.source);
+    test_source_close(&test);
+    reactor_destroy(reactor);
+    
+    printf("Reactor dispatch test passed\n");
+}
+
+/**
+ * @brief Test removal from another thread while the handler runs
+ */
+static void test_remove_waits(void) {
+    printf("Testing reactor remove from another thread...\n");
+    
+    reactor_t* reactor = NULL;
+    if (reactor_create(1, &reactor) != STATUS_SUCCESS) {
+        printf("Failed to create reactor\n");
+        exit(1);
+    }
+    
+    test_source_t test;
+    test_source_open(&test);
+    test.delay_us = 100000;
+    
+    if (reactor_add(reactor, 0, test.pipe_fds[0], EPOLLIN, test_handler, &test, &test.source) != STATUS_SUCCESS) {
+        printf("Failed to add source\n");
+        exit(1);
+    }
+    
+    test_source_poke(&test);
+    
+    while (!__atomic_load_n(&test.in_handler, __ATOMIC_ACQUIRE)) {
+        usleep(1000);
+    }
+    
+    // Returns only once the running handler is done
+    reactor_remove(test.source);
+    
+    if (__atomic_load_n(&test.in_handler, __ATOMIC_ACQUIRE) || test.calls != 1) {
+        printf("Remove returned while the handler was running\n");
+        exit(1);
+    }
+    
+    // No calls after removal
+    test_source_poke(&test);
+    usleep(50000);
+    
+    if (test.calls != 1) {
+        printf("Handler ran after removal\n");
+        exit(1);
+    }
+    
+    test_source_close(&test);
+    reactor_destroy(reactor);
+    
+    printf("Reactor remove test passed\n");
+}
+
+/**
+ * @brief Test a handler removing its own source
+ */
+static void test_remove_self(void) {
+    printf("Testing reactor remove from the handler...\n");
+    
+    reactor_t* reactor = NULL;
+    if (reactor_create(1, &reactor) != STATUS_SUCCESS) {
+        printf("Failed to create reactor\n");
+        exit(1);
+    }
+    
+    test_source_t test;
+    test_source_open(&test);
+    test.remove_self = true;
+    
+    if (reactor_add(reactor, 0, test.pipe_fds[0], EPOLLIN, test_handler, &test, &test.source) != STATUS_SUCCESS) {
+        printf("Failed to add source\n");
+        exit(1);
+    }
+    
+    test_source_poke(&test);
+    test_source_poke(&test);
+    
+    if (!wait_calls(&test, 1)) {
+        printf("Handler did not run\n");
+        exit(1);
+    }
+    
+    // The second byte stays unread
+    usleep(50000);
+    
+    if (test.calls != 1) {
+        printf("Handler ran %d times after removing itself\n", test.calls);
+        exit(1);
+    }
+    
+    test_source_close(&test);
+    reactor_destroy(reactor);
+    
+    printf("Reactor self-remove test passed\n");
+}
+
+/**
+ * @brief Test that round-robin sources spread over every loop
+ */
+static void test_loop_spread(void) {
+    printf("Testing reactor loop spread...\n");
+    
+    reactor_t* reactor = NULL;
+    if (reactor_create(TEST_LOOPS, &reactor) != STATUS_SUCCESS || reactor_loop_count(reactor) != TEST_LOOPS) {
+        printf("Failed to create reactor\n");
+        exit(1);
+    }
+    
+    test_source_t tests[TEST_SOURCES];
+    
+    for (int i = 0; i < TEST_SOURCES; i++) {
+        test_source_open(&tests[i]);
+        
+        if (reactor_add(reactor, reactor_next_loop(reactor), tests[i].pipe_fds[0], EPOLLIN,
+                        test_handler, &tests[i], &tests[i].source) != STATUS_SUCCESS) {
+            printf("Failed to add source %d\n", i);
+            exit(1);
+        }
+        
+        test_source_poke(&tests[i]);
+    }
+    
+    pthread_t threads[TEST_SOURCES];
+    size_t thread_count = 0;
+    
+    for (int i = 0; i < TEST_SOURCES; i++) {
+        if (!wait_calls(&tests[i], 1)) {
+            printf("Source %d was not dispatched\n", i);
+            exit(1);
+        }
+        
+        bool seen = false;
+        for (size_t j = 0; j < thread_count; j++) {
+            if (pthread_equal(threads[j], tests[i].thread)) {
+                seen = true;
+                break;
+            }
+        }
+        
+        if (!seen) {
+            threads[thread_count++] = tests[i].thread;
+        }
+    }
+    
+    if (thread_count != TEST_LOOPS) {
+        printf("Sources ran on %zu loops, expected %d\n", thread_count, TEST_LOOPS);
+        exit(1);
+    }
+    
+    for (int i = 0; i < TEST_SOURCES; i++) {
+        reactor_remove(tests[i].source);
+        test_source_close(&tests[i]);
+    }
+    
+    reactor_destroy(reactor);
+    
+    printf("Reactor loop spread test passed\n");
+}
+
+/**
+ * @brief Main function
+ */
+int main(void) {
+    test_dispatch();
+    test_remove_waits();
+    test_remove_self();
+    test_loop_spread();
+    
+    printf("All tests completed successfully\n");
+    
+    return 0;
+}
@@ -0,0 +1,290 @@
+/**
+ * @file test_tcp_framing.c
+ * @brief Test program for the TCP frame reader
+ */
+
+#include "../protocols/tcp_framing.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Test configuration
+#define TEST_CAPACITY 64
+#define TEST_MAX_FRAME 4096
+
+/**
+ * @brief Write bytes into the reader through reserve/commit, like recv() does
+ */
+static void feed(tcp_frame_reader_t* reader, const uint8_t* data, size_t len) {
+    while (len > 0) {
+        uint8_t* buffer = NULL;
+        size_t buffer_len = 0;
+        
+        if (tcp_frame_reader_reserve(reader, &buffer, &buffer_len) != STATUS_SUCCESS) {
+            printf("Failed to reserve buffer\n");
+            exit(1);
+        }
+        
+        if (buffer_len > len) {
+            buffer_len = len;
+        }
+        
+        memcpy(buffer, data, buffer_len);
+        tcp_frame_reader_commit(reader, buffer_len);
+        data += buffer_len;
+        len -= buffer_len;
+    }
+}
+
+/**
+ * @brief Build a length-prefixed frame
+ */
+static size_t make_frame(uint8_t* out, const uint8_t* payload, uint32_t len) {
+    memcpy(out, &len, sizeof(len));
+    memcpy(out + sizeof(len), payload, len);
+    return sizeof(len) + len;
+}
+
+/**
+ * @brief Expect the next frame to match a payload
+ */
+static void expect_frame(tcp_frame_reader_t* reader, const uint8_t* payload, uint32_t len) {
+    const uint8_t* data = NULL;
+    uint32_t data_len = 0;
+    
+    status_t status = tcp_frame_reader_next(reader, &data, &data_len);
+    
+    if (status != STATUS_SUCCESS || data_len != len || memcmp(data, payload, len) != 0) {
+        printf("Frame mismatch: status=%d len=%u expected=%u\n", status, data_len, len);
+        exit(1);
+    }
+}
+
+/**
+ * @brief Expect the reader to need more bytes
+ */
+static void expect_incomplete(tcp_frame_reader_t* reader) {
+    const uint8_t* data = NULL;
+    uint32_t data_len = 0;
+    
+    if (tcp_frame_reader_next(reader, &data, &data_len) != STATUS_ERROR_NOT_FOUND) {
+        printf("Expected an incomplete frame\n");
+        exit(1);
+    }
+}
+
+/**
+ * @brief Test frames split across reads, byte by byte
+ */
+static void test_partial_reads(void) {
+    printf("Testing partial reads...\n");
+    
+    tcp_frame_reader_t reader;
+    tcp_frame_reader_init(&reader, TEST_CAPACITY, TEST_MAX_FRAME);
+    
+    const uint8_t payload[] = "Hello, TCP!";
+    uint8_t frame[64];
+    size_t frame_len = make_frame(frame, payload, sizeof(payload));
+    
+    for (size_t i = 0; i < frame_len - 1; i++) {
+        feed(&reader, frame + i, 1);
+        expect_incomplete(&reader);
+    }
+    
+    feed(&reader, frame + frame_len - 1, 1);
+    expect_frame(&reader, payload, sizeof(payload));
+    expect_incomplete(&reader);
+    
+    tcp_frame_reader_free(&reader);
+    
+    printf("Partial reads test passed\n");
+}
+
+/**
+ * @brief Test several frames in one read, including an empty one
+ */
+static void test_batched_frames(void) {
+    printf("Testing batched frames...\n");
+    
+    tcp_frame_reader_t reader;
+    tcp_frame_reader_init(&reader, TEST_CAPACITY, TEST_MAX_FRAME);
+    
+    uint8_t stream[64];
+    size_t len = 0;
+    len += make_frame(stream + len, (const uint8_t*)"one", 3);
+    len += make_frame(stream + len, (const uint8_t*)"", 0);
+    len += make_frame(stream + len, (const uint8_t*)"three", 5);
+    
+    feed(&reader, stream, len);
+    expect_frame(&reader, (const uint8_t*)"one", 3);
+    expect_frame(&reader, (const uint8_t*)"", 0);
+    expect_frame(&reader, (const uint8_t*)"three", 5);
+    expect_incomplete(&reader);
+    
+    tcp_frame_reader_free(&reader);
+    
+    printf("Batched frames test passed\n");
+}
+
+/**
+ * @brief Test zero-copy hand-off and frames wrapping around the ring
+ */
+static void test_wrap_around(void) {
+    printf("Testing ring wrap-around...\n");
+    
+    tcp_frame_reader_t reader;
+    tcp_frame_reader_init(&reader, TEST_CAPACITY, TEST_MAX_FRAME);
+    
+    // Ten 44-byte frames fed in 20-byte reads keep the head moving round the ring
+    uint8_t payloads[10][40];
+    uint8_t stream[10 * 44];
+    size_t stream_len = 0;
+    
+    for (int i = 0; i < 10; i++) {
+        for (size_t j = 0; j < sizeof(payloads[i]); j++) {
+            payloads[i][j] = (uint8_t)(i * 31 + j);
+        }
+        stream_len += make_frame(stream + stream_len, payloads[i], sizeof(payloads[i]));
+    }
+    
+    int received = 0;
+    int in_place = 0;
+    int copied = 0;
+    
+    for (size_t offset = 0; offset < stream_len; offset += 20) {
+        size_t chunk = stream_len - offset < 20 ? stream_len - offset : 20;
+        feed(&reader, stream + offset, chunk);
+        
+        const uint8_t* data = NULL;
+        uint32_t data_len = 0;
+        
+        while (tcp_frame_reader_next(&reader, &data, &data_len) == STATUS_SUCCESS) {
+            if (data_len != sizeof(payloads[received]) || memcmp(data, payloads[received], data_len) != 0) {
+                printf("Frame %d mismatch\n", received);
+                exit(1);
+            }
+            
+            // Contiguous frames point into the ring, wrapped ones into scratch
+            if (data >= reader.buffer && data < reader.buffer + reader.capacity) {
+                in_place++;
+            } else if (data == reader.scratch) {
+                copied++;
+            }
+            
+            received++;
+        }
+    }
+    
+    if (received != 10 || in_place == 0 || copied == 0 || in_place + copied != 10) {
+        printf("Unexpected frames: received=%d in_place=%d copied=%d\n", received, in_place, copied);
+        exit(1);
+    }
+    
+    if (reader.capacity != TEST_CAPACITY) {
+        printf("Ring grew for frames that fit: %zu\n", reader.capacity);
+        exit(1);
+    }
+    
+    tcp_frame_reader_free(&reader);
+    
+    printf("Ring wrap-around test passed\n");
+}
+
+/**
+ * @brief Test growth for oversized frames and the maximum frame size
+ */
+static void test_oversized_frames(void) {
+    printf("Testing oversized frames...\n");
+    
+    tcp_frame_reader_t reader;
+    tcp_frame_reader_init(&reader, TEST_CAPACITY, TEST_MAX_FRAME);
+    
+    uint32_t big_len = 1000;
+    uint8_t* frame = (uint8_t*)malloc(sizeof(uint32_t) + big_len);
+    uint8_t* payload = (uint8_t*)malloc(big_len);
+    
+    for (uint32_t i = 0; i < big_len; i++) {
+        payload[i] = (uint8_t)(i * 7);
+    }
+    
+    size_t frame_len = make_frame(frame, payload, big_len);
+    
+    // Feed in small slices, taking frames in between like a receive loop
+    size_t offset = 0;
+    while (offset < frame_len) {
+        size_t chunk = frame_len - offset < 48 ? frame_len - offset : 48;
+        feed(&reader, frame + offset, chunk);
+        offset += chunk;
+        
+        if (offset < frame_len) {
+            expect_incomplete(&reader);
+        }
+        
+        // Memory follows the bytes received, never past the frame itself
+        if (reader.capacity != TEST_CAPACITY || reader.scratch_capacity > frame_len ||
+            reader.scratch_capacity > 2 * offset + TEST_CAPACITY) {
+            printf("Reader grew ahead of the data: ring %zu, scratch %zu after %zu bytes\n",
+                   reader.capacity, reader.scratch_capacity, offset);
+            exit(1);
+        }
+    }
+    
+    expect_frame(&reader, payload, big_len);
+    
+    // The assembly buffer is released on the next write
+    uint8_t small[16];
+    feed(&reader, small, make_frame(small, (const uint8_t*)"tiny", 4));
+    
+    if (reader.capacity != TEST_CAPACITY || reader.scratch_capacity > TEST_CAPACITY) {
+        printf("Reader did not shrink back: ring %zu, scratch %zu\n",
+               reader.capacity, reader.scratch_capacity);
+        exit(1);
+    }
+    
+    expect_frame(&reader, (const uint8_t*)"tiny", 4);
+    
+    // A header announcing the largest frame allocates nothing for the payload yet
+    uint32_t announced = TEST_MAX_FRAME;
+    feed(&reader, (const uint8_t*)&announced, sizeof(announced));
+    expect_incomplete(&reader);
+    
+    if (reader.scratch_capacity > sizeof(announced) + TEST_CAPACITY) {
+        printf("Header alone grew the reader: %zu\n", reader.scratch_capacity);
+        exit(1);
+    }
+    
+    tcp_frame_reader_free(&reader);
+    tcp_frame_reader_init(&reader, TEST_CAPACITY, TEST_MAX_FRAME);
+    
+    // Frames over the limit are rejected
+    uint32_t too_big = TEST_MAX_FRAME + 1;
+    feed(&reader, (const uint8_t*)&too_big, sizeof(too_big));
+    
+    const uint8_t* data = NULL;
+    uint32_t data_len = 0;
+    
+    if (tcp_frame_reader_next(&reader, &data, &data_len) != STATUS_ERROR_INVALID_FORMAT) {
+        printf("Oversized frame was not rejected\n");
+        exit(1);
+    }
+    
+    free(payload);
+    free(frame);
+    tcp_frame_reader_free(&reader);
+    
+    printf("Oversized frames test passed\n");
+}
+
+/**
+ * @brief Main function
+ */
+int main(void) {
+    test_partial_reads();
+    test_batched_frames();
+    test_wrap_around();
+    test_oversized_frames();
+    
+    printf("All tests completed successfully\n");
+    
+    return 0;
+}
@@ -8,6 +8,7 @@
 #include "../include/protocol.h"
 #include "../include/common.h"
 #include "../include/client.h"
+#include "../common/reactor.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -25,10 +26,15 @@
 #define TEST_PORT 8080
 #define TEST_MESSAGE "Hello, TCP!"
 #define TEST_TIMEOUT_MS 5000
+#define TEST_HIGH_WATER (256 * 1024)
+#define TEST_FRAME_SIZE (64 * 1024)
+#define TEST_MAX_FRAMES 4096
+#define TEST_REACTOR_LOOPS 2
+#define TEST_IDLE_TIMEOUT_MS 300
 
 // Global variables
 static protocol_listener_t* listener = NULL;
-static client_t* test_client = NULL;
+static client_t* volatile test_client = NULL;
 static bool message_received = false;
 static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
@@ -38,6 +44,7 @@ static void on_message_received(protocol_listener_t* listener, client_t* client,
 static void on_client_connected(protocol_listener_t* listener, client_t* client);
 static void on_client_disconnected(protocol_listener_t* listener, client_t* client);
 static void* client_thread(void* arg);
+static int connect_client(void);
 static void cleanup(void);
 
 /**
@@ -63,8 +70,10 @@ static void cleanup(void) {
 /**
  * @brief Test TCP listener creation
  */
-static void test_tcp_listener_create(void) {
-    printf("Testing TCP listener creation...\n");
+static void test_tcp_listener_create(protocol_io_model_t io_model, uint32_t acceptor_shards, reactor_t* reactor) {
+    const char* model_names[] = { "thread", "epoll", "uring" };
+    printf("Testing TCP listener creation (%s model, %u acceptors%s)...\n",
+           model_names[io_model], acceptor_shards, reactor != NULL ? ", shared reactor" : "");
     
     // Create listener configuration
     protocol_listener_config_t config;
@@ -73,6 +82,10 @@ static void test_tcp_listener_create(void) {
     config.bind_address = TEST_BIND_ADDRESS;
     config.port = TEST_PORT;
     config.timeout_ms = TEST_TIMEOUT_MS;
+    config.io_model = io_model;
+    config.loop_threads = 2;
+    config.acceptor_shards = acceptor_shards;
+    config.send_high_water = TEST_HIGH_WATER;
     
     // Create listener
     status_t status = tcp_listener_create(&config, &listener);
@@ -91,6 +104,15 @@ static void test_tcp_listener_create(void) {
         exit(1);
     }
     
+    // Serve acceptors and clients from the shared reactor's loops
+    if (reactor != NULL) {
+        if (listener->attach_reactor == NULL || listener->attach_reactor(listener, reactor) != STATUS_SUCCESS) {
+            printf("Failed to attach the reactor\n");
+            listener->destroy(listener);
+            exit(1);
+        }
+    }
+    
     printf("TCP listener created successfully\n");
 }
 
@@ -179,18 +201,205 @@ static void test_tcp_message_send_receive(void) {
 }
 
 /**
- * @brief Client thread function
+ * @brief Test that sends to a client that stops reading are refused, not blocked
  */
-static void* client_thread(void* arg) {
-    // Sleep for a bit to allow server to start
-    sleep(1);
+static void test_tcp_backpressure(void) {
+    printf("Testing TCP send backpressure...\n");
+    
+    test_client = NULL;
+    
+    int sock = connect_client();
+    if (sock < 0) {
+        cleanup();
+        exit(1);
+    }
+    
+    // Wait for the listener to register the connection
+    for (int i = 0; i < 500 && test_client == NULL; i++) {
+        usleep(10000);
+    }
+    
+    client_t* client = test_client;
+    if (client == NULL) {
+        printf("Timeout waiting for client connection\n");
+        close(sock);
+        cleanup();
+        exit(1);
+    }
+    
+    uint8_t* payload = (uint8_t*)malloc(TEST_FRAME_SIZE);
+    protocol_message_t message;
+    message.data = payload;
+    message.data_len = TEST_FRAME_SIZE;
+    
+    // Send until the client's queue reaches the high-water mark
+    int frames_sent = 0;
+    status_t status = STATUS_SUCCESS;
+    
+    while (frames_sent < TEST_MAX_FRAMES) {
+        memset(payload, frames_sent & 0xff, TEST_FRAME_SIZE);
+        
+        status = protocol_manager_send_message(listener, client, &message);
+        if (status != STATUS_SUCCESS) {
+            break;
+        }
+        
+        frames_sent++;
+    }
+    
+    size_t queued = 0;
+    bool backed_up = false;
+    protocol_manager_get_send_backlog(listener, client, &queued, &backed_up);
+    
+    if (status != STATUS_ERROR_WOULD_BLOCK || !backed_up || queued < TEST_HIGH_WATER) {
+        printf("Expected backpressure: status=%d backed_up=%d queued=%zu\n", status, backed_up, queued);
+        free(payload);
+        close(sock);
+        cleanup();
+        exit(1);
+    }
+    
+    printf("Backpressure after %d frames with %zu bytes queued\n", frames_sent, queued);
+    
+    // Drain the socket, every frame must arrive whole and in order
+    for (int i = 0; i < frames_sent; i++) {
+        uint32_t length = 0;
+        
+        if (recv(sock, &length, sizeof(length), MSG_WAITALL) != sizeof(length) ||
+            length != TEST_FRAME_SIZE ||
+            recv(sock, payload, length, MSG_WAITALL) != (ssize_t)length ||
+            payload[0] != (uint8_t)(i & 0xff) || payload[length - 1] != (uint8_t)(i & 0xff)) {
+            printf("Frame %d corrupted\n", i);
+            free(payload);
+            close(sock);
+            cleanup();
+            exit(1);
+        }
+    }
+    
+    // The queue empties once the client reads again
+    for (int i = 0; i < 100; i++) {
+        protocol_manager_get_send_backlog(listener, client, &queued, &backed_up);
+        if (queued == 0) {
+            break;
+        }
+        usleep(10000);
+    }
+    
+    if (queued != 0 || backed_up) {
+        printf("Send queue did not drain: %zu bytes\n", queued);
+        free(payload);
+        close(sock);
+        cleanup();
+        exit(1);
+    }
+    
+    free(payload);
+    close(sock);
+    
+    printf("TCP backpressure test completed successfully\n");
+}
+
+/**
+ * @brief Test that connections silent for the listener timeout are closed, and active ones are not
+ */
+static void test_tcp_idle_timeout(protocol_io_model_t io_model) {
+    const char* model_names[] = { "thread", "epoll", "uring" };
+    printf("Testing TCP idle timeout (%s model)...\n", model_names[io_model]);
+    
+    protocol_listener_config_t config;
+    memset(&config, 0, sizeof(config));
+    
+    config.bind_address = TEST_BIND_ADDRESS;
+    config.port = TEST_PORT;
+    config.timeout_ms = TEST_IDLE_TIMEOUT_MS;
+    config.io_model = io_model;
+    config.loop_threads = 2;
+    
+    if (tcp_listener_create(&config, &listener) != STATUS_SUCCESS ||
+        listener->register_callbacks(listener, on_message_received, on_client_connected, on_client_disconnected) != STATUS_SUCCESS ||
+        listener->attach_timing_wheel == NULL ||
+        listener->attach_timing_wheel(listener, protocol_manager_get_timing_wheel()) != STATUS_SUCCESS ||
+        listener->start(listener) != STATUS_SUCCESS) {
+        printf("Failed to set up TCP listener with an idle timeout\n");
+        cleanup();
+        exit(1);
+    }
+    
+    test_client = NULL;
     
+    int sock = connect_client();
+    if (sock < 0) {
+        cleanup();
+        exit(1);
+    }
+    
+    // Send before the timeout, the echo proves the connection is still served
+    usleep(TEST_IDLE_TIMEOUT_MS * 2 / 3 * 1000);
+    
+    uint32_t length = (uint32_t)strlen(TEST_MESSAGE);
+    char response[sizeof(TEST_MESSAGE)];
+    
+    if (send(sock, &length, sizeof(length), 0) != sizeof(length) ||
+        send(sock, TEST_MESSAGE, length, 0) != (ssize_t)length ||
+        recv(sock, &length, sizeof(length), MSG_WAITALL) != sizeof(length) ||
+        recv(sock, response, length, MSG_WAITALL) != (ssize_t)length) {
+        printf("Active connection was closed\n");
+        close(sock);
+        cleanup();
+        exit(1);
+    }
+    
+    // Past the first deadline, but not idle for a full timeout since the message
+    usleep(TEST_IDLE_TIMEOUT_MS * 2 / 3 * 1000);
+    
+    if (test_client == NULL) {
+        printf("Connection reaped within the timeout of its last message\n");
+        close(sock);
+        cleanup();
+        exit(1);
+    }
+    
+    // Now silent: the server closes the connection
+    struct timeval tv;
+    tv.tv_sec = 2;
+    tv.tv_usec = 0;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    
+    if (recv(sock, response, sizeof(response), 0) != 0) {
+        printf("Idle connection was not closed\n");
+        close(sock);
+        cleanup();
+        exit(1);
+    }
+    
+    for (int i = 0; i < 200 && test_client != NULL; i++) {
+        usleep(10000);
+    }
+    
+    if (test_client != NULL) {
+        printf("Idle client was not disconnected\n");
+        close(sock);
+        cleanup();
+        exit(1);
+    }
+    
+    close(sock);
+    cleanup();
+    
+    printf("TCP idle timeout test completed successfully\n");
+}
+
+/**
+ * @brief Connect a test client to the listener
+ */
+static int connect_client(void) {
     // Create socket
     int sock = socket(AF_INET, SOCK_STREAM, 0);
     
     if (sock < 0) {
         perror("socket");
-        return NULL;
+        return -1;
     }
     
     // Connect to server
@@ -203,13 +412,28 @@ static void* client_thread(void* arg) {
     if (connect(sock, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
         perror("connect");
         close(sock);
-        return NULL;
+        return -1;
     }
     
     printf("Connected to TCP server\n");
     
-    // Send message length
-    uint32_t length = htonl((uint32_t)strlen(TEST_MESSAGE));
+    return sock;
+}
+
+/**
+ * @brief Client thread function
+ */
+static void* client_thread(void* arg) {
+    // Sleep for a bit to allow server to start
+    sleep(1);
+    
+    int sock = connect_client();
+    if (sock < 0) {
+        return NULL;
+    }
+    
+    // Send message length (native byte order, as framed by the listener)
+    uint32_t length = (uint32_t)strlen(TEST_MESSAGE);
     if (send(sock, &length, sizeof(length), 0) != sizeof(length)) {
         perror("send length");
         close(sock);
@@ -226,15 +450,13 @@ static void* client_thread(void* arg) {
     printf("Message sent: %s\n", TEST_MESSAGE);
     
     // Receive response length
-    uint32_t response_length_network;
-    if (recv(sock, &response_length_network, sizeof(response_length_network), 0) != sizeof(response_length_network)) {
+    uint32_t response_length;
+    if (recv(sock, &response_length, sizeof(response_length), MSG_WAITALL) != sizeof(response_length)) {
         perror("recv length");
         close(sock);
         return NULL;
     }
     
-    uint32_t response_length = ntohl(response_length_network);
-    
     // Allocate buffer for response
     char* buffer = (char*)malloc(response_length + 1);
     
@@ -322,13 +544,45 @@ int main(int argc, char** argv) {
         return 1;
     }
     
-    // Run tests
-    test_tcp_listener_create();
-    test_tcp_listener_start_stop();
-    test_tcp_message_send_receive();
+    reactor_t* reactor = NULL;
+    status = reactor_create(TEST_REACTOR_LOOPS, &reactor);
     
-    // Clean up
-    cleanup();
+    if (status != STATUS_SUCCESS) {
+        printf("Failed to create reactor: %d\n", status);
+        return 1;
+    }
+    
+    // Run tests for each I/O model, with a single and a sharded acceptor
+    const struct {
+        protocol_io_model_t io_model;
+        uint32_t acceptor_shards;
+        bool shared_reactor;
+    } variants[] = {
+        { PROTOCOL_IO_MODEL_THREAD, 1, false },
+        { PROTOCOL_IO_MODEL_EPOLL, 1, false },
+        { PROTOCOL_IO_MODEL_EPOLL, 4, false },
+        { PROTOCOL_IO_MODEL_EPOLL, 4, true },
+        { PROTOCOL_IO_MODEL_URING, 1, false },
+    };
+    
+    for (size_t i = 0; i < sizeof(variants) / sizeof(variants[0]); i++) {
+        message_received = false;
+        
+        test_tcp_listener_create(variants[i].io_model, variants[i].acceptor_shards,
+                                 variants[i].shared_reactor ? reactor : NULL);
+        test_tcp_listener_start_stop();
+        test_tcp_message_send_receive();
+        test_tcp_backpressure();
+        
+        // Clean up
+        cleanup();
+    }
+    
+    test_tcp_idle_timeout(PROTOCOL_IO_MODEL_THREAD);
+    test_tcp_idle_timeout(PROTOCOL_IO_MODEL_EPOLL);
+    test_tcp_idle_timeout(PROTOCOL_IO_MODEL_URING);
+    
+    reactor_destroy(reactor);
     protocol_manager_shutdown();
     
     printf("All tests completed successfully\n");
@@ -0,0 +1,332 @@
+/**
+ * @file test_timing_wheel.c
+ * @brief Test program for the hierarchical timing wheel
+ */
+
+#define _DEFAULT_SOURCE /* For usleep */
+
+#include "../common/timing_wheel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+// Test configuration
+#define TEST_TIMERS 1000
+#define TEST_TICK_MS 10
+
+// Per-timer callback state
+typedef struct {
+    timing_wheel_timer_t timer;
+    timing_wheel_t* wheel;
+    int fired;
+    uint64_t fired_tick;            // Ticks advanced when the callback ran (manual wheels)
+    uint64_t fired_ms;              // Clock time the callback ran (threaded wheels)
+    int rearm;                      // Times the callback reschedules itself
+    uint64_t rearm_ms;
+    useconds_t delay_us;            // Time spent in the callback
+} test_timer_t;
+
+// Ticks advanced so far on the manual wheel under test
+static uint64_t test_ticks = 0;
+
+/**
+ * @brief Record an expiry, rescheduling when asked to
+ */
+static void test_callback(timing_wheel_timer_t* timer, void* arg) {
+    test_timer_t* test = (test_timer_t*)arg;
+    
+    if (timer != &test->timer) {
+        printf("Callback got the wrong timer\n");
+        exit(1);
+    }
+    
+    if (test->delay_us > 0) {
+        usleep(test->delay_us);
+    }
+    
+    __atomic_add_fetch(&test->fired, 1, __ATOMIC_SEQ_CST);
+    test->fired_tick = test_ticks;
+    test->fired_ms = timing_wheel_now_ms();
+    
+    if (test->rearm > 0) {
+        test->rearm--;
+        timing_wheel_schedule(test->wheel, timer, test->rearm_ms);
+    }
+}
+
+/**
+ * @brief Advance a manual wheel one tick at a time, tracking the tick count
+ */
+static void advance(timing_wheel_t* wheel, uint64_t ticks) {
+    for (uint64_t i = 0; i < ticks; i++) {
+        test_ticks++;
+        timing_wheel_advance(wheel, 1);
+    }
+}
+
+/**
+ * @brief Create a wheel or exit
+ */
+static timing_wheel_t* create_wheel(bool run_thread) {
+    timing_wheel_t* wheel = NULL;
+    
+    if (timing_wheel_create(TEST_TICK_MS, run_thread, &wheel) != STATUS_SUCCESS) {
+        printf("Failed to create timing wheel\n");
+        exit(1);
+    }
+    
+    test_ticks = 0;
+    
+    return wheel;
+}
+
+/**
+ * @brief Test that timers fire on their tick at every level of the wheel
+ */
+static void test_expiry(void) {
+    printf("Testing expiry across levels...\n");
+    
+    timing_wheel_t* wheel = create_wheel(false);
+    
+    // Delays in ticks, covering level 0, the cascades into it and the top level
+    const uint64_t delays[] = { 1, 2, 63, 64, 65, 100, 4095, 4096, 4097, 5000, 262143, 262144, 300000 };
+    const size_t count = sizeof(delays) / sizeof(delays[0]);
+    test_timer_t tests[sizeof(delays) / sizeof(delays[0])];
+    
+    // Start off a slot boundary so cascades are not aligned with the delays
+    advance(wheel, 37);
+    uint64_t start = test_ticks;
+    
+    for (size_t i = 0; i < count; i++) {
+        memset(&tests[i], 0, sizeof(test_timer_t));
+        timing_wheel_timer_init(&tests[i].timer, test_callback, &tests[i]);
+        timing_wheel_schedule(wheel, &tests[i].timer, delays[i] * TEST_TICK_MS);
+    }
+    
+    advance(wheel, 300000);
+    
+    for (size_t i = 0; i < count; i++) {
+        if (tests[i].fired != 1 || tests[i].fired_tick != start + delays[i]) {
+            printf("Timer for %llu ticks fired %d times at tick %llu, expected once at %llu\n",
+                   (unsigned long long)delays[i], tests[i].fired,
+                   (unsigned long long)(tests[i].fired_tick - start), (unsigned long long)delays[i]);
+            exit(1);
+        }
+    }
+    
+    timing_wheel_destroy(wheel);
+    
+    printf("Expiry test passed\n");
+}
+
+/**
+ * @brief Test that delays round up to whole ticks and zero fires on the next tick
+ */
+static void test_rounding(void) {
+    printf("Testing tick rounding...\n");
+    
+    timing_wheel_t* wheel = create_wheel(false);
+    test_timer_t zero;
+    test_timer_t partial;
+    
+    memset(&zero, 0, sizeof(zero));
+    memset(&partial, 0, sizeof(partial));
+    timing_wheel_timer_init(&zero.timer, test_callback, &zero);
+    timing_wheel_timer_init(&partial.timer, test_callback, &partial);
+    
+    timing_wheel_schedule(wheel, &zero.timer, 0);
+    timing_wheel_schedule(wheel, &partial.timer, TEST_TICK_MS + 1);
+    
+    advance(wheel, 1);
+    
+    if (zero.fired != 1 || partial.fired != 0) {
+        printf("After one tick: zero delay fired %d, partial tick fired %d\n", zero.fired, partial.fired);
+        exit(1);
+    }
+    
+    advance(wheel, 1);
+    
+    if (partial.fired != 1) {
+        printf("Partial tick delay did not round up to two ticks\n");
+        exit(1);
+    }
+    
+    timing_wheel_destroy(wheel);
+    
+    printf("Tick rounding test passed\n");
+}
+
+/**
+ * @brief Test cancelling and moving many timers
+ */
+static void test_cancel_and_move(void) {
+    printf("Testing cancel and reschedule...\n");
+    
+    timing_wheel_t* wheel = create_wheel(false);
+    test_timer_t* tests = (test_timer_t*)calloc(TEST_TIMERS, sizeof(test_timer_t));
+    
+    if (tests == NULL) {
+        printf("Failed to allocate timers\n");
+        exit(1);
+    }
+    
+    for (size_t i = 0; i < TEST_TIMERS; i++) {
+        timing_wheel_timer_init(&tests[i].timer, test_callback, &tests[i]);
+        timing_wheel_schedule(wheel, &tests[i].timer, (uint64_t)(i + 1) * 7 * TEST_TICK_MS);
+    }
+    
+    // Cancel every third timer, push every other one further out
+    for (size_t i = 0; i < TEST_TIMERS; i++) {
+        if (i % 3 == 0) {
+            timing_wheel_cancel(wheel, &tests[i].timer);
+        } else if (i % 3 == 1) {
+            timing_wheel_schedule(wheel, &tests[i].timer, (uint64_t)(i + 1) * 7 * TEST_TICK_MS + 5000 * TEST_TICK_MS);
+        }
+    }
+    
+    // Cancelling twice is harmless
+    timing_wheel_cancel(wheel, &tests[0].timer);
+    
+    advance(wheel, TEST_TIMERS * 7 + 5000);
+    
+    for (size_t i = 0; i < TEST_TIMERS; i++) {
+        uint64_t expected = (uint64_t)(i + 1) * 7 + (i % 3 == 1 ? 5000 : 0);
+        
+        if (i % 3 == 0 ? tests[i].fired != 0 : (tests[i].fired != 1 || tests[i].fired_tick != expected)) {
+            printf("Timer %zu fired %d times at tick %llu\n", i, tests[i].fired, (unsigned long long)tests[i].fired_tick);
+            exit(1);
+        }
+    }
+    
+    free(tests);
+    timing_wheel_destroy(wheel);
+    
+    printf("Cancel and reschedule test passed\n");
+}
+
+/**
+ * @brief Test a callback rearming its own timer, as idle timers do
+ */
+static void test_rearm_from_callback(void) {
+    printf("Testing rearm from the callback...\n");
+    
+    timing_wheel_t* wheel = create_wheel(false);
+    test_timer_t test;
+    
+    memset(&test, 0, sizeof(test));
+    test.wheel = wheel;
+    test.rearm = 3;
+    test.rearm_ms = 100 * TEST_TICK_MS;
+    timing_wheel_timer_init(&test.timer, test_callback, &test);
+    timing_wheel_schedule(wheel, &test.timer, 10 * TEST_TICK_MS);
+    
+    advance(wheel, 10 + 3 * 100 + 50);
+    
+    if (test.fired != 4 || test.fired_tick != 10 + 3 * 100) {
+        printf("Rearming timer fired %d times, last at tick %llu\n", test.fired, (unsigned long long)test.fired_tick);
+        exit(1);
+    }
+    
+    timing_wheel_destroy(wheel);
+    
+    printf("Rearm test passed\n");
+}
+
+/**
+ * @brief Test the wheel thread against the clock
+ */
+static void test_threaded(void) {
+    printf("Testing threaded wheel...\n");
+    
+    timing_wheel_t* wheel = create_wheel(true);
+    test_timer_t early;
+    test_timer_t late;
+    
+    memset(&early, 0, sizeof(early));
+    memset(&late, 0, sizeof(late));
+    timing_wheel_timer_init(&early.timer, test_callback, &early);
+    timing_wheel_timer_init(&late.timer, test_callback, &late);
+    
+    // Let the wheel sleep with nothing armed first
+    usleep(50000);
+    
+    uint64_t start = timing_wheel_now_ms();
+    timing_wheel_schedule(wheel, &early.timer, 50);
+    timing_wheel_schedule(wheel, &late.timer, 150);
+    
+    usleep(400000);
+    
+    if (early.fired != 1 || late.fired != 1) {
+        printf("Timers fired %d and %d times\n", early.fired, late.fired);
+        exit(1);
+    }
+    
+    // Never early, and late by no more than a couple of ticks plus scheduling noise
+    if (early.fired_ms < start + 50 || early.fired_ms > start + 50 + 100 ||
+        late.fired_ms < start + 150 || late.fired_ms > start + 150 + 100) {
+        printf("Timers fired after %llu and %llu ms\n",
+               (unsigned long long)(early.fired_ms - start), (unsigned long long)(late.fired_ms - start));
+        exit(1);
+    }
+    
+    timing_wheel_destroy(wheel);
+    
+    printf("Threaded wheel test passed\n");
+}
+
+/**
+ * @brief Test that cancel waits for a callback in progress
+ */
+static void test_cancel_waits(void) {
+    printf("Testing cancel against a running callback...\n");
+    
+    timing_wheel_t* wheel = create_wheel(true);
+    test_timer_t test;
+    
+    memset(&test, 0, sizeof(test));
+    test.wheel = wheel;
+    test.delay_us = 200000;
+    test.rearm = 1;
+    test.rearm_ms = 10;
+    timing_wheel_timer_init(&test.timer, test_callback, &test);
+    timing_wheel_schedule(wheel, &test.timer, TEST_TICK_MS);
+    
+    // Land in the middle of the slow callback
+    usleep(100000);
+    timing_wheel_cancel(wheel, &test.timer);
+    
+    // The callback had finished and its rearm was undone
+    if (__atomic_load_n(&test.fired, __ATOMIC_SEQ_CST) != 1) {
+        printf("Cancel returned while the callback was running\n");
+        exit(1);
+    }
+    
+    usleep(100000);
+    
+    if (test.fired != 1) {
+        printf("Rearmed timer fired after cancel\n");
+        exit(1);
+    }
+    
+    timing_wheel_destroy(wheel);
+    
+    printf("Cancel wait test passed\n");
+}
+
+/**
+ * @brief Main function
+ */
+int main(void) {
+    test_expiry();
+    test_rounding();
+    test_cancel_and_move();
+    test_rearm_from_callback();
+    test_threaded();
+    test_cancel_waits();
+    
+    printf("All tests completed successfully\n");
+    
+    return 0;
+}
@@ -6,6 +6,8 @@
 #include "../include/protocol.h"
 #include "../include/common.h"
 #include "../include/client.h"
+#include "../include/protocol_header.h"
+#include "../common/reactor.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -15,12 +17,19 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <time.h>
+#include <errno.h>
 
 // Test configuration
 #define TEST_BIND_ADDRESS "127.0.0.1"
 #define TEST_PORT 8081
 #define TEST_MESSAGE "Hello, UDP!"
 #define TEST_TIMEOUT_MS 5000
+#define TEST_BURST 100
+#define TEST_WORKERS 4
+#define TEST_WORKER_PEERS 32
+#define TEST_FILTER_JUNK 16
+#define TEST_REACTOR_LOOPS 2
 
 // Global variables
 static protocol_listener_t* listener = NULL;
@@ -174,6 +183,344 @@ static void test_udp_message_send_receive(void) {
     printf("UDP message test completed successfully\n");
 }
 
+/**
+ * @brief Test a burst of datagrams, received and echoed in batches
+ */
+static void test_udp_burst(void) {
+    printf("Testing UDP datagram burst...\n");
+    
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    
+    if (sock < 0) {
+        perror("socket");
+        cleanup();
+        exit(1);
+    }
+    
+    struct timeval tv;
+    tv.tv_sec = 5;
+    tv.tv_usec = 0;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = inet_addr(TEST_BIND_ADDRESS);
+    server_addr.sin_port = htons(TEST_PORT);
+    
+    // Send every datagram before reading any reply
+    for (int i = 0; i < TEST_BURST; i++) {
+        char datagram[32];
+        int len = snprintf(datagram, sizeof(datagram), "burst-%d", i);
+        
+        if (sendto(sock, datagram, len, 0, (struct sockaddr*)&server_addr, sizeof(server_addr)) != len) {
+            perror("sendto");
+            close(sock);
+            cleanup();
+            exit(1);
+        }
+    }
+    
+    // Every datagram must be echoed exactly once
+    bool seen[TEST_BURST];
+    memset(seen, 0, sizeof(seen));
+    
+    for (int i = 0; i < TEST_BURST; i++) {
+        char buffer[64];
+        ssize_t recv_len = recv(sock, buffer, sizeof(buffer) - 1, 0);
+        
+        if (recv_len < 0) {
+            printf("Timeout after %d of %d echoes\n", i, TEST_BURST);
+            close(sock);
+            cleanup();
+            exit(1);
+        }
+        
+        buffer[recv_len] = '\0';
+        
+        int index = -1;
+        if (sscanf(buffer, "burst-%d", &index) != 1 || index < 0 || index >= TEST_BURST || seen[index]) {
+            printf("Unexpected echo: %s\n", buffer);
+            close(sock);
+            cleanup();
+            exit(1);
+        }
+        
+        seen[index] = true;
+    }
+    
+    close(sock);
+    
+    printf("UDP burst test completed successfully\n");
+}
+
+/**
+ * @brief Test SO_REUSEPORT workers, each peer answered from the port it sent to
+ */
+static void test_udp_workers(void) {
+    printf("Testing UDP SO_REUSEPORT workers...\n");
+    
+    protocol_listener_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.bind_address = TEST_BIND_ADDRESS;
+    config.port = TEST_PORT + 1;
+    config.timeout_ms = TEST_TIMEOUT_MS;
+    config.workers = TEST_WORKERS;
+    
+    protocol_listener_t* workers_listener = NULL;
+    
+    if (udp_listener_create(&config, &workers_listener) != STATUS_SUCCESS ||
+        workers_listener->register_callbacks(workers_listener, on_message_received, on_client_connected, on_client_disconnected) != STATUS_SUCCESS ||
+        workers_listener->start(workers_listener) != STATUS_SUCCESS) {
+        printf("Failed to start UDP listener with %d workers\n", TEST_WORKERS);
+        cleanup();
+        exit(1);
+    }
+    
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = inet_addr(TEST_BIND_ADDRESS);
+    server_addr.sin_port = htons(TEST_PORT + 1);
+    
+    // Distinct source ports spread the peers over the worker sockets
+    int socks[TEST_WORKER_PEERS];
+    
+    for (int i = 0; i < TEST_WORKER_PEERS; i++) {
+        socks[i] = socket(AF_INET, SOCK_DGRAM, 0);
+        
+        struct timeval tv;
+        tv.tv_sec = 5;
+        tv.tv_usec = 0;
+        setsockopt(socks[i], SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        
+        char datagram[32];
+        int len = snprintf(datagram, sizeof(datagram), "peer-%d", i);
+        
+        if (sendto(socks[i], datagram, len, 0, (struct sockaddr*)&server_addr, sizeof(server_addr)) != len) {
+            perror("sendto");
+            exit(1);
+        }
+    }
+    
+    for (int i = 0; i < TEST_WORKER_PEERS; i++) {
+        char buffer[64];
+        char expected[32];
+        struct sockaddr_in from_addr;
+        socklen_t from_addr_len = sizeof(from_addr);
+        
+        ssize_t recv_len = recvfrom(socks[i], buffer, sizeof(buffer) - 1, 0,
+                                    (struct sockaddr*)&from_addr, &from_addr_len);
+        
+        if (recv_len < 0) {
+            printf("Timeout waiting for the echo to peer %d\n", i);
+            exit(1);
+        }
+        
+        buffer[recv_len] = '\0';
+        snprintf(expected, sizeof(expected), "peer-%d", i);
+        
+        // The reply must come back from the listening port, not another socket
+        if (strcmp(buffer, expected) != 0 || from_addr.sin_port != server_addr.sin_port) {
+            printf("Unexpected echo to peer %d: %s from port %d\n", i, buffer, ntohs(from_addr.sin_port));
+            exit(1);
+        }
+        
+        close(socks[i]);
+    }
+    
+    workers_listener->stop(workers_listener);
+    workers_listener->destroy(workers_listener);
+    
+    printf("UDP workers test completed successfully\n");
+}
+
+/**
+ * @brief Test the kernel socket filter, which drops datagrams that are not protocol traffic
+ */
+static void test_udp_socket_filter(void) {
+    printf("Testing UDP kernel socket filter...\n");
+    
+    protocol_listener_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.bind_address = TEST_BIND_ADDRESS;
+    config.port = TEST_PORT + 2;
+    config.timeout_ms = TEST_TIMEOUT_MS;
+    config.socket_filter = true;
+    
+    protocol_listener_t* filter_listener = NULL;
+    
+    if (udp_listener_create(&config, &filter_listener) != STATUS_SUCCESS ||
+        filter_listener->register_callbacks(filter_listener, on_message_received, on_client_connected, on_client_disconnected) != STATUS_SUCCESS ||
+        filter_listener->start(filter_listener) != STATUS_SUCCESS) {
+        printf("Failed to start UDP listener with a socket filter\n");
+        cleanup();
+        exit(1);
+    }
+    
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    
+    struct timeval tv;
+    tv.tv_sec = 5;
+    tv.tv_usec = 0;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = inet_addr(TEST_BIND_ADDRESS);
+    server_addr.sin_port = htons(TEST_PORT + 2);
+    
+    // Junk first, including a protocol magic too short to hold a header
+    for (int i = 0; i < TEST_FILTER_JUNK; i++) {
+        char datagram[32];
+        int len = snprintf(datagram, sizeof(datagram), "junk-%d", i);
+        
+        if (i == 0) {
+            uint32_t magic = PROTOCOL_MAGIC;
+            memcpy(datagram, &magic, sizeof(magic));
+        }
+        
+        sendto(sock, datagram, len, 0, (struct sockaddr*)&server_addr, sizeof(server_addr));
+    }
+    
+    protocol_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = PROTOCOL_MAGIC;
+    header.version = PROTOCOL_VERSION;
+    header.sequence = 42;
+    
+    if (sendto(sock, &header, sizeof(header), 0, (struct sockaddr*)&server_addr, sizeof(server_addr)) != sizeof(header)) {
+        perror("sendto");
+        exit(1);
+    }
+    
+    // Junk would have been echoed first, so the first echo must be the header
+    protocol_header_t echo;
+    ssize_t recv_len = recv(sock, &echo, sizeof(echo), 0);
+    
+    if (recv_len != sizeof(header) || memcmp(&echo, &header, sizeof(header)) != 0) {
+        printf("Unexpected echo through the socket filter: %zd bytes\n", recv_len);
+        exit(1);
+    }
+    
+    close(sock);
+    
+    protocol_stat_t stats[PROTOCOL_MAX_STATS];
+    size_t count = PROTOCOL_MAX_STATS;
+    uint64_t kernel_drops = 0;
+    
+    if (protocol_manager_get_stats(filter_listener, stats, &count) != STATUS_SUCCESS) {
+        printf("Failed to get UDP listener stats\n");
+        exit(1);
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(stats[i].name, "kernel_drops") == 0) {
+            kernel_drops = stats[i].value;
+        }
+    }
+    
+    if (kernel_drops < TEST_FILTER_JUNK) {
+        printf("Expected at least %d kernel drops, got %llu\n", TEST_FILTER_JUNK, (unsigned long long)kernel_drops);
+        exit(1);
+    }
+    
+    filter_listener->stop(filter_listener);
+    filter_listener->destroy(filter_listener);
+    
+    printf("UDP socket filter test completed successfully (%llu kernel drops)\n", (unsigned long long)kernel_drops);
+}
+
+/**
+ * @brief Test workers served by a shared reactor instead of their own threads
+ */
+static void test_udp_reactor(void) {
+    printf("Testing UDP workers on a shared reactor...\n");
+    
+    reactor_t* reactor = NULL;
+    
+    if (reactor_create(TEST_REACTOR_LOOPS, &reactor) != STATUS_SUCCESS) {
+        printf("Failed to create reactor\n");
+        cleanup();
+        exit(1);
+    }
+    
+    protocol_listener_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.bind_address = TEST_BIND_ADDRESS;
+    config.port = TEST_PORT + 3;
+    config.timeout_ms = TEST_TIMEOUT_MS;
+    config.workers = TEST_WORKERS;
+    
+    protocol_listener_t* reactor_listener = NULL;
+    
+    if (udp_listener_create(&config, &reactor_listener) != STATUS_SUCCESS ||
+        reactor_listener->attach_reactor == NULL ||
+        reactor_listener->attach_reactor(reactor_listener, reactor) != STATUS_SUCCESS ||
+        reactor_listener->register_callbacks(reactor_listener, on_message_received, on_client_connected, on_client_disconnected) != STATUS_SUCCESS ||
+        reactor_listener->start(reactor_listener) != STATUS_SUCCESS) {
+        printf("Failed to start UDP listener on the reactor\n");
+        cleanup();
+        exit(1);
+    }
+    
+    struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_addr.s_addr = inet_addr(TEST_BIND_ADDRESS);
+    server_addr.sin_port = htons(TEST_PORT + 3);
+    
+    // Peers spread over the worker sockets, which share the reactor's loops
+    int socks[TEST_WORKER_PEERS];
+    
+    for (int i = 0; i < TEST_WORKER_PEERS; i++) {
+        socks[i] = socket(AF_INET, SOCK_DGRAM, 0);
+        
+        struct timeval tv;
+        tv.tv_sec = 5;
+        tv.tv_usec = 0;
+        setsockopt(socks[i], SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        
+        char datagram[32];
+        int len = snprintf(datagram, sizeof(datagram), "peer-%d", i);
+        
+        if (sendto(socks[i], datagram, len, 0, (struct sockaddr*)&server_addr, sizeof(server_addr)) != len) {
+            perror("sendto");
+            exit(1);
+        }
+    }
+    
+    for (int i = 0; i < TEST_WORKER_PEERS; i++) {
+        char buffer[64];
+        char expected[32];
+        
+        ssize_t recv_len = recv(socks[i], buffer, sizeof(buffer) - 1, 0);
+        
+        if (recv_len < 0) {
+            printf("Timeout waiting for the reactor echo to peer %d\n", i);
+            exit(1);
+        }
+        
+        buffer[recv_len] = '\0';
+        snprintf(expected, sizeof(expected), "peer-%d", i);
+        
+        if (strcmp(buffer, expected) != 0) {
+            printf("Unexpected reactor echo to peer %d: %s\n", i, buffer);
+            exit(1);
+        }
+        
+        close(socks[i]);
+    }
+    
+    // Stop leaves the reactor, which can then go away
+    reactor_listener->stop(reactor_listener);
+    reactor_listener->destroy(reactor_listener);
+    reactor_destroy(reactor);
+    
+    printf("UDP reactor test completed successfully\n");
+}
+
 /**
  * @brief Client thread function
  */
@@ -244,7 +591,9 @@ static void* client_thread(void* arg) {
  * @brief Message received callback
  */
 static void on_message_received(protocol_listener_t* listener, client_t* client, protocol_message_t* message) {
-    printf("Message received: %.*s\n", (int)message->data_len, message->data);
+    if (message->data_len < 6 || memcmp(message->data, "burst-", 6) != 0) {
+        printf("Message received: %.*s\n", (int)message->data_len, message->data);
+    }
     
     // Check if this is the test message
     if (message->data_len == strlen(TEST_MESSAGE) &&
@@ -297,6 +646,10 @@ int main(int argc, char** argv) {
     test_udp_listener_create();
     test_udp_listener_start_stop();
     test_udp_message_send_receive();
+    test_udp_burst();
+    test_udp_workers();
+    test_udp_socket_filter();
+    test_udp_reactor();
     
     // Clean up
     cleanup();
@@ -0,0 +1,194 @@
+/**
+ * @file test_udp_sessions.c
+ * @brief Test program for the UDP session table
+ */
+
+#include "../protocols/udp_sessions.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+// Test configuration
+#define TEST_SESSIONS 10000
+
+/**
+ * @brief Build a distinct source address for an index
+ */
+static struct sockaddr_in make_addr(int index) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(0x0a000000 | (uint32_t)(index / 4));
+    addr.sin_port = htons((uint16_t)(40000 + index % 4));
+    return addr;
+}
+
+/**
+ * @brief Stand-in client pointer for an index
+ */
+static client_t* fake_client(int index) {
+    return (client_t*)(uintptr_t)(0x1000 + index * 16);
+}
+
+/**
+ * @brief Expire callback counting removed clients
+ */
+static void count_expired(client_t* client, void* arg) {
+    (void)client;
+    (*(int*)arg)++;
+}
+
+/**
+ * @brief Test insert, lookup and growth
+ */
+static void test_insert_lookup(void) {
+    printf("Testing session insert and lookup...\n");
+    
+    udp_session_table_t table;
+    udp_session_table_init(&table, 0);
+    
+    for (int i = 0; i < TEST_SESSIONS; i++) {
+        struct sockaddr_in addr = make_addr(i);
+        
+        if (udp_session_table_insert(&table, &addr, fake_client(i), 0) != STATUS_SUCCESS) {
+            printf("Failed to insert session %d\n", i);
+            exit(1);
+        }
+    }
+    
+    // The same source address maps to the same session
+    struct sockaddr_in duplicate = make_addr(42);
+    if (udp_session_table_insert(&table, &duplicate, fake_client(0), 0) != STATUS_ERROR_ALREADY_EXISTS) {
+        printf("Duplicate session was accepted\n");
+        exit(1);
+    }
+    
+    for (int i = 0; i < TEST_SESSIONS; i++) {
+        struct sockaddr_in addr = make_addr(i);
+        
+        if (udp_session_table_lookup(&table, &addr, 0) != fake_client(i)) {
+            printf("Lookup %d returned the wrong client\n", i);
+            exit(1);
+        }
+    }
+    
+    struct sockaddr_in unknown = make_addr(TEST_SESSIONS + 1);
+    if (udp_session_table_lookup(&table, &unknown, 0) != NULL || table.count != TEST_SESSIONS) {
+        printf("Unexpected session for an unknown address\n");
+        exit(1);
+    }
+    
+    udp_session_table_free(&table);
+    
+    printf("Session insert and lookup test passed\n");
+}
+
+/**
+ * @brief Test removal keeps the remaining probe chains intact
+ */
+static void test_remove(void) {
+    printf("Testing session removal...\n");
+    
+    udp_session_table_t table;
+    udp_session_table_init(&table, 0);
+    
+    for (int i = 0; i < TEST_SESSIONS; i++) {
+        struct sockaddr_in addr = make_addr(i);
+        udp_session_table_insert(&table, &addr, fake_client(i), 0);
+    }
+    
+    // Remove every other session
+    for (int i = 0; i < TEST_SESSIONS; i += 2) {
+        struct sockaddr_in addr = make_addr(i);
+        
+        if (udp_session_table_remove(&table, &addr) != fake_client(i)) {
+            printf("Failed to remove session %d\n", i);
+            exit(1);
+        }
+    }
+    
+    for (int i = 0; i < TEST_SESSIONS; i++) {
+        struct sockaddr_in addr = make_addr(i);
+        client_t* expected = i % 2 == 0 ? NULL : fake_client(i);
+        
+        if (udp_session_table_lookup(&table, &addr, 0) != expected) {
+            printf("Lookup %d after removal returned the wrong client\n", i);
+            exit(1);
+        }
+    }
+    
+    if (table.count != TEST_SESSIONS / 2) {
+        printf("Unexpected session count: %zu\n", table.count);
+        exit(1);
+    }
+    
+    udp_session_table_free(&table);
+    
+    printf("Session removal test passed\n");
+}
+
+/**
+ * @brief Test idle expiry, refreshed by lookups
+ */
+static void test_expire(void) {
+    printf("Testing session expiry...\n");
+    
+    udp_session_table_t table;
+    udp_session_table_init(&table, 0);
+    
+    for (int i = 0; i < TEST_SESSIONS; i++) {
+        struct sockaddr_in addr = make_addr(i);
+        udp_session_table_insert(&table, &addr, fake_client(i), 1000);
+    }
+    
+    // Sessions seen again at t=5000 survive an expiry at t=8000 with a 5s timeout
+    for (int i = 0; i < TEST_SESSIONS; i += 3) {
+        struct sockaddr_in addr = make_addr(i);
+        udp_session_table_lookup(&table, &addr, 5000);
+    }
+    
+    int expired = 0;
+    size_t removed = udp_session_table_expire(&table, 8000, 5000, count_expired, &expired);
+    int survivors = (TEST_SESSIONS + 2) / 3;
+    
+    if ((int)removed != TEST_SESSIONS - survivors || expired != (int)removed || (int)table.count != survivors) {
+        printf("Unexpected expiry: removed=%zu expired=%d count=%zu\n", removed, expired, table.count);
+        exit(1);
+    }
+    
+    for (int i = 0; i < TEST_SESSIONS; i++) {
+        struct sockaddr_in addr = make_addr(i);
+        client_t* expected = i % 3 == 0 ? fake_client(i) : NULL;
+        
+        if (udp_session_table_lookup(&table, &addr, 8000) != expected) {
+            printf("Lookup %d after expiry returned the wrong client\n", i);
+            exit(1);
+        }
+    }
+    
+    // A zero timeout removes everything
+    udp_session_table_expire(&table, 8000, 0, NULL, NULL);
+    
+    if (table.count != 0) {
+        printf("Sessions left after clearing: %zu\n", table.count);
+        exit(1);
+    }
+    
+    udp_session_table_free(&table);
+    
+    printf("Session expiry test passed\n");
+}
+
+/**
+ * @brief Main function
+ */
+int main(void) {
+    test_insert_lookup();
+    test_remove();
+    test_expire();
+    
+    printf("All tests completed successfully\n");
+    
+    return 0;
+}
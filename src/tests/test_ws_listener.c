@@ -68,6 +68,10 @@ static void test_ws_listener_create(void) {
     config.port = TEST_PORT;
     config.timeout_ms = TEST_TIMEOUT_MS;
     config.ws_path = TEST_WS_PATH;
+    config.loop_threads = 2;
+    config.ws_deflate = true;
+    config.ws_deflate_window_bits = 12;
+    config.ws_deflate_mem_level = 4;
     
     // Create listener
     status_t status = ws_listener_create(&config, &listener);
@@ -173,6 +177,39 @@ static void test_ws_message_send_receive(void) {
     printf("WebSocket message test completed successfully\n");
 }
 
+/**
+ * @brief Test that traffic counters saw the test message and its echo
+ */
+static void test_ws_stats(void) {
+    printf("Testing WebSocket listener stats...\n");
+    
+    protocol_stat_t stats[PROTOCOL_MAX_STATS];
+    size_t count = PROTOCOL_MAX_STATS;
+    uint64_t rx_bytes = 0;
+    
+    if (protocol_manager_get_stats(listener, stats, &count) != STATUS_SUCCESS || count == 0) {
+        printf("Failed to get WebSocket listener stats\n");
+        cleanup();
+        exit(1);
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        printf("  %s = %llu\n", stats[i].name, (unsigned long long)stats[i].value);
+        
+        if (strcmp(stats[i].name, "rx_bytes") == 0) {
+            rx_bytes = stats[i].value;
+        }
+    }
+    
+    if (rx_bytes < strlen(TEST_MESSAGE)) {
+        printf("Received bytes not counted: %llu\n", (unsigned long long)rx_bytes);
+        cleanup();
+        exit(1);
+    }
+    
+    printf("WebSocket stats test completed successfully\n");
+}
+
 /**
  * @brief Client thread function
  */
@@ -308,6 +345,7 @@ int main(int argc, char** argv) {
     test_ws_listener_create();
     test_ws_listener_start_stop();
     test_ws_message_send_receive();
+    test_ws_stats();
     
     // Clean up
     cleanup();